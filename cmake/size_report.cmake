@@ -0,0 +1,71 @@
+# Print the .text/.data/.bss footprint of each library, summed over the
+# objects of its archive. Run by the size-report target:
+#
+#   cmake -DSIZE_TOOL=<size> -DSIZE_TITLE=<text>
+#         -DSIZE_LIBRARIES="<name>=<archive>|..." -P size_report.cmake
+#
+# .text includes read-only data, as reported by binutils size.
+
+cmake_minimum_required(VERSION 3.13)
+
+function(pad_left value width result)
+    string(LENGTH "${value}" length)
+    while(length LESS width)
+        string(PREPEND value " ")
+        math(EXPR length "${length} + 1")
+    endwhile()
+    set(${result} "${value}" PARENT_SCOPE)
+endfunction()
+
+function(print_row name text data bss)
+    string(LENGTH "${name}" length)
+    while(length LESS name_width)
+        string(APPEND name " ")
+        math(EXPR length "${length} + 1")
+    endwhile()
+    pad_left("${text}" 8 text)
+    pad_left("${data}" 8 data)
+    pad_left("${bss}" 8 bss)
+    message("${name}${text}${data}${bss}")
+endfunction()
+
+string(REPLACE "|" ";" libraries "${SIZE_LIBRARIES}")
+set(name_width 8)
+foreach(entry IN LISTS libraries)
+    string(FIND "${entry}" "=" separator)
+    if(separator GREATER name_width)
+        set(name_width ${separator})
+    endif()
+endforeach()
+set(total_text 0)
+set(total_data 0)
+set(total_bss 0)
+
+message("${SIZE_TITLE}")
+print_row("library" ".text" ".data" ".bss")
+foreach(entry IN LISTS libraries)
+    string(FIND "${entry}" "=" separator)
+    string(SUBSTRING "${entry}" 0 ${separator} name)
+    math(EXPR separator "${separator} + 1")
+    string(SUBSTRING "${entry}" ${separator} -1 archive)
+
+    execute_process(
+        COMMAND "${SIZE_TOOL}" -t "${archive}"
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE error
+        RESULT_VARIABLE result
+    )
+    # Last line: "text data bss dec hex (TOTALS)"
+    string(REGEX MATCH
+        "([0-9]+)[ \t]+([0-9]+)[ \t]+([0-9]+)[ \t]+[0-9]+[ \t]+[0-9a-fA-F]+[ \t]+\\(TOTALS\\)"
+        totals "${output}")
+    if(NOT result EQUAL 0 OR totals STREQUAL "")
+        message(FATAL_ERROR "${SIZE_TOOL} failed on ${archive}: ${error}")
+    endif()
+
+    print_row("${name}" ${CMAKE_MATCH_1} ${CMAKE_MATCH_2} ${CMAKE_MATCH_3})
+    math(EXPR total_text "${total_text} + ${CMAKE_MATCH_1}")
+    math(EXPR total_data "${total_data} + ${CMAKE_MATCH_2}")
+    math(EXPR total_bss "${total_bss} + ${CMAKE_MATCH_3}")
+endforeach()
+print_row("total" ${total_text} ${total_data} ${total_bss})
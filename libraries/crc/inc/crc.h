@@ -50,4 +50,44 @@ int8_t crc8_calculate(
 
 /* ========================================================================== */
 
+/**
+ * @brief Start an incremental CRC-8 calculation.
+ *
+ * crc8_begin(), crc8_update() and crc8_finish() compute the same checksum as
+ * crc8_calculate() over data that is not contiguous in memory (e.g. a header,
+ * a payload and a trailer living in different buffers), without copying it.
+ *
+ * @param crc Pointer to the CRC configuration.
+ * @param state Pointer to the running CRC state to initialize.
+ * @return 0 on success, -EFAULT if any pointer is NULL.
+ */
+int8_t crc8_begin(const struct crc* crc, uint8_t* state);
+
+/* ========================================================================== */
+
+/**
+ * @brief Feed a chunk of data into an incremental CRC-8 calculation.
+ * @param crc Pointer to the CRC configuration.
+ * @param state Pointer to the running CRC state (see crc8_begin()).
+ * @param data Pointer to input data.
+ * @param length Length of input data in bytes (0 is a no-op).
+ * @return 0 on success, -EFAULT if any pointer is NULL.
+ */
+int8_t crc8_update(
+    const struct crc* crc, uint8_t* state, const uint8_t* data, size_t length);
+
+/* ========================================================================== */
+
+/**
+ * @brief Finish an incremental CRC-8 calculation, applying output reflection
+ * and the final XOR value.
+ * @param crc Pointer to the CRC configuration.
+ * @param state Running CRC state (see crc8_begin()).
+ * @param result Pointer to store the calculated CRC-8 value.
+ * @return 0 on success, -EFAULT if any pointer is NULL.
+ */
+int8_t crc8_finish(const struct crc* crc, uint8_t state, uint8_t* result);
+
+/* ========================================================================== */
+
 #endif /* CRC_H */
@@ -17,6 +17,41 @@ static inline uint8_t _reverse_8bits(uint8_t byte)
     return byte;
 }
 
+static uint8_t _crc8_feed(
+    const struct crc* crc, uint8_t crc_value, const uint8_t* data, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        uint8_t byte = data[i];
+        if (crc->reflect_input)
+        {
+            byte = _reverse_8bits(byte);
+        }
+        crc_value ^= byte;
+        for (uint8_t j = 0; j < 8; j++)
+        {
+            if (crc_value & 0x80)
+            {
+                crc_value = (uint8_t)((crc_value << 1) ^ crc->crc8_polynomial);
+            }
+            else
+            {
+                crc_value <<= 1;
+            }
+        }
+    }
+    return crc_value;
+}
+
+static uint8_t _crc8_final(const struct crc* crc, uint8_t crc_value)
+{
+    if (crc->reflect_output)
+    {
+        crc_value = _reverse_8bits(crc_value);
+    }
+    return (uint8_t)(crc_value ^ crc->crc8_final_xor_value);
+}
+
 #if 0 /* Reserved for future CRC16 implementation */
 static inline uint16_t _reverse_16bits(uint16_t value)
 {
@@ -45,33 +80,47 @@ int8_t crc8_calculate(
     {
         return -EINVAL;
     }
-    uint8_t crc_value = crc->crc8_initial_value;
-    for (size_t i = 0; i < length; i++)
+    uint8_t crc_value
+        = _crc8_feed(crc, crc->crc8_initial_value, data, length);
+    crc_value = _crc8_final(crc, crc_value);
+    *result = crc_value;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t crc8_begin(const struct crc* crc, uint8_t* state)
+{
+    if (crc == NULL || state == NULL)
     {
-        uint8_t byte = data[i];
-        if (crc->reflect_input)
-        {
-            byte = _reverse_8bits(byte);
-        }
-        crc_value ^= byte;
-        for (uint8_t j = 0; j < 8; j++)
-        {
-            if (crc_value & 0x80)
-            {
-                crc_value = (uint8_t)((crc_value << 1) ^ crc->crc8_polynomial);
-            }
-            else
-            {
-                crc_value <<= 1;
-            }
-        }
+        return -EFAULT;
     }
-    if (crc->reflect_output)
+    *state = crc->crc8_initial_value;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t crc8_update(
+    const struct crc* crc, uint8_t* state, const uint8_t* data, size_t length)
+{
+    if (crc == NULL || state == NULL || data == NULL)
     {
-        crc_value = _reverse_8bits(crc_value);
+        return -EFAULT;
     }
-    crc_value ^= crc->crc8_final_xor_value;
-    *result = crc_value;
+    *state = _crc8_feed(crc, *state, data, length);
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t crc8_finish(const struct crc* crc, uint8_t state, uint8_t* result)
+{
+    if (crc == NULL || result == NULL)
+    {
+        return -EFAULT;
+    }
+    *result = _crc8_final(crc, state);
     return 0;
 }
 
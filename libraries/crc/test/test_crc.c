@@ -212,3 +212,30 @@ void test_crc8_invalid_length(void)
 }
 
 /* ========================================================================== */
+
+void test_crc8_incremental_matches_one_shot(void)
+{
+    const struct crc crc8
+        = {.crc8_final_xor_value = 0x00,
+           .crc8_initial_value   = 0x00,
+           .crc8_polynomial      = 0xA7,
+           .reflect_input        = true,
+           .reflect_output       = true};
+
+    const uint8_t data[]   = {0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF};
+    uint8_t       expected = 0;
+    uint8_t       result   = 0;
+    uint8_t       state    = 0;
+    TEST_ASSERT_EQUAL_INT8(
+        0, crc8_calculate(&crc8, data, sizeof(data), &expected));
+
+    TEST_ASSERT_EQUAL_INT8(0, crc8_begin(&crc8, &state));
+    TEST_ASSERT_EQUAL_INT8(0, crc8_update(&crc8, &state, data, 3));
+    TEST_ASSERT_EQUAL_INT8(0, crc8_update(&crc8, &state, data + 3, 0));
+    TEST_ASSERT_EQUAL_INT8(
+        0, crc8_update(&crc8, &state, data + 3, sizeof(data) - 3));
+    TEST_ASSERT_EQUAL_INT8(0, crc8_finish(&crc8, state, &result));
+    TEST_ASSERT_EQUAL_UINT8(expected, result);
+}
+
+/* ========================================================================== */
@@ -3,6 +3,7 @@
 
 #include "../../embedded-hal/inc/gpio.h"
 #include "../../embedded-hal/inc/spi.h"
+#include "../../packet-pool/inc/packet_pool.h"
 
 #include <stdint.h>
 
@@ -38,6 +39,16 @@ int8_t enc28j60_receive_packet(
 int8_t enc28j60_transmit_packet(
     struct enc28j60* self, uint8_t* frame, uint16_t size);
 
+/* Receive into a chain of blocks from pool, dropping the packet on -ENOMEM */
+int8_t enc28j60_receive_block(
+    struct enc28j60*      self,
+    struct packet_pool*   pool,
+    struct packet_block** frame);
+
+/* Transmit a frame held by a chain of blocks; the caller still owns it */
+int8_t enc28j60_transmit_block(
+    struct enc28j60* self, const struct packet_block* frame);
+
 /* ========================================================================== */
 
 #endif /* ENC28J60_H */
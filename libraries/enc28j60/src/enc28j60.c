@@ -418,18 +418,13 @@ int8_t enc28j60_get_epktcnt(struct enc28j60* self, uint8_t* epktcnt)
     return 0;
 }
 
-int8_t enc28j60_receive_packet(
-    struct enc28j60* self, uint8_t* buffer, uint16_t* size)
+/**
+ * @brief Select the next received packet and read its header. Leaves chip
+ * select asserted, positioned at the first byte of the frame.
+ */
+static int8_t enc28j60_begin_receive(
+    struct enc28j60* self, uint16_t* next_pkt_ptr, uint16_t* size)
 {
-    if (self == NULL)
-    {
-        return -EFAULT;
-    }
-    if (!self->private.initialized)
-    {
-        return -EPERM;
-    }
-
     uint8_t epktcnt = 0;
     enc28j60_get_epktcnt(self, &epktcnt);
     if (epktcnt == 0)
@@ -454,12 +449,17 @@ int8_t enc28j60_receive_packet(
     self->spi_bus->ops->transfer(
         self->spi_bus, rx_buffer, rx_buffer, sizeof(rx_buffer));
 
-    uint16_t next_pkt_ptr = (uint16_t)((rx_buffer[1] << 8) | rx_buffer[0]);
-
-    uint16_t eth_pkt_size = (uint16_t)((rx_buffer[3] << 8) | rx_buffer[2]);
-
-    self->spi_bus->ops->transfer(self->spi_bus, buffer, buffer, eth_pkt_size);
+    *next_pkt_ptr = (uint16_t)((rx_buffer[1] << 8) | rx_buffer[0]);
+    *size         = (uint16_t)((rx_buffer[3] << 8) | rx_buffer[2]);
+    return 0;
+}
 
+/**
+ * @brief Release chip select and free the space of the packet in the RX
+ * buffer, whether it was read or dropped.
+ */
+static void enc28j60_end_receive(struct enc28j60* self, uint16_t next_pkt_ptr)
+{
     self->spi_cs->ops->set_state(self->spi_cs, true);
 
     /* Update ERXRDPT (must be odd per silicon errata) */
@@ -472,24 +472,14 @@ int8_t enc28j60_receive_packet(
     self->private.erdpt = next_pkt_ptr;
 
     enc28j60_set_eth_bit(self, ECON2, 0x40, true);
-
-    *size = eth_pkt_size;
-
-    return 0;
 }
 
-int8_t enc28j60_transmit_packet(
-    struct enc28j60* self, uint8_t* frame, uint16_t size)
+/**
+ * @brief Point the TX buffer at a frame of the given size and leave chip
+ * select asserted, ready for the frame bytes.
+ */
+static void enc28j60_begin_transmit(struct enc28j60* self, uint16_t size)
 {
-    if (self == NULL)
-    {
-        return -EFAULT;
-    }
-    if (!self->private.initialized)
-    {
-        return -EPERM;
-    }
-
     uint16_t tx_start = self->rx_buf_end_addr + 1;
     uint16_t tx_end   = tx_start + size;
 
@@ -507,9 +497,13 @@ int8_t enc28j60_transmit_packet(
 
     uint8_t ctrl_byte = 0x00;
     self->spi_bus->ops->transmit(self->spi_bus, &ctrl_byte, 1);
+}
 
-    self->spi_bus->ops->transmit(self->spi_bus, frame, size);
-
+/**
+ * @brief Release chip select and send the frame written to the TX buffer.
+ */
+static void enc28j60_end_transmit(struct enc28j60* self)
+{
     self->spi_cs->ops->set_state(self->spi_cs, true);
 
     enc28j60_set_eth_bit(self, ECON1, 0x08, true);
@@ -532,6 +526,132 @@ int8_t enc28j60_transmit_packet(
             txerif = false;
         }
     }
+}
+
+/* ========================================================================== */
+
+int8_t enc28j60_receive_packet(
+    struct enc28j60* self, uint8_t* buffer, uint16_t* size)
+{
+    if (self == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->private.initialized)
+    {
+        return -EPERM;
+    }
+
+    uint16_t next_pkt_ptr = 0;
+    uint16_t eth_pkt_size = 0;
+
+    int8_t ret = enc28j60_begin_receive(self, &next_pkt_ptr, &eth_pkt_size);
+    if (ret)
+    {
+        return ret;
+    }
+
+    self->spi_bus->ops->transfer(self->spi_bus, buffer, buffer, eth_pkt_size);
+
+    enc28j60_end_receive(self, next_pkt_ptr);
+
+    *size = eth_pkt_size;
+
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t enc28j60_receive_block(
+    struct enc28j60*      self,
+    struct packet_pool*   pool,
+    struct packet_block** frame)
+{
+    if (self == NULL || pool == NULL || frame == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->private.initialized)
+    {
+        return -EPERM;
+    }
+
+    uint16_t next_pkt_ptr = 0;
+    uint16_t eth_pkt_size = 0;
+
+    int8_t ret = enc28j60_begin_receive(self, &next_pkt_ptr, &eth_pkt_size);
+    if (ret)
+    {
+        return ret;
+    }
+
+    /* No block left: drop the packet rather than stall the RX buffer */
+    struct packet_block* head = NULL;
+    ret = packet_pool_alloc_chain(pool, eth_pkt_size, &head);
+    if (ret)
+    {
+        enc28j60_end_receive(self, next_pkt_ptr);
+        return ret;
+    }
+
+    for (struct packet_block* block = head; block != NULL; block = block->next)
+    {
+        self->spi_bus->ops->transfer(
+            self->spi_bus, block->data, block->data, block->length);
+    }
+
+    enc28j60_end_receive(self, next_pkt_ptr);
+
+    *frame = head;
+
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t enc28j60_transmit_packet(
+    struct enc28j60* self, uint8_t* frame, uint16_t size)
+{
+    if (self == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->private.initialized)
+    {
+        return -EPERM;
+    }
+
+    enc28j60_begin_transmit(self, size);
+
+    self->spi_bus->ops->transmit(self->spi_bus, frame, size);
+
+    enc28j60_end_transmit(self);
+
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t enc28j60_transmit_block(
+    struct enc28j60* self, const struct packet_block* frame)
+{
+    if (self == NULL || frame == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->private.initialized)
+    {
+        return -EPERM;
+    }
+
+    enc28j60_begin_transmit(self, packet_chain_length(frame));
+
+    for (; frame != NULL; frame = frame->next)
+    {
+        self->spi_bus->ops->transmit(self->spi_bus, frame->data, frame->length);
+    }
+
+    enc28j60_end_transmit(self);
 
     return 0;
 }
@@ -2,15 +2,245 @@
 
 /* ========================================================================== */
 
+#include "../../inc/errno.h"
 #include "../inc/enc28j60.h"
 
+#include <string.h>
+
 TEST_SOURCE_FILE("../src/enc28j60.c")
+TEST_SOURCE_FILE("../../packet-pool/src/packet_pool.c")
+
+/* ========================================================================== */
+
+/*
+ * Fake chip behind the SPI ops: control register reads return 0 except
+ * EPKTCNT, READ BUF MEM streams rx_memory, WRITE BUF MEM appends to
+ * tx_memory. The last value written to each control register address is kept
+ * (bank ignored: after init, addresses 0x00-0x0D are the bank 0 pointers).
+ */
+#define OPCODE_READ_BUF_MEM  0x3A
+#define OPCODE_WRITE_BUF_MEM 0x7A
+#define ADDR_EPKTCNT         0x19
+#define ADDR_ECON2           0x1E
+
+static uint8_t packet_count;
+static uint8_t rx_memory[128];
+static size_t  rx_index;
+static uint8_t tx_memory[128];
+static size_t  tx_index;
+static uint8_t registers[32];
+static uint8_t packets_released;
+static uint8_t buffer_mode;
+static bool    cs_high;
+
+static int8_t
+fake_spi_transmit(const struct spi* self, const uint8_t* buffer, size_t size)
+{
+    (void)self;
+    if (buffer_mode == OPCODE_WRITE_BUF_MEM)
+    {
+        memcpy(&tx_memory[tx_index], buffer, size);
+        tx_index += size;
+        return 0;
+    }
+    if (size == 1)
+    {
+        buffer_mode = buffer[0];
+        return 0;
+    }
+
+    uint8_t opcode = buffer[0] >> 5;
+    uint8_t addr   = buffer[0] & 0x1F;
+    if (opcode == 0x02)
+    {
+        registers[addr] = buffer[1];
+    }
+    else if (opcode == 0x04 && addr == ADDR_ECON2 && (buffer[1] & 0x40))
+    {
+        packets_released += 1; /* PKTDEC */
+        packet_count -= 1;
+    }
+    return 0;
+}
+
+static int8_t fake_spi_transfer(
+    const struct spi* self,
+    const uint8_t*    tx_buffer,
+    uint8_t*          rx_buffer,
+    size_t            size)
+{
+    (void)self;
+    if (buffer_mode == OPCODE_READ_BUF_MEM)
+    {
+        memcpy(rx_buffer, &rx_memory[rx_index], size);
+        rx_index += size;
+        return 0;
+    }
+    uint8_t value = ((tx_buffer[0] & 0x1F) == ADDR_EPKTCNT) ? packet_count : 0;
+    memset(rx_buffer, 0, size);
+    rx_buffer[size - 1] = value;
+    return 0;
+}
+
+static int8_t fake_cs_set_state(const struct gpio* self, bool state)
+{
+    (void)self;
+    cs_high = state;
+    if (state)
+    {
+        buffer_mode = 0;
+    }
+    return 0;
+}
+
+static const struct spi_ops  fake_spi_ops = {.transmit = fake_spi_transmit,
+                                             .transfer = fake_spi_transfer};
+static const struct gpio_ops fake_cs_ops  = {.set_state = fake_cs_set_state};
+static struct spi            fake_spi     = {.ops = &fake_spi_ops};
+static struct gpio           fake_cs      = {.ops = &fake_cs_ops};
+
+static struct enc28j60 enc = {
+    .spi_cs          = &fake_cs,
+    .spi_bus         = &fake_spi,
+    .mac_address     = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01},
+    .rx_buf_end_addr = 0x0FFF,
+};
+
+static struct packet_block blocks[4];
+static uint8_t             storage[4 * 16];
+static struct packet_pool  pool = {
+    .blocks      = blocks,
+    .storage     = storage,
+    .block_count = 4,
+    .block_size  = 16,
+};
+
+/**
+ * @brief Queue one received packet: next packet pointer, size, status vector,
+ * then the frame.
+ */
+static void queue_packet(uint16_t next, const uint8_t* frame, uint16_t size)
+{
+    const uint8_t header[6] = {(uint8_t)next, (uint8_t)(next >> 8),
+                               (uint8_t)size, (uint8_t)(size >> 8),
+                               0x00,          0x80};
+    memcpy(rx_memory, header, sizeof(header));
+    memcpy(&rx_memory[sizeof(header)], frame, size);
+    rx_index     = 0;
+    packet_count = 1;
+}
+
+static uint16_t register_pair(uint8_t low_addr)
+{
+    return (uint16_t)(registers[low_addr] | registers[low_addr + 1] << 8);
+}
 
 /* ========================================================================== */
 
-void test_sample(void)
+void setUp(void)
+{
+    packet_count     = 0;
+    rx_index         = 0;
+    tx_index         = 0;
+    packets_released = 0;
+    buffer_mode      = 0;
+    memset(registers, 0, sizeof(registers));
+    memset(&enc.private, 0, sizeof(enc.private));
+    TEST_ASSERT_EQUAL(0, enc28j60_init(&enc));
+    TEST_ASSERT_EQUAL(0, packet_pool_init(&pool));
+}
+
+void tearDown(void)
+{
+}
+
+/* ========================================================================== */
+
+void test_receive_block_fills_a_chain(void)
+{
+    uint8_t frame[40];
+    for (uint8_t i = 0; i < sizeof(frame); i++)
+    {
+        frame[i] = (uint8_t)(0xA0 + i);
+    }
+    queue_packet(0x0200, frame, sizeof(frame));
+
+    struct packet_block* head = NULL;
+    TEST_ASSERT_EQUAL(0, enc28j60_receive_block(&enc, &pool, &head));
+    TEST_ASSERT_EQUAL(1, packet_pool_available(&pool));
+    TEST_ASSERT_EQUAL(sizeof(frame), packet_chain_length(head));
+    uint8_t copy[40];
+    TEST_ASSERT_EQUAL(
+        sizeof(frame), packet_chain_copy(head, 0, copy, sizeof(copy)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frame, copy, sizeof(frame));
+
+    // The packet is released and the read pointer follows it (odd address)
+    TEST_ASSERT_TRUE(cs_high);
+    TEST_ASSERT_EQUAL(1, packets_released);
+    TEST_ASSERT_EQUAL_HEX16(0x01FF, register_pair(0x0C)); /* ERXRDPT */
+
+    TEST_ASSERT_EQUAL(-ENODATA, enc28j60_receive_block(&enc, &pool, &head));
+    TEST_ASSERT_EQUAL(0, packet_pool_free(&pool, head));
+}
+
+void test_receive_block_drops_the_packet_without_blocks(void)
+{
+    uint8_t frame[40] = {0};
+    queue_packet(0x0300, frame, sizeof(frame));
+    struct packet_block* taken = NULL;
+    TEST_ASSERT_EQUAL(0, packet_pool_alloc_chain(&pool, 48, &taken));
+
+    struct packet_block* head = NULL;
+    TEST_ASSERT_EQUAL(-ENOMEM, enc28j60_receive_block(&enc, &pool, &head));
+    TEST_ASSERT_NULL(head);
+    // Dropped, not left in the RX buffer to stall the next ones
+    TEST_ASSERT_TRUE(cs_high);
+    TEST_ASSERT_EQUAL(1, packets_released);
+    TEST_ASSERT_EQUAL_HEX16(0x02FF, register_pair(0x0C)); /* ERXRDPT */
+    TEST_ASSERT_EQUAL(1, packet_pool_available(&pool));
+
+    TEST_ASSERT_EQUAL(-EFAULT, enc28j60_receive_block(&enc, NULL, &head));
+    TEST_ASSERT_EQUAL(-EFAULT, enc28j60_receive_block(&enc, &pool, NULL));
+}
+
+void test_transmit_block_sends_the_whole_chain(void)
+{
+    struct packet_block* head = NULL;
+    TEST_ASSERT_EQUAL(0, packet_pool_alloc_chain(&pool, 20, &head));
+    for (uint8_t i = 0; i < 16; i++)
+    {
+        head->data[i] = i;
+    }
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        head->next->data[i] = (uint8_t)(16 + i);
+    }
+
+    TEST_ASSERT_EQUAL(0, enc28j60_transmit_block(&enc, head));
+    // Per-packet control byte, then the frame across both blocks
+    TEST_ASSERT_EQUAL(1 + 20, tx_index);
+    TEST_ASSERT_EQUAL_HEX8(0x00, tx_memory[0]);
+    for (uint8_t i = 0; i < 20; i++)
+    {
+        TEST_ASSERT_EQUAL(i, tx_memory[1 + i]);
+    }
+    TEST_ASSERT_EQUAL_HEX16(0x1000, register_pair(0x02)); /* EWRPT */
+    TEST_ASSERT_EQUAL_HEX16(0x1000 + 20, register_pair(0x06)); /* ETXND */
+    TEST_ASSERT_TRUE(cs_high);
+
+    // The caller still owns the chain
+    TEST_ASSERT_EQUAL(2, packet_pool_available(&pool));
+    TEST_ASSERT_EQUAL(0, packet_pool_free(&pool, head));
+    TEST_ASSERT_EQUAL(-EFAULT, enc28j60_transmit_block(&enc, NULL));
+}
+
+void test_block_calls_need_an_initialized_driver(void)
 {
-    TEST_ASSERT_TRUE(1);
+    struct packet_block* head = NULL;
+    TEST_ASSERT_EQUAL(0, packet_pool_alloc(&pool, &head));
+    enc.private.initialized = false;
+    TEST_ASSERT_EQUAL(-EPERM, enc28j60_receive_block(&enc, &pool, &head));
+    TEST_ASSERT_EQUAL(-EPERM, enc28j60_transmit_block(&enc, head));
 }
 
 /* ========================================================================== */
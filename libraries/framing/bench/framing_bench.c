@@ -0,0 +1,584 @@
+/**
+ * @file framing_bench.c
+ * @brief Host throughput and robustness benchmark for the framing library.
+ *
+ * Generates random frames, passes them through a simulated noisy link (bit
+ * errors, inserted and deleted bytes) and feeds the result through
+ * ring_buffer + framing exactly like an RX ISR and main loop would. Reports
+ * RX/TX throughput, delivery statistics, lost_frames counter accuracy and
+ * resynchronization latency after a damaged frame.
+ *
+ * Every payload starts with a 32-bit sequence number; the remaining bytes are
+ * derived from it, so delivered frames can be matched to sent ones and
+ * undetected corruption (CRC-8 collisions) can be counted.
+ *
+ * Usage: framing-bench [-n frames] [-m max_payload] [-b bit_error_rate]
+ *                      [-i insertion_rate] [-d deletion_rate] [-s seed]
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "../../buffer/inc/buffer.h"
+#include "../../crc/inc/crc.h"
+#include "../../ring-buffer/inc/ring_buffer.h"
+#include "../inc/framing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* ========================================================================== */
+
+#define BATCH_FRAMES   4096
+#define SEQ_SIZE       4
+#define MAX_FRAME_SIZE (FRAMING_HEADER_SIZE + 255 + FRAMING_TRAILER_SIZE)
+#define RX_RING_SIZE   256
+
+/* Worst case: every byte followed by an inserted byte */
+#define STREAM_SIZE (2 * BATCH_FRAMES * MAX_FRAME_SIZE)
+
+struct bench_config
+{
+    unsigned long frames;
+    uint8_t       max_payload;
+    double        bit_error_rate;
+    double        insertion_rate;
+    double        deletion_rate;
+    unsigned int  seed;
+};
+
+struct bench_results
+{
+    unsigned long sent;
+    unsigned long impaired;
+    unsigned long delivered;
+    unsigned long undetected;
+    unsigned long collateral;
+    unsigned long reported_lost;
+    unsigned long crc_errors;
+    unsigned long resync_events;
+    unsigned long resync_bytes_total;
+    unsigned long resync_bytes_max;
+    uint64_t      rx_bytes;
+    double        rx_seconds;
+    double        tx_seconds;
+    double        tx_iov_seconds;
+};
+
+/* Per-frame bookkeeping of the current batch */
+struct frame_info
+{
+    size_t start;
+    size_t end;
+    bool   impaired;
+    bool   delivered;
+};
+
+static uint8_t           stream[STREAM_SIZE];
+static struct frame_info frames[BATCH_FRAMES];
+
+/* Payloads delivered while timing, matched against sent frames afterwards.
+ * Every delivery consumes at least one minimum-size frame of the stream. */
+static uint8_t delivered_log[STREAM_SIZE];
+static uint8_t delivered_size[STREAM_SIZE / (FRAMING_HEADER_SIZE + SEQ_SIZE)];
+
+/* ========================================================================== */
+
+/* xorshift32: fast, deterministic and good enough for channel simulation */
+static uint32_t rng_state = 1;
+
+static uint32_t rng_next(void)
+{
+    uint32_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rng_state = x;
+    return x;
+}
+
+static bool rng_chance(double probability)
+{
+    return probability > 0.0
+           && (double)rng_next() < probability * 4294967296.0;
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* ========================================================================== */
+
+static uint8_t payload_size_for(uint32_t seq, uint8_t max_payload)
+{
+    uint32_t span = (uint32_t)max_payload - SEQ_SIZE + 1;
+    return (uint8_t)(SEQ_SIZE + (seq * 2654435761u >> 8) % span);
+}
+
+static void payload_for(uint32_t seq, uint8_t* payload, uint8_t size)
+{
+    memcpy(payload, &seq, SEQ_SIZE);
+    uint32_t x = seq * 2654435761u + 1;
+    for (uint8_t i = SEQ_SIZE; i < size; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        payload[i] = (uint8_t)x;
+    }
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Build a batch of frames into the stream, applying channel errors.
+ * @return Number of bytes written to the stream.
+ */
+static size_t build_batch(
+    struct framing*            tx,
+    const struct bench_config* cfg,
+    uint32_t                   first_seq,
+    size_t                     count,
+    struct bench_results*      res)
+{
+    size_t  pos = 0;
+    uint8_t payload[255];
+    for (size_t f = 0; f < count; f++)
+    {
+        uint32_t seq  = first_seq + (uint32_t)f;
+        uint8_t  size = payload_size_for(seq, cfg->max_payload);
+        payload_for(seq, payload, size);
+
+        struct framing_iovec iov[FRAMING_IOV_COUNT];
+        uint8_t              frame_size;
+        framing_build_frame_iov(tx, payload, size, iov, &frame_size);
+
+        frames[f].start     = pos;
+        frames[f].impaired  = false;
+        frames[f].delivered = false;
+        for (size_t s = 0; s < FRAMING_IOV_COUNT; s++)
+        {
+            for (size_t i = 0; i < iov[s].len; i++)
+            {
+                if (rng_chance(cfg->deletion_rate))
+                {
+                    frames[f].impaired = true;
+                    continue;
+                }
+                uint8_t byte = iov[s].base[i];
+                for (uint8_t bit = 0; bit < 8; bit++)
+                {
+                    if (rng_chance(cfg->bit_error_rate))
+                    {
+                        byte ^= (uint8_t)(1u << bit);
+                        frames[f].impaired = true;
+                    }
+                }
+                stream[pos++] = byte;
+                if (rng_chance(cfg->insertion_rate))
+                {
+                    stream[pos++]      = (uint8_t)rng_next();
+                    frames[f].impaired = true;
+                }
+            }
+        }
+        frames[f].end = pos;
+        res->impaired += frames[f].impaired ? 1 : 0;
+    }
+    res->sent += count;
+    return pos;
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Identify which frame of the batch a delivered payload belongs to.
+ * @return Frame index within the batch, or -1 if the payload does not match
+ * any sent frame (undetected corruption).
+ */
+static long match_payload(
+    const struct bench_config* cfg,
+    uint32_t                   first_seq,
+    size_t                     count,
+    const uint8_t*             payload,
+    uint8_t                    size)
+{
+    uint32_t seq;
+    uint8_t  expected[255];
+    if (size < SEQ_SIZE)
+    {
+        return -1;
+    }
+    memcpy(&seq, payload, SEQ_SIZE);
+    if (seq < first_seq || seq - first_seq >= count
+        || size != payload_size_for(seq, cfg->max_payload))
+    {
+        return -1;
+    }
+    payload_for(seq, expected, size);
+    if (memcmp(expected, payload, size) != 0)
+    {
+        return -1;
+    }
+    return (long)(seq - first_seq);
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Feed a batch through ring_buffer + framing. Only this part is timed:
+ * delivered payloads are logged and matched against sent frames afterwards.
+ */
+static void receive_batch(
+    struct framing*            rx,
+    const struct bench_config* cfg,
+    uint32_t                   first_seq,
+    size_t                     count,
+    size_t                     stream_size,
+    struct bench_results*      res)
+{
+    size_t  pos        = 0;
+    size_t  log_pos    = 0;
+    size_t  deliveries = 0;
+    uint8_t last_lost  = rx->lost_frames;
+
+    double start = now_seconds();
+    while (pos < stream_size)
+    {
+        /* ISR side: push a chunk that is guaranteed to fit */
+        size_t chunk = stream_size - pos;
+        if (chunk > RX_RING_SIZE - 1)
+        {
+            chunk = RX_RING_SIZE - 1;
+        }
+        ring_buffer_push(rx->rx_raw_buffer, &stream[pos], chunk);
+        pos += chunk;
+
+        /* Main loop side: drain it */
+        int8_t status;
+        while ((status = framing_process_incoming_data(rx)) != -ENODATA)
+        {
+            if (status == -EILSEQ)
+            {
+                res->crc_errors += 1;
+            }
+            else if (
+                status == 0
+                && framing_retrieve_payload(
+                       rx, &delivered_log[log_pos], &delivered_size[deliveries])
+                       == 0)
+            {
+                log_pos += delivered_size[deliveries];
+                deliveries += 1;
+            }
+        }
+
+        /* lost_frames is a wrapping uint8_t: accumulate per chunk, a chunk
+         * can never hold 255 frames */
+        res->reported_lost += (uint8_t)(rx->lost_frames - last_lost);
+        last_lost = rx->lost_frames;
+    }
+    res->rx_seconds += now_seconds() - start;
+    res->rx_bytes += stream_size;
+
+    long next_frame = 0;
+    log_pos         = 0;
+    for (size_t d = 0; d < deliveries; d++)
+    {
+        long idx = match_payload(
+            cfg, first_seq, count, &delivered_log[log_pos], delivered_size[d]);
+        log_pos += delivered_size[d];
+        if (idx < 0)
+        {
+            res->undetected += 1;
+            continue;
+        }
+        res->delivered += 1;
+        frames[idx].delivered = true;
+        if (idx > next_frame)
+        {
+            /* Frames lost before this one: resync latency is measured from
+             * the end of the first lost frame to the start of this one */
+            unsigned long gap
+                = (unsigned long)(frames[idx].start - frames[next_frame].end);
+            res->resync_events += 1;
+            res->resync_bytes_total += gap;
+            if (gap > res->resync_bytes_max)
+            {
+                res->resync_bytes_max = gap;
+            }
+        }
+        next_frame = idx + 1;
+    }
+
+    for (size_t f = 0; f < count; f++)
+    {
+        if (!frames[f].delivered && !frames[f].impaired)
+        {
+            res->collateral += 1;
+        }
+    }
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Time framing_build_frame against framing_build_frame_iov.
+ */
+static void bench_tx(
+    struct framing*            tx,
+    const struct bench_config* cfg,
+    struct bench_results*      res)
+{
+    uint8_t       payload[255];
+    uint8_t       frame_size;
+    unsigned long iterations = cfg->frames;
+    unsigned long sink       = 0;
+
+    payload_for(0, payload, cfg->max_payload);
+
+    double start = now_seconds();
+    for (unsigned long i = 0; i < iterations; i++)
+    {
+        payload[0] = (uint8_t)i;
+        framing_build_frame(tx, payload, cfg->max_payload, &frame_size);
+        sink += frame_size;
+    }
+    res->tx_seconds = now_seconds() - start;
+
+    struct framing_iovec iov[FRAMING_IOV_COUNT];
+    start = now_seconds();
+    for (unsigned long i = 0; i < iterations; i++)
+    {
+        payload[0] = (uint8_t)i;
+        framing_build_frame_iov(
+            tx, payload, cfg->max_payload, iov, &frame_size);
+        sink += iov[2].base[1];
+    }
+    res->tx_iov_seconds = now_seconds() - start;
+
+    if (sink == 0)
+    {
+        printf("(unreachable)\n");
+    }
+}
+
+/* ========================================================================== */
+
+static void print_results(
+    const struct bench_config* cfg, const struct bench_results* res)
+{
+    unsigned long lost = res->sent - res->delivered;
+    printf("framing benchmark\n");
+    printf(
+        "  frames: %lu, max payload: %u, seed: %u\n",
+        cfg->frames,
+        cfg->max_payload,
+        cfg->seed);
+    printf(
+        "  channel: bit error rate %.2e, insertion %.2e, deletion %.2e\n",
+        cfg->bit_error_rate,
+        cfg->insertion_rate,
+        cfg->deletion_rate);
+    printf("RX (ring_buffer + framing_process_incoming_data + retrieve)\n");
+    printf(
+        "  frames/s:            %.0f\n",
+        (double)res->sent / res->rx_seconds);
+    printf(
+        "  bytes/s:             %.0f\n",
+        (double)res->rx_bytes / res->rx_seconds);
+    printf(
+        "  ns/byte:             %.2f\n",
+        1e9 * res->rx_seconds / (double)res->rx_bytes);
+    printf("TX (%u-byte payload)\n", cfg->max_payload);
+    printf(
+        "  build_frame:         %.0f frames/s\n",
+        (double)cfg->frames / res->tx_seconds);
+    printf(
+        "  build_frame_iov:     %.0f frames/s\n",
+        (double)cfg->frames / res->tx_iov_seconds);
+    printf("Delivery\n");
+    printf("  sent:                %lu\n", res->sent);
+    printf("  impaired by channel: %lu\n", res->impaired);
+    printf("  delivered intact:    %lu\n", res->delivered);
+    printf("  lost:                %lu\n", lost);
+    printf("  lost, not impaired:  %lu (collateral)\n", res->collateral);
+    printf("  undetected corrupt:  %lu (CRC-8 collisions)\n", res->undetected);
+    printf("lost_frames counter\n");
+    printf("  CRC errors seen:     %lu\n", res->crc_errors);
+    printf("  counter (unwrapped): %lu\n", res->reported_lost);
+    printf(
+        "  accuracy:            %.1f%% of actual losses\n",
+        lost ? 100.0 * (double)res->reported_lost / (double)lost : 100.0);
+    printf("Resynchronization after loss\n");
+    printf("  events:              %lu\n", res->resync_events);
+    printf(
+        "  mean latency:        %.1f bytes\n",
+        res->resync_events ? (double)res->resync_bytes_total
+                                 / (double)res->resync_events
+                           : 0.0);
+    printf("  max latency:         %lu bytes\n", res->resync_bytes_max);
+}
+
+/* ========================================================================== */
+
+static void print_stats(const struct framing* rx)
+{
+    struct framing_stats stats;
+    if (framing_get_stats(rx, &stats) != 0)
+    {
+        return;  // Built with FRAMING_STATS_ENABLED set to 0
+    }
+    printf("framing_stats\n");
+    printf("  frames_ok:           %lu\n", (unsigned long)stats.frames_ok);
+    printf("  crc_errors:          %lu\n", (unsigned long)stats.crc_errors);
+    printf(
+        "  invalid_length:      %lu\n", (unsigned long)stats.invalid_length);
+    printf("  missing_stop:        %lu\n", (unsigned long)stats.missing_stop);
+    printf(
+        "  discarded_bytes:     %lu\n", (unsigned long)stats.discarded_bytes);
+}
+
+/* ========================================================================== */
+
+static int parse_args(int argc, char** argv, struct bench_config* cfg)
+{
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const char* opt = argv[i];
+        const char* val = argv[i + 1];
+        if (!strcmp(opt, "-n"))
+        {
+            cfg->frames = strtoul(val, NULL, 0);
+        }
+        else if (!strcmp(opt, "-m"))
+        {
+            unsigned long m = strtoul(val, NULL, 0);
+            if (m < SEQ_SIZE || m > 251)
+            {
+                fprintf(
+                    stderr, "max payload must be in [%d, 251]\n", SEQ_SIZE);
+                return -1;
+            }
+            cfg->max_payload = (uint8_t)m;
+        }
+        else if (!strcmp(opt, "-b"))
+        {
+            cfg->bit_error_rate = strtod(val, NULL);
+        }
+        else if (!strcmp(opt, "-i"))
+        {
+            cfg->insertion_rate = strtod(val, NULL);
+        }
+        else if (!strcmp(opt, "-d"))
+        {
+            cfg->deletion_rate = strtod(val, NULL);
+        }
+        else if (!strcmp(opt, "-s"))
+        {
+            cfg->seed = (unsigned int)strtoul(val, NULL, 0);
+        }
+        else
+        {
+            return -1;
+        }
+    }
+    return (cfg->frames > 0) ? 0 : -1;
+}
+
+/* ========================================================================== */
+
+int main(int argc, char** argv)
+{
+    struct bench_config cfg
+        = {.frames         = 1000000,
+           .max_payload    = 64,
+           .bit_error_rate = 1e-5,
+           .insertion_rate = 1e-5,
+           .deletion_rate  = 1e-5,
+           .seed           = 1};
+    if (parse_args(argc, argv, &cfg) != 0)
+    {
+        fprintf(
+            stderr,
+            "usage: %s [-n frames] [-m max_payload] [-b bit_error_rate] "
+            "[-i insertion_rate] [-d deletion_rate] [-s seed]\n",
+            argv[0]);
+        return 1;
+    }
+    rng_state = cfg.seed ? cfg.seed : 1;
+
+    static uint8_t _rx_raw_buffer[RX_RING_SIZE];
+    static uint8_t _tx_frame_buffer[MAX_FRAME_SIZE];
+    static uint8_t _internal_buffer[MAX_FRAME_SIZE];
+    static uint8_t _unused_rx_buffer[1];
+    static uint8_t _unused_buffer[1];
+
+    struct ring_buffer rx_buffer
+        = {.buffer    = _rx_raw_buffer,
+           .size      = sizeof(_rx_raw_buffer),
+           .overwrite = false};
+    struct ring_buffer unused_rx_buffer
+        = {.buffer    = _unused_rx_buffer,
+           .size      = sizeof(_unused_rx_buffer),
+           .overwrite = false};
+    struct buffer tx_buffer
+        = {.buffer = _tx_frame_buffer, .size = sizeof(_tx_frame_buffer)};
+    struct buffer int_buffer
+        = {.buffer = _internal_buffer, .size = sizeof(_internal_buffer)};
+    struct buffer unused_buffer
+        = {.buffer = _unused_buffer, .size = sizeof(_unused_buffer)};
+    ring_buffer_init(&rx_buffer);
+    ring_buffer_init(&unused_rx_buffer);
+    buffer_init(&tx_buffer);
+    buffer_init(&int_buffer);
+    buffer_init(&unused_buffer);
+
+    struct crc crc8
+        = {.crc8_polynomial      = 0x97,
+           .crc8_initial_value   = 0x00,
+           .crc8_final_xor_value = 0x00,
+           .reflect_input        = false,
+           .reflect_output       = false};
+
+    struct framing tx
+        = {.crc8_calculator  = &crc8,
+           .rx_raw_buffer    = &unused_rx_buffer,
+           .tx_frame_buffer  = &tx_buffer,
+           .parsing_buffer   = &unused_buffer,
+           .start_delimiter  = 0xAA,
+           .stop_delimiter   = 0x55,
+           .max_payload_size = cfg.max_payload};
+    struct framing rx
+        = {.crc8_calculator  = &crc8,
+           .rx_raw_buffer    = &rx_buffer,
+           .tx_frame_buffer  = &unused_buffer,
+           .parsing_buffer   = &int_buffer,
+           .start_delimiter  = 0xAA,
+           .stop_delimiter   = 0x55,
+           .max_payload_size = cfg.max_payload};
+    framing_init(&tx);
+    framing_init(&rx);
+
+    struct bench_results res;
+    memset(&res, 0, sizeof(res));
+
+    for (unsigned long done = 0; done < cfg.frames;)
+    {
+        size_t count = (cfg.frames - done > BATCH_FRAMES)
+                           ? BATCH_FRAMES
+                           : (size_t)(cfg.frames - done);
+        size_t stream_size
+            = build_batch(&tx, &cfg, (uint32_t)done, count, &res);
+        receive_batch(&rx, &cfg, (uint32_t)done, count, stream_size, &res);
+        done += count;
+    }
+    bench_tx(&tx, &cfg, &res);
+    print_results(&cfg, &res);
+    print_stats(&rx);
+    return 0;
+}
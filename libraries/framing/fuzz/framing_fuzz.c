@@ -0,0 +1,161 @@
+/**
+ * @file framing_fuzz.c
+ * @brief libFuzzer entry point for framing_process_incoming_data.
+ *
+ * The first input byte selects max_payload_size, the rest is fed through
+ * ring_buffer + framing the way an RX ISR and main loop would. Every delivered
+ * payload must respect the configured limits, and rebuilding it with
+ * framing_build_frame and framing_build_frame_iov must give identical frames.
+ *
+ * Build with clang: -fsanitize=fuzzer,address,undefined. Other compilers get
+ * a replay driver (FRAMING_FUZZ_STANDALONE) that runs each file given on the
+ * command line through the entry point, to reproduce crashes.
+ */
+
+#include "../../buffer/inc/buffer.h"
+#include "../../crc/inc/crc.h"
+#include "../../ring-buffer/inc/ring_buffer.h"
+#include "../inc/framing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ========================================================================== */
+
+#define MAX_FRAME_SIZE (FRAMING_HEADER_SIZE + 255 + FRAMING_TRAILER_SIZE)
+#define RX_RING_SIZE   64
+
+/* ========================================================================== */
+
+static void check_round_trip(
+    struct framing* self, const uint8_t* payload, uint8_t payload_size)
+{
+    struct framing_iovec iov[FRAMING_IOV_COUNT];
+    uint8_t              frame_size;
+    uint8_t              frame[MAX_FRAME_SIZE];
+    size_t               pos = 0;
+
+    if (framing_build_frame_iov(self, payload, payload_size, iov, &frame_size)
+        != 0)
+    {
+        abort();
+    }
+    for (size_t i = 0; i < FRAMING_IOV_COUNT; i++)
+    {
+        memcpy(&frame[pos], iov[i].base, iov[i].len);
+        pos += iov[i].len;
+    }
+
+    uint8_t frame_again_size;
+    if (framing_build_frame(self, payload, payload_size, &frame_again_size) != 0
+        || frame_again_size != frame_size || pos != frame_size
+        || memcmp(frame, self->tx_frame_buffer->buffer, frame_size) != 0)
+    {
+        abort();
+    }
+}
+
+/* ========================================================================== */
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    if (size < 1)
+    {
+        return 0;
+    }
+
+    uint8_t _rx_raw_buffer[RX_RING_SIZE];
+    uint8_t _tx_frame_buffer[MAX_FRAME_SIZE];
+    uint8_t _internal_buffer[MAX_FRAME_SIZE];
+
+    struct ring_buffer rx_buffer
+        = {.buffer    = _rx_raw_buffer,
+           .size      = sizeof(_rx_raw_buffer),
+           .overwrite = false};
+    struct buffer tx_buffer
+        = {.buffer = _tx_frame_buffer, .size = sizeof(_tx_frame_buffer)};
+    struct buffer int_buffer
+        = {.buffer = _internal_buffer, .size = sizeof(_internal_buffer)};
+    ring_buffer_init(&rx_buffer);
+    buffer_init(&tx_buffer);
+    buffer_init(&int_buffer);
+
+    struct crc crc8
+        = {.crc8_polynomial      = 0x97,
+           .crc8_initial_value   = 0x00,
+           .crc8_final_xor_value = 0x00,
+           .reflect_input        = false,
+           .reflect_output       = false};
+
+    /* Keep max_payload_size within what framing_build_frame_iov accepts */
+    uint8_t max_payload = (uint8_t)(1 + data[0] % 251);
+
+    struct framing framing_instance
+        = {.crc8_calculator  = &crc8,
+           .rx_raw_buffer    = &rx_buffer,
+           .tx_frame_buffer  = &tx_buffer,
+           .parsing_buffer   = &int_buffer,
+           .start_delimiter  = 0xAA,
+           .stop_delimiter   = 0x55,
+           .max_payload_size = max_payload};
+    if (framing_init(&framing_instance) != 0)
+    {
+        abort();
+    }
+
+    size_t pos = 1;
+    while (pos < size)
+    {
+        size_t chunk = size - pos;
+        if (chunk > RX_RING_SIZE - 1)
+        {
+            chunk = RX_RING_SIZE - 1;
+        }
+        ring_buffer_push(&rx_buffer, &data[pos], chunk);
+        pos += chunk;
+
+        int8_t status;
+        while ((status = framing_process_incoming_data(&framing_instance))
+               != -ENODATA)
+        {
+            if (status != 0)
+            {
+                continue;
+            }
+            uint8_t payload[255];
+            uint8_t payload_size = 0;
+            if (framing_retrieve_payload(
+                    &framing_instance, payload, &payload_size)
+                    != 0
+                || payload_size == 0 || payload_size > max_payload)
+            {
+                abort();
+            }
+            check_round_trip(&framing_instance, payload, payload_size);
+        }
+    }
+    return 0;
+}
+
+/* ========================================================================== */
+
+#ifdef FRAMING_FUZZ_STANDALONE
+int main(int argc, char** argv)
+{
+    static uint8_t input[1 << 16];
+    for (int i = 1; i < argc; i++)
+    {
+        FILE* file = fopen(argv[i], "rb");
+        if (file == NULL)
+        {
+            perror(argv[i]);
+            return 1;
+        }
+        size_t size = fread(input, 1, sizeof(input), file);
+        fclose(file);
+        LLVMFuzzerTestOneInput(input, size);
+    }
+    return 0;
+}
+#endif
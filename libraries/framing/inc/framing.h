@@ -4,17 +4,40 @@
 /* ========================================================================== */
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /* ========================================================================== */
 
 #include "../../buffer/inc/buffer.h"
 #include "../../crc/inc/crc.h"
+#include "../../embedded-hal/inc/timer.h"
 #include "../../inc/errno.h"
 #include "../../ring-buffer/inc/ring_buffer.h"
 
 /* ========================================================================== */
 
+/* Size internal arrays and the caller's segment array: must stay macros. A
+ * const object is not a compile-time constant expression usable as an array
+ * dimension in C. */
+#define FRAMING_HEADER_SIZE  2 /* [START][LENGTH] */
+#define FRAMING_TRAILER_SIZE 2 /* [STOP][CRC8] */
+#define FRAMING_IOV_COUNT    3 /* Header, payload and trailer segments */
+
+/*
+ * Statistics are compiled in by default. Define FRAMING_STATS_ENABLED to 0
+ * (e.g. -DFRAMING_STATS_ENABLED=0) to remove the counters and their cost.
+ */
+#ifndef FRAMING_STATS_ENABLED
+#define FRAMING_STATS_ENABLED 1
+#endif
+
+/* Parse latency histogram: bucket 0 counts latency 0, bucket n counts
+ * [2^(n-1), 2^n) timestamp units, the last bucket everything above. */
+#define FRAMING_LATENCY_BUCKETS 8
+
+/* ========================================================================== */
+
 /**
  * @brief Frame parser internal states.
  */
@@ -29,6 +52,54 @@ enum framing_state
     FRAMING_ERROR_STATE
 };
 
+/**
+ * @brief Timestamp source for parse latency statistics, e.g. a millisecond
+ * system tick or a free-running timer counter. Must be monotonic; wrap-around
+ * is handled.
+ * @return uint32_t Current time, in any unit.
+ */
+typedef uint32_t (*framing_timestamp_t)(void);
+
+/**
+ * struct framing_stats - Per-instance link quality counters
+ * @frames_ok: Frames received with a valid CRC
+ * @crc_errors: Complete frames dropped because of a CRC mismatch
+ * @invalid_length: Frames dropped because the length byte was 0 or larger
+ * than max_payload_size
+ * @missing_stop: Frames dropped because the stop delimiter was not found
+ * where expected
+ * @discarded_bytes: Bytes discarded while hunting for a start delimiter
+ * @timeouts: Partial frames aborted after an inter-byte gap
+ * @latency_histogram: Time from start delimiter to valid CRC, per bucket (see
+ * FRAMING_LATENCY_BUCKETS). Only updated when a timestamp source is set.
+ *
+ * 32-bit counters; unlike lost_frames, each failure reason is counted apart.
+ */
+struct framing_stats
+{
+    uint32_t frames_ok;
+    uint32_t crc_errors;
+    uint32_t invalid_length;
+    uint32_t missing_stop;
+    uint32_t discarded_bytes;
+    uint32_t timeouts;
+    uint32_t latency_histogram[FRAMING_LATENCY_BUCKETS];
+};
+
+/**
+ * struct framing_iovec - One contiguous segment of an outgoing frame
+ * @base: Pointer to the first byte of the segment
+ * @len: Number of bytes in the segment
+ *
+ * Filled by framing_build_frame_iov(). Transmitting the segments in order
+ * yields the same bytes framing_build_frame() writes into tx_frame_buffer.
+ */
+struct framing_iovec
+{
+    const uint8_t* base;
+    size_t         len;
+};
+
 /**
  * struct framing - Frame parser and builder for serial protocols
  * @crc8_calculator: Pointer to CRC calculator instance
@@ -38,10 +109,23 @@ enum framing_state
  * @start_delimiter: Start delimiter byte value
  * @stop_delimiter: Stop delimiter byte value
  * @max_payload_size: Maximum allowed payload size
- * @lost_frames: Count of lost frames due to errors (read-only)
+ * @get_timestamp: Optional timestamp source for the parse latency histogram
+ * (NULL disables it)
+ * @inter_byte_timer: Optional timer aborting partial frames (NULL disables it)
+ * @inter_byte_timeout_ms: Longest gap allowed between two bytes of a frame
+ * @lost_frames: Count of lost frames due to CRC errors (read-only, wraps)
  *
  * State machine based frame parser supporting delimited frames with CRC-8.
  * Frame format: [START][LENGTH][PAYLOAD...][STOP][CRC8]
+ *
+ * Without @inter_byte_timer, a truncated frame keeps the parser waiting for
+ * the missing bytes, and the start of the next frame is swallowed as payload.
+ * With it, the parser re-arms the timer on every byte of a frame. If it
+ * expires while the RX ring buffer is empty (the line really went silent, as
+ * opposed to the main loop falling behind), the next call to
+ * framing_process_incoming_data() drops the partial frame before reading new
+ * bytes. The timer callback is owned by the framing instance.
+ *
  * Configure public fields before calling framing_init().
  */
 struct framing
@@ -54,6 +138,9 @@ struct framing
     const uint8_t             start_delimiter;
     const uint8_t             stop_delimiter;
     const uint8_t             max_payload_size;
+    const framing_timestamp_t get_timestamp;
+    const struct timer* const inter_byte_timer;
+    const uint16_t            inter_byte_timeout_ms;
 
     /* public: read-only diagnostic field */
     uint8_t lost_frames;
@@ -63,6 +150,13 @@ struct framing
     uint8_t            payload_size;
     enum framing_state current_state;
     bool               was_initialized;
+    volatile bool      inter_byte_expired;
+    uint8_t            tx_header[FRAMING_HEADER_SIZE];
+    uint8_t            tx_trailer[FRAMING_TRAILER_SIZE];
+#if FRAMING_STATS_ENABLED
+    struct framing_stats stats;
+    uint32_t             frame_start_time;
+#endif
 };
 
 /* ========================================================================== */
@@ -70,7 +164,9 @@ struct framing
 /**
  * @brief Initialize the framing instance.
  * @param self Pointer to the framing instance with public fields configured.
- * @return 0 on success, -EFAULT if self or any required pointer is NULL.
+ * @return 0 on success, -EFAULT if self or any required pointer is NULL,
+ * -EINVAL if inter_byte_timer is set with a zero inter_byte_timeout_ms, or
+ * the error returned by the timer.
  */
 int8_t framing_init(struct framing* self);
 
@@ -93,12 +189,42 @@ int8_t framing_build_frame(
 
 /* ========================================================================== */
 
+/**
+ * @brief Build a frame as a scatter-gather list, without copying the payload.
+ *
+ * Header and trailer are written to small storage inside the framing
+ * instance; the payload segment references the caller's buffer directly. The
+ * CRC is computed in a single pass over header, payload and stop delimiter.
+ * The payload buffer must remain unchanged until the frame is transmitted, and
+ * the segments are only valid until the next call on the same instance.
+ *
+ * @param self Pointer to the framing instance.
+ * @param payload Pointer to the payload data to be framed.
+ * @param payload_size Size of the payload data (1..max_payload_size).
+ * @param iov Array of FRAMING_IOV_COUNT segments to fill (header, payload,
+ * trailer), to be transmitted in order.
+ * @param frame_size Pointer to store the total size of the frame.
+ * @return 0 on success, -EFAULT if any pointer is NULL, -EPERM if not
+ * initialized, -EINVAL if payload_size is 0, exceeds max_payload_size or the
+ * frame size would not fit in frame_size.
+ */
+int8_t framing_build_frame_iov(
+    struct framing*      self,
+    const uint8_t*       payload,
+    uint8_t              payload_size,
+    struct framing_iovec iov[FRAMING_IOV_COUNT],
+    uint8_t*             frame_size);
+
+/* ========================================================================== */
+
 /**
  * @brief Process one byte from the RX buffer through the frame parser state
  * machine.
  * @param self Pointer to the framing instance.
  * @return 0 if a complete frame was parsed (call framing_retrieve_payload
  * next), -EAGAIN if more data is needed, -ENODATA if RX buffer is empty,
+ *         -EILSEQ if a frame failed the CRC check, -ETIMEDOUT if a partial
+ *         frame was dropped after an inter-byte gap (no byte consumed),
  *         -EFAULT if self is NULL, -EPERM if not initialized.
  */
 int8_t framing_process_incoming_data(struct framing* self);
@@ -119,4 +245,26 @@ int8_t framing_retrieve_payload(
 
 /* ========================================================================== */
 
+/**
+ * @brief Get a snapshot of the instance statistics.
+ * @param self Pointer to the framing instance.
+ * @param stats Pointer to store the statistics.
+ * @return 0 on success, -EFAULT if any pointer is NULL, -EPERM if not
+ * initialized, -ENOTSUP if built with FRAMING_STATS_ENABLED set to 0.
+ */
+int8_t framing_get_stats(
+    const struct framing* self, struct framing_stats* stats);
+
+/* ========================================================================== */
+
+/**
+ * @brief Reset all statistics counters to zero.
+ * @param self Pointer to the framing instance.
+ * @return 0 on success, -EFAULT if self is NULL, -EPERM if not initialized,
+ * -ENOTSUP if built with FRAMING_STATS_ENABLED set to 0.
+ */
+int8_t framing_reset_stats(struct framing* self);
+
+/* ========================================================================== */
+
 #endif /* FRAMING_H */
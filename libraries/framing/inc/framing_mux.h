@@ -0,0 +1,114 @@
+#ifndef FRAMING_MUX_H
+#define FRAMING_MUX_H
+
+/* ========================================================================== */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ========================================================================== */
+
+#include "../../inc/errno.h"
+#include "framing.h"
+
+/* ========================================================================== */
+
+/* One bit per channel in the pending/ready masks (uint32_t). */
+#define FRAMING_MUX_MAX_CHANNELS 32
+
+/* ========================================================================== */
+
+/**
+ * struct framing_mux - Multiplexer servicing several framing instances
+ * @channels: Array of pointers to already initialized framing instances
+ * @channel_count: Number of entries in @channels (1..FRAMING_MUX_MAX_CHANNELS)
+ * @byte_budget: Maximum bytes consumed per channel on each poll call
+ *
+ * Services one framing instance per serial link from a single poll call. The
+ * RX path of each link pushes bytes into the channel's ring buffer and then
+ * calls framing_mux_notify(), which marks the channel as pending. Poll only
+ * visits pending channels, in round-robin order, and consumes at most
+ * @byte_budget bytes from each, so idle links cost nothing and a busy link
+ * cannot starve the others. Channels holding a complete frame are reported
+ * through a bitmask and are not serviced again until the frame is retrieved.
+ *
+ * If framing_mux_notify() is called from an ISR on a target where a 32-bit
+ * read-modify-write is not atomic, define CRITICAL_HEADER (see
+ * embedded-hal/inc/critical.h) so poll updates the pending mask with
+ * interrupts masked.
+ *
+ * Configure public fields before calling framing_mux_init().
+ */
+struct framing_mux
+{
+    /* public: user-configurable fields - set before init (const after init) */
+    struct framing* const* const channels;
+    const uint8_t                channel_count;
+    const uint8_t                byte_budget;
+
+    /* private: internal state - do not access directly */
+    volatile uint32_t pending_mask;
+    uint32_t          ready_mask;
+    uint8_t           next_channel;
+    bool              was_initialized;
+};
+
+/* ========================================================================== */
+
+/**
+ * @brief Initialize the framing multiplexer. All channels start as pending so
+ * bytes received before init are serviced on the first poll.
+ * @param self Pointer to the multiplexer with public fields configured.
+ * @return 0 on success, -EFAULT if self, channels or any channel is NULL,
+ * -EINVAL if channel_count or byte_budget is out of range, -EPERM if any
+ * channel is not initialized.
+ */
+int8_t framing_mux_init(struct framing_mux* self);
+
+/* ========================================================================== */
+
+/**
+ * @brief Mark a channel as having new RX data. Safe to call from the RX ISR
+ * right after pushing into the channel's ring buffer.
+ * @param self Pointer to the multiplexer.
+ * @param channel Channel index.
+ * @return 0 on success, -EFAULT if self is NULL, -EPERM if not initialized,
+ * -EINVAL if channel is out of range.
+ */
+int8_t framing_mux_notify(struct framing_mux* self, uint8_t channel);
+
+/* ========================================================================== */
+
+/**
+ * @brief Service pending channels with bounded work (at most byte_budget
+ * bytes per channel), starting one channel further on every call.
+ * @param self Pointer to the multiplexer.
+ * @param ready_mask Pointer to store the bitmask of channels holding a
+ * complete frame (bit n set: retrieve channel n).
+ * @return 0 if at least one channel has a frame ready, -EAGAIN if none,
+ * -EFAULT if any pointer is NULL, -EPERM if not initialized.
+ */
+int8_t framing_mux_poll(struct framing_mux* self, uint32_t* ready_mask);
+
+/* ========================================================================== */
+
+/**
+ * @brief Retrieve the payload of a channel reported ready by framing_mux_poll
+ * and resume servicing that channel.
+ * @param self Pointer to the multiplexer.
+ * @param channel Channel index.
+ * @param payload Pointer to store the retrieved payload.
+ * @param payload_size Pointer to store the size of the retrieved payload.
+ * @return 0 on success, -EFAULT if any pointer is NULL, -EPERM if not
+ * initialized, -EINVAL if channel is out of range, -ENODATA if the channel
+ * has no complete frame.
+ */
+int8_t framing_mux_retrieve_payload(
+    struct framing_mux* self,
+    uint8_t             channel,
+    uint8_t*            payload,
+    uint8_t*            payload_size);
+
+/* ========================================================================== */
+
+#endif /* FRAMING_MUX_H */
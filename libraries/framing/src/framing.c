@@ -6,6 +6,14 @@
 
 /* ========================================================================== */
 
+#if FRAMING_STATS_ENABLED
+#define FRAMING_STAT_INC(self, counter) ((self)->stats.counter += 1)
+#else
+#define FRAMING_STAT_INC(self, counter) ((void)0)
+#endif
+
+/* ========================================================================== */
+
 /* PRIVATE */
 
 /* ========================================================================== */
@@ -43,8 +51,15 @@ static enum framing_state start_state_handler(struct framing* self, uint8_t byte
 {
     if (byte != self->start_delimiter)
     {
+        FRAMING_STAT_INC(self, discarded_bytes);
         return FRAMING_START_STATE;
     }
+#if FRAMING_STATS_ENABLED
+    if (self->get_timestamp != NULL)
+    {
+        self->frame_start_time = self->get_timestamp();
+    }
+#endif
     buffer_reset_index(self->parsing_buffer);
     buffer_push(self->parsing_buffer, byte);
     return FRAMING_LENGTH_STATE;
@@ -55,6 +70,7 @@ static enum framing_state length_state_handler(
 {
     if (byte == 0 || byte > self->max_payload_size)
     {
+        FRAMING_STAT_INC(self, invalid_length);
         return FRAMING_START_STATE;  // Invalid length, reset FSM
     }
     self->payload_size = byte;
@@ -81,6 +97,7 @@ static enum framing_state stop_state_handler(struct framing* self, uint8_t byte)
 {
     if (byte != self->stop_delimiter)
     {
+        FRAMING_STAT_INC(self, missing_stop);
         return FRAMING_START_STATE;  // Invalid frame, reset FSM
     }
     buffer_push(self->parsing_buffer, byte);
@@ -102,6 +119,68 @@ static enum framing_state crc_state_handler(struct framing* self, uint8_t byte)
     return FRAMING_ERROR_STATE;
 }
 
+static bool _is_partial(enum framing_state state)
+{
+    return state >= FRAMING_LENGTH_STATE && state <= FRAMING_CRC_STATE;
+}
+
+// Runs in the timer's context (usually an ISR). Bytes still waiting in the RX
+// buffer mean the main loop is behind, not that the line went silent: leave
+// the frame alone, consuming the next byte re-arms the timer.
+static void _inter_byte_timeout_callback(void* context)
+{
+    struct framing* self = context;
+    bool            empty;
+    if (ring_buffer_is_empty(self->rx_raw_buffer, &empty) == 0 && empty)
+    {
+        self->inter_byte_expired = true;
+    }
+}
+
+static int8_t _init_inter_byte_timer(struct framing* self)
+{
+    const struct timer* timer = self->inter_byte_timer;
+    if (timer->ops == NULL || timer->ops->set_timeout_ms == NULL
+        || timer->ops->reset_timeout == NULL
+        || timer->ops->deactivate_timeout == NULL
+        || timer->ops->set_timeout_callback == NULL)
+    {
+        return -EFAULT;
+    }
+    if (self->inter_byte_timeout_ms == 0)
+    {
+        return -EINVAL;
+    }
+    int8_t status = timer->ops->set_timeout_callback(
+        timer, _inter_byte_timeout_callback, self);
+    if (status == 0)
+    {
+        status = timer->ops->set_timeout_ms(timer, self->inter_byte_timeout_ms);
+    }
+    timer->ops->deactivate_timeout(timer);
+    return status;
+}
+
+#if FRAMING_STATS_ENABLED
+static void _record_frame_ok(struct framing* self)
+{
+    self->stats.frames_ok += 1;
+    if (self->get_timestamp == NULL)
+    {
+        return;
+    }
+    // Unsigned subtraction stays correct across a timestamp wrap-around
+    uint32_t latency = self->get_timestamp() - self->frame_start_time;
+    uint8_t  bucket  = 0;
+    while (latency != 0 && bucket < FRAMING_LATENCY_BUCKETS - 1)
+    {
+        latency >>= 1;
+        bucket += 1;
+    }
+    self->stats.latency_histogram[bucket] += 1;
+}
+#endif
+
 /* ========================================================================== */
 
 /* PUBLIC */
@@ -116,7 +195,19 @@ int8_t framing_init(struct framing* self)
     {
         return -EFAULT;
     }
-    self->current_state   = FRAMING_START_STATE;
+    self->current_state      = FRAMING_START_STATE;
+    self->inter_byte_expired = false;
+    if (self->inter_byte_timer != NULL)
+    {
+        int8_t status = _init_inter_byte_timer(self);
+        if (status != 0)
+        {
+            return status;
+        }
+    }
+#if FRAMING_STATS_ENABLED
+    memset(&self->stats, 0, sizeof(self->stats));
+#endif
     self->was_initialized = true;
     return 0;
 }
@@ -133,6 +224,18 @@ int8_t framing_process_incoming_data(struct framing* self)
     {
         return -EPERM;
     }
+    if (self->inter_byte_expired)
+    {
+        self->inter_byte_expired = false;
+        if (_is_partial(self->current_state))
+        {
+            self->inter_byte_timer->ops->deactivate_timeout(
+                self->inter_byte_timer);
+            self->current_state = FRAMING_START_STATE;
+            FRAMING_STAT_INC(self, timeouts);
+            return -ETIMEDOUT;
+        }
+    }
     uint8_t byte;
     // Retrieve next byte from RX raw buffer
     if (ring_buffer_pop(self->rx_raw_buffer, &byte, 1))
@@ -140,15 +243,35 @@ int8_t framing_process_incoming_data(struct framing* self)
         return -ENODATA;
     }
     // Process byte through state machine
+    enum framing_state previous_state = self->current_state;
     self->current_state = state_table[self->current_state].handler(self, byte);
+    if (self->inter_byte_timer != NULL)
+    {
+        const struct timer* timer = self->inter_byte_timer;
+        if (_is_partial(self->current_state))
+        {
+            timer->ops->reset_timeout(timer);
+            // A byte was just consumed, so an expiry flagged since the check
+            // above raced with it and does not denote a gap
+            self->inter_byte_expired = false;
+        }
+        else if (_is_partial(previous_state))
+        {
+            timer->ops->deactivate_timeout(timer);
+        }
+    }
     if (self->current_state == FRAMING_COMPLETE_STATE)
     {
         self->frame_available = true;
+#if FRAMING_STATS_ENABLED
+        _record_frame_ok(self);
+#endif
         return 0;
     }
     else if (self->current_state == FRAMING_ERROR_STATE)
     {
         self->lost_frames += 1;
+        FRAMING_STAT_INC(self, crc_errors);
         self->current_state = FRAMING_START_STATE;  // Resets FSM upon erroneous
                                                     // CRC
         return -EILSEQ;
@@ -238,3 +361,91 @@ int8_t framing_build_frame(
 }
 
 /* ========================================================================== */
+
+int8_t framing_build_frame_iov(
+    struct framing*      self,
+    const uint8_t*       payload,
+    uint8_t              payload_size,
+    struct framing_iovec iov[FRAMING_IOV_COUNT],
+    uint8_t*             frame_size)
+{
+    if (self == NULL || payload == NULL || iov == NULL || frame_size == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    if (payload_size == 0 || payload_size > self->max_payload_size
+        || payload_size > UINT8_MAX - FRAMING_HEADER_SIZE - FRAMING_TRAILER_SIZE)
+    {
+        return -EINVAL;
+    }
+    self->tx_header[0]  = self->start_delimiter;
+    self->tx_header[1]  = payload_size;
+    self->tx_trailer[0] = self->stop_delimiter;
+
+    // Single CRC pass over [START][LENGTH][PAYLOAD...][STOP]
+    uint8_t crc;
+    crc8_begin(self->crc8_calculator, &crc);
+    crc8_update(
+        self->crc8_calculator, &crc, self->tx_header, FRAMING_HEADER_SIZE);
+    crc8_update(self->crc8_calculator, &crc, payload, payload_size);
+    crc8_update(self->crc8_calculator, &crc, self->tx_trailer, 1);
+    crc8_finish(self->crc8_calculator, crc, &self->tx_trailer[1]);
+
+    iov[0].base = self->tx_header;
+    iov[0].len  = FRAMING_HEADER_SIZE;
+    iov[1].base = payload;
+    iov[1].len  = payload_size;
+    iov[2].base = self->tx_trailer;
+    iov[2].len  = FRAMING_TRAILER_SIZE;
+
+    *frame_size = (uint8_t)(FRAMING_HEADER_SIZE + payload_size
+                            + FRAMING_TRAILER_SIZE);
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t framing_get_stats(
+    const struct framing* self, struct framing_stats* stats)
+{
+    if (self == NULL || stats == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+#if FRAMING_STATS_ENABLED
+    *stats = self->stats;
+    return 0;
+#else
+    return -ENOTSUP;
+#endif
+}
+
+/* ========================================================================== */
+
+int8_t framing_reset_stats(struct framing* self)
+{
+    if (self == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+#if FRAMING_STATS_ENABLED
+    memset(&self->stats, 0, sizeof(self->stats));
+    return 0;
+#else
+    return -ENOTSUP;
+#endif
+}
+
+/* ========================================================================== */
@@ -0,0 +1,193 @@
+#include "../inc/framing_mux.h"
+
+/* ========================================================================== */
+
+#ifdef CRITICAL_HEADER
+#include "../../embedded-hal/inc/critical.h"
+#define MUX_ATOMIC(code) CRITICAL_SECTION(code)
+#else
+#define MUX_ATOMIC(code) \
+    do                   \
+    {                    \
+        code             \
+    } while (0)
+#endif
+
+/* ========================================================================== */
+
+/* PRIVATE */
+
+/* ========================================================================== */
+
+/**
+ * @brief Feed up to byte_budget bytes of one channel through its parser.
+ * @return true if the channel may still hold unprocessed bytes (budget
+ * exhausted or frame completed), false if its RX buffer was drained.
+ */
+static bool _service_channel(struct framing_mux* self, uint8_t channel)
+{
+    struct framing* link = self->channels[channel];
+    for (uint8_t i = 0; i < self->byte_budget; i++)
+    {
+        int8_t status = framing_process_incoming_data(link);
+        if (status == 0)
+        {
+            self->ready_mask |= (uint32_t)1 << channel;
+            return true;
+        }
+        if (status == -ENODATA)
+        {
+            return false;
+        }
+        /* -EAGAIN: need more bytes, -EILSEQ/-ETIMEDOUT: frame lost, parser
+         * reset */
+    }
+    return true;
+}
+
+/* ========================================================================== */
+
+/* PUBLIC */
+
+/* ========================================================================== */
+
+int8_t framing_mux_init(struct framing_mux* self)
+{
+    if (self == NULL || self->channels == NULL)
+    {
+        return -EFAULT;
+    }
+    if (self->channel_count == 0
+        || self->channel_count > FRAMING_MUX_MAX_CHANNELS
+        || self->byte_budget == 0)
+    {
+        return -EINVAL;
+    }
+    for (uint8_t i = 0; i < self->channel_count; i++)
+    {
+        if (self->channels[i] == NULL)
+        {
+            return -EFAULT;
+        }
+        if (!self->channels[i]->was_initialized)
+        {
+            return -EPERM;
+        }
+    }
+    self->pending_mask = (self->channel_count == FRAMING_MUX_MAX_CHANNELS)
+                             ? UINT32_MAX
+                             : (((uint32_t)1 << self->channel_count) - 1);
+    self->ready_mask      = 0;
+    self->next_channel    = 0;
+    self->was_initialized = true;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t framing_mux_notify(struct framing_mux* self, uint8_t channel)
+{
+    if (self == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    if (channel >= self->channel_count)
+    {
+        return -EINVAL;
+    }
+    self->pending_mask |= (uint32_t)1 << channel;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t framing_mux_poll(struct framing_mux* self, uint32_t* ready_mask)
+{
+    if (self == NULL || ready_mask == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+
+    // Channels holding an unretrieved frame are left alone until retrieval
+    uint32_t to_service    = self->pending_mask & ~self->ready_mask;
+    uint32_t still_pending = 0;
+    uint8_t  channel       = self->next_channel;
+
+    // Clear the bits being serviced first: a notify arriving while a channel
+    // is serviced sets its bit again, so no RX data is ever left stranded
+    MUX_ATOMIC({ self->pending_mask &= ~to_service; });
+
+    while (to_service != 0)
+    {
+        uint32_t bit = (uint32_t)1 << channel;
+        if (to_service & bit)
+        {
+            to_service &= ~bit;
+            if (_service_channel(self, channel))
+            {
+                still_pending |= bit;
+            }
+        }
+        channel += 1;
+        if (channel >= self->channel_count)
+        {
+            channel = 0;
+        }
+    }
+
+    if (still_pending != 0)
+    {
+        MUX_ATOMIC({ self->pending_mask |= still_pending; });
+    }
+
+    // Rotate the starting channel so no link is always serviced first
+    self->next_channel += 1;
+    if (self->next_channel >= self->channel_count)
+    {
+        self->next_channel = 0;
+    }
+
+    *ready_mask = self->ready_mask;
+    return (self->ready_mask != 0) ? 0 : -EAGAIN;
+}
+
+/* ========================================================================== */
+
+int8_t framing_mux_retrieve_payload(
+    struct framing_mux* self,
+    uint8_t             channel,
+    uint8_t*            payload,
+    uint8_t*            payload_size)
+{
+    if (self == NULL || payload == NULL || payload_size == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    if (channel >= self->channel_count)
+    {
+        return -EINVAL;
+    }
+    uint32_t bit = (uint32_t)1 << channel;
+    if (!(self->ready_mask & bit))
+    {
+        return -ENODATA;
+    }
+    int8_t status = framing_retrieve_payload(
+        self->channels[channel], payload, payload_size);
+    self->ready_mask &= ~bit;
+    return status;
+}
+
+/* ========================================================================== */
@@ -5,6 +5,7 @@
 #include "unity.h"
 
 #include <stdio.h>
+#include <string.h>
 
 /* ========================================================================== */
 
@@ -414,3 +415,175 @@ void test_framing_retrieve_short_payload_no_error(void)
 }
 
 /* ========================================================================== */
+
+void test_build_frame_iov_matches_build_frame(void)
+{
+    uint8_t _rx_raw_buffer[128]   = {0};
+    uint8_t _tx_frame_buffer[128] = {0};
+    uint8_t _internal_buffer[128] = {0};
+
+    struct ring_buffer rx_buffer
+        = {.buffer    = _rx_raw_buffer,
+           .size      = sizeof(_rx_raw_buffer),
+           .overwrite = false};
+    ring_buffer_init(&rx_buffer);
+
+    struct buffer tx_buffer
+        = {.buffer = _tx_frame_buffer,
+           .size   = sizeof(_tx_frame_buffer),
+           .index  = 0};
+    buffer_init(&tx_buffer);
+
+    struct buffer int_buffer
+        = {.buffer = _internal_buffer,
+           .size   = sizeof(_internal_buffer),
+           .index  = 0};
+    buffer_init(&int_buffer);
+
+    struct crc crc8
+        = {.crc8_polynomial      = 0x97,
+           .crc8_initial_value   = 0x00,
+           .crc8_final_xor_value = 0x00,
+           .reflect_input        = false,
+           .reflect_output       = false};
+
+    struct framing framing_instance
+        = {.crc8_calculator  = &crc8,
+           .rx_raw_buffer    = &rx_buffer,
+           .tx_frame_buffer  = &tx_buffer,
+           .parsing_buffer   = &int_buffer,
+           .start_delimiter  = 0xAA,
+           .stop_delimiter   = 0x55,
+           .max_payload_size = 0x04};
+
+    TEST_ASSERT_EQUAL(0, framing_init(&framing_instance));
+
+    const uint8_t payload[] = {0x01, 0x02, 0x03, 0x04};
+    const uint8_t expected[]
+        = {0xAA, 0x04, 0x01, 0x02, 0x03, 0x04, 0x55, 0x33};
+    struct framing_iovec iov[FRAMING_IOV_COUNT];
+    uint8_t              frame_size = 0;
+    TEST_ASSERT_EQUAL(
+        0,
+        framing_build_frame_iov(
+            &framing_instance, payload, sizeof(payload), iov, &frame_size));
+    TEST_ASSERT_EQUAL(sizeof(expected), frame_size);
+
+    // Payload segment must reference the caller's buffer (no copy)
+    TEST_ASSERT_TRUE(iov[1].base == payload);
+
+    uint8_t gathered[sizeof(expected)] = {0};
+    size_t  pos                        = 0;
+    for (size_t i = 0; i < FRAMING_IOV_COUNT; i++)
+    {
+        memcpy(&gathered[pos], iov[i].base, iov[i].len);
+        pos += iov[i].len;
+    }
+    TEST_ASSERT_EQUAL(frame_size, pos);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, gathered, sizeof(expected));
+
+    TEST_ASSERT_EQUAL(
+        -EINVAL,
+        framing_build_frame_iov(
+            &framing_instance, payload, 0, iov, &frame_size));
+    TEST_ASSERT_EQUAL(
+        -EINVAL,
+        framing_build_frame_iov(
+            &framing_instance, payload, 5, iov, &frame_size));
+}
+
+/* ========================================================================== */
+
+static uint32_t fake_tick = 0;
+
+static uint32_t fake_get_timestamp(void)
+{
+    fake_tick += 5;  // Each call advances time: start-to-end latency is 5
+    return fake_tick;
+}
+
+void test_framing_stats_count_each_error_kind(void)
+{
+    uint8_t _rx_raw_buffer[128]   = {0};
+    uint8_t _tx_frame_buffer[128] = {0};
+    uint8_t _internal_buffer[128] = {0};
+
+    struct ring_buffer rx_buffer
+        = {.buffer    = _rx_raw_buffer,
+           .size      = sizeof(_rx_raw_buffer),
+           .overwrite = false};
+    ring_buffer_init(&rx_buffer);
+
+    struct buffer tx_buffer
+        = {.buffer = _tx_frame_buffer,
+           .size   = sizeof(_tx_frame_buffer),
+           .index  = 0};
+    buffer_init(&tx_buffer);
+
+    struct buffer int_buffer
+        = {.buffer = _internal_buffer,
+           .size   = sizeof(_internal_buffer),
+           .index  = 0};
+    buffer_init(&int_buffer);
+
+    struct crc crc8
+        = {.crc8_polynomial      = 0x97,
+           .crc8_initial_value   = 0x00,
+           .crc8_final_xor_value = 0x00,
+           .reflect_input        = false,
+           .reflect_output       = false};
+
+    struct framing framing_instance
+        = {.crc8_calculator  = &crc8,
+           .rx_raw_buffer    = &rx_buffer,
+           .tx_frame_buffer  = &tx_buffer,
+           .parsing_buffer   = &int_buffer,
+           .start_delimiter  = 0xAA,
+           .stop_delimiter   = 0x55,
+           .max_payload_size = 0x04,
+           .get_timestamp    = fake_get_timestamp};
+
+    TEST_ASSERT_EQUAL(0, framing_init(&framing_instance));
+
+    const uint8_t stream[] = {
+        0x11, 0x22,                                      // Line noise
+        0xAA, 0x00,                                      // Invalid length
+        0xAA, 0x04, 0x01, 0x02, 0x03, 0x04, 0x66,        // Missing stop
+        0xAA, 0x04, 0x01, 0x02, 0x03, 0x04, 0x55, 0x34,  // Incorrect CRC
+        0xAA, 0x04, 0x01, 0x02, 0x03, 0x04, 0x55, 0x33,  // Valid frame
+    };
+    ring_buffer_push(framing_instance.rx_raw_buffer, stream, sizeof(stream));
+
+    uint8_t payload[64]  = {0};
+    uint8_t payload_size = 0;
+    int8_t  status;
+    while ((status = framing_process_incoming_data(&framing_instance))
+           != -ENODATA)
+    {
+        if (status == 0)
+        {
+            TEST_ASSERT_EQUAL(
+                0,
+                framing_retrieve_payload(
+                    &framing_instance, payload, &payload_size));
+        }
+    }
+
+    struct framing_stats stats;
+    TEST_ASSERT_EQUAL(0, framing_get_stats(&framing_instance, &stats));
+    TEST_ASSERT_EQUAL_UINT32(1, stats.frames_ok);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.crc_errors);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.invalid_length);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.missing_stop);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.discarded_bytes);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.latency_histogram[3]);  // [4, 8)
+    TEST_ASSERT_EQUAL(1, framing_instance.lost_frames);
+
+    TEST_ASSERT_EQUAL(0, framing_reset_stats(&framing_instance));
+    TEST_ASSERT_EQUAL(0, framing_get_stats(&framing_instance, &stats));
+    TEST_ASSERT_EQUAL_UINT32(0, stats.frames_ok);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.latency_histogram[3]);
+    TEST_ASSERT_EQUAL(-EFAULT, framing_get_stats(&framing_instance, NULL));
+}
+
+/* ========================================================================== */
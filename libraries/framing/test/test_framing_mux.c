@@ -0,0 +1,202 @@
+#include "buffer.h"
+#include "crc.h"
+#include "framing.h"
+#include "framing_mux.h"
+#include "ring_buffer.h"
+#include "unity.h"
+
+/* ========================================================================== */
+
+#define CHANNEL_COUNT 3
+
+static uint8_t _rx_raw_buffer[CHANNEL_COUNT][64];
+static uint8_t _tx_frame_buffer[CHANNEL_COUNT][16];
+static uint8_t _internal_buffer[CHANNEL_COUNT][16];
+
+#define RX_BUFFER(i)                          \
+    {.buffer    = _rx_raw_buffer[i],          \
+     .size      = sizeof(_rx_raw_buffer[i]),  \
+     .overwrite = false}
+#define TX_BUFFER(i) \
+    {.buffer = _tx_frame_buffer[i], .size = sizeof(_tx_frame_buffer[i])}
+#define INT_BUFFER(i) \
+    {.buffer = _internal_buffer[i], .size = sizeof(_internal_buffer[i])}
+
+static struct ring_buffer rx_buffer[CHANNEL_COUNT]
+    = {RX_BUFFER(0), RX_BUFFER(1), RX_BUFFER(2)};
+static struct buffer tx_buffer[CHANNEL_COUNT]
+    = {TX_BUFFER(0), TX_BUFFER(1), TX_BUFFER(2)};
+static struct buffer int_buffer[CHANNEL_COUNT]
+    = {INT_BUFFER(0), INT_BUFFER(1), INT_BUFFER(2)};
+
+static struct crc crc8
+    = {.crc8_polynomial      = 0x97,
+       .crc8_initial_value   = 0x00,
+       .crc8_final_xor_value = 0x00,
+       .reflect_input        = false,
+       .reflect_output       = false};
+
+#define LINK(i)                           \
+    {.crc8_calculator  = &crc8,           \
+     .rx_raw_buffer    = &rx_buffer[i],   \
+     .tx_frame_buffer  = &tx_buffer[i],   \
+     .parsing_buffer   = &int_buffer[i],  \
+     .start_delimiter  = 0xAA,            \
+     .stop_delimiter   = 0x55,            \
+     .max_payload_size = 0x04}
+
+static struct framing  link[CHANNEL_COUNT] = {LINK(0), LINK(1), LINK(2)};
+static struct framing* channels[CHANNEL_COUNT]
+    = {&link[0], &link[1], &link[2]};
+
+static const uint8_t frame_a[]
+    = {0xAA, 0x04, 0x01, 0x02, 0x03, 0x04, 0x55, 0x33};
+static const uint8_t frame_b[] = {0xAA, 0x02, 0x01, 0x02, 0x55, 0xE0};
+
+/* ========================================================================== */
+
+void setUp(void)
+{
+    for (size_t i = 0; i < CHANNEL_COUNT; i++)
+    {
+        ring_buffer_init(&rx_buffer[i]);
+        buffer_init(&tx_buffer[i]);
+        buffer_init(&int_buffer[i]);
+        framing_init(&link[i]);
+    }
+}
+
+void tearDown(void)
+{
+}
+
+/* ========================================================================== */
+
+void test_framing_mux_init_errors(void)
+{
+    struct framing_mux no_channels
+        = {.channels = NULL, .channel_count = 1, .byte_budget = 8};
+    TEST_ASSERT_EQUAL(-EFAULT, framing_mux_init(&no_channels));
+
+    struct framing_mux no_budget
+        = {.channels      = channels,
+           .channel_count = CHANNEL_COUNT,
+           .byte_budget   = 0};
+    TEST_ASSERT_EQUAL(-EINVAL, framing_mux_init(&no_budget));
+
+    struct framing_mux too_many
+        = {.channels      = channels,
+           .channel_count = FRAMING_MUX_MAX_CHANNELS + 1,
+           .byte_budget   = 8};
+    TEST_ASSERT_EQUAL(-EINVAL, framing_mux_init(&too_many));
+
+    struct framing_mux not_initialized
+        = {.channels = channels, .channel_count = 1, .byte_budget = 8};
+    uint32_t ready_mask;
+    TEST_ASSERT_EQUAL(-EPERM, framing_mux_poll(&not_initialized, &ready_mask));
+}
+
+/* ========================================================================== */
+
+void test_framing_mux_reports_ready_channels(void)
+{
+    struct framing_mux mux
+        = {.channels      = channels,
+           .channel_count = CHANNEL_COUNT,
+           .byte_budget   = 16};
+    TEST_ASSERT_EQUAL(0, framing_mux_init(&mux));
+
+    uint32_t ready_mask = 0;
+    TEST_ASSERT_EQUAL(-EAGAIN, framing_mux_poll(&mux, &ready_mask));
+    TEST_ASSERT_EQUAL(0, ready_mask);
+
+    ring_buffer_push(&rx_buffer[0], frame_a, sizeof(frame_a));
+    TEST_ASSERT_EQUAL(0, framing_mux_notify(&mux, 0));
+    ring_buffer_push(&rx_buffer[2], frame_b, sizeof(frame_b));
+    TEST_ASSERT_EQUAL(0, framing_mux_notify(&mux, 2));
+    TEST_ASSERT_EQUAL(-EINVAL, framing_mux_notify(&mux, CHANNEL_COUNT));
+
+    TEST_ASSERT_EQUAL(0, framing_mux_poll(&mux, &ready_mask));
+    TEST_ASSERT_EQUAL(0x05, ready_mask);
+
+    uint8_t payload[4]   = {0};
+    uint8_t payload_size = 0;
+    TEST_ASSERT_EQUAL(
+        -ENODATA,
+        framing_mux_retrieve_payload(&mux, 1, payload, &payload_size));
+    TEST_ASSERT_EQUAL(
+        0, framing_mux_retrieve_payload(&mux, 2, payload, &payload_size));
+    TEST_ASSERT_EQUAL(2, payload_size);
+    TEST_ASSERT_EQUAL(0x01, payload[0]);
+    TEST_ASSERT_EQUAL(0x02, payload[1]);
+    TEST_ASSERT_EQUAL(
+        0, framing_mux_retrieve_payload(&mux, 0, payload, &payload_size));
+    TEST_ASSERT_EQUAL(4, payload_size);
+    TEST_ASSERT_EQUAL(0x04, payload[3]);
+
+    TEST_ASSERT_EQUAL(-EAGAIN, framing_mux_poll(&mux, &ready_mask));
+    TEST_ASSERT_EQUAL(0, ready_mask);
+}
+
+/* ========================================================================== */
+
+void test_framing_mux_byte_budget_bounds_work(void)
+{
+    struct framing_mux mux
+        = {.channels      = channels,
+           .channel_count = CHANNEL_COUNT,
+           .byte_budget   = 3};
+    TEST_ASSERT_EQUAL(0, framing_mux_init(&mux));
+
+    ring_buffer_push(&rx_buffer[1], frame_a, sizeof(frame_a));
+    framing_mux_notify(&mux, 1);
+
+    size_t   count      = 0;
+    uint32_t ready_mask = 0;
+    TEST_ASSERT_EQUAL(-EAGAIN, framing_mux_poll(&mux, &ready_mask));
+    ring_buffer_count(&rx_buffer[1], &count);
+    TEST_ASSERT_EQUAL(sizeof(frame_a) - 3, count);
+
+    TEST_ASSERT_EQUAL(-EAGAIN, framing_mux_poll(&mux, &ready_mask));
+    ring_buffer_count(&rx_buffer[1], &count);
+    TEST_ASSERT_EQUAL(sizeof(frame_a) - 6, count);
+
+    // Channel stays pending without a new notify until it is drained
+    TEST_ASSERT_EQUAL(0, framing_mux_poll(&mux, &ready_mask));
+    TEST_ASSERT_EQUAL(0x02, ready_mask);
+}
+
+/* ========================================================================== */
+
+void test_framing_mux_ready_channel_is_not_serviced(void)
+{
+    struct framing_mux mux
+        = {.channels      = channels,
+           .channel_count = CHANNEL_COUNT,
+           .byte_budget   = 32};
+    TEST_ASSERT_EQUAL(0, framing_mux_init(&mux));
+
+    ring_buffer_push(&rx_buffer[0], frame_b, sizeof(frame_b));
+    ring_buffer_push(&rx_buffer[0], frame_a, sizeof(frame_a));
+    framing_mux_notify(&mux, 0);
+
+    size_t   count      = 0;
+    uint32_t ready_mask = 0;
+    TEST_ASSERT_EQUAL(0, framing_mux_poll(&mux, &ready_mask));
+    TEST_ASSERT_EQUAL(0, framing_mux_poll(&mux, &ready_mask));
+    ring_buffer_count(&rx_buffer[0], &count);
+    TEST_ASSERT_EQUAL(sizeof(frame_a), count);
+
+    uint8_t payload[4]   = {0};
+    uint8_t payload_size = 0;
+    TEST_ASSERT_EQUAL(
+        0, framing_mux_retrieve_payload(&mux, 0, payload, &payload_size));
+    TEST_ASSERT_EQUAL(2, payload_size);
+
+    TEST_ASSERT_EQUAL(0, framing_mux_poll(&mux, &ready_mask));
+    TEST_ASSERT_EQUAL(
+        0, framing_mux_retrieve_payload(&mux, 0, payload, &payload_size));
+    TEST_ASSERT_EQUAL(4, payload_size);
+}
+
+/* ========================================================================== */
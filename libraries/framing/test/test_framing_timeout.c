@@ -0,0 +1,274 @@
+#include "buffer.h"
+#include "crc.h"
+#include "framing.h"
+#include "ring_buffer.h"
+#include "timer.h"
+#include "unity.h"
+
+#include <stdio.h>
+
+/* ========================================================================== */
+
+// Host simulation: one byte per millisecond on the line, a one-shot timer
+// driven by a simulated millisecond clock, and a main loop that drains the RX
+// buffer every millisecond.
+
+#define INTER_BYTE_TIMEOUT_MS 5
+#define SIM_END_MS            40
+
+static uint32_t         sim_now_ms;
+static uint32_t         sim_deadline_ms;
+static uint16_t         sim_timeout_ms;
+static bool             sim_active;
+static timer_callback_t sim_callback;
+static void*            sim_context;
+
+static int8_t sim_set_timeout_ms(const struct timer* self, uint16_t ms)
+{
+    (void)self;
+    sim_timeout_ms  = ms;
+    sim_deadline_ms = sim_now_ms + ms;
+    sim_active      = true;
+    return 0;
+}
+
+static void sim_reset_timeout(const struct timer* self)
+{
+    (void)self;
+    sim_deadline_ms = sim_now_ms + sim_timeout_ms;
+    sim_active      = true;
+}
+
+static void sim_deactivate_timeout(const struct timer* self)
+{
+    (void)self;
+    sim_active = false;
+}
+
+static int8_t sim_set_timeout_callback(
+    const struct timer* self, timer_callback_t callback, void* context)
+{
+    (void)self;
+    sim_callback = callback;
+    sim_context  = context;
+    return 0;
+}
+
+static const struct timer_ops sim_timer_ops
+    = {.set_timeout_ms       = sim_set_timeout_ms,
+       .reset_timeout        = sim_reset_timeout,
+       .deactivate_timeout   = sim_deactivate_timeout,
+       .set_timeout_callback = sim_set_timeout_callback};
+
+static struct timer sim_timer = {.id = 0, .ops = &sim_timer_ops};
+
+/**
+ * @brief Advance the simulated clock, firing the timer callback as the timer
+ * ISR would.
+ */
+static void sim_advance_to(uint32_t now_ms)
+{
+    sim_now_ms = now_ms;
+    if (sim_active && sim_now_ms >= sim_deadline_ms)
+    {
+        sim_active = false;
+        sim_callback(sim_context);
+    }
+}
+
+/* ========================================================================== */
+
+static uint8_t _rx_raw_buffer[64];
+static uint8_t _tx_frame_buffer[16];
+static uint8_t _internal_buffer[16];
+
+static struct ring_buffer rx_buffer
+    = {.buffer    = _rx_raw_buffer,
+       .size      = sizeof(_rx_raw_buffer),
+       .overwrite = false};
+static struct buffer tx_buffer
+    = {.buffer = _tx_frame_buffer, .size = sizeof(_tx_frame_buffer)};
+static struct buffer int_buffer
+    = {.buffer = _internal_buffer, .size = sizeof(_internal_buffer)};
+
+static struct crc crc8
+    = {.crc8_polynomial      = 0x97,
+       .crc8_initial_value   = 0x00,
+       .crc8_final_xor_value = 0x00,
+       .reflect_input        = false,
+       .reflect_output       = false};
+
+static struct framing link_with_timer
+    = {.crc8_calculator       = &crc8,
+       .rx_raw_buffer         = &rx_buffer,
+       .tx_frame_buffer       = &tx_buffer,
+       .parsing_buffer        = &int_buffer,
+       .start_delimiter       = 0xAA,
+       .stop_delimiter        = 0x55,
+       .max_payload_size      = 0x04,
+       .inter_byte_timer      = &sim_timer,
+       .inter_byte_timeout_ms = INTER_BYTE_TIMEOUT_MS};
+
+static struct framing link_without_timer
+    = {.crc8_calculator  = &crc8,
+       .rx_raw_buffer    = &rx_buffer,
+       .tx_frame_buffer  = &tx_buffer,
+       .parsing_buffer   = &int_buffer,
+       .start_delimiter  = 0xAA,
+       .stop_delimiter   = 0x55,
+       .max_payload_size = 0x04};
+
+// Sender resets after 4 bytes of a frame, then sends a valid frame at 20 ms
+static const uint8_t  truncated_frame[]  = {0xAA, 0x04, 0x01, 0x02};
+static const uint32_t truncated_start_ms = 0;
+static const uint8_t  valid_frame[]
+    = {0xAA, 0x04, 0x01, 0x02, 0x03, 0x04, 0x55, 0x33};
+static const uint32_t valid_start_ms = 20;
+
+struct sim_result
+{
+    uint8_t  frames_received;
+    uint32_t abort_ms;  // UINT32_MAX if the partial frame was never aborted
+};
+
+/* ========================================================================== */
+
+static void rx_isr_at(uint32_t now_ms)
+{
+    if (now_ms >= truncated_start_ms
+        && now_ms - truncated_start_ms < sizeof(truncated_frame))
+    {
+        ring_buffer_push(
+            &rx_buffer, &truncated_frame[now_ms - truncated_start_ms], 1);
+    }
+    if (now_ms >= valid_start_ms
+        && now_ms - valid_start_ms < sizeof(valid_frame))
+    {
+        ring_buffer_push(&rx_buffer, &valid_frame[now_ms - valid_start_ms], 1);
+    }
+}
+
+static struct sim_result run_simulation(struct framing* link)
+{
+    struct sim_result result = {.frames_received = 0, .abort_ms = UINT32_MAX};
+    for (uint32_t now_ms = 0; now_ms < SIM_END_MS; now_ms++)
+    {
+        sim_advance_to(now_ms);
+        rx_isr_at(now_ms);
+
+        int8_t status;
+        while ((status = framing_process_incoming_data(link)) != -ENODATA)
+        {
+            if (status == -ETIMEDOUT)
+            {
+                result.abort_ms = now_ms;
+            }
+            else if (status == 0)
+            {
+                uint8_t payload[4];
+                uint8_t payload_size;
+                TEST_ASSERT_EQUAL(
+                    0, framing_retrieve_payload(link, payload, &payload_size));
+                TEST_ASSERT_EQUAL_UINT8_ARRAY(
+                    &valid_frame[2], payload, sizeof(payload));
+                result.frames_received += 1;
+            }
+        }
+    }
+    return result;
+}
+
+/* ========================================================================== */
+
+void setUp(void)
+{
+    sim_now_ms   = 0;
+    sim_active   = false;
+    sim_callback = NULL;
+    ring_buffer_init(&rx_buffer);
+    buffer_init(&tx_buffer);
+    buffer_init(&int_buffer);
+}
+
+void tearDown(void)
+{
+}
+
+/* ========================================================================== */
+
+void test_truncated_frame_costs_next_frame_without_timer(void)
+{
+    TEST_ASSERT_EQUAL(0, framing_init(&link_without_timer));
+
+    struct sim_result result = run_simulation(&link_without_timer);
+
+    TEST_ASSERT_EQUAL(0, result.frames_received);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, result.abort_ms);
+}
+
+/* ========================================================================== */
+
+void test_truncated_frame_aborted_after_inter_byte_gap(void)
+{
+    TEST_ASSERT_EQUAL(0, framing_init(&link_with_timer));
+    TEST_ASSERT_NOT_NULL(sim_callback);
+    TEST_ASSERT_FALSE(sim_active);  // Idle until a frame starts
+
+    struct sim_result result = run_simulation(&link_with_timer);
+
+    uint32_t last_byte_ms = truncated_start_ms + sizeof(truncated_frame) - 1;
+    uint32_t recovery_ms  = result.abort_ms - last_byte_ms;
+    printf("Recovery latency: %u ms\n", (unsigned)recovery_ms);
+
+    TEST_ASSERT_EQUAL(1, result.frames_received);
+    TEST_ASSERT_EQUAL_UINT32(INTER_BYTE_TIMEOUT_MS, recovery_ms);
+    TEST_ASSERT_FALSE(sim_active);  // Disarmed again once the frame completed
+
+    struct framing_stats stats;
+    TEST_ASSERT_EQUAL(0, framing_get_stats(&link_with_timer, &stats));
+    TEST_ASSERT_EQUAL_UINT32(1, stats.timeouts);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.frames_ok);
+}
+
+/* ========================================================================== */
+
+void test_expiry_with_pending_bytes_keeps_frame(void)
+{
+    TEST_ASSERT_EQUAL(0, framing_init(&link_with_timer));
+
+    // Whole frame arrives, but the main loop stalls after two bytes
+    ring_buffer_push(&rx_buffer, valid_frame, sizeof(valid_frame));
+    TEST_ASSERT_EQUAL(-EAGAIN, framing_process_incoming_data(&link_with_timer));
+    TEST_ASSERT_EQUAL(-EAGAIN, framing_process_incoming_data(&link_with_timer));
+    sim_advance_to(2 * INTER_BYTE_TIMEOUT_MS);
+
+    int8_t status;
+    do
+    {
+        status = framing_process_incoming_data(&link_with_timer);
+    } while (status == -EAGAIN);
+    TEST_ASSERT_EQUAL(0, status);
+
+    struct framing_stats stats;
+    TEST_ASSERT_EQUAL(0, framing_get_stats(&link_with_timer, &stats));
+    TEST_ASSERT_EQUAL_UINT32(0, stats.timeouts);
+}
+
+/* ========================================================================== */
+
+void test_init_rejects_zero_inter_byte_timeout(void)
+{
+    struct framing link
+        = {.crc8_calculator       = &crc8,
+           .rx_raw_buffer         = &rx_buffer,
+           .tx_frame_buffer       = &tx_buffer,
+           .parsing_buffer        = &int_buffer,
+           .start_delimiter       = 0xAA,
+           .stop_delimiter        = 0x55,
+           .max_payload_size      = 0x04,
+           .inter_byte_timer      = &sim_timer,
+           .inter_byte_timeout_ms = 0};
+    TEST_ASSERT_EQUAL(-EINVAL, framing_init(&link));
+}
+
+/* ========================================================================== */
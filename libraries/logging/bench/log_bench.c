@@ -0,0 +1,242 @@
+/**
+ * @file log_bench.c
+ * @brief Host benchmark of the logging calls, through an in-memory serial
+ * port.
+ *
+ * Reports the time per call of log_write() for several message lengths and of
+ * log_value(), each with the record sent and with the record filtered out by
+ * the runtime level. Then compares log_format() with the snprintf based
+ * paths: each case logs the same text both ways and the produced lines are
+ * compared, so both sides do the same work. The cost of appending one record
+ * to the flight recorder is reported as well.
+ *
+ * Usage: log-bench [-n iterations]
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "../inc/log_recorder.h"
+#include "../inc/logging.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* ========================================================================== */
+
+#define LOG_MAX_LINE 128 /* LOG_MAX_BUFFER_SIZE default */
+
+static char   last_line[LOG_MAX_LINE];
+static size_t last_size;
+
+static int8_t memory_transmit(
+    const struct serial* self, const uint8_t* buffer, size_t size)
+{
+    (void)self;
+    memcpy(last_line, buffer, size);
+    last_size = size;
+    return 0;
+}
+
+static const struct serial_ops memory_ops = {.transmit = memory_transmit};
+static struct serial           memory_serial = {.ops = &memory_ops};
+
+static char short_message[16 + 1];
+static char medium_message[64 + 1];
+static char long_message[112 + 1]; /* Longest fitting with "[INFO] " */
+
+static void fill_message(char* message, size_t size)
+{
+    for (size_t i = 0; i < size - 1; i++)
+    {
+        message[i] = (char)('a' + i % 26);
+    }
+    message[size - 1] = '\0';
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* ========================================================================== */
+
+static void write_short(uint32_t i)
+{
+    (void)i;
+    log_write(LOG_LEVEL_INFO, short_message);
+}
+
+static void write_medium(uint32_t i)
+{
+    (void)i;
+    log_write(LOG_LEVEL_INFO, medium_message);
+}
+
+static void write_long(uint32_t i)
+{
+    (void)i;
+    log_write(LOG_LEVEL_INFO, long_message);
+}
+
+static void one_arg_snprintf(uint32_t i)
+{
+    int32_t value = (int32_t)i - 1000;
+    log_value("temp=%" PRId32, &value, LOG_VALUE_INT32);
+}
+
+static void one_arg_format(uint32_t i)
+{
+    LOG_FMT(LOG_LEVEL_INFO, "temp={}", LOG_I((int32_t)i - 1000));
+}
+
+static void four_args_snprintf(uint32_t i)
+{
+    char    line[LOG_MAX_LINE];
+    int32_t millivolts = (int32_t)(3000 + i % 1000);
+    snprintf(
+        line,
+        sizeof(line),
+        "adc=%" PRIu32 " vbat=%" PRId32 ".%03" PRId32 " V reg=0x%04" PRIX32
+        " name=%s",
+        i,
+        millivolts / 1000,
+        millivolts % 1000,
+        i & 0xFFFF,
+        "sensor");
+    log_write(LOG_LEVEL_INFO, line);
+}
+
+static void four_args_format(uint32_t i)
+{
+    LOG_FMT(
+        LOG_LEVEL_INFO,
+        "adc={} vbat={} V reg=0x{} name={}",
+        LOG_U(i),
+        LOG_FIXED((int32_t)(3000 + i % 1000), 3),
+        LOG_HEXN(i & 0xFFFF, 4),
+        LOG_STR("sensor"));
+}
+
+static uint32_t            recorder_ram[256];
+static struct log_recorder recorder
+    = {.memory = recorder_ram, .size = sizeof(recorder_ram)};
+
+static void recorder_append(uint32_t i)
+{
+    static const char record[] = "1500 #42 [INFO] adc=1234 state=3\r\n";
+    (void)i;
+    log_recorder_write(&recorder, (const uint8_t*)record, sizeof(record) - 1);
+}
+
+/* ========================================================================== */
+
+static double time_case(void (*log_case)(uint32_t), unsigned long iterations)
+{
+    double start = now_seconds();
+    for (unsigned long i = 0; i < iterations; i++)
+    {
+        log_case((uint32_t)i);
+    }
+    return 1e9 * (now_seconds() - start) / (double)iterations;
+}
+
+static int check_same_output(
+    void (*reference)(uint32_t), void (*candidate)(uint32_t))
+{
+    static const uint32_t samples[] = {0, 7, 999, 1000, 65535, 4000000000u};
+    for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++)
+    {
+        char   expected[LOG_MAX_LINE];
+        size_t expected_size;
+        reference(samples[i]);
+        memcpy(expected, last_line, last_size);
+        expected_size = last_size;
+        candidate(samples[i]);
+        if (last_size != expected_size
+            || memcmp(expected, last_line, last_size) != 0)
+        {
+            fprintf(
+                stderr,
+                "output mismatch:\n  %.*s  %.*s",
+                (int)expected_size,
+                expected,
+                (int)last_size,
+                last_line);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* ========================================================================== */
+
+int main(int argc, char** argv)
+{
+    unsigned long iterations = 1000000;
+    if (argc == 3 && strcmp(argv[1], "-n") == 0)
+    {
+        iterations = strtoul(argv[2], NULL, 10);
+    }
+    if (iterations == 0 || (argc != 1 && argc != 3))
+    {
+        fprintf(stderr, "usage: %s [-n iterations]\n", argv[0]);
+        return 1;
+    }
+
+    struct log_config config
+        = {.serial_output = &memory_serial,
+           .min_level     = LOG_LEVEL_DEBUG,
+           .show_level    = true};
+    log_init(&config);
+    fill_message(short_message, sizeof(short_message));
+    fill_message(medium_message, sizeof(medium_message));
+    fill_message(long_message, sizeof(long_message));
+
+    if (log_recorder_init(&recorder, NULL) != 0
+        || check_same_output(one_arg_snprintf, one_arg_format) != 0
+        || check_same_output(four_args_snprintf, four_args_format) != 0)
+    {
+        return 1;
+    }
+
+    // Records are INFO: a WARN runtime level filters them all out
+    static const struct
+    {
+        const char* name;
+        void (*log_case)(uint32_t);
+    } filter_cases[] = {
+        {"log_write, 16 characters", write_short},
+        {"log_write, 64 characters", write_medium},
+        {"log_write, 112 characters", write_long},
+        {"log_value (snprintf)", one_arg_snprintf},
+        {"LOG_FMT, 1 argument", one_arg_format},
+    };
+    printf("logging benchmark (%lu iterations, ns/call)\n", iterations);
+    printf("  %-26s %7s %9s\n", "", "sent", "filtered");
+    for (size_t i = 0; i < sizeof(filter_cases) / sizeof(filter_cases[0]); i++)
+    {
+        log_set_level(LOG_LEVEL_DEBUG);
+        double sent = time_case(filter_cases[i].log_case, iterations);
+        log_set_level(LOG_LEVEL_WARN);
+        double filtered = time_case(filter_cases[i].log_case, iterations);
+        printf("  %-26s %7.1f %9.1f\n", filter_cases[i].name, sent, filtered);
+    }
+    log_set_level(LOG_LEVEL_DEBUG);
+
+    printf("\nlog_format against snprintf (ns/call)\n");
+    printf(
+        "  4 arguments, snprintf + log_write:     %7.1f\n",
+        time_case(four_args_snprintf, iterations));
+    printf(
+        "  4 arguments, LOG_FMT:                  %7.1f\n",
+        time_case(four_args_format, iterations));
+    printf(
+        "  flight recorder, 34-byte record:       %7.1f\n",
+        time_case(recorder_append, iterations));
+    return 0;
+}
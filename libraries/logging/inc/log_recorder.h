@@ -0,0 +1,129 @@
+#ifndef LOG_RECORDER_H
+#define LOG_RECORDER_H
+
+/* ========================================================================== */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ========================================================================== */
+
+#include "../../inc/errno.h"
+#include "logging.h"
+
+/* ========================================================================== */
+
+#define LOG_RECORDER_MAGIC       0x4C4F4752u /* "LOGR" */
+#define LOG_RECORDER_HEADER_SIZE 20u         /* 5 x uint32_t */
+
+/* Bytes stored per record besides its data: 2 x length, CRC-32 */
+#define LOG_RECORDER_RECORD_OVERHEAD 8u
+
+/*
+ * Attribute placing the recorder memory in RAM that the startup code neither
+ * zeroes nor initializes. The section must also exist in the linker script,
+ * e.g. for GNU ld:
+ *
+ *   .noinit (NOLOAD) : { *(.noinit*) } > RAM
+ */
+#ifndef LOG_RECORDER_NOINIT
+#if defined(__GNUC__)
+#define LOG_RECORDER_NOINIT __attribute__((section(".noinit")))
+#else
+#define LOG_RECORDER_NOINIT
+#endif
+#endif
+
+/* ========================================================================== */
+
+/**
+ * struct log_recorder - Flight recorder keeping the last log records in RAM
+ * that survives a warm reset (watchdog, fault handler, software reset)
+ * @memory: 4-byte aligned no-init RAM (see LOG_RECORDER_NOINIT), holding a
+ * header followed by the record data
+ * @size: Size of @memory in bytes, more than LOG_RECORDER_HEADER_SIZE +
+ * LOG_RECORDER_RECORD_OVERHEAD
+ *
+ * The header at the start of @memory holds a magic number, the data size, the
+ * write offset and the number of bytes in use, followed by a CRC-32 of these.
+ * Each record is framed with its length before and after the data and carries
+ * a CRC-32 of its own, so binary (tokenised) records survive as well as text.
+ * The oldest whole records are dropped to make room. The data is written
+ * before the header that publishes it, behind a compiler barrier.
+ *
+ * On init, a header that passes all checks means the data is left over from
+ * before the reset: the records are checked from the newest back and kept up
+ * to the first damaged one. Anything else (power-on, different size) starts an
+ * empty recorder.
+ *
+ * Register log_recorder_write() as a LOG_SINK_CALLBACK sink with the recorder
+ * as context. The logger never runs a sink's write twice at the same time,
+ * which keeps the header consistent when several contexts log.
+ *
+ * Configure public fields before calling log_recorder_init().
+ */
+struct log_recorder
+{
+    /* public: user-configurable fields - set before init (const after init) */
+    void* const  memory;
+    const size_t size;
+
+    /* private: internal state - do not access directly */
+    bool was_initialized;
+};
+
+/* ========================================================================== */
+
+/**
+ * @brief Initialize the recorder, keeping the data left by the previous run
+ * if its header is intact.
+ * @param self Pointer to the recorder with public fields configured.
+ * @param recovered Optional, set to the number of bytes kept from before the
+ * reset, framing included (0 after power-on).
+ * @return 0 on success, -EFAULT if self or memory is NULL, -EINVAL if memory
+ * is not 4-byte aligned or size is too small.
+ */
+int8_t log_recorder_init(struct log_recorder* self, size_t* recovered);
+
+/* ========================================================================== */
+
+/**
+ * @brief Append a record, overwriting the oldest data. Matches
+ * log_sink_write_t, to be registered as a LOG_SINK_CALLBACK sink.
+ * @param context Pointer to an initialized recorder.
+ * @param data Record bytes.
+ * @param size Number of bytes. Only the last bytes are kept if the record
+ * would not fit the data area alone, or is longer than 65535 bytes.
+ * @return 0 on success, -EFAULT if context or data is NULL, -EPERM if not
+ * initialized.
+ */
+int8_t log_recorder_write(void* context, const uint8_t* data, size_t size);
+
+/* ========================================================================== */
+
+/**
+ * @brief Replay the recorded records, oldest first, through the log sinks
+ * with log_write_record(), between two marker lines. Records longer than
+ * LOG_MAX_BUFFER_SIZE are replayed in pieces. The data is kept. Call it
+ * after log_init() and before registering the recorder sink, so the replay is
+ * not recorded again.
+ * @param self Pointer to the recorder.
+ * @param level Level the replayed records are sent with.
+ * @return 0 on success, -EFAULT if self is NULL, -EPERM if not initialized,
+ * -ENODATA if the recorder is empty, or the log output error.
+ */
+int8_t log_recorder_dump(const struct log_recorder* self, enum log_level level);
+
+/* ========================================================================== */
+
+/**
+ * @brief Discard the recorded data.
+ * @param self Pointer to the recorder.
+ * @return 0 on success, -EFAULT if self is NULL, -EPERM if not initialized.
+ */
+int8_t log_recorder_clear(struct log_recorder* self);
+
+/* ========================================================================== */
+
+#endif /* LOG_RECORDER_H */
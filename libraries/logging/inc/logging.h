@@ -11,6 +11,15 @@
 /* ========================================================================== */
 
 #include "../../embedded-hal/inc/serial.h"
+#include "../../ring-buffer/inc/ring_buffer.h"
+
+/* ========================================================================== */
+
+/* Longest line, terminator included. Queued lines carry a one-byte length, so
+ * it must not exceed 255 */
+#ifndef LOG_MAX_BUFFER_SIZE
+#define LOG_MAX_BUFFER_SIZE 128
+#endif
 
 /* ========================================================================== */
 
@@ -40,24 +49,199 @@ enum value_type
     LOG_VALUE_INT32,
 };
 
+/**
+ * @brief Argument kinds understood by log_format().
+ */
+enum log_arg_type
+{
+    LOG_ARG_UINT,  /**< Unsigned decimal */
+    LOG_ARG_INT,   /**< Signed decimal */
+    LOG_ARG_HEX,   /**< Uppercase hexadecimal, no prefix */
+    LOG_ARG_STR,   /**< Null-terminated string */
+    LOG_ARG_FIXED, /**< Signed fixed-point: value / 10^precision */
+};
+
+/**
+ * struct log_arg - One log_format() argument, built with the LOG_U, LOG_I,
+ * LOG_HEX, LOG_HEXN, LOG_STR and LOG_FIXED macros
+ * @type: How to format the value
+ * @precision: Decimals for LOG_ARG_FIXED (0..9), minimum digits (zero
+ * padded) for LOG_ARG_HEX
+ * @value: The value, in the union member matching @type
+ */
+struct log_arg
+{
+    enum log_arg_type type;
+    uint8_t           precision;
+    union
+    {
+        uint32_t    u;
+        int32_t     i;
+        const char* s;
+    } value;
+};
+
+/**
+ * @brief What to do when a message does not fit in the asynchronous buffer.
+ */
+enum log_overflow_policy
+{
+    LOG_DROP_NEWEST = 0, /**< Discard the message being logged */
+    LOG_DROP_OLDEST = 1  /**< Discard queued messages until it fits */
+};
+
+/**
+ * @brief Kinds of output a log sink writes records to.
+ */
+enum log_sink_type
+{
+    LOG_SINK_SERIAL      = 0, /**< Transmit over a serial port */
+    LOG_SINK_RING_BUFFER = 1, /**< Append to a RAM trace buffer */
+    LOG_SINK_CALLBACK    = 2  /**< Hand to a user function (NVM, network...) */
+};
+
+/**
+ * @brief Write one whole record for a LOG_SINK_CALLBACK sink.
+ * @return 0 on success, negative errno on error.
+ */
+typedef int8_t (*log_sink_write_t)(
+    void* context, const uint8_t* data, size_t size);
+
+/**
+ * @brief Returns the current time for log records, in the unit of the
+ * caller's choice (e.g. a millisecond tick or a microsecond counter).
+ */
+typedef uint32_t (*log_timestamp_t)(void);
+
 /* ========================================================================== */
 
 /**
  * struct log_config - Log utility configuration
  * @serial_output: Serial port for log output (required)
- * @min_level: Minimum level to output (runtime filter)
+ * @min_level: Minimum level sent to @serial_output (runtime filter)
  * @show_level: Show level prefix [DEBUG], [INFO], etc.
+ * @async_buffer: Optional ring buffer (overwrite disabled) holding lines not
+ * yet transmitted. NULL keeps the synchronous behavior.
+ * @overflow_policy: What to drop when @async_buffer is full
+ * @get_timestamp: Optional time source. When set, every record starts with
+ * the time it was logged at. NULL disables timestamps.
+ * @show_sequence: Number every record ("#42") so gaps reveal dropped records
+ * @isr_buffer: Optional ring buffer (overwrite disabled) for records logged
+ * with the _from_isr functions, until log_drain() dispatches them. NULL makes
+ * those functions return -ENOTSUP.
+ * @collapse_repeats: Drop text records identical to the previous one (same
+ * level, module and message) and report them as one "last message repeated N
+ * times" line when a different record arrives
+ * @repeat_timeout: With @collapse_repeats, log_drain() also reports the
+ * repeats once the first of them is this old (@get_timestamp units), so a
+ * message that stops repeating is not left unreported. 0, or no
+ * @get_timestamp, reports them at every log_drain().
  *
  * A log utility is useful for logging messages over a serial interface. It
  * allows to see insights during system operation. All fields must be set before
  * calling log_init().
+ *
+ * Without @async_buffer, every log call blocks until serial_output has sent
+ * the whole line (~11 ms for 128 bytes at 115200 baud on a polled UART). With
+ * it, log calls only copy the line into the buffer, and log_drain() streams it
+ * out later from the idle loop or the TX-empty interrupt. If log_drain() runs
+ * in an interrupt, define CRITICAL_HEADER (see embedded-hal/inc/critical.h)
+ * when building the library so the buffer is updated with interrupts masked.
+ *
+ * Concurrency: formatting only uses the caller's stack. When the library is
+ * built with CRITICAL_HEADER, the shared state (queues, counters, sink list)
+ * is updated with interrupts masked, for a few instructions at a time. Each
+ * synchronous sink has a lock, taken and released in such a critical section
+ * and held with interrupts enabled for the whole write, so lines from several
+ * tasks never interleave. A task finding the lock taken spins until it is
+ * released: on a preemptive scheduler, tasks of different priorities sharing
+ * a synchronous sink must use an async_buffer instead. log_drain() never
+ * waits: an interrupt record meeting a locked sink is dropped for it, and
+ * counted by log_get_dropped(). Interrupt handlers must use
+ * log_write_from_isr()/LOG_FMT_FROM_ISR, which never touch a sink and only
+ * copy the record into @isr_buffer. The get_timestamp hook may run inside a
+ * critical section and must not block; sink callbacks must not log.
+ *
+ * Text records then look like "123456 #42 [INFO] message": timestamp, then
+ * sequence number, then level, each only if enabled. The timestamp is taken
+ * when the message is logged, not when it is transmitted, so the difference
+ * between two records measures the time between the two log calls.
  */
 struct log_config
 {
     /* public: user-configurable fields - set before init (const after init) */
-    const struct serial* serial_output;
-    enum log_level       min_level;
-    bool                 show_level;
+    const struct serial*     serial_output;
+    enum log_level           min_level;
+    bool                     show_level;
+    struct ring_buffer*      async_buffer;
+    enum log_overflow_policy overflow_policy;
+    log_timestamp_t          get_timestamp;
+    bool                     show_sequence;
+    struct ring_buffer*      isr_buffer;
+    bool                     collapse_repeats;
+    uint32_t                 repeat_timeout;
+};
+
+/**
+ * struct log_sink - Additional log output, registered with log_add_sink()
+ * @type: Kind of output, selects which of the following fields is used
+ * @min_level: Minimum level this sink receives (see log_sink_set_level())
+ * @serial: Serial port (LOG_SINK_SERIAL)
+ * @trace_buffer: Ring buffer receiving the raw records, one after the other
+ * (LOG_SINK_RING_BUFFER). With overwrite enabled it keeps the newest records,
+ * which is what a crash trace wants; without, a record that does not fit is
+ * dropped whole.
+ * @write: Function called with each record (LOG_SINK_CALLBACK)
+ * @context: Passed back to @write
+ * @async_buffer: As in struct log_config, for serial and callback sinks. NULL
+ * writes each record from the log call.
+ * @overflow_policy: What to drop when @async_buffer is full
+ *
+ * The line configured in struct log_config is the first sink; up to
+ * LOG_MAX_SINKS - 1 more can be added. Each record is formatted once and the
+ * same bytes are passed to every sink whose @min_level it reaches. The sink
+ * must stay valid (static) while registered.
+ */
+struct log_sink
+{
+    /* public: user-configurable fields - set before log_add_sink() */
+    enum log_sink_type       type;
+    enum log_level           min_level;
+    const struct serial*     serial;
+    struct ring_buffer*      trace_buffer;
+    log_sink_write_t         write;
+    void*                    context;
+    struct ring_buffer*      async_buffer;
+    enum log_overflow_policy overflow_policy;
+
+    /* private: internal state - do not access directly */
+    volatile bool busy;
+};
+
+/**
+ * struct log_module - Subsystem with its own log level, see
+ * LOG_MODULE_DECLARE and LOG_MODULE_DEFINE
+ * @name: Tag printed after the level, e.g. "uip"
+ * @min_level: Runtime minimum level of the module (see log_module_set_level())
+ */
+struct log_module
+{
+    const char* const       name;
+    volatile enum log_level min_level;
+};
+
+/**
+ * struct log_rate_limit - Token bucket of one call site, see LOG_LIMITED
+ *
+ * Zero-initialized (static) before first use. Private state, only accessed by
+ * log_rate_allow().
+ */
+struct log_rate_limit
+{
+    /* private: internal state - do not access directly */
+    uint32_t last_refill;
+    uint32_t suppressed;
+    uint16_t spent;
 };
 
 /* ========================================================================== */
@@ -65,19 +249,20 @@ struct log_config
 /**
  * @brief Initialize the log module.
  * @param config Pointer to log configuration.
- * @return 0 on success, -EFAULT if config or output is NULL.
+ * @return 0 on success, -EFAULT if config or output is NULL, -EINVAL if
+ * async_buffer overwrites on full or overflow_policy is out of range.
  */
 int8_t log_init(const struct log_config* config);
 
 /**
- * @brief Set minimum log level at runtime.
+ * @brief Set minimum log level of serial_output at runtime.
  * @param level New minimum level.
  * @return 0 on success, -EPERM if log not initialized.
  */
 int8_t log_set_level(enum log_level level);
 
 /**
- * @brief Get current minimum log level.
+ * @brief Get current minimum log level of serial_output.
  * @param level Pointer to store current level.
  * @return 0 on success, -EFAULT if level is NULL, -EPERM if not initialized.
  */
@@ -90,6 +275,36 @@ int8_t log_get_level(enum log_level* level);
  */
 int8_t log_show_level(bool enable);
 
+/**
+ * @brief Send records to one more output as well, e.g. errors to NVM or
+ * debug messages to a RAM trace. log_init() removes all added sinks.
+ * @param sink Sink with its public fields configured.
+ * @return 0 on success, -EFAULT if sink or the output of its type is NULL,
+ * -EINVAL if type or overflow_policy is out of range or async_buffer is
+ * invalid (set on a ring buffer sink, or overwrites on full), -EALREADY if
+ * already added, -ENOSPC if LOG_MAX_SINKS sinks are registered, -EPERM if not
+ * initialized.
+ */
+int8_t log_add_sink(struct log_sink* sink);
+
+/**
+ * @brief Stop sending records to a sink added with log_add_sink(). Records
+ * still queued in its async_buffer are left there.
+ * @param sink Sink to remove.
+ * @return 0 on success, -EFAULT if sink is NULL, -ENOENT if not registered,
+ * -EPERM if not initialized.
+ */
+int8_t log_remove_sink(struct log_sink* sink);
+
+/**
+ * @brief Change the minimum level of a registered sink at runtime.
+ * @param sink Sink added with log_add_sink().
+ * @param level New minimum level.
+ * @return 0 on success, -EFAULT if sink is NULL, -ENOENT if not registered,
+ * -EPERM if not initialized.
+ */
+int8_t log_sink_set_level(struct log_sink* sink, enum log_level level);
+
 /* ========================================================================== */
 
 /**
@@ -103,6 +318,29 @@ int8_t log_show_level(bool enable);
  */
 int8_t log_write(enum log_level level, const char* msg);
 
+/**
+ * @brief Send bytes that are already a formatted record (e.g. replayed from a
+ * flight recorder or forwarded from another node) to the sinks, unchanged.
+ * @param level Level used to select the sinks.
+ * @param data Record bytes.
+ * @param size Number of bytes, at most LOG_MAX_BUFFER_SIZE.
+ * @return 0 on success, -EFAULT if data is NULL, -EINVAL if size is 0 or too
+ * large, -EPERM if not initialized, or the output error.
+ */
+int8_t log_write_record(enum log_level level, const uint8_t* data, size_t size);
+
+/**
+ * @brief Log a message from an interrupt handler. The record is formatted on
+ * the caller's stack and copied to isr_buffer; log_drain() later sends it to
+ * the sinks. Never waits for an output.
+ * @param level Log level for this message.
+ * @param msg Null-terminated message string.
+ * @return 0 on success, -EFAULT if msg is NULL, -EPERM if not initialized,
+ * -ENOTSUP without isr_buffer, -ENOSPC if isr_buffer is full (the record is
+ * dropped and counted, see log_get_dropped()).
+ */
+int8_t log_write_from_isr(enum log_level level, const char* msg);
+
 /**
  * @brief Log a debug message.
  * @param msg Null-terminated message string.
@@ -148,6 +386,117 @@ int8_t log_fatal(const char* msg);
  */
 int8_t log_value(const char* msg, void* value, enum value_type type);
 
+/**
+ * @brief Log a message with several arguments, without snprintf.
+ * @param level Log level for this message.
+ * @param fmt Message where each "{}" is replaced by the next argument. Extra
+ * "{}" are printed as is, extra arguments are ignored.
+ * @param args Arguments (may be NULL if arg_count is 0).
+ * @param arg_count Number of arguments.
+ * @return 0 on success, -EFAULT if fmt is NULL or args is NULL with
+ * arg_count > 0, -EPERM if not initialized, or the output error.
+ *
+ * @note Prefer the LOG_FMT macro, which builds the argument array and count.
+ * The line is truncated to LOG_MAX_BUFFER_SIZE like log_write().
+ */
+int8_t log_format(
+    enum log_level        level,
+    const char*           fmt,
+    const struct log_arg* args,
+    uint8_t               arg_count);
+
+/**
+ * @brief log_format() from an interrupt handler, see log_write_from_isr().
+ * Prefer the LOG_FMT_FROM_ISR macro.
+ * @return As log_format() and log_write_from_isr().
+ */
+int8_t log_format_from_isr(
+    enum log_level        level,
+    const char*           fmt,
+    const struct log_arg* args,
+    uint8_t               arg_count);
+
+/**
+ * @brief Log a message on behalf of a module. Prefer the LOG_MOD macro.
+ * @param module Module, or NULL to behave as log_write().
+ * @param level Log level for this message.
+ * @param msg Null-terminated message string.
+ * @return As log_write(). Messages below the module level are filtered out.
+ */
+int8_t log_module_write(
+    const struct log_module* module, enum log_level level, const char* msg);
+
+/**
+ * @brief log_format() on behalf of a module. Prefer the LOG_MOD_FMT macro.
+ * @param module Module, or NULL to behave as log_format().
+ * @return As log_format(). Messages below the module level are filtered out.
+ */
+int8_t log_module_format(
+    const struct log_module* module,
+    enum log_level           level,
+    const char*              fmt,
+    const struct log_arg*    args,
+    uint8_t                  arg_count);
+
+/**
+ * @brief Change the runtime level of a module, e.g. to debug one subsystem.
+ * Works before log_init().
+ * @param module Module defined with LOG_MODULE_DEFINE.
+ * @param level New minimum level (LOG_LEVEL_NONE silences the module).
+ * @return 0 on success, -EFAULT if module is NULL, -EINVAL if level is out
+ * of range.
+ */
+int8_t log_module_set_level(struct log_module* module, enum log_level level);
+
+/**
+ * @brief Dispatch the oldest record logged from an interrupt, report the
+ * collapsed repeats due (see log_config.repeat_timeout), then transmit the
+ * oldest queued line of every asynchronous sink. Call from the idle loop
+ * until it returns -ENODATA, or once per TX-empty interrupt, from one context
+ * only.
+ * @return 0 if a line was transmitted, -ENODATA if nothing is queued (always,
+ * in synchronous mode), -EPERM if not initialized, or the first error returned
+ * by an output (the line is dropped).
+ */
+int8_t log_drain(void);
+
+/**
+ * @brief Get the number of messages dropped because an asynchronous buffer
+ * was full, summed over all sinks.
+ * @param dropped Pointer to store the counter.
+ * @return 0 on success, -EFAULT if dropped is NULL, -EPERM if not
+ * initialized.
+ */
+int8_t log_get_dropped(uint32_t* dropped);
+
+/**
+ * @brief Decide whether a rate limited call site may log now, spending one
+ * token of its bucket. The bucket holds burst tokens and gets one back per
+ * period. When a call is allowed after some were refused, a "N similar
+ * messages suppressed" line is logged first. Prefer the LOG_LIMITED macros.
+ * @param limit Bucket of the call site.
+ * @param level Level of the call site.
+ * @param burst Messages allowed back to back (at least 1).
+ * @param period Time to earn one token back, in get_timestamp units. 0
+ * disables the limit.
+ * @return true if the message may be logged. Always true without a
+ * get_timestamp hook, false if limit is NULL or the library not initialized.
+ */
+bool log_rate_allow(
+    struct log_rate_limit* limit,
+    enum log_level         level,
+    uint16_t               burst,
+    uint32_t               period);
+
+/**
+ * @brief Get the number of messages suppressed by rate limiting and by
+ * collapse_repeats since log_init().
+ * @param suppressed Pointer to store the counter.
+ * @return 0 on success, -EFAULT if suppressed is NULL, -EPERM if not
+ * initialized.
+ */
+int8_t log_get_suppressed(uint32_t* suppressed);
+
 /* ========================================================================== */
 
 /*
@@ -199,6 +548,246 @@ int8_t log_value(const char* msg, void* value, enum value_type type);
 #define LOG_FATAL(msg) ((void)0)
 #endif
 
+/*
+ * Arguments for log_format(). The value is assigned, not cast, to the union
+ * member of its kind, so the compiler diagnoses e.g. a pointer given to LOG_U.
+ *
+ *   LOG_FMT(LOG_LEVEL_INFO, "adc={} vbat={} V reg=0x{} name={}",
+ *           LOG_U(adc), LOG_FIXED(millivolts, 3), LOG_HEXN(reg, 4),
+ *           LOG_STR(name));
+ */
+#define LOG_U(x) \
+    ((struct log_arg){.type = LOG_ARG_UINT, .precision = 0, .value.u = (x)})
+#define LOG_I(x) \
+    ((struct log_arg){.type = LOG_ARG_INT, .precision = 0, .value.i = (x)})
+#define LOG_HEX(x) \
+    ((struct log_arg){.type = LOG_ARG_HEX, .precision = 0, .value.u = (x)})
+#define LOG_HEXN(x, digits) \
+    ((struct log_arg){      \
+        .type = LOG_ARG_HEX, .precision = (digits), .value.u = (x)})
+#define LOG_STR(x) \
+    ((struct log_arg){.type = LOG_ARG_STR, .precision = 0, .value.s = (x)})
+#define LOG_FIXED(x, decimals)      \
+    ((struct log_arg){              \
+        .type      = LOG_ARG_FIXED, \
+        .precision = (decimals),    \
+        .value.i   = (x)})
+
+/* Log a message with 1 or more LOG_U/LOG_I/... arguments */
+#define LOG_FMT(level, fmt, ...)                                        \
+    do                                                                  \
+    {                                                                   \
+        if ((level) >= LOG_COMPILE_LEVEL)                               \
+        {                                                               \
+            (void)log_format(                                           \
+                (level),                                                \
+                (fmt),                                                  \
+                (const struct log_arg[]){__VA_ARGS__},                  \
+                (uint8_t)(sizeof((const struct log_arg[]){__VA_ARGS__}) \
+                          / sizeof(struct log_arg)));                   \
+        }                                                               \
+    } while (0)
+
+/* log_format_from_isr() with 1 or more LOG_U/LOG_I/... arguments */
+#define LOG_FMT_FROM_ISR(level, fmt, ...)                               \
+    do                                                                  \
+    {                                                                   \
+        if ((level) >= LOG_COMPILE_LEVEL)                               \
+        {                                                               \
+            (void)log_format_from_isr(                                  \
+                (level),                                                \
+                (fmt),                                                  \
+                (const struct log_arg[]){__VA_ARGS__},                  \
+                (uint8_t)(sizeof((const struct log_arg[]){__VA_ARGS__}) \
+                          / sizeof(struct log_arg)));                   \
+        }                                                               \
+    } while (0)
+
+/*
+ * Rate limited logging, for messages that may fire in a loop (e.g. a receive
+ * error on every frame). Each call site owns a token bucket: burst messages
+ * pass back to back, then one per period (get_timestamp units). Refused
+ * messages are counted and reported by the next one that passes.
+ *
+ *   LOG_FMT_LIMITED(LOG_LEVEL_WARN, 3, 1000, "rx error {}", LOG_I(err));
+ */
+#define LOG_LIMITED(level, burst, period, msg)                          \
+    do                                                                  \
+    {                                                                   \
+        static struct log_rate_limit _log_limit;                        \
+        if ((level) >= LOG_COMPILE_LEVEL                                \
+            && log_rate_allow(&_log_limit, (level), (burst), (period))) \
+        {                                                               \
+            (void)log_write((level), (msg));                            \
+        }                                                               \
+    } while (0)
+
+/* LOG_FMT with a per-call-site rate limit, see LOG_LIMITED */
+#define LOG_FMT_LIMITED(level, burst, period, fmt, ...)                 \
+    do                                                                  \
+    {                                                                   \
+        static struct log_rate_limit _log_limit;                        \
+        if ((level) >= LOG_COMPILE_LEVEL                                \
+            && log_rate_allow(&_log_limit, (level), (burst), (period))) \
+        {                                                               \
+            LOG_FMT((level), (fmt), __VA_ARGS__);                       \
+        }                                                               \
+    } while (0)
+
+/* ========================================================================== */
+
+/*
+ * Per-module log levels.
+ *
+ * Each subsystem declares a module in its header, with a compile-time floor,
+ * and defines it in one source file, with a default runtime level:
+ *
+ *   // uip_log.h
+ *   #ifndef UIP_LOG_FLOOR
+ *   #define UIP_LOG_FLOOR LOG_LEVEL_INFO
+ *   #endif
+ *   LOG_MODULE_DECLARE(uip, UIP_LOG_FLOOR);
+ *
+ *   // uip.c
+ *   LOG_MODULE_DEFINE(uip, LOG_LEVEL_WARN);
+ *   ...
+ *   LOG_MOD(uip, LOG_LEVEL_DEBUG, "rx");
+ *   LOG_MOD_FMT(uip, LOG_LEVEL_INFO, "len={}", LOG_U(len));
+ *
+ * Calls below the floor or LOG_COMPILE_LEVEL compile to nothing. The others
+ * cost one load and compare against the module level before any call, so
+ * log_module_set_level(&log_module_uip, LOG_LEVEL_DEBUG) enables one noisy
+ * subsystem at runtime. Records still have to reach the level of a sink.
+ */
+#define LOG_MODULE_DECLARE(mod, floor)   \
+    enum                                 \
+    {                                    \
+        log_module_floor_##mod = (floor) \
+    };                                   \
+    extern struct log_module log_module_##mod
+
+#define LOG_MODULE_DEFINE(mod, default_level) \
+    struct log_module log_module_##mod        \
+        = {.name = #mod, .min_level = (default_level)}
+
+/* True if a call at this level is compiled in and enabled at runtime */
+#define LOG_MOD_ENABLED(mod, level)                 \
+    ((level) >= LOG_COMPILE_LEVEL                   \
+     && (int)(level) >= (int)log_module_floor_##mod \
+     && (level) >= log_module_##mod.min_level)
+
+/* Log a message for a module */
+#define LOG_MOD(mod, level, msg)                                       \
+    do                                                                 \
+    {                                                                  \
+        if (LOG_MOD_ENABLED(mod, level))                               \
+        {                                                              \
+            (void)log_module_write(&log_module_##mod, (level), (msg)); \
+        }                                                              \
+    } while (0)
+
+/* Log a message with 1 or more LOG_U/LOG_I/... arguments for a module */
+#define LOG_MOD_FMT(mod, level, fmt, ...)                               \
+    do                                                                  \
+    {                                                                   \
+        if (LOG_MOD_ENABLED(mod, level))                                \
+        {                                                               \
+            (void)log_module_format(                                    \
+                &log_module_##mod,                                      \
+                (level),                                                \
+                (fmt),                                                  \
+                (const struct log_arg[]){__VA_ARGS__},                  \
+                (uint8_t)(sizeof((const struct log_arg[]){__VA_ARGS__}) \
+                          / sizeof(struct log_arg)));                   \
+        }                                                               \
+    } while (0)
+
+/* ========================================================================== */
+
+/*
+ * Tokenised (binary) logging.
+ *
+ * LOG_TOKEN sites store their format string in the "log_tokens" section
+ * instead of formatting it on the target. Each call emits a short record:
+ *
+ *   [LOG_TOKEN_SYNC][HEADER][ID (2, LE)][ARG (4, LE)]...
+ *
+ * HEADER holds the level in bits 6..4 and the argument count in bits 3..0.
+ * ID is the offset of the format string inside the section, known at link
+ * time. If get_timestamp or show_sequence is configured, bit 7 of HEADER is
+ * set and the ID is followed by [TIMESTAMP (4, LE)][SEQUENCE (2, LE)], the
+ * timestamp being 0 without a time source and the sequence number truncated
+ * to 16 bits. tools/log_decode.py reads the section from the
+ * ELF file and turns records back into text; plain text lines from log_write
+ * may share the same output, since LOG_TOKEN_SYNC is not printable ASCII.
+ *
+ * Arguments are integers (converted to uint32_t); the format string may use
+ * %d, %i, %u, %x, %X, %o and %c with the usual flags and width.
+ *
+ * Requires a GCC or Clang ELF toolchain: the linker provides
+ * __start_log_tokens. To keep the strings out of flash, map the section to a
+ * non-loaded (INFO) output section in the linker script and define
+ * __start_log_tokens there. IDs are 16 bits: a string starting past the
+ * first 64 KiB of the section cannot be logged, log_token() refuses it.
+ */
+#define LOG_TOKEN_SYNC        0xA5
+#define LOG_TOKEN_MAX_ARGS    8
+#define LOG_TOKEN_HEADER_SIZE 4 /* [SYNC][HEADER][ID (2)] */
+#define LOG_TOKEN_META_FLAG   0x80
+#define LOG_TOKEN_META_SIZE   6 /* [TIMESTAMP (4)][SEQUENCE (2)] */
+
+/**
+ * @brief Emit a tokenised log record. Prefer the LOG_TOKEN macros.
+ * @param level Log level for this record.
+ * @param id Offset of the format string in the log_tokens section.
+ * @param args Argument values (may be NULL if arg_count is 0).
+ * @param arg_count Number of arguments (at most LOG_TOKEN_MAX_ARGS).
+ * @return 0 on success, -EFAULT if args is NULL with arg_count > 0, -EINVAL if
+ * arg_count is too large, -ERANGE if id does not fit the 16-bit record field,
+ * -EPERM if not initialized, or the output error.
+ */
+int8_t log_token(
+    enum log_level  level,
+    uint32_t        id,
+    const uint32_t* args,
+    uint8_t         arg_count);
+
+#if defined(__GNUC__) && defined(__ELF__)
+extern const char __start_log_tokens[];
+
+#define LOG_TOKEN_ID_(fmt_array) \
+    ((uint32_t)((uintptr_t)(fmt_array) - (uintptr_t)__start_log_tokens))
+
+/* Log a tokenised message without arguments */
+#define LOG_TOKEN0(level, fmt)                                          \
+    do                                                                  \
+    {                                                                   \
+        static const char _log_fmt[]                                    \
+            __attribute__((section("log_tokens"))) = fmt;               \
+        if ((level) >= LOG_COMPILE_LEVEL)                               \
+        {                                                               \
+            (void)log_token((level), LOG_TOKEN_ID_(_log_fmt), NULL, 0); \
+        }                                                               \
+    } while (0)
+
+/* Log a tokenised message with 1..LOG_TOKEN_MAX_ARGS integer arguments */
+#define LOG_TOKEN(level, fmt, ...)                                         \
+    do                                                                     \
+    {                                                                      \
+        static const char _log_fmt[]                                       \
+            __attribute__((section("log_tokens"))) = fmt;                  \
+        if ((level) >= LOG_COMPILE_LEVEL)                                  \
+        {                                                                  \
+            (void)log_token(                                               \
+                (level),                                                   \
+                LOG_TOKEN_ID_(_log_fmt),                                   \
+                (const uint32_t[]){__VA_ARGS__},                           \
+                (uint8_t)(sizeof((const uint32_t[]){__VA_ARGS__})          \
+                          / sizeof(uint32_t)));                            \
+        }                                                                  \
+    } while (0)
+#endif
+
 /* ========================================================================== */
 
 #endif /* LOG_H */
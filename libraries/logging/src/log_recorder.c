@@ -0,0 +1,417 @@
+#include "../inc/log_recorder.h"
+
+/* ========================================================================== */
+
+#include <string.h>
+
+/* ========================================================================== */
+
+/* PRIVATE */
+
+/* ========================================================================== */
+
+/*
+ * Keeps the compiler from moving the data stores past the header stores that
+ * publish them (or the other way round), so a reset in between never leaves
+ * a header describing bytes that were not written yet.
+ */
+#if defined(__GNUC__)
+#define LOG_RECORDER_BARRIER() __asm__ volatile("" ::: "memory")
+#else
+#define LOG_RECORDER_BARRIER() ((void)0)
+#endif
+
+/* Layout of the start of the recorder memory */
+struct log_recorder_header
+{
+    uint32_t magic;
+    uint32_t size; /* Data bytes following the header */
+    uint32_t head; /* Offset of the next byte written */
+    uint32_t used; /* Bytes of whole records, the oldest at head - used */
+    uint32_t check;
+};
+
+/* CRC-32 (IEEE 802.3, reflected), a byte at a time */
+static const uint32_t CRC32_TABLE[256] = {
+    0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F,
+    0xE963A535, 0x9E6495A3, 0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988,
+    0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91, 0x1DB71064, 0x6AB020F2,
+    0xF3B97148, 0x84BE41DE, 0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7,
+    0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC, 0x14015C4F, 0x63066CD9,
+    0xFA0F3D63, 0x8D080DF5, 0x3B6E20C8, 0x4C69105E, 0xD56041E4, 0xA2677172,
+    0x3C03E4D1, 0x4B04D447, 0xD20D85FD, 0xA50AB56B, 0x35B5A8FA, 0x42B2986C,
+    0xDBBBC9D6, 0xACBCF940, 0x32D86CE3, 0x45DF5C75, 0xDCD60DCF, 0xABD13D59,
+    0x26D930AC, 0x51DE003A, 0xC8D75180, 0xBFD06116, 0x21B4F4B5, 0x56B3C423,
+    0xCFBA9599, 0xB8BDA50F, 0x2802B89E, 0x5F058808, 0xC60CD9B2, 0xB10BE924,
+    0x2F6F7C87, 0x58684C11, 0xC1611DAB, 0xB6662D3D, 0x76DC4190, 0x01DB7106,
+    0x98D220BC, 0xEFD5102A, 0x71B18589, 0x06B6B51F, 0x9FBFE4A5, 0xE8B8D433,
+    0x7807C9A2, 0x0F00F934, 0x9609A88E, 0xE10E9818, 0x7F6A0DBB, 0x086D3D2D,
+    0x91646C97, 0xE6635C01, 0x6B6B51F4, 0x1C6C6162, 0x856530D8, 0xF262004E,
+    0x6C0695ED, 0x1B01A57B, 0x8208F4C1, 0xF50FC457, 0x65B0D9C6, 0x12B7E950,
+    0x8BBEB8EA, 0xFCB9887C, 0x62DD1DDF, 0x15DA2D49, 0x8CD37CF3, 0xFBD44C65,
+    0x4DB26158, 0x3AB551CE, 0xA3BC0074, 0xD4BB30E2, 0x4ADFA541, 0x3DD895D7,
+    0xA4D1C46D, 0xD3D6F4FB, 0x4369E96A, 0x346ED9FC, 0xAD678846, 0xDA60B8D0,
+    0x44042D73, 0x33031DE5, 0xAA0A4C5F, 0xDD0D7CC9, 0x5005713C, 0x270241AA,
+    0xBE0B1010, 0xC90C2086, 0x5768B525, 0x206F85B3, 0xB966D409, 0xCE61E49F,
+    0x5EDEF90E, 0x29D9C998, 0xB0D09822, 0xC7D7A8B4, 0x59B33D17, 0x2EB40D81,
+    0xB7BD5C3B, 0xC0BA6CAD, 0xEDB88320, 0x9ABFB3B6, 0x03B6E20C, 0x74B1D29A,
+    0xEAD54739, 0x9DD277AF, 0x04DB2615, 0x73DC1683, 0xE3630B12, 0x94643B84,
+    0x0D6D6A3E, 0x7A6A5AA8, 0xE40ECF0B, 0x9309FF9D, 0x0A00AE27, 0x7D079EB1,
+    0xF00F9344, 0x8708A3D2, 0x1E01F268, 0x6906C2FE, 0xF762575D, 0x806567CB,
+    0x196C3671, 0x6E6B06E7, 0xFED41B76, 0x89D32BE0, 0x10DA7A5A, 0x67DD4ACC,
+    0xF9B9DF6F, 0x8EBEEFF9, 0x17B7BE43, 0x60B08ED5, 0xD6D6A3E8, 0xA1D1937E,
+    0x38D8C2C4, 0x4FDFF252, 0xD1BB67F1, 0xA6BC5767, 0x3FB506DD, 0x48B2364B,
+    0xD80D2BDA, 0xAF0A1B4C, 0x36034AF6, 0x41047A60, 0xDF60EFC3, 0xA867DF55,
+    0x316E8EEF, 0x4669BE79, 0xCB61B38C, 0xBC66831A, 0x256FD2A0, 0x5268E236,
+    0xCC0C7795, 0xBB0B4703, 0x220216B9, 0x5505262F, 0xC5BA3BBE, 0xB2BD0B28,
+    0x2BB45A92, 0x5CB36A04, 0xC2D7FFA7, 0xB5D0CF31, 0x2CD99E8B, 0x5BDEAE1D,
+    0x9B64C2B0, 0xEC63F226, 0x756AA39C, 0x026D930A, 0x9C0906A9, 0xEB0E363F,
+    0x72076785, 0x05005713, 0x95BF4A82, 0xE2B87A14, 0x7BB12BAE, 0x0CB61B38,
+    0x92D28E9B, 0xE5D5BE0D, 0x7CDCEFB7, 0x0BDBDF21, 0x86D3D2D4, 0xF1D4E242,
+    0x68DDB3F8, 0x1FDA836E, 0x81BE16CD, 0xF6B9265B, 0x6FB077E1, 0x18B74777,
+    0x88085AE6, 0xFF0F6A70, 0x66063BCA, 0x11010B5C, 0x8F659EFF, 0xF862AE69,
+    0x616BFFD3, 0x166CCF45, 0xA00AE278, 0xD70DD2EE, 0x4E048354, 0x3903B3C2,
+    0xA7672661, 0xD06016F7, 0x4969474D, 0x3E6E77DB, 0xAED16A4A, 0xD9D65ADC,
+    0x40DF0B66, 0x37D83BF0, 0xA9BCAE53, 0xDEBB9EC5, 0x47B2CF7F, 0x30B5FFE9,
+    0xBDBDF21C, 0xCABAC28A, 0x53B39330, 0x24B4A3A6, 0xBAD03605, 0xCDD70693,
+    0x54DE5729, 0x23D967BF, 0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94,
+    0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D,
+};
+
+static uint32_t _crc32_update(uint32_t crc, const uint8_t* data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        crc = (crc >> 8) ^ CRC32_TABLE[(crc ^ data[i]) & 0xFF];
+    }
+    return crc;
+}
+
+static volatile struct log_recorder_header*
+_header(const struct log_recorder* self)
+{
+    return (volatile struct log_recorder_header*)self->memory;
+}
+
+static uint8_t* _data(const struct log_recorder* self)
+{
+    return (uint8_t*)self->memory + LOG_RECORDER_HEADER_SIZE;
+}
+
+static uint32_t _check_word(const volatile struct log_recorder_header* header)
+{
+    const uint32_t fields[4]
+        = {header->magic, header->size, header->head, header->used};
+    return ~_crc32_update(0xFFFFFFFF, (const uint8_t*)fields, sizeof(fields));
+}
+
+static bool _header_is_valid(
+    const volatile struct log_recorder_header* header, uint32_t data_size)
+{
+    return header->magic == LOG_RECORDER_MAGIC && header->size == data_size
+           && header->head < data_size && header->used <= data_size
+           && header->check == _check_word(header);
+}
+
+static void _commit_header(
+    volatile struct log_recorder_header* header, uint32_t head, uint32_t used)
+{
+    LOG_RECORDER_BARRIER();
+    header->head  = head;
+    header->used  = used;
+    header->check = _check_word(header);
+    LOG_RECORDER_BARRIER();
+}
+
+static void _reset_header(
+    volatile struct log_recorder_header* header, uint32_t size)
+{
+    header->magic = LOG_RECORDER_MAGIC;
+    header->size  = size;
+    _commit_header(header, 0, 0);
+}
+
+/* ========================================================================== */
+
+/*
+ * The data area is a ring of records:
+ *
+ *   [LENGTH (2, LE)][CRC-32 (4, LE)][BYTES...][LENGTH (2, LE)]
+ *
+ * The CRC covers the leading length and the bytes. The trailing length lets
+ * log_recorder_init() walk back from the newest record.
+ */
+
+/* Bytes ahead of the record data: length and CRC */
+#define LOG_RECORDER_PREFIX 6u
+
+static uint32_t _wrap(const struct log_recorder* self, uint32_t pos)
+{
+    uint32_t size = _header(self)->size;
+    return (pos >= size) ? pos - size : pos;
+}
+
+static uint32_t _put(
+    const struct log_recorder* self,
+    uint32_t                   pos,
+    const uint8_t*             src,
+    uint32_t                   size)
+{
+    uint8_t* data  = _data(self);
+    uint32_t first = _header(self)->size - pos;
+    if (first > size)
+    {
+        first = size;
+    }
+    memcpy(&data[pos], src, first);
+    memcpy(data, &src[first], size - first);
+    return _wrap(self, pos + size);
+}
+
+static uint32_t _get(
+    const struct log_recorder* self,
+    uint32_t                   pos,
+    uint8_t*                   dest,
+    uint32_t                   size)
+{
+    const uint8_t* data  = _data(self);
+    uint32_t       first = _header(self)->size - pos;
+    if (first > size)
+    {
+        first = size;
+    }
+    memcpy(dest, &data[pos], first);
+    memcpy(&dest[first], data, size - first);
+    return _wrap(self, pos + size);
+}
+
+static uint16_t _get_length(const struct log_recorder* self, uint32_t pos)
+{
+    uint8_t bytes[2];
+    _get(self, pos, bytes, sizeof(bytes));
+    return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+/**
+ * @brief Check the record starting at pos.
+ * @return Its size in the ring, overhead included, or 0 if it is damaged or
+ * longer than the available bytes.
+ */
+static uint32_t
+_check_record(const struct log_recorder* self, uint32_t pos, uint32_t available)
+{
+    uint16_t length = _get_length(self, pos);
+    uint32_t total  = (uint32_t)length + LOG_RECORDER_RECORD_OVERHEAD;
+    if (total > available
+        || _get_length(self, _wrap(self, pos + total - 2)) != length)
+    {
+        return 0;
+    }
+
+    uint8_t  prefix[LOG_RECORDER_PREFIX];
+    uint32_t data_pos = _get(self, pos, prefix, sizeof(prefix));
+    uint32_t crc      = _crc32_update(0xFFFFFFFF, prefix, 2);
+    uint32_t first    = _header(self)->size - data_pos;
+    if (first > length)
+    {
+        first = length;
+    }
+    crc = _crc32_update(crc, &_data(self)[data_pos], first);
+    crc = ~_crc32_update(crc, _data(self), length - first);
+    uint32_t stored = (uint32_t)prefix[2] | (uint32_t)prefix[3] << 8
+                      | (uint32_t)prefix[4] << 16 | (uint32_t)prefix[5] << 24;
+    return (crc == stored) ? total : 0;
+}
+
+/* ========================================================================== */
+
+/* PUBLIC */
+
+/* ========================================================================== */
+
+int8_t log_recorder_init(struct log_recorder* self, size_t* recovered)
+{
+    if (self == NULL || self->memory == NULL)
+    {
+        return -EFAULT;
+    }
+    if ((uintptr_t)self->memory % sizeof(uint32_t) != 0
+        || self->size
+               <= LOG_RECORDER_HEADER_SIZE + LOG_RECORDER_RECORD_OVERHEAD)
+    {
+        return -EINVAL;
+    }
+
+    volatile struct log_recorder_header* header = _header(self);
+    uint32_t data_size = (uint32_t)(self->size - LOG_RECORDER_HEADER_SIZE);
+    if (!_header_is_valid(header, data_size))
+    {
+        _reset_header(header, data_size);
+    }
+
+    // Keep the newest records up to the first damaged one, walking back
+    uint32_t head  = header->head;
+    uint32_t start = head;
+    uint32_t kept  = 0;
+    while (header->used - kept >= LOG_RECORDER_RECORD_OVERHEAD)
+    {
+        uint32_t length = _get_length(self, _wrap(self, start + data_size - 2));
+        uint32_t total  = length + LOG_RECORDER_RECORD_OVERHEAD;
+        uint32_t pos    = (start >= total) ? start - total
+                                           : start + data_size - total;
+        if (total > header->used - kept
+            || _check_record(self, pos, header->used - kept) != total)
+        {
+            break;
+        }
+        start = pos;
+        kept += total;
+    }
+    if (kept != header->used)
+    {
+        _commit_header(header, head, kept);
+    }
+
+    if (recovered != NULL)
+    {
+        *recovered = kept;
+    }
+    self->was_initialized = true;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t log_recorder_write(void* context, const uint8_t* data, size_t size)
+{
+    struct log_recorder* self = context;
+    if (self == NULL || data == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+
+    volatile struct log_recorder_header* header = _header(self);
+    uint32_t max_length = header->size - LOG_RECORDER_RECORD_OVERHEAD;
+    if (max_length > UINT16_MAX)
+    {
+        max_length = UINT16_MAX;
+    }
+    if (size > max_length)
+    {
+        data += size - max_length;
+        size  = max_length;
+    }
+    uint32_t total = (uint32_t)size + LOG_RECORDER_RECORD_OVERHEAD;
+
+    // Forget the oldest records to make room. A reset while they are being
+    // overwritten leaves them failing their CRC, and log_recorder_init()
+    // stops before them, so the header is only committed once.
+    uint32_t head = header->head;
+    uint32_t used = header->used;
+    uint32_t tail = _wrap(self, head + header->size - used);
+    while (header->size - used < total)
+    {
+        uint32_t dropped
+            = _get_length(self, tail) + LOG_RECORDER_RECORD_OVERHEAD;
+        if (dropped > used)
+        {
+            dropped = used; /* Damaged since init: forget everything */
+        }
+        tail = _wrap(self, tail + dropped);
+        used -= dropped;
+    }
+
+    uint8_t prefix[LOG_RECORDER_PREFIX];
+    prefix[0]    = (uint8_t)size;
+    prefix[1]    = (uint8_t)(size >> 8);
+    uint32_t crc = _crc32_update(0xFFFFFFFF, prefix, 2);
+    crc          = ~_crc32_update(crc, data, size);
+    prefix[2]    = (uint8_t)crc;
+    prefix[3]    = (uint8_t)(crc >> 8);
+    prefix[4]    = (uint8_t)(crc >> 16);
+    prefix[5]    = (uint8_t)(crc >> 24);
+
+    uint32_t pos = _put(self, head, prefix, sizeof(prefix));
+    pos          = _put(self, pos, data, (uint32_t)size);
+    pos          = _put(self, pos, prefix, 2);
+
+    // Data first, then the header words: a reset in between loses this
+    // record, never replays garbage
+    _commit_header(header, pos, used + total);
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t log_recorder_dump(const struct log_recorder* self, enum log_level level)
+{
+    if (self == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+
+    const volatile struct log_recorder_header* header = _header(self);
+    if (header->used == 0)
+    {
+        return -ENODATA;
+    }
+
+    // Oldest record first, each replayed whole (in pieces of
+    // LOG_MAX_BUFFER_SIZE if longer), so binary records keep their framing
+    uint8_t  buffer[LOG_MAX_BUFFER_SIZE];
+    uint32_t remaining = header->used;
+    uint32_t pos       = _wrap(self, header->head + header->size - remaining);
+    int8_t   status    = log_write(level, "--- flight recorder ---");
+    while (remaining > 0 && status == 0)
+    {
+        uint32_t total = _check_record(self, pos, remaining);
+        if (total == 0)
+        {
+            break; /* Damaged since init */
+        }
+        uint32_t length = total - LOG_RECORDER_RECORD_OVERHEAD;
+        uint32_t next   = _wrap(self, pos + total);
+        pos             = _wrap(self, pos + LOG_RECORDER_PREFIX);
+        while (length > 0 && status == 0)
+        {
+            uint32_t chunk
+                = (length > sizeof(buffer)) ? sizeof(buffer) : length;
+            pos    = _get(self, pos, buffer, chunk);
+            status = log_write_record(level, buffer, chunk);
+            length -= chunk;
+        }
+        pos = next;
+        remaining -= total;
+    }
+    if (status != 0)
+    {
+        return status;
+    }
+    return log_write(level, "--- end of flight recorder ---");
+}
+
+/* ========================================================================== */
+
+int8_t log_recorder_clear(struct log_recorder* self)
+{
+    if (self == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    _reset_header(_header(self), _header(self)->size);
+    return 0;
+}
+
+/* ========================================================================== */
@@ -6,18 +6,56 @@
 
 /* ========================================================================== */
 
+#include <string.h>
+
+/* ========================================================================== */
+
+#ifdef CRITICAL_HEADER
+#include "../../embedded-hal/inc/critical.h"
+#define LOG_ATOMIC(code) CRITICAL_SECTION(code)
+#else
+#define LOG_ATOMIC(code) \
+    do                   \
+    {                    \
+        code             \
+    } while (0)
+#endif
+
+/* ========================================================================== */
+
 /* PRIVATE */
 
 /* ========================================================================== */
 
-#ifndef LOG_MAX_BUFFER_SIZE
-#define LOG_MAX_BUFFER_SIZE 128
+/* Queued lines are stored as [LENGTH][BYTES...] with a one-byte length */
+#if LOG_MAX_BUFFER_SIZE > 255
+#error "LOG_MAX_BUFFER_SIZE must not exceed 255"
 #endif
 
-static const struct serial* g_serial_port = NULL;
-static enum log_level       g_min_level   = LOG_LEVEL_DEBUG;
-static bool                 g_show_level  = true;
-static bool                 g_initialized = false;
+#ifndef LOG_MAX_SINKS
+#define LOG_MAX_SINKS 4 /* serial_output included */
+#endif
+
+static struct log_sink          g_serial_sink;
+static struct log_sink*         g_sinks[LOG_MAX_SINKS];
+static volatile uint8_t         g_sink_count     = 0;
+static enum log_level           g_lowest_level   = LOG_LEVEL_DEBUG;
+static bool                     g_show_level     = true;
+static bool                     g_initialized    = false;
+static uint32_t                 g_dropped        = 0;
+static log_timestamp_t          g_get_timestamp  = NULL;
+static bool                     g_show_sequence  = false;
+static uint32_t                 g_sequence       = 0;
+static struct ring_buffer*      g_isr_buffer     = NULL;
+static bool                     g_collapse       = false;
+static uint32_t                 g_repeat_timeout = 0;
+static char                     g_last_body[LOG_MAX_BUFFER_SIZE];
+static size_t                   g_last_size      = 0;
+static const struct log_module* g_last_module    = NULL;
+static enum log_level           g_last_level     = LOG_LEVEL_DEBUG;
+static uint32_t                 g_repeats        = 0;
+static uint32_t                 g_repeat_since   = 0;
+static uint32_t                 g_suppressed     = 0;
 
 /**
  * @brief Copy string to buffer, character by character.
@@ -40,6 +78,672 @@ static size_t _copy_string(char* dest, const char* src, size_t max_len)
     return count;
 }
 
+/**
+ * @brief Append "\r\n" and the terminator. The caller leaves 3 bytes free.
+ * @return Line length, terminator excluded.
+ */
+static size_t _end_line(char* buffer, size_t pos)
+{
+    buffer[pos++] = '\r';
+    buffer[pos++] = '\n';
+    buffer[pos]   = '\0';
+    return pos;
+}
+
+/**
+ * @brief Write value in decimal, most significant digit first.
+ * @return Number of characters written (at most room).
+ */
+static size_t _format_uint(char* dest, size_t room, uint32_t value)
+{
+    char   digits[10];
+    size_t count = 0;
+    do
+    {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    size_t written = 0;
+    while (count > 0 && written < room)
+    {
+        dest[written++] = digits[--count];
+    }
+    return written;
+}
+
+/**
+ * @brief Write value in uppercase hexadecimal, zero padded to min_digits.
+ * @return Number of characters written (at most room).
+ */
+static size_t _format_hex(
+    char* dest, size_t room, uint32_t value, uint8_t min_digits)
+{
+    static const char hex_digits[] = "0123456789ABCDEF";
+
+    uint8_t digits = 8;
+    while (digits > 1 && digits > min_digits
+           && (value >> (4 * (digits - 1))) == 0)
+    {
+        digits -= 1;
+    }
+    size_t written = 0;
+    while (digits > 0 && written < room)
+    {
+        digits -= 1;
+        dest[written++] = hex_digits[(value >> (4 * digits)) & 0xF];
+    }
+    return written;
+}
+
+/**
+ * @brief Write value / 10^decimals with exactly decimals fractional digits.
+ * @return Number of characters written (at most room).
+ */
+static size_t _format_fixed(
+    char* dest, size_t room, int32_t value, uint8_t decimals)
+{
+    // Magnitude computed in unsigned arithmetic so INT32_MIN is handled
+    uint32_t magnitude = (value < 0) ? 0u - (uint32_t)value : (uint32_t)value;
+    uint32_t divisor   = 1;
+    for (uint8_t i = 0; i < decimals && i < 9; i++)
+    {
+        divisor *= 10;
+    }
+
+    size_t written = 0;
+    if (value < 0 && room > 0)
+    {
+        dest[written++] = '-';
+    }
+    written += _format_uint(
+        &dest[written], room - written, magnitude / divisor);
+    if (divisor == 1 || written >= room)
+    {
+        return written;
+    }
+    dest[written++] = '.';
+    uint32_t fraction = magnitude % divisor;
+    for (divisor /= 10; divisor > 0 && written < room; divisor /= 10)
+    {
+        dest[written++] = (char)('0' + (fraction / divisor) % 10);
+    }
+    return written;
+}
+
+/**
+ * @brief Format one log_format() argument.
+ * @return Number of characters written (at most room).
+ */
+static size_t _format_arg(char* dest, size_t room, const struct log_arg* arg)
+{
+    switch (arg->type)
+    {
+        case LOG_ARG_UINT:
+            return _format_uint(dest, room, arg->value.u);
+
+        case LOG_ARG_INT:
+            return _format_fixed(dest, room, arg->value.i, 0);
+
+        case LOG_ARG_HEX:
+            return _format_hex(dest, room, arg->value.u, arg->precision);
+
+        case LOG_ARG_STR:
+            return (arg->value.s != NULL)
+                       ? _copy_string(dest, arg->value.s, room)
+                       : 0;
+
+        case LOG_ARG_FIXED:
+            return _format_fixed(dest, room, arg->value.i, arg->precision);
+
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Take the next record sequence number.
+ */
+static uint32_t _next_sequence(void)
+{
+    uint32_t sequence;
+    LOG_ATOMIC({ sequence = g_sequence++; });
+    return sequence;
+}
+
+/**
+ * @brief Write the "TIMESTAMP #SEQUENCE [LEVEL] MODULE: " prefix into an
+ * empty line buffer, each part only if enabled.
+ * @return Number of characters written.
+ */
+static size_t _begin_line(
+    char* buffer, enum log_level level, const struct log_module* module)
+{
+    static const char* const level_names[]
+        = {"DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
+
+    size_t end = LOG_MAX_BUFFER_SIZE - 3; /* Room for \r\n\0 */
+    size_t pos = 0;
+    if (g_get_timestamp != NULL)
+    {
+        pos += _format_uint(&buffer[pos], end - pos, g_get_timestamp());
+        if (pos < end)
+        {
+            buffer[pos++] = ' ';
+        }
+    }
+    if (g_show_sequence && end - pos >= 2)
+    {
+        buffer[pos++] = '#';
+        pos += _format_uint(&buffer[pos], end - pos, _next_sequence());
+        if (pos < end)
+        {
+            buffer[pos++] = ' ';
+        }
+    }
+    if (g_show_level && level < LOG_LEVEL_NONE && end - pos >= 8)
+    {
+        buffer[pos++] = '[';
+        pos += _copy_string(&buffer[pos], level_names[level], end - pos - 2);
+        buffer[pos++] = ']';
+        buffer[pos++] = ' ';
+    }
+    if (module != NULL && end - pos >= 2)
+    {
+        pos += _copy_string(&buffer[pos], module->name, end - pos - 2);
+        buffer[pos++] = ':';
+        buffer[pos++] = ' ';
+    }
+    return pos;
+}
+
+/**
+ * @brief Store the low size bytes of value, little-endian.
+ * @return size
+ */
+static size_t _put_le(uint8_t* dest, uint32_t value, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        dest[i] = (uint8_t)(value >> (8 * i));
+    }
+    return size;
+}
+
+/**
+ * @brief Free bytes in an asynchronous buffer. The ring buffer keeps one slot
+ * empty to tell full from empty, so it is one less than reported available.
+ */
+static size_t _async_free(const struct ring_buffer* queue)
+{
+    size_t available = 0;
+    ring_buffer_available(queue, &available);
+    return (available > 0) ? available - 1 : 0;
+}
+
+/**
+ * @brief Remove the oldest queued line. Must run inside LOG_ATOMIC.
+ * @return true if a line was removed, false if the buffer was empty.
+ */
+static bool _async_drop_oldest(struct ring_buffer* queue)
+{
+    uint8_t length;
+    if (ring_buffer_pop(queue, &length, 1) != 0)
+    {
+        return false;
+    }
+    uint8_t discard;
+    for (size_t i = 0; i < length; i++)
+    {
+        ring_buffer_pop(queue, &discard, 1);
+    }
+    return true;
+}
+
+/**
+ * @brief Queue a line as [LENGTH][BYTES...], applying the overflow policy.
+ * @return 0 if queued, -ENOSPC if the line was dropped.
+ */
+static int8_t _async_enqueue(
+    const struct log_sink* sink, const uint8_t* data, size_t size)
+{
+    struct ring_buffer* queue  = sink->async_buffer;
+    int8_t              status = 0;
+    uint8_t             length = (uint8_t)size;
+    LOG_ATOMIC({
+        if (sink->overflow_policy == LOG_DROP_OLDEST)
+        {
+            while (_async_free(queue) < size + 1 && _async_drop_oldest(queue))
+            {
+                g_dropped += 1;
+            }
+        }
+        if (_async_free(queue) < size + 1)
+        {
+            g_dropped += 1;
+            status = -ENOSPC;
+        }
+        else
+        {
+            ring_buffer_push(queue, &length, 1);
+            ring_buffer_push(queue, data, size);
+        }
+    });
+    return status;
+}
+
+/**
+ * @brief Take the lock of a synchronous sink. Only the claim runs inside
+ * LOG_ATOMIC, never the write.
+ * @param wait Spin while another task writes to the sink. log_drain() does
+ * not wait, since it may have interrupted that task.
+ * @return true if taken.
+ */
+static bool _sink_lock(struct log_sink* sink, bool wait)
+{
+    bool taken = false;
+    do
+    {
+        LOG_ATOMIC({
+            taken      = !sink->busy;
+            sink->busy = true;
+        });
+    } while (!taken && wait);
+    return taken;
+}
+
+static void _sink_unlock(struct log_sink* sink)
+{
+    LOG_ATOMIC({ sink->busy = false; });
+}
+
+/**
+ * @brief Write a record to the output of a sink, now. Synchronous sinks are
+ * written with their lock held by the caller, so lines never interleave.
+ */
+static int8_t _sink_write(
+    const struct log_sink* sink, const uint8_t* data, size_t size)
+{
+    switch (sink->type)
+    {
+        case LOG_SINK_SERIAL:
+            return sink->serial->ops->transmit(sink->serial, data, size);
+
+        case LOG_SINK_RING_BUFFER:
+            // The push copies byte by byte: without overwrite, check first so
+            // that a record is stored whole or not at all
+            if (!sink->trace_buffer->overwrite
+                && _async_free(sink->trace_buffer) < size)
+            {
+                return -ENOSPC;
+            }
+            return ring_buffer_push(sink->trace_buffer, data, size);
+
+        case LOG_SINK_CALLBACK:
+            return sink->write(sink->context, data, size);
+
+        default:
+            return -EINVAL;
+    }
+}
+
+/**
+ * @brief Pass a formatted record to every sink whose level it reaches,
+ * writing it or queueing it in the sink's asynchronous buffer.
+ * @param wait As for _sink_lock(). A record meeting a locked sink is dropped
+ * for that sink.
+ * @return 0, or the first error returned by a sink.
+ */
+static int8_t _dispatch(
+    enum log_level level, const uint8_t* data, size_t size, bool wait)
+{
+    int8_t result = 0;
+    for (uint8_t i = 0; i < g_sink_count; i++)
+    {
+        struct log_sink* sink = g_sinks[i];
+        if (level < sink->min_level)
+        {
+            continue;
+        }
+        int8_t status;
+        if (sink->async_buffer != NULL)
+        {
+            status = _async_enqueue(sink, data, size);
+        }
+        else
+        {
+            if (_sink_lock(sink, wait))
+            {
+                status = _sink_write(sink, data, size);
+                _sink_unlock(sink);
+            }
+            else
+            {
+                LOG_ATOMIC({ g_dropped += 1; });
+                status = -EBUSY;
+            }
+        }
+        if (result == 0)
+        {
+            result = status;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Queue a record logged from an interrupt as [LENGTH][LEVEL][BYTES...]
+ * for log_drain() to dispatch. Only masks interrupts for the copy.
+ * @return 0 if queued, -ENOSPC if the record was dropped.
+ */
+static int8_t _isr_enqueue(
+    enum log_level level, const uint8_t* data, size_t size)
+{
+    int8_t  status    = 0;
+    uint8_t header[2] = {(uint8_t)size, (uint8_t)level};
+    LOG_ATOMIC({
+        if (_async_free(g_isr_buffer) < size + sizeof(header))
+        {
+            g_dropped += 1;
+            status = -ENOSPC;
+        }
+        else
+        {
+            ring_buffer_push(g_isr_buffer, header, sizeof(header));
+            ring_buffer_push(g_isr_buffer, data, size);
+        }
+    });
+    return status;
+}
+
+/**
+ * @brief Dispatch the oldest record queued from an interrupt.
+ * @return As log_drain().
+ */
+static int8_t _isr_forward(void)
+{
+    uint8_t buffer[LOG_MAX_BUFFER_SIZE];
+    uint8_t header[2];
+    int8_t  status = 0;
+    LOG_ATOMIC({
+        status = ring_buffer_pop(g_isr_buffer, header, sizeof(header));
+        if (status == 0)
+        {
+            ring_buffer_pop(g_isr_buffer, buffer, header[0]);
+        }
+    });
+    if (status != 0)
+    {
+        return -ENODATA;
+    }
+    return _dispatch((enum log_level)header[1], buffer, header[0], false);
+}
+
+/**
+ * @brief Recompute the lowest level any sink accepts, the early filter of
+ * every log call.
+ */
+static void _update_lowest_level(void)
+{
+    enum log_level lowest = LOG_LEVEL_NONE;
+    for (uint8_t i = 0; i < g_sink_count; i++)
+    {
+        if (g_sinks[i]->min_level < lowest)
+        {
+            lowest = g_sinks[i]->min_level;
+        }
+    }
+    g_lowest_level = lowest;
+}
+
+/**
+ * @brief Check the fields of a sink against its type.
+ * @return 0 if valid, -EFAULT or -EINVAL as for log_add_sink().
+ */
+static int8_t _validate_sink(const struct log_sink* sink)
+{
+    if ((sink->type == LOG_SINK_SERIAL && sink->serial == NULL)
+        || (sink->type == LOG_SINK_RING_BUFFER && sink->trace_buffer == NULL)
+        || (sink->type == LOG_SINK_CALLBACK && sink->write == NULL))
+    {
+        return -EFAULT;
+    }
+    if (sink->type > LOG_SINK_CALLBACK
+        || sink->overflow_policy > LOG_DROP_OLDEST)
+    {
+        return -EINVAL;
+    }
+    if (sink->async_buffer != NULL
+        && (sink->type == LOG_SINK_RING_BUFFER
+            || sink->async_buffer->overwrite))
+    {
+        return -EINVAL;
+    }
+    return 0;
+}
+
+/**
+ * @brief Find a registered sink.
+ * @return Its index, or -ENOENT.
+ */
+static int8_t _find_sink(const struct log_sink* sink)
+{
+    for (uint8_t i = 0; i < g_sink_count; i++)
+    {
+        if (g_sinks[i] == sink)
+        {
+            return (int8_t)i;
+        }
+    }
+    return -ENOENT;
+}
+
+/**
+ * @brief Dispatch "last message repeated N times" at the level of the
+ * repeated message.
+ * @param wait As _dispatch().
+ */
+static int8_t _report_repeats(enum log_level level, uint32_t count, bool wait)
+{
+    char   buffer[LOG_MAX_BUFFER_SIZE];
+    size_t end = LOG_MAX_BUFFER_SIZE - 3; /* Room for \r\n\0 */
+    size_t pos = _begin_line(buffer, level, NULL);
+    pos += _copy_string(&buffer[pos], "last message repeated ", end - pos);
+    pos += _format_uint(&buffer[pos], end - pos, count);
+    pos += _copy_string(
+        &buffer[pos], (count == 1) ? " time" : " times", end - pos);
+    pos = _end_line(buffer, pos);
+    return _dispatch(level, (const uint8_t*)buffer, pos, wait);
+}
+
+/**
+ * @brief Check a text record against the previous one (level, module and
+ * message bytes, prefix excluded). A different record first reports how many
+ * times the previous one was repeated.
+ * @return true if the record repeats the previous one and must be dropped.
+ */
+static bool _is_repeat(
+    enum log_level           level,
+    const struct log_module* module,
+    const char*              body,
+    size_t                   size)
+{
+    uint32_t now = (g_get_timestamp != NULL) ? g_get_timestamp() : 0;
+
+    bool           repeat        = false;
+    uint32_t       repeats       = 0;
+    enum log_level repeats_level = LOG_LEVEL_DEBUG;
+    LOG_ATOMIC({
+        if (level == g_last_level && module == g_last_module
+            && size == g_last_size && memcmp(body, g_last_body, size) == 0)
+        {
+            if (g_repeats == 0)
+            {
+                g_repeat_since = now;
+            }
+            g_repeats    += 1;
+            g_suppressed += 1;
+            repeat       = true;
+        }
+        else
+        {
+            repeats       = g_repeats;
+            repeats_level = g_last_level;
+            g_repeats     = 0;
+            g_last_level  = level;
+            g_last_module = module;
+            g_last_size   = size;
+            memcpy(g_last_body, body, size);
+        }
+    });
+    if (repeats > 0)
+    {
+        (void)_report_repeats(repeats_level, repeats, true);
+    }
+    return repeat;
+}
+
+/**
+ * @brief Report the repeats of the last record once the first of them is
+ * repeat_timeout old, so a message that stops repeating is not left
+ * unreported until a different one arrives. The last record stays the
+ * reference for the next repeats.
+ * @return As log_drain().
+ */
+static int8_t _flush_repeats(void)
+{
+    uint32_t now = (g_get_timestamp != NULL) ? g_get_timestamp() : 0;
+
+    uint32_t       repeats       = 0;
+    enum log_level repeats_level = LOG_LEVEL_DEBUG;
+    LOG_ATOMIC({
+        if (g_repeats > 0 && now - g_repeat_since >= g_repeat_timeout)
+        {
+            repeats       = g_repeats;
+            repeats_level = g_last_level;
+            g_repeats     = 0;
+        }
+    });
+    if (repeats == 0)
+    {
+        return -ENODATA;
+    }
+    return _report_repeats(repeats_level, repeats, false);
+}
+
+/**
+ * @brief Send a formatted text record on: queue it for log_drain() when
+ * logged from an interrupt, drop it if it repeats the previous record (with
+ * collapse_repeats), or dispatch it.
+ * @param body Offset of the message, after the prefix.
+ */
+static int8_t _output(
+    enum log_level           level,
+    const struct log_module* module,
+    const char*              buffer,
+    size_t                   body,
+    size_t                   size,
+    bool                     from_isr)
+{
+    if (from_isr)
+    {
+        return _isr_enqueue(level, (const uint8_t*)buffer, size);
+    }
+    if (g_collapse && _is_repeat(level, module, &buffer[body], size - body))
+    {
+        return 0;
+    }
+    return _dispatch(level, (const uint8_t*)buffer, size, true);
+}
+
+/**
+ * @brief Format a text record and dispatch it, or queue it for log_drain()
+ * when logged from an interrupt.
+ */
+static int8_t _write(
+    const struct log_module* module,
+    enum log_level           level,
+    const char*              msg,
+    bool                     from_isr)
+{
+    if (msg == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!g_initialized)
+    {
+        return -EPERM;
+    }
+    if (from_isr && g_isr_buffer == NULL)
+    {
+        return -ENOTSUP;
+    }
+    if (level < g_lowest_level || (module != NULL && level < module->min_level))
+    {
+        return 0; /* Filtered out, not an error */
+    }
+
+    char   buffer[LOG_MAX_BUFFER_SIZE];
+    size_t body = _begin_line(buffer, level, module);
+
+    /* Copy message, leaving room for \r\n\0 */
+    size_t pos = body;
+    pos += _copy_string(&buffer[pos], msg, LOG_MAX_BUFFER_SIZE - pos - 3);
+    pos = _end_line(buffer, pos);
+
+    return _output(level, module, buffer, body, pos, from_isr);
+}
+
+/**
+ * @brief log_format() with an optional module, see _write().
+ */
+static int8_t _format(
+    const struct log_module* module,
+    enum log_level           level,
+    const char*              fmt,
+    const struct log_arg*    args,
+    uint8_t                  arg_count,
+    bool                     from_isr)
+{
+    if (fmt == NULL || (args == NULL && arg_count > 0))
+    {
+        return -EFAULT;
+    }
+    if (!g_initialized)
+    {
+        return -EPERM;
+    }
+    if (from_isr && g_isr_buffer == NULL)
+    {
+        return -ENOTSUP;
+    }
+    if (level < g_lowest_level || (module != NULL && level < module->min_level))
+    {
+        return 0; /* Filtered out, not an error */
+    }
+
+    char    buffer[LOG_MAX_BUFFER_SIZE];
+    size_t  body = _begin_line(buffer, level, module);
+    size_t  pos  = body;
+    size_t  end  = LOG_MAX_BUFFER_SIZE - 3; /* Room for \r\n\0 */
+    uint8_t next = 0;
+    while (*fmt != '\0' && pos < end)
+    {
+        if (fmt[0] == '{' && fmt[1] == '}' && next < arg_count)
+        {
+            pos += _format_arg(&buffer[pos], end - pos, &args[next++]);
+            fmt += 2;
+        }
+        else
+        {
+            buffer[pos++] = *fmt++;
+        }
+    }
+    pos = _end_line(buffer, pos);
+
+    return _output(level, module, buffer, body, pos, from_isr);
+}
+
 /* ========================================================================== */
 
 /* PUBLIC */
@@ -52,10 +756,39 @@ int8_t log_init(const struct log_config* config)
     {
         return -EFAULT;
     }
-    g_serial_port = config->serial_output;
-    g_min_level   = config->min_level;
-    g_show_level  = config->show_level;
-    g_initialized = true;
+    struct log_sink serial_sink
+        = {.type            = LOG_SINK_SERIAL,
+           .min_level       = config->min_level,
+           .serial          = config->serial_output,
+           .async_buffer    = config->async_buffer,
+           .overflow_policy = config->overflow_policy};
+    int8_t status = _validate_sink(&serial_sink);
+    if (status != 0)
+    {
+        return status;
+    }
+    if (config->isr_buffer != NULL && config->isr_buffer->overwrite)
+    {
+        return -EINVAL;
+    }
+    g_serial_sink    = serial_sink;
+    g_sinks[0]       = &g_serial_sink;
+    g_sink_count     = 1;
+    g_show_level     = config->show_level;
+    g_dropped        = 0;
+    g_get_timestamp  = config->get_timestamp;
+    g_show_sequence  = config->show_sequence;
+    g_sequence       = 0;
+    g_isr_buffer     = config->isr_buffer;
+    g_collapse       = config->collapse_repeats;
+    g_repeat_timeout = config->repeat_timeout;
+    g_last_size      = 0;
+    g_last_module    = NULL;
+    g_last_level     = LOG_LEVEL_NONE; /* Matches no record */
+    g_repeats        = 0;
+    g_suppressed     = 0;
+    g_initialized    = true;
+    _update_lowest_level();
     return 0;
 }
 
@@ -65,7 +798,8 @@ int8_t log_set_level(enum log_level level)
     {
         return -EPERM;
     }
-    g_min_level = level;
+    g_serial_sink.min_level = level;
+    _update_lowest_level();
     return 0;
 }
 
@@ -79,7 +813,7 @@ int8_t log_get_level(enum log_level* level)
     {
         return -EPERM;
     }
-    *level = g_min_level;
+    *level = g_serial_sink.min_level;
     return 0;
 }
 
@@ -94,9 +828,9 @@ int8_t log_show_level(bool enable)
     return 0;
 }
 
-int8_t log_write(enum log_level level, const char* msg)
+int8_t log_add_sink(struct log_sink* sink)
 {
-    if (msg == NULL)
+    if (sink == NULL)
     {
         return -EFAULT;
     }
@@ -104,37 +838,108 @@ int8_t log_write(enum log_level level, const char* msg)
     {
         return -EPERM;
     }
-    if (level < g_min_level)
+    int8_t status = _validate_sink(sink);
+    if (status != 0)
     {
-        return 0; /* Filtered out, not an error */
+        return status;
     }
+    if (_find_sink(sink) >= 0)
+    {
+        return -EALREADY;
+    }
+    if (g_sink_count >= LOG_MAX_SINKS)
+    {
+        return -ENOSPC;
+    }
+    sink->busy = false;
+    LOG_ATOMIC({
+        g_sinks[g_sink_count] = sink;
+        g_sink_count += 1;
+        _update_lowest_level();
+    });
+    return 0;
+}
 
-    static const char* const level_names[]
-        = {"DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
-
-    char   buffer[LOG_MAX_BUFFER_SIZE];
-    size_t pos = 0;
+int8_t log_remove_sink(struct log_sink* sink)
+{
+    if (sink == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!g_initialized)
+    {
+        return -EPERM;
+    }
+    int8_t index = _find_sink(sink);
+    if (index < 0)
+    {
+        return index;
+    }
+    LOG_ATOMIC({
+        for (uint8_t i = (uint8_t)index; i + 1 < g_sink_count; i++)
+        {
+            g_sinks[i] = g_sinks[i + 1];
+        }
+        g_sink_count -= 1;
+        _update_lowest_level();
+    });
+    return 0;
+}
 
-    /* Build level prefix if enabled: "[LEVEL] " */
-    if (g_show_level && level < LOG_LEVEL_NONE)
+int8_t log_sink_set_level(struct log_sink* sink, enum log_level level)
+{
+    if (sink == NULL)
     {
-        buffer[pos++] = '[';
-        pos += _copy_string(
-            &buffer[pos], level_names[level], LOG_MAX_BUFFER_SIZE - pos - 1);
-        buffer[pos++] = ']';
-        buffer[pos++] = ' ';
+        return -EFAULT;
     }
+    if (!g_initialized)
+    {
+        return -EPERM;
+    }
+    if (_find_sink(sink) < 0)
+    {
+        return -ENOENT;
+    }
+    sink->min_level = level;
+    _update_lowest_level();
+    return 0;
+}
 
-    /* Copy message, leaving room for \r\n\0 */
-    pos += _copy_string(&buffer[pos], msg, LOG_MAX_BUFFER_SIZE - pos - 3);
+int8_t log_write(enum log_level level, const char* msg)
+{
+    return _write(NULL, level, msg, false);
+}
 
-    /* Append newline */
-    buffer[pos++] = '\r';
-    buffer[pos++] = '\n';
-    buffer[pos]   = '\0';
+int8_t log_module_write(
+    const struct log_module* module, enum log_level level, const char* msg)
+{
+    return _write(module, level, msg, false);
+}
 
-    return g_serial_port->ops->transmit(
-        g_serial_port, (const uint8_t*)buffer, pos);
+int8_t log_write_record(enum log_level level, const uint8_t* data, size_t size)
+{
+    if (data == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!g_initialized)
+    {
+        return -EPERM;
+    }
+    if (size == 0 || size > LOG_MAX_BUFFER_SIZE)
+    {
+        return -EINVAL;
+    }
+    if (level < g_lowest_level)
+    {
+        return 0; /* Filtered out, not an error */
+    }
+    return _dispatch(level, data, size, true);
+}
+
+int8_t log_write_from_isr(enum log_level level, const char* msg)
+{
+    return _write(NULL, level, msg, true);
 }
 
 int8_t log_debug(const char* msg)
@@ -199,3 +1004,243 @@ int8_t log_value(const char* msg, void* value, enum value_type type)
 }
 
 /* ========================================================================== */
+
+int8_t log_format(
+    enum log_level        level,
+    const char*           fmt,
+    const struct log_arg* args,
+    uint8_t               arg_count)
+{
+    return _format(NULL, level, fmt, args, arg_count, false);
+}
+
+int8_t log_module_format(
+    const struct log_module* module,
+    enum log_level           level,
+    const char*              fmt,
+    const struct log_arg*    args,
+    uint8_t                  arg_count)
+{
+    return _format(module, level, fmt, args, arg_count, false);
+}
+
+int8_t log_format_from_isr(
+    enum log_level        level,
+    const char*           fmt,
+    const struct log_arg* args,
+    uint8_t               arg_count)
+{
+    return _format(NULL, level, fmt, args, arg_count, true);
+}
+
+int8_t log_token(
+    enum log_level  level,
+    uint32_t        id,
+    const uint32_t* args,
+    uint8_t         arg_count)
+{
+    if (args == NULL && arg_count > 0)
+    {
+        return -EFAULT;
+    }
+    if (!g_initialized)
+    {
+        return -EPERM;
+    }
+    if (arg_count > LOG_TOKEN_MAX_ARGS || level >= LOG_LEVEL_NONE)
+    {
+        return -EINVAL;
+    }
+    if (id > UINT16_MAX)
+    {
+        return -ERANGE; /* Would collide with the string at id & 0xFFFF */
+    }
+    if (level < g_lowest_level)
+    {
+        return 0; /* Filtered out, not an error */
+    }
+
+    uint8_t record
+        [LOG_TOKEN_HEADER_SIZE + LOG_TOKEN_META_SIZE + 4 * LOG_TOKEN_MAX_ARGS];
+    uint8_t header    = (uint8_t)(((uint8_t)level << 4) | arg_count);
+    bool    with_meta = (g_get_timestamp != NULL || g_show_sequence);
+    if (with_meta)
+    {
+        header |= LOG_TOKEN_META_FLAG;
+    }
+
+    size_t pos    = 0;
+    record[pos++] = LOG_TOKEN_SYNC;
+    record[pos++] = header;
+    pos += _put_le(&record[pos], id, 2);
+    if (with_meta)
+    {
+        uint32_t timestamp = (g_get_timestamp != NULL) ? g_get_timestamp() : 0;
+        pos += _put_le(&record[pos], timestamp, 4);
+        pos += _put_le(&record[pos], _next_sequence(), 2);
+    }
+    for (uint8_t i = 0; i < arg_count; i++)
+    {
+        pos += _put_le(&record[pos], args[i], 4);
+    }
+    return _dispatch(level, record, pos, true);
+}
+
+int8_t log_module_set_level(struct log_module* module, enum log_level level)
+{
+    if (module == NULL)
+    {
+        return -EFAULT;
+    }
+    if (level > LOG_LEVEL_NONE)
+    {
+        return -EINVAL;
+    }
+    module->min_level = level;
+    return 0;
+}
+
+int8_t log_drain(void)
+{
+    if (!g_initialized)
+    {
+        return -EPERM;
+    }
+
+    int8_t result = (g_isr_buffer != NULL) ? _isr_forward() : -ENODATA;
+    if (g_collapse)
+    {
+        int8_t status = _flush_repeats();
+        if (result == -ENODATA || (result == 0 && status != -ENODATA))
+        {
+            result = status;
+        }
+    }
+    for (uint8_t i = 0; i < g_sink_count; i++)
+    {
+        const struct log_sink* sink = g_sinks[i];
+        if (sink->async_buffer == NULL)
+        {
+            continue;
+        }
+
+        uint8_t buffer[LOG_MAX_BUFFER_SIZE];
+        uint8_t length = 0;
+        int8_t  status = 0;
+        LOG_ATOMIC({
+            status = ring_buffer_pop(sink->async_buffer, &length, 1);
+            if (status == 0)
+            {
+                ring_buffer_pop(sink->async_buffer, buffer, length);
+            }
+        });
+        if (status != 0)
+        {
+            continue;
+        }
+        status = _sink_write(sink, buffer, length);
+        if (result == -ENODATA || (result == 0 && status != 0))
+        {
+            result = status;
+        }
+    }
+    return result;
+}
+
+int8_t log_get_dropped(uint32_t* dropped)
+{
+    if (dropped == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!g_initialized)
+    {
+        return -EPERM;
+    }
+    *dropped = g_dropped;
+    return 0;
+}
+
+/* ========================================================================== */
+
+bool log_rate_allow(
+    struct log_rate_limit* limit,
+    enum log_level         level,
+    uint16_t               burst,
+    uint32_t               period)
+{
+    if (limit == NULL || !g_initialized)
+    {
+        return false;
+    }
+    if (g_get_timestamp == NULL || period == 0)
+    {
+        return true;
+    }
+
+    uint32_t now        = g_get_timestamp();
+    uint32_t suppressed = 0;
+    bool     allowed    = false;
+    LOG_ATOMIC({
+        // Give back the tokens earned since the last refill
+        if (limit->spent > 0)
+        {
+            uint32_t earned = (now - limit->last_refill) / period;
+            if (earned >= limit->spent)
+            {
+                limit->spent = 0;
+            }
+            else
+            {
+                limit->spent       -= (uint16_t)earned;
+                limit->last_refill += earned * period;
+            }
+        }
+        if (limit->spent < burst)
+        {
+            if (limit->spent == 0)
+            {
+                limit->last_refill = now;
+            }
+            limit->spent      += 1;
+            suppressed        = limit->suppressed;
+            limit->suppressed = 0;
+            allowed           = true;
+        }
+        else
+        {
+            limit->suppressed += 1;
+            g_suppressed      += 1;
+        }
+    });
+
+    if (suppressed > 0)
+    {
+        const struct log_arg count = LOG_U(suppressed);
+        (void)log_format(
+            level,
+            (suppressed == 1) ? "{} similar message suppressed"
+                              : "{} similar messages suppressed",
+            &count,
+            1);
+    }
+    return allowed;
+}
+
+/* ========================================================================== */
+
+int8_t log_get_suppressed(uint32_t* suppressed)
+{
+    if (suppressed == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!g_initialized)
+    {
+        return -EPERM;
+    }
+    *suppressed = g_suppressed;
+    return 0;
+}
+
+/* ========================================================================== */
@@ -0,0 +1,21 @@
+/**
+ * @file critical_pthread.h
+ * @brief Host CRITICAL_HEADER for test_logging_threads: a global mutex
+ * stands in for masking interrupts.
+ */
+
+#ifndef CRITICAL_PTHREAD_H
+#define CRITICAL_PTHREAD_H
+
+#include <pthread.h>
+
+extern pthread_mutex_t critical_pthread_mutex;
+
+#define CRITICAL_SECTION_STATE_T int
+#define CRITICAL_SECTION_ENTER(state) \
+    ((state) = pthread_mutex_lock(&critical_pthread_mutex))
+#define CRITICAL_SECTION_EXIT(state) \
+    ((void)(state), (void)pthread_mutex_unlock(&critical_pthread_mutex))
+#define CLEAR_WDT()
+
+#endif /* CRITICAL_PTHREAD_H */
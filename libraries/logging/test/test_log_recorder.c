@@ -0,0 +1,207 @@
+#include "log_recorder.h"
+#include "logging.h"
+#include "serial.h"
+#include "string.h"
+#include "unity.h"
+
+/* ========================================================================== */
+
+static char   tx_text[512];
+static size_t tx_index;
+
+static int8_t mock_transmit(
+    const struct serial* self, const uint8_t* buffer, size_t size)
+{
+    (void)self;
+    for (size_t i = 0; i < size && tx_index < sizeof(tx_text) - 1; i++)
+    {
+        tx_text[tx_index++] = (char)buffer[i];
+    }
+    return 0;
+}
+
+static const struct serial_ops mock_ops    = {.transmit = mock_transmit};
+static struct serial           mock_serial = {.ops = &mock_ops};
+
+#define RECORDER_DATA_SIZE 64
+
+// Stands in for the no-init section: setUp does not clear it between the
+// "runs" of a test
+static uint32_t recorder_ram[(LOG_RECORDER_HEADER_SIZE + RECORDER_DATA_SIZE)
+                             / sizeof(uint32_t)];
+
+static struct log_recorder recorder;
+
+/**
+ * @brief Simulate a reset: a fresh recorder object over the same RAM.
+ */
+static size_t reboot_recorder(void)
+{
+    size_t recovered = 0;
+    memcpy(
+        &recorder,
+        &(struct log_recorder){
+            .memory = recorder_ram, .size = sizeof(recorder_ram)},
+        sizeof(recorder));
+    TEST_ASSERT_EQUAL(0, log_recorder_init(&recorder, &recovered));
+    return recovered;
+}
+
+static void reboot_log(void)
+{
+    struct log_config log_configuration = {
+        .serial_output = &mock_serial,
+        .min_level     = LOG_LEVEL_INFO,
+        .show_level    = true,
+    };
+    TEST_ASSERT_EQUAL(0, log_init(&log_configuration));
+    tx_index = 0;
+    memset(tx_text, 0, sizeof(tx_text));
+}
+
+/* ========================================================================== */
+
+void setUp(void)
+{
+    memset(recorder_ram, 0xA5, sizeof(recorder_ram));  // Power-on garbage
+    reboot_log();
+}
+
+void tearDown(void)
+{
+}
+
+/* ========================================================================== */
+
+void test_records_survive_warm_reset(void)
+{
+    TEST_ASSERT_EQUAL(0, reboot_recorder());  // Power-on: nothing recovered
+    static struct log_sink recorder_sink;
+    recorder_sink = (struct log_sink){
+        .type      = LOG_SINK_CALLBACK,
+        .min_level = LOG_LEVEL_DEBUG,
+        .write     = log_recorder_write,
+        .context   = &recorder,
+    };
+    TEST_ASSERT_EQUAL(0, log_add_sink(&recorder_sink));
+    log_debug("tick");
+    log_error("stack low");
+
+    // Watchdog reset
+    reboot_log();
+    TEST_ASSERT_EQUAL(
+        strlen("[DEBUG] tick\r\n[ERROR] stack low\r\n")
+            + 2 * LOG_RECORDER_RECORD_OVERHEAD,
+        reboot_recorder());
+    TEST_ASSERT_EQUAL(0, log_recorder_dump(&recorder, LOG_LEVEL_WARN));
+    TEST_ASSERT_EQUAL_STRING(
+        "[WARN] --- flight recorder ---\r\n"
+        "[DEBUG] tick\r\n[ERROR] stack low\r\n"
+        "[WARN] --- end of flight recorder ---\r\n",
+        tx_text);
+
+    TEST_ASSERT_EQUAL(0, log_recorder_clear(&recorder));
+    TEST_ASSERT_EQUAL(-ENODATA, log_recorder_dump(&recorder, LOG_LEVEL_WARN));
+}
+
+/* ========================================================================== */
+
+void test_wrapped_recorder_dumps_whole_records_only(void)
+{
+    reboot_recorder();
+    const char* lines[]
+        = {"first line\n", "second line\n", "third line\n", "fourth line\n",
+           "fifth\n"};
+    for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); i++)
+    {
+        TEST_ASSERT_EQUAL(
+            0,
+            log_recorder_write(
+                &recorder, (const uint8_t*)lines[i], strlen(lines[i])));
+    }
+
+    // The oldest records made room for the newer ones
+    TEST_ASSERT_EQUAL(
+        strlen("third line\nfourth line\nfifth\n")
+            + 3 * LOG_RECORDER_RECORD_OVERHEAD,
+        reboot_recorder());
+    TEST_ASSERT_EQUAL(0, log_recorder_dump(&recorder, LOG_LEVEL_WARN));
+    TEST_ASSERT_EQUAL_STRING(
+        "[WARN] --- flight recorder ---\r\n"
+        "third line\nfourth line\nfifth\n"
+        "[WARN] --- end of flight recorder ---\r\n",
+        tx_text);
+}
+
+/* ========================================================================== */
+
+void test_binary_records_survive_wrap_intact(void)
+{
+    reboot_recorder();
+    const uint8_t text[20]   = "0123456789012345678\n";
+    const uint8_t binary[20] = {0x0A, 0x00, 0x12, 0x0A, 0x0A, 0xFF, 0x0D,
+                                0x0A, 0x00, 0x00, 0x0A, 0x34, 0x56, 0x0A,
+                                0x78, 0x9A, 0x0A, 0xBC, 0x0A, 0x0A};
+    TEST_ASSERT_EQUAL(0, log_recorder_write(&recorder, text, sizeof(text)));
+    TEST_ASSERT_EQUAL(0, log_recorder_write(&recorder, text, sizeof(text)));
+    // Drops the first record and wraps around the end of the data area
+    TEST_ASSERT_EQUAL(
+        0, log_recorder_write(&recorder, binary, sizeof(binary)));
+
+    reboot_log();
+    TEST_ASSERT_EQUAL(
+        sizeof(text) + sizeof(binary) + 2 * LOG_RECORDER_RECORD_OVERHEAD,
+        reboot_recorder());
+    TEST_ASSERT_EQUAL(0, log_recorder_dump(&recorder, LOG_LEVEL_WARN));
+
+    const char* start = "[WARN] --- flight recorder ---\r\n";
+    size_t      at    = strlen(start);
+    TEST_ASSERT_EQUAL_MEMORY(start, tx_text, at);
+    TEST_ASSERT_EQUAL_MEMORY(text, &tx_text[at], sizeof(text));
+    TEST_ASSERT_EQUAL_MEMORY(
+        binary, &tx_text[at + sizeof(text)], sizeof(binary));
+    TEST_ASSERT_EQUAL_STRING(
+        "[WARN] --- end of flight recorder ---\r\n",
+        &tx_text[at + sizeof(text) + sizeof(binary)]);
+}
+
+/* ========================================================================== */
+
+void test_damaged_record_drops_it_and_older_ones(void)
+{
+    reboot_recorder();
+    TEST_ASSERT_EQUAL(
+        0, log_recorder_write(&recorder, (const uint8_t*)"older\n", 6));
+    TEST_ASSERT_EQUAL(
+        0, log_recorder_write(&recorder, (const uint8_t*)"newer\n", 6));
+    // Stray write into the data of the older record, past its length and CRC
+    ((uint8_t*)recorder_ram)[LOG_RECORDER_HEADER_SIZE + 6] ^= 0x01;
+
+    TEST_ASSERT_EQUAL(6 + LOG_RECORDER_RECORD_OVERHEAD, reboot_recorder());
+    TEST_ASSERT_EQUAL(0, log_recorder_dump(&recorder, LOG_LEVEL_WARN));
+    TEST_ASSERT_EQUAL_STRING(
+        "[WARN] --- flight recorder ---\r\n"
+        "newer\n"
+        "[WARN] --- end of flight recorder ---\r\n",
+        tx_text);
+}
+
+/* ========================================================================== */
+
+void test_corrupted_header_starts_empty(void)
+{
+    reboot_recorder();
+    TEST_ASSERT_EQUAL(
+        0, log_recorder_write(&recorder, (const uint8_t*)"lost\n", 5));
+    recorder_ram[2] ^= 0x10;  // Write offset hit by a stray write
+
+    TEST_ASSERT_EQUAL(0, reboot_recorder());
+    TEST_ASSERT_EQUAL(-ENODATA, log_recorder_dump(&recorder, LOG_LEVEL_WARN));
+
+    struct log_recorder unaligned
+        = {.memory = (uint8_t*)recorder_ram + 1, .size = 32};
+    TEST_ASSERT_EQUAL(-EINVAL, log_recorder_init(&unaligned, NULL));
+    TEST_ASSERT_EQUAL(-EFAULT, log_recorder_write(NULL, NULL, 0));
+}
+
+/* ========================================================================== */
@@ -40,6 +40,13 @@ static struct serial test_serial = {
     .was_initialized = true,
 };
 
+static uint32_t fake_time;
+
+static uint32_t fake_get_timestamp(void)
+{
+    return fake_time;
+}
+
 /* ========================================================================== */
 
 void setUp(void)
@@ -175,3 +182,588 @@ void test_example(void)
 }
 
 /* ========================================================================== */
+
+/* The queued length of a line is one byte */
+_Static_assert(LOG_MAX_BUFFER_SIZE <= UINT8_MAX, "queued length overflows");
+
+static uint8_t            _async_raw[32];
+static struct ring_buffer async_buffer
+    = {.buffer = _async_raw, .size = sizeof(_async_raw), .overwrite = false};
+
+void test_async_write_defers_transmit_until_drain(void)
+{
+    ring_buffer_init(&async_buffer);
+    struct log_config log_configuration = {
+        .serial_output = &test_serial,
+        .min_level     = LOG_LEVEL_DEBUG,
+        .show_level    = true,
+        .async_buffer  = &async_buffer,
+    };
+    TEST_ASSERT_EQUAL(0, log_init(&log_configuration));
+
+    TEST_ASSERT_EQUAL(0, log_info("one"));
+    TEST_ASSERT_EQUAL(0, tx_index);  // Nothing sent yet
+
+    TEST_ASSERT_EQUAL(0, log_drain());
+    TEST_ASSERT_EQUAL_STRING("[INFO] one\r\n", (const char*)tx_buffer);
+    TEST_ASSERT_EQUAL(-ENODATA, log_drain());
+}
+
+void test_async_drop_newest_counts_dropped(void)
+{
+    ring_buffer_init(&async_buffer);
+    struct log_config log_configuration = {
+        .serial_output   = &test_serial,
+        .min_level       = LOG_LEVEL_DEBUG,
+        .show_level      = true,
+        .async_buffer    = &async_buffer,
+        .overflow_policy = LOG_DROP_NEWEST,
+    };
+    TEST_ASSERT_EQUAL(0, log_init(&log_configuration));
+
+    // 14 bytes per queued line ([LENGTH] + "[INFO] msgN\r\n"): two fit in 31
+    TEST_ASSERT_EQUAL(0, log_info("msg1"));
+    TEST_ASSERT_EQUAL(0, log_info("msg2"));
+    TEST_ASSERT_EQUAL(-ENOSPC, log_info("msg3"));
+
+    uint32_t dropped = 0;
+    TEST_ASSERT_EQUAL(0, log_get_dropped(&dropped));
+    TEST_ASSERT_EQUAL_UINT32(1, dropped);
+
+    while (log_drain() == 0)
+    {
+    }
+    TEST_ASSERT_EQUAL_STRING(
+        "[INFO] msg1\r\n[INFO] msg2\r\n", (const char*)tx_buffer);
+}
+
+void test_async_drop_oldest_keeps_newest(void)
+{
+    ring_buffer_init(&async_buffer);
+    struct log_config log_configuration = {
+        .serial_output   = &test_serial,
+        .min_level       = LOG_LEVEL_DEBUG,
+        .show_level      = true,
+        .async_buffer    = &async_buffer,
+        .overflow_policy = LOG_DROP_OLDEST,
+    };
+    TEST_ASSERT_EQUAL(0, log_init(&log_configuration));
+
+    TEST_ASSERT_EQUAL(0, log_info("msg1"));
+    TEST_ASSERT_EQUAL(0, log_info("msg2"));
+    TEST_ASSERT_EQUAL(0, log_info("msg3"));
+
+    uint32_t dropped = 0;
+    TEST_ASSERT_EQUAL(0, log_get_dropped(&dropped));
+    TEST_ASSERT_EQUAL_UINT32(1, dropped);
+
+    while (log_drain() == 0)
+    {
+    }
+    TEST_ASSERT_EQUAL_STRING(
+        "[INFO] msg2\r\n[INFO] msg3\r\n", (const char*)tx_buffer);
+}
+
+void test_async_longest_line_is_queued_whole(void)
+{
+    // [LENGTH] + the longest line, plus the byte the ring buffer keeps free
+    static uint8_t            raw[LOG_MAX_BUFFER_SIZE + 1];
+    static struct ring_buffer large_buffer
+        = {.buffer = raw, .size = sizeof(raw), .overwrite = false};
+    ring_buffer_init(&large_buffer);
+    struct log_config log_configuration = {
+        .serial_output = &test_serial,
+        .min_level     = LOG_LEVEL_DEBUG,
+        .async_buffer  = &large_buffer,
+    };
+    TEST_ASSERT_EQUAL(0, log_init(&log_configuration));
+
+    char msg[LOG_MAX_BUFFER_SIZE + 16];
+    memset(msg, 'x', sizeof(msg) - 1);
+    msg[sizeof(msg) - 1] = '\0';
+    TEST_ASSERT_EQUAL(0, log_info(msg));
+
+    TEST_ASSERT_EQUAL(0, log_drain());
+    TEST_ASSERT_EQUAL(-ENODATA, log_drain());
+    TEST_ASSERT_EQUAL(LOG_MAX_BUFFER_SIZE - 1, tx_index);
+    TEST_ASSERT_EQUAL_HEX8('x', tx_buffer[0]);
+    TEST_ASSERT_EQUAL_HEX8('\n', tx_buffer[tx_index - 1]);
+}
+
+void test_async_record_of_the_maximum_size_is_queued_whole(void)
+{
+    // [LENGTH] + the record, plus the byte the ring buffer keeps free
+    static uint8_t            raw[LOG_MAX_BUFFER_SIZE + 2];
+    static struct ring_buffer large_buffer
+        = {.buffer = raw, .size = sizeof(raw), .overwrite = false};
+    ring_buffer_init(&large_buffer);
+    struct log_config log_configuration = {
+        .serial_output = &test_serial,
+        .min_level     = LOG_LEVEL_DEBUG,
+        .async_buffer  = &large_buffer,
+    };
+    TEST_ASSERT_EQUAL(0, log_init(&log_configuration));
+
+    uint8_t record[LOG_MAX_BUFFER_SIZE + 1];
+    for (size_t i = 0; i < sizeof(record); i++)
+    {
+        record[i] = (uint8_t)('a' + i % 26);
+    }
+    TEST_ASSERT_EQUAL(
+        -EINVAL, log_write_record(LOG_LEVEL_INFO, record, sizeof(record)));
+    TEST_ASSERT_EQUAL(
+        0, log_write_record(LOG_LEVEL_INFO, record, LOG_MAX_BUFFER_SIZE));
+
+    TEST_ASSERT_EQUAL(0, log_drain());
+    TEST_ASSERT_EQUAL(-ENODATA, log_drain());
+    TEST_ASSERT_EQUAL(LOG_MAX_BUFFER_SIZE, tx_index);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(record, tx_buffer, LOG_MAX_BUFFER_SIZE);
+}
+
+/* ========================================================================== */
+
+void test_log_token_emits_binary_record(void)
+{
+    struct log_config log_configuration = {
+        .serial_output = &test_serial,
+        .min_level     = LOG_LEVEL_INFO,
+        .show_level    = true,
+    };
+    TEST_ASSERT_EQUAL(0, log_init(&log_configuration));
+
+    int32_t temperature = -2;
+    LOG_TOKEN(LOG_LEVEL_WARN, "temperature=%d raw=0x%X", temperature, 0x1234);
+    LOG_TOKEN0(LOG_LEVEL_DEBUG, "filtered out");
+
+    TEST_ASSERT_EQUAL(LOG_TOKEN_HEADER_SIZE + 2 * 4, tx_index);
+    TEST_ASSERT_EQUAL_HEX8(LOG_TOKEN_SYNC, tx_buffer[0]);
+    TEST_ASSERT_EQUAL_HEX8((LOG_LEVEL_WARN << 4) | 2, tx_buffer[1]);
+
+    // The ID locates the format string in the log_tokens section
+    uint16_t id = (uint16_t)(tx_buffer[2] | (tx_buffer[3] << 8));
+    TEST_ASSERT_EQUAL_STRING(
+        "temperature=%d raw=0x%X", &__start_log_tokens[id]);
+
+    const uint8_t expected_args[]
+        = {0xFE, 0xFF, 0xFF, 0xFF, 0x34, 0x12, 0x00, 0x00};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(
+        expected_args,
+        &tx_buffer[LOG_TOKEN_HEADER_SIZE],
+        sizeof(expected_args));
+
+    uint32_t too_many[LOG_TOKEN_MAX_ARGS + 1] = {0};
+    TEST_ASSERT_EQUAL(
+        -EINVAL,
+        log_token(LOG_LEVEL_INFO, id, too_many, LOG_TOKEN_MAX_ARGS + 1));
+    TEST_ASSERT_EQUAL(-EFAULT, log_token(LOG_LEVEL_INFO, id, NULL, 1));
+
+    // Past 64 KiB of strings, the 16-bit ID would silently name another one
+    TEST_ASSERT_EQUAL(-ERANGE, log_token(LOG_LEVEL_INFO, 0x10000, NULL, 0));
+    TEST_ASSERT_EQUAL(LOG_TOKEN_HEADER_SIZE + 2 * 4, tx_index);
+}
+
+/* ========================================================================== */
+
+void test_log_format_multiple_arguments(void)
+{
+    struct log_config log_configuration = {
+        .serial_output = &test_serial,
+        .min_level     = LOG_LEVEL_DEBUG,
+        .show_level    = true,
+    };
+    TEST_ASSERT_EQUAL(0, log_init(&log_configuration));
+
+    LOG_FMT(
+        LOG_LEVEL_INFO,
+        "u={} i={} h=0x{} h4=0x{} s={} v={} t={} {}",
+        LOG_U(4294967295u),
+        LOG_I(INT32_MIN),
+        LOG_HEX(0xBEEF),
+        LOG_HEXN(0x2A, 4),
+        LOG_STR("abc"),
+        LOG_FIXED(3305, 3),
+        LOG_FIXED(-5, 2),
+        LOG_U(0));
+    TEST_ASSERT_EQUAL_STRING(
+        "[INFO] u=4294967295 i=-2147483648 h=0xBEEF h4=0x002A s=abc v=3.305 "
+        "t=-0.05 0\r\n",
+        (const char*)tx_buffer);
+
+    // Missing arguments leave the placeholder
+    tx_index = 0;
+    memset(tx_buffer, 0, sizeof(tx_buffer));
+    TEST_ASSERT_EQUAL(0, log_format(LOG_LEVEL_WARN, "a={} b={}", NULL, 0));
+    TEST_ASSERT_EQUAL_STRING("[WARN] a={} b={}\r\n", (const char*)tx_buffer);
+    TEST_ASSERT_EQUAL(-EFAULT, log_format(LOG_LEVEL_WARN, NULL, NULL, 0));
+}
+
+/* ========================================================================== */
+
+void test_timestamp_and_sequence_prefix(void)
+{
+    struct log_config log_configuration = {
+        .serial_output = &test_serial,
+        .min_level     = LOG_LEVEL_INFO,
+        .show_level    = true,
+        .get_timestamp = fake_get_timestamp,
+        .show_sequence = true,
+    };
+    TEST_ASSERT_EQUAL(0, log_init(&log_configuration));
+
+    fake_time = 1500;
+    log_info("start");
+    log_debug("filtered out, no sequence number used");
+    fake_time = 4294967295u;
+    LOG_FMT(LOG_LEVEL_WARN, "x={}", LOG_U(7));
+    TEST_ASSERT_EQUAL_STRING(
+        "1500 #0 [INFO] start\r\n4294967295 #1 [WARN] x=7\r\n",
+        (const char*)tx_buffer);
+
+    // Tokenised records carry the same information in binary
+    tx_index  = 0;
+    fake_time = 0x01020304;
+    LOG_TOKEN(LOG_LEVEL_ERROR, "code=%u", 9);
+    TEST_ASSERT_EQUAL(
+        LOG_TOKEN_HEADER_SIZE + LOG_TOKEN_META_SIZE + 4, tx_index);
+    TEST_ASSERT_EQUAL_HEX8(
+        LOG_TOKEN_META_FLAG | (LOG_LEVEL_ERROR << 4) | 1, tx_buffer[1]);
+    const uint8_t expected_meta_and_arg[]
+        = {0x04, 0x03, 0x02, 0x01, 0x02, 0x00, 0x09, 0x00, 0x00, 0x00};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(
+        expected_meta_and_arg,
+        &tx_buffer[LOG_TOKEN_HEADER_SIZE],
+        sizeof(expected_meta_and_arg));
+}
+
+/* ========================================================================== */
+
+static uint8_t nvm_image[64];
+static size_t  nvm_used;
+
+static int8_t fake_nvm_append(void* context, const uint8_t* data, size_t size)
+{
+    TEST_ASSERT_EQUAL_PTR(nvm_image, context);
+    if (nvm_used + size > sizeof(nvm_image))
+    {
+        return -ENOSPC;
+    }
+    memcpy(&nvm_image[nvm_used], data, size);
+    nvm_used += size;
+    return 0;
+}
+
+void test_sinks_receive_records_at_their_own_level(void)
+{
+    struct log_config log_configuration = {
+        .serial_output = &test_serial,
+        .min_level     = LOG_LEVEL_INFO,
+        .show_level    = true,
+        .show_sequence = true,
+    };
+    TEST_ASSERT_EQUAL(0, log_init(&log_configuration));
+
+    static uint8_t     trace_raw[48];
+    struct ring_buffer trace
+        = {.buffer = trace_raw, .size = sizeof(trace_raw), .overwrite = true};
+    TEST_ASSERT_EQUAL(0, ring_buffer_init(&trace));
+    static struct log_sink trace_sink;
+    trace_sink = (struct log_sink){
+        .type         = LOG_SINK_RING_BUFFER,
+        .min_level    = LOG_LEVEL_DEBUG,
+        .trace_buffer = &trace,
+    };
+    static struct log_sink nvm_sink;
+    nvm_sink = (struct log_sink){
+        .type      = LOG_SINK_CALLBACK,
+        .min_level = LOG_LEVEL_ERROR,
+        .write     = fake_nvm_append,
+        .context   = nvm_image,
+    };
+    nvm_used = 0;
+    TEST_ASSERT_EQUAL(0, log_add_sink(&trace_sink));
+    TEST_ASSERT_EQUAL(0, log_add_sink(&nvm_sink));
+    TEST_ASSERT_EQUAL(-EALREADY, log_add_sink(&nvm_sink));
+
+    log_debug("d");
+    log_info("i");
+    log_error("e");
+
+    // Each record is formatted once: all sinks see the same sequence number
+    TEST_ASSERT_EQUAL_STRING(
+        "#1 [INFO] i\r\n#2 [ERROR] e\r\n", (const char*)tx_buffer);
+    TEST_ASSERT_EQUAL(strlen("#2 [ERROR] e\r\n"), nvm_used);
+    TEST_ASSERT_EQUAL_STRING_LEN(
+        "#2 [ERROR] e\r\n", (const char*)nvm_image, nvm_used);
+    char   trace_text[48] = {0};
+    size_t trace_size     = 0;
+    ring_buffer_count(&trace, &trace_size);
+    ring_buffer_pop(&trace, (uint8_t*)trace_text, trace_size);
+    TEST_ASSERT_EQUAL_STRING(
+        "#0 [DEBUG] d\r\n#1 [INFO] i\r\n#2 [ERROR] e\r\n", trace_text);
+
+    // Removing the debug sink lets the early filter skip debug records again
+    TEST_ASSERT_EQUAL(0, log_remove_sink(&trace_sink));
+    TEST_ASSERT_EQUAL(-ENOENT, log_remove_sink(&trace_sink));
+    log_debug("d");
+    TEST_ASSERT_EQUAL(0, log_sink_set_level(&nvm_sink, LOG_LEVEL_WARN));
+    log_warn("w");
+    TEST_ASSERT_EQUAL(strlen("#2 [ERROR] e\r\n#3 [WARN] w\r\n"), nvm_used);
+    TEST_ASSERT_EQUAL_STRING_LEN(
+        "#2 [ERROR] e\r\n#3 [WARN] w\r\n", (const char*)nvm_image, nvm_used);
+
+    struct log_sink broken = {.type = LOG_SINK_SERIAL, .serial = NULL};
+    TEST_ASSERT_EQUAL(-EFAULT, log_add_sink(&broken));
+    struct log_sink async_trace
+        = {.type         = LOG_SINK_RING_BUFFER,
+           .trace_buffer = &trace,
+           .async_buffer = &trace};
+    TEST_ASSERT_EQUAL(-EINVAL, log_add_sink(&async_trace));
+}
+
+void test_full_trace_buffer_keeps_whole_records(void)
+{
+    struct log_config log_configuration = {
+        .serial_output = &test_serial,
+        .min_level     = LOG_LEVEL_INFO,
+        .show_level    = true,
+    };
+    TEST_ASSERT_EQUAL(0, log_init(&log_configuration));
+
+    // Room for one "[INFO] xx\r\n" (11 bytes) and part of a second
+    static uint8_t     trace_raw[17];
+    struct ring_buffer trace
+        = {.buffer = trace_raw, .size = sizeof(trace_raw), .overwrite = false};
+    TEST_ASSERT_EQUAL(0, ring_buffer_init(&trace));
+    static struct log_sink trace_sink;
+    trace_sink = (struct log_sink){
+        .type         = LOG_SINK_RING_BUFFER,
+        .min_level    = LOG_LEVEL_INFO,
+        .trace_buffer = &trace,
+    };
+    TEST_ASSERT_EQUAL(0, log_add_sink(&trace_sink));
+
+    log_info("i1");
+    log_info("i2");
+
+    char   trace_text[17] = {0};
+    size_t trace_size     = 0;
+    ring_buffer_count(&trace, &trace_size);
+    ring_buffer_pop(&trace, (uint8_t*)trace_text, trace_size);
+    TEST_ASSERT_EQUAL_STRING("[INFO] i1\r\n", trace_text);
+    TEST_ASSERT_EQUAL(0, log_remove_sink(&trace_sink));
+}
+
+/* ========================================================================== */
+
+LOG_MODULE_DECLARE(radio, LOG_LEVEL_INFO);
+LOG_MODULE_DEFINE(radio, LOG_LEVEL_WARN);
+LOG_MODULE_DECLARE(sensor, LOG_LEVEL_DEBUG);
+LOG_MODULE_DEFINE(sensor, LOG_LEVEL_WARN);
+
+void test_module_levels_filter_independently(void)
+{
+    struct log_config log_configuration = {
+        .serial_output = &test_serial,
+        .min_level     = LOG_LEVEL_DEBUG,
+        .show_level    = true,
+    };
+    TEST_ASSERT_EQUAL(0, log_init(&log_configuration));
+
+    LOG_MOD(radio, LOG_LEVEL_INFO, "filtered at runtime");
+    LOG_MOD(sensor, LOG_LEVEL_WARN, "kept");
+    TEST_ASSERT_EQUAL_STRING("[WARN] sensor: kept\r\n", (const char*)tx_buffer);
+
+    // Debug one module: the other one stays quiet
+    tx_index = 0;
+    memset(tx_buffer, 0, sizeof(tx_buffer));
+    TEST_ASSERT_EQUAL(
+        0, log_module_set_level(&log_module_sensor, LOG_LEVEL_DEBUG));
+    LOG_MOD_FMT(sensor, LOG_LEVEL_DEBUG, "raw={}", LOG_U(12));
+    LOG_MOD(radio, LOG_LEVEL_DEBUG, "still filtered");
+    TEST_ASSERT_EQUAL_STRING(
+        "[DEBUG] sensor: raw=12\r\n", (const char*)tx_buffer);
+
+    // Below the compile-time floor the call is compiled out entirely
+    tx_index = 0;
+    TEST_ASSERT_EQUAL(
+        0, log_module_set_level(&log_module_radio, LOG_LEVEL_DEBUG));
+    TEST_ASSERT_FALSE(LOG_MOD_ENABLED(radio, LOG_LEVEL_DEBUG));
+    LOG_MOD(radio, LOG_LEVEL_DEBUG, "below floor");
+    TEST_ASSERT_EQUAL(0, tx_index);
+
+    TEST_ASSERT_EQUAL(-EINVAL, log_module_set_level(&log_module_radio, 6));
+    TEST_ASSERT_EQUAL(-EFAULT, log_module_set_level(NULL, LOG_LEVEL_INFO));
+}
+
+/* ========================================================================== */
+
+void test_isr_records_are_dispatched_by_drain(void)
+{
+    static uint8_t     isr_raw[64];
+    struct ring_buffer isr_queue
+        = {.buffer = isr_raw, .size = sizeof(isr_raw), .overwrite = false};
+    TEST_ASSERT_EQUAL(0, ring_buffer_init(&isr_queue));
+    struct log_config log_configuration = {
+        .serial_output = &test_serial,
+        .min_level     = LOG_LEVEL_INFO,
+        .show_level    = true,
+    };
+    TEST_ASSERT_EQUAL(0, log_init(&log_configuration));
+    TEST_ASSERT_EQUAL(-ENOTSUP, log_write_from_isr(LOG_LEVEL_INFO, "x"));
+
+    log_configuration.isr_buffer = &isr_queue;
+    TEST_ASSERT_EQUAL(0, log_init(&log_configuration));
+    TEST_ASSERT_EQUAL(0, log_write_from_isr(LOG_LEVEL_WARN, "rx overrun"));
+    LOG_FMT_FROM_ISR(LOG_LEVEL_ERROR, "code={}", LOG_U(3));
+    TEST_ASSERT_EQUAL(0, log_write_from_isr(LOG_LEVEL_DEBUG, "filtered"));
+    TEST_ASSERT_EQUAL(0, tx_index);  // Nothing written from the "interrupt"
+
+    TEST_ASSERT_EQUAL(0, log_drain());
+    TEST_ASSERT_EQUAL(0, log_drain());
+    TEST_ASSERT_EQUAL(-ENODATA, log_drain());
+    TEST_ASSERT_EQUAL_STRING(
+        "[WARN] rx overrun\r\n[ERROR] code=3\r\n", (const char*)tx_buffer);
+
+    // A full queue drops the record instead of waiting
+    char long_msg[60];
+    memset(long_msg, 'x', sizeof(long_msg) - 1);
+    long_msg[sizeof(long_msg) - 1] = '\0';
+    TEST_ASSERT_EQUAL(-ENOSPC, log_write_from_isr(LOG_LEVEL_INFO, long_msg));
+    uint32_t dropped;
+    TEST_ASSERT_EQUAL(0, log_get_dropped(&dropped));
+    TEST_ASSERT_EQUAL(1, dropped);
+}
+
+/* ========================================================================== */
+
+static void log_rx_error(int32_t code)
+{
+    LOG_FMT_LIMITED(LOG_LEVEL_WARN, 2, 100, "rx error {}", LOG_I(code));
+}
+
+void test_rate_limit_suppresses_bursts(void)
+{
+    struct log_config log_configuration = {
+        .serial_output = &test_serial,
+        .min_level     = LOG_LEVEL_INFO,
+        .show_level    = true,
+        .get_timestamp = fake_get_timestamp,
+    };
+    TEST_ASSERT_EQUAL(0, log_init(&log_configuration));
+
+    fake_time = 1000;
+    for (int32_t i = 0; i < 5; i++)
+    {
+        log_rx_error(i);
+    }
+    fake_time = 1099;
+    log_rx_error(5);
+    TEST_ASSERT_EQUAL_STRING(
+        "1000 [WARN] rx error 0\r\n1000 [WARN] rx error 1\r\n",
+        (const char*)tx_buffer);
+
+    // One token back per period, the refused calls are reported first
+    tx_index  = 0;
+    fake_time = 1100;
+    log_rx_error(6);
+    log_rx_error(7);
+    TEST_ASSERT_EQUAL_STRING(
+        "1100 [WARN] 4 similar messages suppressed\r\n"
+        "1100 [WARN] rx error 6\r\n",
+        (const char*)tx_buffer);
+    uint32_t suppressed;
+    TEST_ASSERT_EQUAL(0, log_get_suppressed(&suppressed));
+    TEST_ASSERT_EQUAL(5, suppressed);
+
+    // A quiet site gets its whole burst back
+    memset(tx_buffer, 0, sizeof(tx_buffer));
+    tx_index  = 0;
+    fake_time = 1000000;
+    log_rx_error(8);
+    log_rx_error(9);
+    TEST_ASSERT_EQUAL_STRING(
+        "1000000 [WARN] 1 similar message suppressed\r\n"
+        "1000000 [WARN] rx error 8\r\n1000000 [WARN] rx error 9\r\n",
+        (const char*)tx_buffer);
+
+    // Without a time source nothing is limited
+    log_configuration.get_timestamp = NULL;
+    TEST_ASSERT_EQUAL(0, log_init(&log_configuration));
+    struct log_rate_limit limit = {0};
+    for (int i = 0; i < 10; i++)
+    {
+        TEST_ASSERT_TRUE(log_rate_allow(&limit, LOG_LEVEL_WARN, 1, 100));
+    }
+    TEST_ASSERT_FALSE(log_rate_allow(NULL, LOG_LEVEL_WARN, 1, 100));
+}
+
+void test_repeated_messages_are_collapsed(void)
+{
+    struct log_config log_configuration = {
+        .serial_output    = &test_serial,
+        .min_level        = LOG_LEVEL_INFO,
+        .show_level       = true,
+        .collapse_repeats = true,
+    };
+    TEST_ASSERT_EQUAL(0, log_init(&log_configuration));
+
+    log_warn("link down");
+    log_warn("link down");
+    LOG_FMT(LOG_LEVEL_WARN, "link {}", LOG_STR("down"));
+    log_error("link down"); // Other level: a different message
+    log_info("link up");
+    log_info("link up");
+    TEST_ASSERT_EQUAL_STRING(
+        "[WARN] link down\r\n"
+        "[WARN] last message repeated 2 times\r\n"
+        "[ERROR] link down\r\n"
+        "[INFO] link up\r\n",
+        (const char*)tx_buffer);
+    uint32_t suppressed;
+    TEST_ASSERT_EQUAL(0, log_get_suppressed(&suppressed));
+    TEST_ASSERT_EQUAL(3, suppressed);
+    TEST_ASSERT_EQUAL(-EFAULT, log_get_suppressed(NULL));
+}
+
+void test_pending_repeats_are_reported_by_drain(void)
+{
+    struct log_config log_configuration = {
+        .serial_output    = &test_serial,
+        .min_level        = LOG_LEVEL_INFO,
+        .show_level       = true,
+        .get_timestamp    = fake_get_timestamp,
+        .collapse_repeats = true,
+        .repeat_timeout   = 1000,
+    };
+    TEST_ASSERT_EQUAL(0, log_init(&log_configuration));
+
+    fake_time = 100;
+    log_warn("crc error");
+    log_warn("crc error");
+    log_warn("crc errox"); // Same length, other bytes: not a repeat
+    log_warn("crc errox");
+    fake_time = 1099;
+    TEST_ASSERT_EQUAL(-ENODATA, log_drain());  // Not due yet
+    fake_time = 1100;
+    TEST_ASSERT_EQUAL(0, log_drain());
+    TEST_ASSERT_EQUAL(-ENODATA, log_drain());
+    TEST_ASSERT_EQUAL_STRING(
+        "100 [WARN] crc error\r\n"
+        "100 [WARN] last message repeated 1 time\r\n"
+        "100 [WARN] crc errox\r\n"
+        "1100 [WARN] last message repeated 1 time\r\n",
+        (const char*)tx_buffer);
+
+    // The message stays the reference for the next repeats
+    tx_index = 0;
+    memset(tx_buffer, 0, sizeof(tx_buffer));
+    log_warn("crc errox");
+    log_warn("crc errox");
+    log_info("link up");
+    TEST_ASSERT_EQUAL_STRING(
+        "1100 [WARN] last message repeated 2 times\r\n"
+        "1100 [INFO] link up\r\n",
+        (const char*)tx_buffer);
+}
+
+/* ========================================================================== */
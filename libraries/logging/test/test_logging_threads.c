@@ -0,0 +1,212 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "logging.h"
+#include "ring_buffer.h"
+#include "serial.h"
+#include "string.h"
+#include "unity.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* ========================================================================== */
+
+// Built with CRITICAL_HEADER="critical_pthread.h": several tasks log through a
+// synchronous serial port whose transmit yields between bytes, while an
+// "interrupt" thread logs through the ISR path and a drain thread dispatches
+// its records. Every received line must be whole and in order per producer.
+
+#define TASK_COUNT       4
+#define LINES_PER_TASK   2000
+#define ISR_LINES        2000
+#define MAX_LINE         64
+#define CAPTURE_SIZE     ((TASK_COUNT + 1) * (LINES_PER_TASK + ISR_LINES) * 48)
+#define ISR_PRODUCER_ID  TASK_COUNT
+#define YIELD_EVERY_BYTE 8
+
+pthread_mutex_t critical_pthread_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static char         capture[CAPTURE_SIZE];
+static size_t       capture_size;
+static volatile int producers_running;
+
+static int8_t slow_transmit(
+    const struct serial* self, const uint8_t* buffer, size_t size)
+{
+    (void)self;
+    for (size_t i = 0; i < size; i++)
+    {
+        // Not locked on purpose: only the library serializes transmits
+        size_t pos = __atomic_fetch_add(&capture_size, 1, __ATOMIC_RELAXED);
+        if (pos < sizeof(capture))
+        {
+            capture[pos] = (char)buffer[i];
+        }
+        if (i % YIELD_EVERY_BYTE == 0)
+        {
+            sched_yield();
+        }
+    }
+    return 0;
+}
+
+static const struct serial_ops slow_ops    = {.transmit = slow_transmit};
+static struct serial           slow_serial = {.ops = &slow_ops};
+
+static uint8_t            isr_raw[2048];
+static struct ring_buffer isr_queue
+    = {.buffer = isr_raw, .size = sizeof(isr_raw), .overwrite = false};
+
+/* ========================================================================== */
+
+static void* task_main(void* arg)
+{
+    uint32_t id = (uint32_t)(uintptr_t)arg;
+    for (uint32_t n = 0; n < LINES_PER_TASK; n++)
+    {
+        LOG_FMT(
+            LOG_LEVEL_INFO,
+            "P{} n={} payload={}",
+            LOG_U(id),
+            LOG_U(n),
+            LOG_STR("abcdefghijklmnop"));
+    }
+    return NULL;
+}
+
+static void* isr_main(void* arg)
+{
+    uint32_t* sent = arg;
+    for (uint32_t n = 0; n < ISR_LINES; n++)
+    {
+        LOG_FMT_FROM_ISR(
+            LOG_LEVEL_WARN,
+            "P{} n={} payload={}",
+            LOG_U(ISR_PRODUCER_ID),
+            LOG_U(n),
+            LOG_STR("ISR"));
+        *sent += 1;
+        sched_yield();
+    }
+    return NULL;
+}
+
+static void* drain_main(void* arg)
+{
+    (void)arg;
+    while (producers_running)
+    {
+        if (log_drain() == -ENODATA)
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/* ========================================================================== */
+
+void setUp(void)
+{
+    capture_size = 0;
+    TEST_ASSERT_EQUAL(0, ring_buffer_init(&isr_queue));
+}
+
+void tearDown(void)
+{
+}
+
+/* ========================================================================== */
+
+void test_concurrent_lines_are_never_torn(void)
+{
+    struct log_config log_configuration = {
+        .serial_output = &slow_serial,
+        .min_level     = LOG_LEVEL_DEBUG,
+        .show_level    = true,
+        .isr_buffer    = &isr_queue,
+    };
+    TEST_ASSERT_EQUAL(0, log_init(&log_configuration));
+
+    pthread_t tasks[TASK_COUNT];
+    pthread_t isr;
+    pthread_t drain;
+    uint32_t  isr_sent = 0;
+    producers_running  = 1;
+    pthread_create(&drain, NULL, drain_main, NULL);
+    pthread_create(&isr, NULL, isr_main, &isr_sent);
+    for (uintptr_t i = 0; i < TASK_COUNT; i++)
+    {
+        pthread_create(&tasks[i], NULL, task_main, (void*)i);
+    }
+    for (size_t i = 0; i < TASK_COUNT; i++)
+    {
+        pthread_join(tasks[i], NULL);
+    }
+    pthread_join(isr, NULL);
+    producers_running = 0;
+    pthread_join(drain, NULL);
+    while (log_drain() != -ENODATA)
+    {
+    }
+
+    uint32_t dropped;
+    TEST_ASSERT_EQUAL(0, log_get_dropped(&dropped));
+    TEST_ASSERT_TRUE(capture_size < sizeof(capture));
+
+    // Every line is whole, and each producer's lines arrive in order
+    uint32_t next[TASK_COUNT + 1]     = {0};
+    uint32_t received[TASK_COUNT + 1] = {0};
+    size_t   pos                      = 0;
+    while (pos < capture_size)
+    {
+        char* end = memchr(&capture[pos], '\n', capture_size - pos);
+        TEST_ASSERT_NOT_NULL(end);
+        char line[MAX_LINE] = {0};
+        TEST_ASSERT_TRUE((size_t)(end - &capture[pos]) < sizeof(line));
+        memcpy(line, &capture[pos], (size_t)(end - &capture[pos]) + 1);
+        pos = (size_t)(end - capture) + 1;
+
+        unsigned id;
+        unsigned n;
+        char     level[8];
+        char     payload[24];
+        int      used = 0;
+        TEST_ASSERT_EQUAL(
+            4,
+            sscanf(
+                line,
+                "[%7[A-Z]] P%u n=%u payload=%23s\r\n%n",
+                level,
+                &id,
+                &n,
+                payload,
+                &used));
+        TEST_ASSERT_EQUAL(strlen(line), (size_t)used);
+        TEST_ASSERT_TRUE(id <= ISR_PRODUCER_ID);
+        TEST_ASSERT_EQUAL_STRING(
+            (id == ISR_PRODUCER_ID) ? "WARN" : "INFO", level);
+        TEST_ASSERT_EQUAL_STRING(
+            (id == ISR_PRODUCER_ID) ? "ISR" : "abcdefghijklmnop", payload);
+        // The ISR path may drop records when its queue is full, never reorder
+        TEST_ASSERT_TRUE(n >= next[id]);
+        TEST_ASSERT_TRUE(id == ISR_PRODUCER_ID || n == next[id]);
+        next[id] = n + 1;
+        received[id] += 1;
+    }
+
+    for (size_t i = 0; i < TASK_COUNT; i++)
+    {
+        TEST_ASSERT_EQUAL(LINES_PER_TASK, received[i]);
+    }
+    TEST_ASSERT_EQUAL(isr_sent, received[ISR_PRODUCER_ID] + dropped);
+    printf(
+        "%u task lines, %u ISR lines, %u ISR lines dropped\n",
+        (unsigned)(TASK_COUNT * LINES_PER_TASK),
+        (unsigned)received[ISR_PRODUCER_ID],
+        (unsigned)dropped);
+}
+
+/* ========================================================================== */
@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+"""Decode tokenised log records (see LOG_TOKEN in logging.h).
+
+The string table is the "log_tokens" section of the firmware ELF file, or a
+JSON table previously extracted from it:
+
+    log_decode.py extract firmware.elf -o tokens.json
+    log_decode.py decode --elf firmware.elf capture.bin
+    stty -F /dev/ttyUSB0 115200 raw && \\
+        log_decode.py decode --table tokens.json /dev/ttyUSB0
+
+Plain text lines sharing the output (log_write) are passed through unchanged.
+Records carrying a timestamp and sequence number are printed as
+"TIMESTAMP #SEQUENCE [LEVEL] message", like text lines; the sequence number is
+16 bits, so it wraps at 65536.
+Only the Python standard library is used.
+"""
+
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+
+SECTION_NAME = "log_tokens"
+TOKEN_SYNC = 0xA5
+TOKEN_HEADER_SIZE = 4
+TOKEN_MAX_ID = 0xFFFF  # IDs are 16 bits
+TOKEN_MAX_ARGS = 8
+TOKEN_META_FLAG = 0x80
+TOKEN_META_SIZE = 6  # [TIMESTAMP (4, LE)][SEQUENCE (2, LE)]
+LEVEL_NAMES = ("DEBUG", "INFO", "WARN", "ERROR", "FATAL")
+
+FORMAT_SPEC = re.compile(
+    r"%([-+ #0]*)(\d*)(?:\.(\d+))?(?:hh|h|ll|l|z|j|t)?([diuxXoc%])"
+)
+
+
+# =========================================================================== #
+
+
+def read_elf_section(path, name):
+    """Return the contents of section `name` of an ELF file."""
+    with open(path, "rb") as elf:
+        data = elf.read()
+    if data[:4] != b"\x7fELF":
+        raise ValueError(f"{path}: not an ELF file")
+    is_64 = data[4] == 2
+    endian = "<" if data[5] == 1 else ">"
+    if is_64:
+        shoff, = struct.unpack_from(endian + "Q", data, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", data, 0x3A)
+        section_fmt = endian + "IIQQQQ"
+    else:
+        shoff, = struct.unpack_from(endian + "I", data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", data, 0x2E)
+        section_fmt = endian + "IIIIII"
+
+    def header(index):
+        fields = struct.unpack_from(section_fmt, data, shoff + index * shentsize)
+        return tuple(fields[i] for i in (0, 1, 4, 5))  # name, type, offset, size
+
+    _, _, names_offset, _ = header(shstrndx)
+    for index in range(shnum):
+        name_index, section_type, offset, size = header(index)
+        end = data.index(b"\0", names_offset + name_index)
+        if data[names_offset + name_index:end].decode() == name:
+            if section_type == 8:  # SHT_NOBITS
+                raise ValueError(f"{path}: section {name} has no contents")
+            return data[offset:offset + size]
+    raise ValueError(f"{path}: no {name} section (no LOG_TOKEN call linked?)")
+
+
+def extract_table(section):
+    """Map every string offset in the section to its format string."""
+    table = {}
+    start = 0
+    while start < len(section):
+        end = section.find(b"\0", start)
+        if end < 0:
+            end = len(section)
+        if end > start:
+            if start > TOKEN_MAX_ID:
+                raise ValueError(
+                    f"{SECTION_NAME}: string at offset {start:#x} has no "
+                    "16-bit token ID")
+            table[start] = section[start:end].decode("utf-8", "replace")
+        start = end + 1
+    return table
+
+
+# =========================================================================== #
+
+
+def format_message(fmt, args):
+    """Apply printf-style integer conversions to raw uint32_t arguments."""
+    remaining = list(args)
+
+    def convert(match):
+        flags, width, precision, conversion = match.groups()
+        if conversion == "%":
+            return "%"
+        if not remaining:
+            return match.group(0)
+        value = remaining.pop(0)
+        if conversion in "di":
+            value = value - (1 << 32) if value & 0x80000000 else value
+            conversion = "d"
+        elif conversion == "u":
+            conversion = "d"
+        elif conversion == "c":
+            return chr(value & 0xFF)
+        spec = "%" + flags + width
+        if precision is not None:
+            spec += "." + precision
+        return (spec + conversion) % value
+
+    return FORMAT_SPEC.sub(convert, fmt)
+
+
+def decode_stream(stream, table, out):
+    """Decode records from a binary stream, passing text through."""
+    pending = bytearray()
+    text = bytearray()
+
+    def flush_text():
+        if text:
+            out.write(text.decode("latin-1"))
+            text.clear()
+
+    while True:
+        chunk = stream(4096)
+        if not chunk:
+            break
+        pending.extend(chunk)
+        while pending:
+            if pending[0] != TOKEN_SYNC:
+                text.append(pending.pop(0))
+                if text.endswith(b"\n"):
+                    flush_text()
+                continue
+            if len(pending) < TOKEN_HEADER_SIZE:
+                break
+            header = pending[1]
+            level, arg_count = (header >> 4) & 0x7, header & 0xF
+            if level >= len(LEVEL_NAMES) or arg_count > TOKEN_MAX_ARGS:
+                text.append(pending.pop(0))  # Not a record: resynchronise
+                continue
+            meta_size = TOKEN_META_SIZE if header & TOKEN_META_FLAG else 0
+            size = TOKEN_HEADER_SIZE + meta_size + 4 * arg_count
+            if len(pending) < size:
+                break
+            token_id, = struct.unpack_from("<H", pending, 2)
+            prefix = ""
+            if meta_size:
+                timestamp, sequence = struct.unpack_from("<IH", pending, TOKEN_HEADER_SIZE)
+                prefix = f"{timestamp} #{sequence} "
+            args = struct.unpack_from(
+                "<%dI" % arg_count, pending, TOKEN_HEADER_SIZE + meta_size
+            )
+            del pending[:size]
+            fmt = table.get(token_id)
+            if fmt is None:
+                message = f"<unknown token 0x{token_id:04X}> " + " ".join(
+                    f"0x{arg:08X}" for arg in args
+                )
+            else:
+                message = format_message(fmt, args)
+            flush_text()
+            out.write(f"{prefix}[{LEVEL_NAMES[level]}] {message}\n")
+            out.flush()
+    text.extend(pending)
+    flush_text()
+
+
+# =========================================================================== #
+
+
+def load_table(args):
+    if args.elf:
+        return extract_table(read_elf_section(args.elf, SECTION_NAME))
+    with open(args.table) as table_file:
+        return {int(key): value for key, value in json.load(table_file).items()}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    extract = commands.add_parser("extract", help="write the string table as JSON")
+    extract.add_argument("elf", help="firmware ELF file")
+    extract.add_argument("-o", "--output", help="JSON file (default: stdout)")
+
+    decode = commands.add_parser("decode", help="decode a captured log stream")
+    source = decode.add_mutually_exclusive_group(required=True)
+    source.add_argument("--elf", help="firmware ELF file")
+    source.add_argument("--table", help="JSON table from 'extract'")
+    decode.add_argument("input", nargs="?", default="-",
+                        help="capture file or serial device (default: stdin)")
+
+    args = parser.parse_args()
+    if args.command == "extract":
+        table = extract_table(read_elf_section(args.elf, SECTION_NAME))
+        text = json.dumps(table, indent=2, ensure_ascii=False) + "\n"
+        if args.output:
+            with open(args.output, "w") as output:
+                output.write(text)
+        else:
+            sys.stdout.write(text)
+        return 0
+
+    table = load_table(args)
+    if args.input == "-":
+        decode_stream(sys.stdin.buffer.read1, table, sys.stdout)
+    else:
+        fd = os.open(args.input, os.O_RDONLY)
+        try:
+            decode_stream(lambda size: os.read(fd, size), table, sys.stdout)
+        finally:
+            os.close(fd)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
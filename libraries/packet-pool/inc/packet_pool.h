@@ -0,0 +1,163 @@
+#ifndef PACKET_POOL_H
+#define PACKET_POOL_H
+
+/* ========================================================================== */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ========================================================================== */
+
+/**
+ * struct packet_block - One fixed-size block of a packet pool
+ * @data: Start of the block, block_size bytes (set by the pool)
+ * @length: Bytes of @data holding frame data, kept by the owner
+ * @next: Next block of the same frame, NULL for the last one
+ *
+ * A frame larger than one block is held by a chain of blocks linked through
+ * @next. The pool reuses @next for its free list while the block is free.
+ */
+struct packet_block
+{
+    uint8_t*             data;
+    uint16_t             length;
+    struct packet_block* next;
+
+    /* private: internal state - do not access directly */
+    bool is_free;
+};
+
+/**
+ * struct packet_pool_stats - Usage counters of a packet pool
+ * @in_use: Blocks currently allocated
+ * @high_water: Most blocks ever allocated at the same time
+ * @failures: Allocations refused because too few blocks were free
+ */
+struct packet_pool_stats
+{
+    uint8_t  in_use;
+    uint8_t  high_water;
+    uint16_t failures;
+};
+
+/**
+ * struct packet_pool - Fixed set of equal blocks shared by drivers and stacks
+ * @blocks: Array of @block_count descriptors, owned by the pool once
+ * initialized
+ * @storage: @block_count x @block_size bytes backing the descriptors
+ * @block_count: Number of blocks, at most 255
+ * @block_size: Size of each block, e.g. MAX_ETH_PKT_SIZE for one block per
+ * frame, or less to chain several blocks per large frame
+ *
+ * Free blocks form a list through the descriptors: allocation and release
+ * take constant time per block and never fragment. When built with
+ * CRITICAL_HEADER, the free list is only touched inside a critical section,
+ * so that blocks may be allocated and freed from an interrupt handler.
+ *
+ * Configure public fields before calling packet_pool_init().
+ */
+struct packet_pool
+{
+    /* public: user-configurable fields - set before init (const after init) */
+    struct packet_block* const blocks;
+    uint8_t* const             storage;
+    const uint8_t              block_count;
+    const uint16_t             block_size;
+
+    /* private: internal state - do not access directly */
+    struct packet_block* free_list;
+    uint8_t              free_count;
+    uint8_t              high_water;
+    uint16_t             failures;
+    bool                 was_initialized;
+};
+
+/* ========================================================================== */
+
+/**
+ * @brief Link all blocks of the pool into its free list and clear its
+ * statistics.
+ * @param self Pointer to the pool with public fields configured.
+ * @return 0 on success, -EFAULT if self, blocks or storage is NULL, -EINVAL if
+ * block_count or block_size is 0.
+ */
+int8_t packet_pool_init(struct packet_pool* self);
+
+/**
+ * @brief Take one block from the pool.
+ * @param self Pointer to the pool.
+ * @param block Set to the block, with length 0 and no next block.
+ * @return 0 on success, -EFAULT if self or block is NULL, -EPERM if not
+ * initialized, -ENOMEM if all blocks are in use.
+ */
+int8_t packet_pool_alloc(struct packet_pool* self, struct packet_block** block);
+
+/**
+ * @brief Take enough blocks to hold a frame, chained in order.
+ * @param self Pointer to the pool.
+ * @param size Frame size in bytes.
+ * @param head Set to the first block. Every block but the last is full, the
+ * lengths add up to size.
+ * @return 0 on success, -EFAULT if self or head is NULL, -EPERM if not
+ * initialized, -EINVAL if size is 0, -ENOMEM if too few blocks are free (none
+ * is taken then).
+ */
+int8_t packet_pool_alloc_chain(
+    struct packet_pool* self, uint16_t size, struct packet_block** head);
+
+/**
+ * @brief Give a block back to the pool, with every block chained after it.
+ *
+ * Safe to call from an interrupt handler when built with CRITICAL_HEADER.
+ *
+ * @param self Pointer to the pool.
+ * @param head First block of the chain.
+ * @return 0 on success, -EFAULT if self or head is NULL, -EPERM if not
+ * initialized, -EINVAL if a block does not belong to the pool or is already
+ * free (none is freed then).
+ */
+int8_t packet_pool_free(struct packet_pool* self, struct packet_block* head);
+
+/**
+ * @brief Get the number of blocks available.
+ * @param self Pointer to the pool.
+ * @return Free blocks, 0 if self is NULL or not initialized.
+ */
+uint8_t packet_pool_available(const struct packet_pool* self);
+
+/**
+ * @brief Get the usage counters of the pool.
+ * @param self Pointer to the pool.
+ * @param stats Filled with the counters.
+ * @return 0 on success, -EFAULT if self or stats is NULL, -EPERM if not
+ * initialized.
+ */
+int8_t packet_pool_get_stats(
+    const struct packet_pool* self, struct packet_pool_stats* stats);
+
+/* ========================================================================== */
+
+/**
+ * @brief Get the size of the frame held by a chain.
+ * @param head First block of the chain.
+ * @return Sum of the block lengths, 0 if head is NULL.
+ */
+uint16_t packet_chain_length(const struct packet_block* head);
+
+/**
+ * @brief Copy bytes of the frame held by a chain into a flat buffer.
+ * @param head First block of the chain.
+ * @param offset Offset in the frame of the first byte to copy.
+ * @param buffer Destination of at least size bytes.
+ * @param size Number of bytes to copy.
+ * @return Bytes copied, less than size if the frame ends first.
+ */
+uint16_t packet_chain_copy(
+    const struct packet_block* head,
+    uint16_t                   offset,
+    uint8_t*                   buffer,
+    uint16_t                   size);
+
+/* ========================================================================== */
+
+#endif /* PACKET_POOL_H */
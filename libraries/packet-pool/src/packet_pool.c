@@ -0,0 +1,298 @@
+#include "../inc/packet_pool.h"
+
+/* ========================================================================== */
+
+#include "../../inc/errno.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/* ========================================================================== */
+
+#ifdef CRITICAL_HEADER
+#include "../../embedded-hal/inc/critical.h"
+#define POOL_ATOMIC(code) CRITICAL_SECTION(code)
+#else
+#define POOL_ATOMIC(code) \
+    do                    \
+    {                     \
+        code              \
+    } while (0)
+#endif
+
+/* ========================================================================== */
+
+/* PRIVATE */
+
+/* ========================================================================== */
+
+static bool _owns(
+    const struct packet_pool* self, const struct packet_block* block)
+{
+    return block >= self->blocks && block < self->blocks + self->block_count;
+}
+
+/**
+ * @brief Pop count blocks off the free list, chained in order. Must run in
+ * the critical section, with at least count blocks free.
+ */
+static struct packet_block* _pop(struct packet_pool* self, uint8_t count)
+{
+    struct packet_block* head = self->free_list;
+    struct packet_block* tail = head;
+    for (uint8_t i = 1; i < count; i++)
+    {
+        tail = tail->next;
+    }
+    self->free_list = tail->next;
+    tail->next      = NULL;
+    self->free_count -= count;
+
+    uint8_t in_use = self->block_count - self->free_count;
+    if (in_use > self->high_water)
+    {
+        self->high_water = in_use;
+    }
+    return head;
+}
+
+/* ========================================================================== */
+
+/* PUBLIC */
+
+/* ========================================================================== */
+
+int8_t packet_pool_init(struct packet_pool* self)
+{
+    if (self == NULL || self->blocks == NULL || self->storage == NULL)
+    {
+        return -EFAULT;
+    }
+    if (self->block_count == 0 || self->block_size == 0)
+    {
+        return -EINVAL;
+    }
+
+    self->free_list = NULL;
+    for (uint8_t i = self->block_count; i > 0; i--)
+    {
+        struct packet_block* block = &self->blocks[i - 1];
+        block->data     = self->storage + (size_t)(i - 1) * self->block_size;
+        block->length   = 0;
+        block->next     = self->free_list;
+        block->is_free  = true;
+        self->free_list = block;
+    }
+    self->free_count      = self->block_count;
+    self->high_water      = 0;
+    self->failures        = 0;
+    self->was_initialized = true;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t packet_pool_alloc(struct packet_pool* self, struct packet_block** block)
+{
+    if (self == NULL || block == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+
+    struct packet_block* taken = NULL;
+    POOL_ATOMIC({
+        if (self->free_count == 0)
+        {
+            self->failures += 1;
+        }
+        else
+        {
+            taken = _pop(self, 1);
+        }
+    });
+    if (taken == NULL)
+    {
+        return -ENOMEM;
+    }
+    taken->length  = 0;
+    taken->is_free = false;
+    *block         = taken;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t packet_pool_alloc_chain(
+    struct packet_pool* self, uint16_t size, struct packet_block** head)
+{
+    if (self == NULL || head == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    if (size == 0)
+    {
+        return -EINVAL;
+    }
+
+    uint16_t needed = (uint16_t)((size - 1) / self->block_size + 1);
+
+    struct packet_block* taken = NULL;
+    POOL_ATOMIC({
+        if (needed > self->free_count)
+        {
+            self->failures += 1;
+        }
+        else
+        {
+            taken = _pop(self, (uint8_t)needed);
+        }
+    });
+    if (taken == NULL)
+    {
+        return -ENOMEM;
+    }
+
+    struct packet_block* block = taken;
+    while (block != NULL)
+    {
+        block->length  = (size > self->block_size) ? self->block_size : size;
+        block->is_free = false;
+        size -= block->length;
+        block = block->next;
+    }
+    *head = taken;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t packet_pool_free(struct packet_pool* self, struct packet_block* head)
+{
+    if (self == NULL || head == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+
+    // Walk the chain outside the critical section: it still belongs to the
+    // caller, only the splice into the free list must be atomic. A block
+    // already free would link the free list into itself.
+    struct packet_block* tail  = head;
+    uint8_t              count = 1;
+    if (!_owns(self, tail) || tail->is_free)
+    {
+        return -EINVAL;
+    }
+    while (tail->next != NULL)
+    {
+        if (!_owns(self, tail->next) || tail->next->is_free
+            || count == self->block_count)
+        {
+            return -EINVAL;
+        }
+        tail = tail->next;
+        count += 1;
+    }
+    for (struct packet_block* block = head; block != NULL; block = block->next)
+    {
+        block->is_free = true;
+    }
+
+    POOL_ATOMIC({
+        tail->next      = self->free_list;
+        self->free_list = head;
+        self->free_count += count;
+    });
+    return 0;
+}
+
+/* ========================================================================== */
+
+uint8_t packet_pool_available(const struct packet_pool* self)
+{
+    if (self == NULL || !self->was_initialized)
+    {
+        return 0;
+    }
+    return self->free_count;
+}
+
+/* ========================================================================== */
+
+int8_t packet_pool_get_stats(
+    const struct packet_pool* self, struct packet_pool_stats* stats)
+{
+    if (self == NULL || stats == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+
+    POOL_ATOMIC({
+        stats->in_use     = self->block_count - self->free_count;
+        stats->high_water = self->high_water;
+        stats->failures   = self->failures;
+    });
+    return 0;
+}
+
+/* ========================================================================== */
+
+uint16_t packet_chain_length(const struct packet_block* head)
+{
+    uint16_t length = 0;
+    for (; head != NULL; head = head->next)
+    {
+        length += head->length;
+    }
+    return length;
+}
+
+/* ========================================================================== */
+
+uint16_t packet_chain_copy(
+    const struct packet_block* head,
+    uint16_t                   offset,
+    uint8_t*                   buffer,
+    uint16_t                   size)
+{
+    if (buffer == NULL)
+    {
+        return 0;
+    }
+
+    uint16_t copied = 0;
+    for (; head != NULL && copied < size; head = head->next)
+    {
+        if (offset >= head->length)
+        {
+            offset -= head->length;
+            continue;
+        }
+        uint16_t chunk = head->length - offset;
+        if (chunk > size - copied)
+        {
+            chunk = size - copied;
+        }
+        memcpy(buffer + copied, head->data + offset, chunk);
+        copied += chunk;
+        offset = 0;
+    }
+    return copied;
+}
+
+/* ========================================================================== */
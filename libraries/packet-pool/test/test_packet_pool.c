@@ -0,0 +1,156 @@
+#include "unity.h"
+
+/* ========================================================================== */
+
+#include "../../inc/errno.h"
+#include "../inc/packet_pool.h"
+
+#include <string.h>
+
+TEST_SOURCE_FILE("../src/packet_pool.c")
+
+/* ========================================================================== */
+
+static struct packet_block blocks[4];
+static uint8_t             storage[4 * 16];
+static struct packet_pool  pool = {
+    .blocks      = blocks,
+    .storage     = storage,
+    .block_count = 4,
+    .block_size  = 16,
+};
+
+/* ========================================================================== */
+
+void setUp(void)
+{
+    TEST_ASSERT_EQUAL(0, packet_pool_init(&pool));
+}
+
+void tearDown(void)
+{
+}
+
+/* ========================================================================== */
+
+void test_pool_hands_out_each_block_once(void)
+{
+    struct packet_block* taken[4];
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        TEST_ASSERT_EQUAL(0, packet_pool_alloc(&pool, &taken[i]));
+        TEST_ASSERT_EQUAL(0, taken[i]->length);
+        TEST_ASSERT_NULL(taken[i]->next);
+    }
+    TEST_ASSERT_EQUAL(0, packet_pool_available(&pool));
+    TEST_ASSERT_TRUE(taken[0]->data != taken[1]->data);
+    TEST_ASSERT_TRUE(taken[2]->data != taken[3]->data);
+
+    struct packet_block* extra = NULL;
+    TEST_ASSERT_EQUAL(-ENOMEM, packet_pool_alloc(&pool, &extra));
+    TEST_ASSERT_EQUAL(0, packet_pool_free(&pool, taken[2]));
+    TEST_ASSERT_EQUAL(0, packet_pool_alloc(&pool, &extra));
+    TEST_ASSERT_EQUAL_PTR(taken[2], extra);
+}
+
+void test_large_frame_is_held_by_a_chain(void)
+{
+    struct packet_block* head = NULL;
+    TEST_ASSERT_EQUAL(0, packet_pool_alloc_chain(&pool, 40, &head));
+    TEST_ASSERT_EQUAL(1, packet_pool_available(&pool));
+    TEST_ASSERT_EQUAL(16, head->length);
+    TEST_ASSERT_EQUAL(16, head->next->length);
+    TEST_ASSERT_EQUAL(8, head->next->next->length);
+    TEST_ASSERT_NULL(head->next->next->next);
+    TEST_ASSERT_EQUAL(40, packet_chain_length(head));
+
+    uint8_t frame[40];
+    for (uint8_t i = 0; i < sizeof(frame); i++)
+    {
+        frame[i] = i;
+    }
+    memcpy(head->data, frame, 16);
+    memcpy(head->next->data, frame + 16, 16);
+    memcpy(head->next->next->data, frame + 32, 8);
+
+    // Read back across the block boundaries, and past the end
+    uint8_t copy[40] = {0};
+    TEST_ASSERT_EQUAL(20, packet_chain_copy(head, 10, copy, 20));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frame + 10, copy, 20);
+    TEST_ASSERT_EQUAL(6, packet_chain_copy(head, 34, copy, 20));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frame + 34, copy, 6);
+
+    // All or nothing
+    struct packet_block* other = NULL;
+    TEST_ASSERT_EQUAL(-ENOMEM, packet_pool_alloc_chain(&pool, 17, &other));
+    TEST_ASSERT_EQUAL(1, packet_pool_available(&pool));
+
+    // The whole chain goes back at once
+    TEST_ASSERT_EQUAL(0, packet_pool_free(&pool, head));
+    TEST_ASSERT_EQUAL(4, packet_pool_available(&pool));
+    TEST_ASSERT_EQUAL(0, packet_pool_alloc_chain(&pool, 64, &head));
+    TEST_ASSERT_EQUAL(-EINVAL, packet_pool_alloc_chain(&pool, 0, &other));
+}
+
+void test_pool_rejects_foreign_blocks(void)
+{
+    uint8_t              buffer[16];
+    struct packet_block  foreign = {.data = buffer, .length = 0, .next = NULL};
+    struct packet_block* head    = NULL;
+    TEST_ASSERT_EQUAL(-EINVAL, packet_pool_free(&pool, &foreign));
+
+    // A foreign block at the end of a chain keeps the chain allocated
+    TEST_ASSERT_EQUAL(0, packet_pool_alloc_chain(&pool, 20, &head));
+    head->next->next = &foreign;
+    TEST_ASSERT_EQUAL(-EINVAL, packet_pool_free(&pool, head));
+    TEST_ASSERT_EQUAL(2, packet_pool_available(&pool));
+    head->next->next = NULL;
+    TEST_ASSERT_EQUAL(0, packet_pool_free(&pool, head));
+    TEST_ASSERT_EQUAL(4, packet_pool_available(&pool));
+}
+
+void test_pool_rejects_blocks_freed_twice(void)
+{
+    struct packet_block* block = NULL;
+    struct packet_block* head  = NULL;
+    TEST_ASSERT_EQUAL(0, packet_pool_alloc(&pool, &block));
+    TEST_ASSERT_EQUAL(0, packet_pool_free(&pool, block));
+    TEST_ASSERT_EQUAL(-EINVAL, packet_pool_free(&pool, block));
+    TEST_ASSERT_EQUAL(4, packet_pool_available(&pool));
+
+    // A chain ending in a free block is refused whole
+    TEST_ASSERT_EQUAL(0, packet_pool_alloc_chain(&pool, 20, &head));
+    TEST_ASSERT_EQUAL(0, packet_pool_alloc(&pool, &block));
+    TEST_ASSERT_EQUAL(0, packet_pool_free(&pool, block));
+    head->next->next = block;
+    TEST_ASSERT_EQUAL(-EINVAL, packet_pool_free(&pool, head));
+    TEST_ASSERT_EQUAL(2, packet_pool_available(&pool));
+    head->next->next = NULL;
+    TEST_ASSERT_EQUAL(0, packet_pool_free(&pool, head));
+    TEST_ASSERT_EQUAL(4, packet_pool_available(&pool));
+}
+
+void test_stats_track_the_high_water_mark(void)
+{
+    struct packet_pool_stats stats;
+    struct packet_block*     head  = NULL;
+    struct packet_block*     block = NULL;
+    TEST_ASSERT_EQUAL(0, packet_pool_alloc_chain(&pool, 48, &head));
+    TEST_ASSERT_EQUAL(0, packet_pool_alloc(&pool, &block));
+    TEST_ASSERT_EQUAL(-ENOMEM, packet_pool_alloc(&pool, &block));
+    TEST_ASSERT_EQUAL(0, packet_pool_free(&pool, head));
+
+    TEST_ASSERT_EQUAL(0, packet_pool_get_stats(&pool, &stats));
+    TEST_ASSERT_EQUAL(1, stats.in_use);
+    TEST_ASSERT_EQUAL(4, stats.high_water);
+    TEST_ASSERT_EQUAL(1, stats.failures);
+
+    // Init starts over
+    TEST_ASSERT_EQUAL(0, packet_pool_init(&pool));
+    TEST_ASSERT_EQUAL(0, packet_pool_get_stats(&pool, &stats));
+    TEST_ASSERT_EQUAL(0, stats.in_use);
+    TEST_ASSERT_EQUAL(0, stats.high_water);
+    TEST_ASSERT_EQUAL(0, stats.failures);
+}
+
+/* ========================================================================== */
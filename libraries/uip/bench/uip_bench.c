@@ -0,0 +1,593 @@
+/**
+ * @file uip_bench.c
+ * @brief Host benchmark of uip_input() through the full receive path, and of
+ * uip_udp_send() through the transmit path.
+ *
+ * Each case feeds the same received frame to uip_input() in a loop and
+ * reports packets/s and ns per packet. The frame is copied back into the
+ * receive buffer before every call, like the MAC would deliver it, because
+ * replies are built in place; the cost of that copy alone is reported first.
+ * UDP datagrams go to one of BOUND_PORTS sockets, so the port lookup is timed
+ * with a realistically filled table.
+ *
+ * Transmit cases take a buffer from a pbuf pool, write the payload once and
+ * send it: the headers are prepended in place, so the payload is never copied
+ * again. They run with uip_udp_send(), then with uip_udp_flow_send(), whose
+ * IPv4 header comes from a template.
+ *
+ * The TCP case runs a bulk transfer between two more stacks joined by an
+ * in-memory link, the client writing into its send window and the server
+ * consuming its receive window as data arrives, and reports MB/s of payload.
+ *
+ * Usage: uip-bench [-n packets]
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "../../inc/errno.h"
+#include "../inc/uip.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* ========================================================================== */
+
+static const uint8_t NODE_IP[4]  = {192, 168, 1, 10};
+static const uint8_t NODE_MAC[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+static const uint8_t PEER_IP[4]  = {192, 168, 1, 20};
+static const uint8_t PEER_MAC[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02};
+
+static unsigned long sent_frames;
+static unsigned long received_bytes;
+
+static int8_t count_send(void* context, uint8_t* frame, uint16_t size)
+{
+    (void)context;
+    (void)frame;
+    (void)size;
+    sent_frames += 1;
+    return 0;
+}
+
+static void count_datagram(void* context, const struct udp_rx_metadata* mdata)
+{
+    (void)context;
+    received_bytes += mdata->payload_size;
+}
+
+#define BOUND_PORTS 48
+
+static struct udp_socket* slots[64];
+static struct udp_table   table = {.slots = slots, .capacity = 64};
+static struct udp_socket  sockets[BOUND_PORTS];
+
+static struct arp_entry arp_entries[8];
+static struct arp_cache arp_cache = {
+    .entries        = arp_entries,
+    .capacity       = 8,
+    .max_age        = 60000,
+    .retry_interval = 1000,
+    .max_requests   = 3,
+};
+
+static struct packet_block blocks[4];
+static uint8_t             block_storage[4 * MAX_ETH_PKT_SIZE];
+static struct packet_pool  block_pool = {
+    .blocks      = blocks,
+    .storage     = block_storage,
+    .block_count = 4,
+    .block_size  = MAX_ETH_PKT_SIZE,
+};
+static struct pbuf      pbufs[4];
+static struct pbuf_pool pool = {.pbufs = pbufs, .blocks = &block_pool};
+
+static struct uip stack = {
+    .ip_addr   = {192, 168, 1, 10},
+    .mac_addr  = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01},
+    .send      = count_send,
+    .udp_table = &table,
+    .arp_cache = &arp_cache,
+};
+
+struct bench_frame
+{
+    const char* name;
+    uint8_t     data[MAX_ETH_PKT_SIZE];
+    uint16_t    size;
+    int8_t      expected;
+};
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* ========================================================================== */
+
+static uint16_t finish_eth_frame(
+    uint8_t* frame, enum eth_payload_type type, uint16_t payload_size)
+{
+    static const uint8_t   broadcast[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    struct eth             peer         = {.calc_crc = false};
+    struct eth_tx_metadata mdata
+        = {.payload_type = type, .payload_size = payload_size};
+    uint16_t size = 0;
+    memcpy(peer.mac_addr, PEER_MAC, 6);
+    memcpy(
+        mdata.dest_mac_addr, (type == ETH_PLD_ARP) ? broadcast : NODE_MAC, 6);
+    eth_build_frame(&peer, &mdata, frame, &size);
+    return (size < 60) ? 64 : size + 4; /* Padding and FCS */
+}
+
+static uint16_t build_ip_frame(
+    uint8_t*              frame,
+    enum ip_pld_prot_type prot,
+    const uint8_t*        dest_ip,
+    uint16_t              payload_size)
+{
+    struct ip             peer  = {.ip_addr = {0}};
+    struct ip_tx_metadata mdata = {
+        .version       = IP_VER_4,
+        .pld_prot_type = prot,
+        .payload_size  = payload_size,
+    };
+    uint16_t size = 0;
+    memcpy(mdata.src_ip, PEER_IP, 4);
+    memcpy(mdata.dest_ip, dest_ip, 4);
+    ip_build_frame(&peer, &mdata, frame + IP_FRAME_OFST, &size);
+    return finish_eth_frame(frame, ETH_PLD_IPV4, size);
+}
+
+static void build_udp(
+    struct bench_frame* frame, const uint8_t* dest_ip, uint16_t payload_size)
+{
+    struct udp            peer     = {0};
+    struct ip_tx_metadata ip_mdata = {0};
+    memcpy(ip_mdata.src_ip, PEER_IP, 4);
+    memcpy(ip_mdata.dest_ip, dest_ip, 4);
+    struct udp_tx_metadata mdata = {
+        .ip_mdata      = &ip_mdata,
+        .src_port_num  = 5000,
+        .dest_port_num = 7000,
+        .payload_size  = payload_size,
+    };
+    uint16_t size = 0;
+    for (uint16_t i = 0; i < payload_size; i++)
+    {
+        frame->data[UDP_PAYLOAD_OFST + i] = (uint8_t)i;
+    }
+    udp_build_frame(&peer, &mdata, frame->data + UDP_FRAME_OFST, &size);
+    frame->size     = build_ip_frame(frame->data, IP_PLD_UDP, dest_ip, size);
+    frame->expected = 0;
+}
+
+static void build_icmp_echo(struct bench_frame* frame, uint16_t payload_size)
+{
+    struct icmp             peer  = {0};
+    struct icmp_tx_metadata mdata = {
+        .type         = 8,
+        .code         = 0,
+        .id           = 1,
+        .seq_num      = 1,
+        .payload_size = payload_size,
+    };
+    uint16_t size = 0;
+    icmp_build_frame(&peer, &mdata, frame->data + ICMP_FRAME_OFST, &size);
+    frame->size
+        = build_ip_frame(frame->data, IP_PLD_ICMP, NODE_IP, size);
+    frame->expected = 0;
+}
+
+static void build_arp_request(struct bench_frame* frame)
+{
+    struct arp             peer;
+    struct arp_tx_metadata mdata = {.op_type = ARP_REQUEST};
+    uint8_t                size  = 0;
+    memcpy(peer.ip_addr, PEER_IP, 4);
+    memcpy(peer.mac_addr, PEER_MAC, 6);
+    memcpy(mdata.dest_ip_addr, NODE_IP, 4);
+    arp_build_frame(&peer, &mdata, frame->data + ETH_HEADER_SIZE, &size);
+    frame->size     = finish_eth_frame(frame->data, ETH_PLD_ARP, size);
+    frame->expected = 0;
+}
+
+/* ========================================================================== */
+
+static double time_frame(
+    const struct bench_frame* frame, unsigned long packets, bool input)
+{
+    static uint8_t rx_buffer[MAX_ETH_PKT_SIZE];
+    double         start = now_seconds();
+    for (unsigned long i = 0; i < packets; i++)
+    {
+        memcpy(rx_buffer, frame->data, frame->size);
+        if (input)
+        {
+            uip_input(&stack, rx_buffer, frame->size);
+        }
+    }
+    return 1e9 * (now_seconds() - start) / (double)packets;
+}
+
+static struct uip_udp_flow flow = {
+    .src_port = 7000,
+    .to       = {.ip_addr = {192, 168, 1, 20}, .port = 5000},
+};
+
+/* With use_flow, the IPv4 header comes from the template of flow */
+static double
+time_send(uint16_t payload_size, unsigned long packets, bool use_flow)
+{
+    static uint8_t source[1472];
+    double         start = now_seconds();
+    for (unsigned long i = 0; i < packets; i++)
+    {
+        struct pbuf* packet  = NULL;
+        uint8_t*     payload = NULL;
+        pbuf_pool_alloc(&pool, UDP_PAYLOAD_OFST, &packet);
+        pbuf_put(packet, payload_size, &payload);
+        memcpy(payload, source, payload_size);
+        if (use_flow)
+        {
+            uip_udp_flow_send(&stack, &flow, packet);
+        }
+        else
+        {
+            uip_udp_send(&stack, packet, flow.src_port, &flow.to);
+        }
+        pbuf_pool_free(&pool, packet);
+    }
+    return 1e9 * (now_seconds() - start) / (double)packets;
+}
+
+/* ========================================================================== */
+
+/* TCP: two stacks joined by a FIFO of frames */
+
+#define TCP_LINK_DEPTH 16
+#define TCP_BUF_SIZE   8192
+
+struct link_frame
+{
+    struct uip* to;
+    uint16_t    size;
+    uint8_t     data[MAX_ETH_PKT_SIZE];
+};
+
+static struct link_frame link_frames[TCP_LINK_DEPTH];
+static unsigned          link_head;
+static unsigned          link_used;
+static unsigned long     tcp_received;
+static unsigned long     tcp_segments;
+
+static int8_t link_send(void* context, uint8_t* frame, uint16_t size)
+{
+    if (link_used == TCP_LINK_DEPTH)
+    {
+        return -ENOSPC;
+    }
+    struct link_frame* slot
+        = &link_frames[(link_head + link_used) % TCP_LINK_DEPTH];
+    memcpy(slot->data, frame, size);
+    memset(slot->data + size, 0, 4); /* FCS */
+    slot->size = ((size < 60) ? 60 : size) + 4;
+    slot->to   = context;
+    link_used += 1;
+    tcp_segments += 1;
+    return 0;
+}
+
+static void run_link(void)
+{
+    static uint8_t frame[MAX_ETH_PKT_SIZE];
+    while (link_used > 0)
+    {
+        struct link_frame* slot = &link_frames[link_head];
+        struct uip*        to   = slot->to;
+        uint16_t           size = slot->size;
+        memcpy(frame, slot->data, size);
+        link_head = (link_head + 1) % TCP_LINK_DEPTH;
+        link_used -= 1;
+        uip_input(to, frame, size);
+    }
+}
+
+static struct tcp_conn* client_conn;
+
+static void
+tcp_client(void* context, struct tcp_conn* conn, enum tcp_event event)
+{
+    (void)context;
+    (void)event;
+    client_conn = conn;
+}
+
+static void
+tcp_server(void* context, struct tcp_conn* conn, enum tcp_event event)
+{
+    const uint8_t* data = NULL;
+    uint16_t       size = 0;
+    while (event == TCP_EVENT_RECEIVED
+           && tcp_conn_rx_window(conn, &data, &size) == 0 && size > 0)
+    {
+        tcp_received += size;
+        uip_tcp_consume(context, conn, size);
+    }
+}
+
+static uint8_t tcp_buffers[2][2][TCP_BUF_SIZE];
+static uint8_t tcp_tx_frames[2][MAX_ETH_PKT_SIZE];
+
+static struct tcp_conn client_conns[1] = {{
+    .rx_buffer = tcp_buffers[0][0],
+    .rx_size   = TCP_BUF_SIZE,
+    .tx_buffer = tcp_buffers[0][1],
+    .tx_size   = TCP_BUF_SIZE,
+}};
+static struct tcp_conn server_conns[1] = {{
+    .rx_buffer = tcp_buffers[1][0],
+    .rx_size   = TCP_BUF_SIZE,
+    .tx_buffer = tcp_buffers[1][1],
+    .tx_size   = TCP_BUF_SIZE,
+}};
+static struct tcp_listener* client_listeners[1];
+static struct tcp_listener* server_listeners[1];
+static struct tcp_table     client_table = {
+    .conns          = client_conns,
+    .conn_count     = 1,
+    .listeners      = client_listeners,
+    .listener_count = 1,
+    .tx_frame       = tcp_tx_frames[0],
+    .tx_frame_size  = MAX_ETH_PKT_SIZE,
+    .ack_delay      = 200,
+    .rto_initial    = 1000,
+    .rto_min        = 200,
+    .rto_max        = 60000,
+    .max_retries    = 5,
+    .time_wait      = 4000,
+};
+static struct tcp_table server_table = {
+    .conns          = server_conns,
+    .conn_count     = 1,
+    .listeners      = server_listeners,
+    .listener_count = 1,
+    .tx_frame       = tcp_tx_frames[1],
+    .tx_frame_size  = MAX_ETH_PKT_SIZE,
+    .ack_delay      = 200,
+    .rto_initial    = 1000,
+    .rto_min        = 200,
+    .rto_max        = 60000,
+    .max_retries    = 5,
+    .time_wait      = 4000,
+};
+
+static struct arp_entry client_arp_entries[2];
+static struct arp_entry server_arp_entries[2];
+static struct arp_cache client_arp_cache = {
+    .entries        = client_arp_entries,
+    .capacity       = 2,
+    .max_age        = 60000,
+    .retry_interval = 1000,
+    .max_requests   = 3,
+};
+static struct arp_cache server_arp_cache = {
+    .entries        = server_arp_entries,
+    .capacity       = 2,
+    .max_age        = 60000,
+    .retry_interval = 1000,
+    .max_requests   = 3,
+};
+
+static struct uip tcp_server_stack;
+static struct uip tcp_client_stack = {
+    .ip_addr      = {192, 168, 1, 10},
+    .mac_addr     = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01},
+    .send         = link_send,
+    .send_context = &tcp_server_stack,
+    .arp_cache    = &client_arp_cache,
+    .tcp_table    = &client_table,
+};
+static struct uip tcp_server_stack = {
+    .ip_addr      = {192, 168, 1, 20},
+    .mac_addr     = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02},
+    .send         = link_send,
+    .send_context = &tcp_client_stack,
+    .arp_cache    = &server_arp_cache,
+    .tcp_table    = &server_table,
+};
+static struct tcp_listener listener = {
+    .port    = 80,
+    .handler = tcp_server,
+    .context = &tcp_server_stack,
+};
+
+/**
+ * @brief Connect, then send bytes of payload as fast as the windows allow.
+ * @return ns per MB of payload, 0 on failure.
+ */
+static double time_tcp(unsigned long bytes)
+{
+    static const struct tcp_endpoint to = {
+        .ip_addr = {192, 168, 1, 20},
+        .port    = 80,
+    };
+    struct tcp_conn* conn = NULL;
+    if (arp_cache_init(&client_arp_cache) != 0
+        || arp_cache_init(&server_arp_cache) != 0
+        || tcp_table_init(&client_table) != 0
+        || tcp_table_init(&server_table) != 0
+        || uip_init(&tcp_client_stack) != 0 || uip_init(&tcp_server_stack) != 0
+        || arp_cache_update(&client_arp_cache, PEER_IP, PEER_MAC, true) != 0
+        || arp_cache_update(&server_arp_cache, NODE_IP, NODE_MAC, true) != 0
+        || tcp_table_listen(&server_table, &listener) != 0
+        || uip_tcp_connect(&tcp_client_stack, &to, tcp_client, NULL, &conn)
+               != 0)
+    {
+        return 0;
+    }
+    run_link();
+    if (tcp_conn_get_state(conn) != TCP_ESTABLISHED)
+    {
+        return 0;
+    }
+
+    unsigned long written = 0;
+    tcp_received          = 0;
+    tcp_segments          = 0;
+    double start          = now_seconds();
+    while (tcp_received < bytes)
+    {
+        uint8_t* data = NULL;
+        uint16_t size = 0;
+        tcp_conn_tx_window(conn, &data, &size);
+        if (size > bytes - written)
+        {
+            size = (uint16_t)(bytes - written);
+        }
+        if (size > 0)
+        {
+            memset(data, (int)written, size);
+            uip_tcp_send(&tcp_client_stack, conn, size);
+            written += size;
+        }
+        else if (link_used == 0)
+        {
+            return 0; /* Stalled */
+        }
+        run_link();
+    }
+    return 1e9 * (now_seconds() - start) / ((double)bytes / 1e6);
+}
+
+/* ========================================================================== */
+
+int main(int argc, char** argv)
+{
+    unsigned long packets = 1000000;
+    if (argc == 3 && strcmp(argv[1], "-n") == 0)
+    {
+        packets = strtoul(argv[2], NULL, 10);
+    }
+    if (packets == 0 || (argc != 1 && argc != 3))
+    {
+        fprintf(stderr, "usage: %s [-n packets]\n", argv[0]);
+        return 1;
+    }
+
+    if (udp_table_init(&table) != 0 || arp_cache_init(&arp_cache) != 0
+        || packet_pool_init(&block_pool) != 0 || pbuf_pool_init(&pool) != 0
+        || uip_init(&stack) != 0 || uip_udp_flow_init(&stack, &flow) != 0
+        || arp_cache_update(&arp_cache, PEER_IP, PEER_MAC, true) != 0)
+    {
+        return 1;
+    }
+    // Ports 6977 to 7024: the benchmarked port 7000 is in the middle
+    for (uint16_t i = 0; i < BOUND_PORTS; i++)
+    {
+        struct udp_socket socket = {
+            .port    = (uint16_t)(7000 - BOUND_PORTS / 2 + 1 + i),
+            .handler = count_datagram,
+        };
+        memcpy(&sockets[i], &socket, sizeof(socket));
+        if (udp_table_bind(&table, &sockets[i]) != 0)
+        {
+            return 1;
+        }
+    }
+
+    static struct bench_frame frames[] = {
+        {.name = "UDP, 16-byte payload"},
+        {.name = "UDP, 512-byte payload"},
+        {.name = "UDP, 1472-byte payload"},
+        {.name = "ICMP echo, 56-byte payload"},
+        {.name = "ARP request"},
+        {.name = "UDP, bad checksum"},
+        {.name = "UDP, other node"},
+        {.name = "IPv4, bad header checksum"},
+    };
+    size_t frame_count = sizeof(frames) / sizeof(frames[0]);
+    static const uint8_t other_ip[4] = {192, 168, 1, 11};
+    build_udp(&frames[0], NODE_IP, 16);
+    build_udp(&frames[1], NODE_IP, 512);
+    build_udp(&frames[2], NODE_IP, 1472);
+    build_icmp_echo(&frames[3], 56);
+    build_arp_request(&frames[4]);
+    build_udp(&frames[5], NODE_IP, 512);
+    frames[5].data[UDP_PAYLOAD_OFST] ^= 0x01;
+    frames[5].expected = -EINVAL;
+    build_udp(&frames[6], other_ip, 16);
+    frames[6].expected = -ENOENT;
+    build_udp(&frames[7], NODE_IP, 1472);
+    frames[7].data[IP_FRAME_OFST + 10] ^= 0x01; /* Header checksum */
+    frames[7].expected = -EINVAL;
+
+    // Every case must take the intended path before it is timed
+    for (size_t i = 0; i < frame_count; i++)
+    {
+        uint8_t rx_buffer[MAX_ETH_PKT_SIZE];
+        memcpy(rx_buffer, frames[i].data, frames[i].size);
+        int8_t status = uip_input(&stack, rx_buffer, frames[i].size);
+        if (status != frames[i].expected)
+        {
+            fprintf(
+                stderr, "%s: uip_input returned %d\n", frames[i].name, status);
+            return 1;
+        }
+    }
+
+    printf("uip benchmark (%lu packets per case)\n", packets);
+    printf("  %-28s %8s %12s\n", "", "ns/pkt", "packets/s");
+    printf(
+        "  %-28s %8.1f\n",
+        "copy of a 1518-byte frame",
+        time_frame(&frames[2], packets, false));
+    for (size_t i = 0; i < frame_count; i++)
+    {
+        double ns = time_frame(&frames[i], packets, true);
+        printf("  %-28s %8.1f %12.0f\n", frames[i].name, ns, 1e9 / ns);
+    }
+
+    static const uint16_t send_sizes[] = {16, 512, 1472};
+    for (int use_flow = 0; use_flow < 2; use_flow++)
+    {
+        for (size_t i = 0; i < sizeof(send_sizes) / sizeof(send_sizes[0]); i++)
+        {
+            char name[40];
+            snprintf(
+                name,
+                sizeof(name),
+                "UDP %s, %u-byte payload",
+                use_flow ? "flow" : "send",
+                send_sizes[i]);
+            double ns = time_send(send_sizes[i], packets, use_flow);
+            printf("  %-28s %8.1f %12.0f\n", name, ns, 1e9 / ns);
+        }
+    }
+
+    unsigned long tcp_bytes = (packets < 10000) ? packets * 1000 : 10000000;
+    double        ns        = time_tcp(tcp_bytes);
+    if (ns == 0)
+    {
+        fprintf(stderr, "TCP transfer failed\n");
+        return 1;
+    }
+    printf(
+        "  %-28s %8.1f MB/s (%lu bytes, %lu segments)\n",
+        "TCP bulk transfer",
+        1e9 / ns,
+        tcp_bytes,
+        tcp_segments);
+
+    struct uip_stats stats;
+    uip_get_stats(&stack, &stats);
+    printf(
+        "%lu frames sent, %lu UDP bytes delivered, %lu frames dropped\n",
+        sent_frames,
+        received_bytes,
+        (unsigned long)stats.dropped);
+    return 0;
+}
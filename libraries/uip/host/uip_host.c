@@ -0,0 +1,844 @@
+/**
+ * @file uip_host.c
+ * @brief Host harness running the uip stack on a Linux workstation, against
+ * a TAP interface or a pcap capture.
+ *
+ * With -t, frames are read from and written to a TAP interface, so the stack
+ * can be reached from the host like a board on the bench: it answers ARP and
+ * ping, echoes UDP and TCP on port 7 and discards UDP on port 9. With -f, it
+ * also sends a flood of UDP datagrams to the given address through
+ * uip_udp_flow_send(). It runs until interrupted, or for -d seconds.
+ *
+ * With -r, the frames of a pcap capture are fed to uip_input() instead, -l
+ * times over, with the stack timers following the capture timestamps. Frames
+ * the stack sends are only counted. This needs no privileges.
+ *
+ * Either way, -w records every frame received and sent in a pcap file, for
+ * Wireshark or tcpdump -r. The report gives frames/s, the time spent in
+ * uip_input() per frame (mean and max), the flood rate and the stack
+ * counters.
+ *
+ * Usage: uip-host (-t tap | -r capture.pcap) [-a ip] [-m mac] [-w out.pcap]
+ *                 [-l loops] [-d seconds] [-f ip:port] [-n count] [-s size]
+ */
+
+#define _DEFAULT_SOURCE
+
+#include "../../inc/errno.h"
+#include "../inc/pcap.h"
+#include "../inc/uip.h"
+
+#include <fcntl.h>
+#include <linux/if.h>
+#include <linux/if_tun.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/random.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ========================================================================== */
+
+static const uint16_t ECHO_PORT    = 7;
+static const uint16_t DISCARD_PORT = 9;
+static const int      POLL_MS      = 10;
+
+/* Shortest frame on the wire without its FCS: shorter ones are padded */
+static const uint16_t ETH_MIN_FRAME_SIZE = 60;
+static const uint16_t ETH_FCS_SIZE       = 4;
+
+/* Datagrams of the flood sent per turn of the main loop, between reads */
+static const unsigned FLOOD_BURST = 32;
+
+struct host_options
+{
+    const char*   tap_name;
+    const char*   replay_path;
+    const char*   capture_path;
+    uint8_t       ip_addr[4];
+    uint8_t       mac_addr[6];
+    unsigned long loops;
+    double        duration;
+    bool          flood;
+    uint8_t       flood_ip[4];
+    uint16_t      flood_port;
+    unsigned long flood_count;
+    uint16_t      flood_size;
+};
+
+/* Everything the send function and the report need */
+struct host_link
+{
+    int                 tap_fd;
+    struct pcap_writer* capture;
+    unsigned long       rx_frames;
+    unsigned long       tx_frames;
+    unsigned long       tx_errors;
+    double              input_ns;
+    double              input_max_ns;
+};
+
+static volatile sig_atomic_t stop;
+static struct host_link      host_link = {.tap_fd = -1};
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(now_seconds() * 1000);
+}
+
+static void on_signal(int signal)
+{
+    (void)signal;
+    stop = 1;
+}
+
+/* ========================================================================== */
+
+/* Capture */
+
+static int8_t file_write(void* context, const uint8_t* data, uint16_t size)
+{
+    return (fwrite(data, 1, size, context) == size) ? 0 : -EIO;
+}
+
+static void capture_frame(const uint8_t* frame, uint16_t size)
+{
+    if (host_link.capture == NULL)
+    {
+        return;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    pcap_writer_frame(
+        host_link.capture,
+        (uint32_t)ts.tv_sec,
+        (uint32_t)(ts.tv_nsec / 1000),
+        frame,
+        size);
+}
+
+/* ========================================================================== */
+
+/* Link: a TAP interface, or nothing when replaying */
+
+static int8_t host_send(void* context, uint8_t* frame, uint16_t size)
+{
+    struct host_link* link = context;
+    capture_frame(frame, size);
+    if (link->tap_fd >= 0 && write(link->tap_fd, frame, size) != size)
+    {
+        link->tx_errors += 1;
+        return -EIO;
+    }
+    link->tx_frames += 1;
+    return 0;
+}
+
+static int open_tap(const char* name)
+{
+    int fd = open("/dev/net/tun", O_RDWR);
+    if (fd < 0)
+    {
+        perror("/dev/net/tun");
+        return -1;
+    }
+    struct ifreq request;
+    memset(&request, 0, sizeof(request));
+    request.ifr_flags = IFF_TAP | IFF_NO_PI;
+    strncpy(request.ifr_name, name, IFNAMSIZ - 1);
+    if (ioctl(fd, TUNSETIFF, &request) < 0)
+    {
+        perror(name);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Hand one received frame to the stack, timing uip_input(). TAP
+ * interfaces and captures give frames without padding and FCS: they are added
+ * back, as the MAC would deliver the frame. frame must have room for them.
+ */
+static void input_frame(struct uip* stack, uint8_t* frame, uint16_t size)
+{
+    capture_frame(frame, size);
+    if (size < ETH_MIN_FRAME_SIZE)
+    {
+        memset(frame + size, 0, ETH_MIN_FRAME_SIZE - size);
+        size = ETH_MIN_FRAME_SIZE;
+    }
+    if (size <= MAX_ETH_PKT_SIZE - ETH_FCS_SIZE)
+    {
+        memset(frame + size, 0, ETH_FCS_SIZE);
+        size += ETH_FCS_SIZE;
+    }
+
+    double start = now_seconds();
+    uip_input(stack, frame, size);
+    double ns = 1e9 * (now_seconds() - start);
+
+    host_link.rx_frames += 1;
+    host_link.input_ns += ns;
+    if (ns > host_link.input_max_ns)
+    {
+        host_link.input_max_ns = ns;
+    }
+}
+
+/* ========================================================================== */
+
+/* Stack */
+
+static struct udp_socket* slots[8];
+static struct udp_table   udp_table = {.slots = slots, .capacity = 8};
+
+static struct arp_entry arp_entries[16];
+static struct arp_cache arp_cache = {
+    .entries        = arp_entries,
+    .capacity       = 16,
+    .max_age        = 60000,
+    .retry_interval = 1000,
+    .max_requests   = 3,
+};
+static uint8_t tx_queue[8 * (2 + MAX_ETH_PKT_SIZE)];
+
+static struct ip_reasm_slot reasm_slots[2];
+static uint8_t              reasm_storage[2][8192];
+static struct ip_reasm      reasm = {
+    .slots      = reasm_slots,
+    .storage    = reasm_storage[0],
+    .slot_count = 2,
+    .slot_size  = sizeof(reasm_storage[0]),
+    .timeout    = 2000,
+};
+
+#define TCP_CONNS    4
+#define TCP_BUF_SIZE 4096
+
+static uint32_t host_random(void)
+{
+    uint32_t value = 0;
+    if (getrandom(&value, sizeof(value), 0) != sizeof(value))
+    {
+        value = (uint32_t)time(NULL);
+    }
+    return value;
+}
+
+static uint8_t         tcp_buffers[TCP_CONNS][2][TCP_BUF_SIZE];
+static uint8_t         tcp_tx_frame[MAX_ETH_PKT_SIZE];
+static struct tcp_conn tcp_conns[TCP_CONNS] = {
+    {
+        .rx_buffer = tcp_buffers[0][0],
+        .rx_size   = TCP_BUF_SIZE,
+        .tx_buffer = tcp_buffers[0][1],
+        .tx_size   = TCP_BUF_SIZE,
+    },
+    {
+        .rx_buffer = tcp_buffers[1][0],
+        .rx_size   = TCP_BUF_SIZE,
+        .tx_buffer = tcp_buffers[1][1],
+        .tx_size   = TCP_BUF_SIZE,
+    },
+    {
+        .rx_buffer = tcp_buffers[2][0],
+        .rx_size   = TCP_BUF_SIZE,
+        .tx_buffer = tcp_buffers[2][1],
+        .tx_size   = TCP_BUF_SIZE,
+    },
+    {
+        .rx_buffer = tcp_buffers[3][0],
+        .rx_size   = TCP_BUF_SIZE,
+        .tx_buffer = tcp_buffers[3][1],
+        .tx_size   = TCP_BUF_SIZE,
+    },
+};
+static struct tcp_listener* tcp_listeners[1];
+static struct tcp_table     tcp_table = {
+    .conns          = tcp_conns,
+    .conn_count     = TCP_CONNS,
+    .listeners      = tcp_listeners,
+    .listener_count = 1,
+    .tx_frame       = tcp_tx_frame,
+    .tx_frame_size  = sizeof(tcp_tx_frame),
+    .ack_delay      = 40,
+    .rto_initial    = 1000,
+    .rto_min        = 200,
+    .rto_max        = 60000,
+    .max_retries    = 8,
+    .time_wait      = 4000,
+    .get_random     = host_random,
+};
+
+static struct packet_block blocks[8];
+static uint8_t             block_storage[8 * MAX_ETH_PKT_SIZE];
+static struct packet_pool  block_pool = {
+    .blocks      = blocks,
+    .storage     = block_storage,
+    .block_count = 8,
+    .block_size  = MAX_ETH_PKT_SIZE,
+};
+static struct pbuf      pbufs[8];
+static struct pbuf_pool pool = {.pbufs = pbufs, .blocks = &block_pool};
+
+static void udp_echo(void* context, const struct udp_rx_metadata* mdata)
+{
+    struct pbuf*        packet  = NULL;
+    uint8_t*            payload = NULL;
+    struct udp_endpoint to      = {.port = mdata->src_port_num};
+    memcpy(to.ip_addr, mdata->ip_mdata->src_ip, 4);
+    if (pbuf_pool_alloc(&pool, UDP_PAYLOAD_OFST, &packet) != 0)
+    {
+        return;
+    }
+    if (pbuf_put(packet, mdata->payload_size, &payload) == 0)
+    {
+        memcpy(payload, mdata->payload, mdata->payload_size);
+        uip_udp_send(context, packet, mdata->dest_port_num, &to);
+    }
+    pbuf_pool_free(&pool, packet);
+}
+
+static void udp_discard(void* context, const struct udp_rx_metadata* mdata)
+{
+    (void)context;
+    (void)mdata;
+}
+
+/* Move what was received to the send window, as far as it has room */
+static void tcp_echo(void* context, struct tcp_conn* conn, enum tcp_event event)
+{
+    if (event == TCP_EVENT_PEER_CLOSED)
+    {
+        uip_tcp_close(context, conn);
+    }
+    if (event != TCP_EVENT_RECEIVED && event != TCP_EVENT_SENT)
+    {
+        return;
+    }
+    const uint8_t* data  = NULL;
+    uint8_t*       room  = NULL;
+    uint16_t       size  = 0;
+    uint16_t       space = 0;
+    while (tcp_conn_rx_window(conn, &data, &size) == 0 && size > 0
+           && tcp_conn_tx_window(conn, &room, &space) == 0 && space > 0)
+    {
+        if (size > space)
+        {
+            size = space;
+        }
+        memcpy(room, data, size);
+        if (uip_tcp_send(context, conn, size) != 0
+            || uip_tcp_consume(context, conn, size) != 0)
+        {
+            return;
+        }
+    }
+}
+
+/* ========================================================================== */
+
+/* Backends */
+
+/**
+ * @brief Read a whole file into memory.
+ * @return The contents, to be freed, or NULL on error.
+ */
+static uint8_t* read_file(const char* path, uint32_t* size)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        perror(path);
+        return NULL;
+    }
+    uint8_t* data = NULL;
+    long     end  = -1;
+    if (fseek(file, 0, SEEK_END) == 0)
+    {
+        end = ftell(file);
+    }
+    if (end >= 0 && end <= 0x7FFFFFFF && fseek(file, 0, SEEK_SET) == 0)
+    {
+        data = malloc(end ? (size_t)end : 1);
+    }
+    if (data != NULL && fread(data, 1, (size_t)end, file) != (size_t)end)
+    {
+        free(data);
+        data = NULL;
+    }
+    if (data == NULL)
+    {
+        fprintf(stderr, "%s: cannot read\n", path);
+    }
+    fclose(file);
+    *size = (uint32_t)end;
+    return data;
+}
+
+static int
+run_replay(struct uip* stack, const struct host_options* options, double* time)
+{
+    uint32_t size = 0;
+    uint8_t* data = read_file(options->replay_path, &size);
+    if (data == NULL)
+    {
+        return 1;
+    }
+
+    static uint8_t     frame[MAX_ETH_PKT_SIZE];
+    struct pcap_reader reader = {.data = data, .size = size};
+    struct pcap_record record;
+    int8_t             status = 0;
+    double             start  = now_seconds();
+    for (unsigned long loop = 0; loop < options->loops && !stop; loop++)
+    {
+        status = pcap_reader_init(&reader);
+        while (status == 0 && !stop
+               && (status = pcap_reader_next(&reader, &record)) == 0)
+        {
+            // The stack rewrites frames in place: give it a copy
+            uint16_t frame_size = record.size;
+            if (frame_size > sizeof(frame))
+            {
+                frame_size = sizeof(frame);
+            }
+            memcpy(frame, record.frame, frame_size);
+            input_frame(stack, frame, frame_size);
+            uip_poll(stack, record.ts_sec * 1000 + record.ts_usec / 1000);
+        }
+        if (status != -ENOENT && !stop)
+        {
+            fprintf(
+                stderr, "%s: not a valid capture\n", options->replay_path);
+            break;
+        }
+    }
+    *time = now_seconds() - start;
+    free(data);
+    return (status == -ENOENT || stop) ? 0 : 1;
+}
+
+struct flood
+{
+    struct uip_udp_flow* flow;
+    unsigned long        sent;
+    unsigned long        refused;
+    double               send_ns;
+    double               start;
+    double               end;
+};
+
+static void
+flood_burst(struct uip* stack, struct flood* flood, uint16_t payload_size)
+{
+    for (unsigned i = 0; i < FLOOD_BURST; i++)
+    {
+        struct pbuf* packet  = NULL;
+        uint8_t*     payload = NULL;
+        if (pbuf_pool_alloc(&pool, UDP_PAYLOAD_OFST, &packet) != 0)
+        {
+            return;
+        }
+        pbuf_put(packet, payload_size, &payload);
+        memset(payload, (int)flood->sent, payload_size);
+
+        double start  = now_seconds();
+        int8_t status = uip_udp_flow_send(stack, flood->flow, packet);
+        double end    = now_seconds();
+        pbuf_pool_free(&pool, packet);
+        if (status != 0 && status != -EINPROGRESS)
+        {
+            // The TX queue is full until ARP resolves: try again next turn
+            flood->refused += 1;
+            return;
+        }
+        if (flood->sent == 0)
+        {
+            flood->start = start;
+        }
+        flood->sent += 1;
+        flood->send_ns += 1e9 * (end - start);
+        flood->end = end;
+    }
+}
+
+static int run_tap(
+    struct uip*                stack,
+    const struct host_options* options,
+    struct flood*              flood,
+    double*                    time)
+{
+    host_link.tap_fd = open_tap(options->tap_name);
+    if (host_link.tap_fd < 0)
+    {
+        return 1;
+    }
+    uip_announce(stack);
+
+    static uint8_t frame[MAX_ETH_PKT_SIZE];
+    struct pollfd  tap   = {.fd = host_link.tap_fd, .events = POLLIN};
+    double         start = now_seconds();
+    while (!stop
+           && (options->duration <= 0
+               || now_seconds() - start < options->duration))
+    {
+        bool flooding = flood->flow != NULL
+                        && flood->sent < options->flood_count;
+        if (poll(&tap, 1, flooding ? 0 : POLL_MS) > 0)
+        {
+            ssize_t size = read(host_link.tap_fd, frame, sizeof(frame));
+            if (size > 0)
+            {
+                input_frame(stack, frame, (uint16_t)size);
+            }
+        }
+        if (flooding)
+        {
+            flood_burst(stack, flood, options->flood_size);
+        }
+        uip_poll(stack, now_ms());
+    }
+    *time = now_seconds() - start;
+    close(host_link.tap_fd);
+    return 0;
+}
+
+/* ========================================================================== */
+
+/* Command line */
+
+static bool parse_ip(const char* text, uint8_t* ip_addr)
+{
+    unsigned parts[4];
+    char     end = 0;
+    if (sscanf(
+            text, "%u.%u.%u.%u%c", &parts[0], &parts[1], &parts[2], &parts[3],
+            &end)
+        != 4)
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        if (parts[i] > 255)
+        {
+            return false;
+        }
+        ip_addr[i] = (uint8_t)parts[i];
+    }
+    return true;
+}
+
+static bool parse_mac(const char* text, uint8_t* mac_addr)
+{
+    unsigned parts[6];
+    char     end = 0;
+    if (sscanf(
+            text, "%x:%x:%x:%x:%x:%x%c", &parts[0], &parts[1], &parts[2],
+            &parts[3], &parts[4], &parts[5], &end)
+        != 6)
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        if (parts[i] > 255)
+        {
+            return false;
+        }
+        mac_addr[i] = (uint8_t)parts[i];
+    }
+    return true;
+}
+
+static bool parse_endpoint(const char* text, uint8_t* ip_addr, uint16_t* port)
+{
+    char     ip_text[16];
+    unsigned value = 0;
+    char     end   = 0;
+    if (sscanf(text, "%15[0-9.]:%u%c", ip_text, &value, &end) != 2
+        || value == 0 || value > 65535 || !parse_ip(ip_text, ip_addr))
+    {
+        return false;
+    }
+    *port = (uint16_t)value;
+    return true;
+}
+
+static bool
+parse_options(int argc, char** argv, struct host_options* options)
+{
+    for (int i = 1; i < argc; i += 2)
+    {
+        const char* flag  = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (value == NULL || flag[0] != '-' || flag[1] == 0 || flag[2] != 0)
+        {
+            return false;
+        }
+        bool ok = true;
+        switch (flag[1])
+        {
+            case 't':
+            {
+                options->tap_name = value;
+                break;
+            }
+            case 'r':
+            {
+                options->replay_path = value;
+                break;
+            }
+            case 'w':
+            {
+                options->capture_path = value;
+                break;
+            }
+            case 'a':
+            {
+                ok = parse_ip(value, options->ip_addr);
+                break;
+            }
+            case 'm':
+            {
+                ok = parse_mac(value, options->mac_addr);
+                break;
+            }
+            case 'l':
+            {
+                options->loops = strtoul(value, NULL, 10);
+                break;
+            }
+            case 'd':
+            {
+                options->duration = strtod(value, NULL);
+                break;
+            }
+            case 'n':
+            {
+                options->flood_count = strtoul(value, NULL, 10);
+                break;
+            }
+            case 'f':
+            {
+                options->flood = true;
+                ok             = parse_endpoint(
+                    value, options->flood_ip, &options->flood_port);
+                break;
+            }
+            case 's':
+            {
+                unsigned long size  = strtoul(value, NULL, 10);
+                ok                  = size <= 1472;
+                options->flood_size = (uint16_t)size;
+                break;
+            }
+            default:
+            {
+                ok = false;
+                break;
+            }
+        }
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    // Exactly one backend, and a flood needs a live link
+    return (options->tap_name == NULL) != (options->replay_path == NULL)
+           && options->loops > 0
+           && (options->tap_name != NULL || !options->flood);
+}
+
+/* ========================================================================== */
+
+static void
+report(const struct uip* stack, const struct flood* flood, double time)
+{
+    struct uip_stats stats;
+    uip_get_stats(stack, &stats);
+
+    double rate = (time > 0) ? (double)host_link.rx_frames / time : 0;
+    double mean = host_link.rx_frames
+                      ? host_link.input_ns / (double)host_link.rx_frames
+                      : 0;
+    printf(
+        "rx: %lu frames in %.3f s, %.0f frames/s, uip_input() %.0f ns mean, "
+        "%.0f ns max\n",
+        host_link.rx_frames,
+        time,
+        rate,
+        mean,
+        host_link.input_max_ns);
+    printf(
+        "tx: %lu frames, %lu errors\n",
+        host_link.tx_frames,
+        host_link.tx_errors);
+    if (flood->flow != NULL)
+    {
+        double span = flood->end - flood->start;
+        printf(
+            "flood: %lu datagrams, %.0f datagrams/s, %.0f ns per send, "
+            "%lu refused (queue full)\n",
+            flood->sent,
+            (span > 0) ? (double)flood->sent / span : 0,
+            flood->sent ? flood->send_ns / (double)flood->sent : 0,
+            flood->refused);
+    }
+    printf(
+        "stack: %u ARP replies, %u echo replies, %u UDP delivered, %u TCP "
+        "segments, %u dropped\n",
+        (unsigned)stats.arp_replies,
+        (unsigned)stats.icmp_echo_replies,
+        (unsigned)stats.udp_delivered,
+        (unsigned)stats.tcp_segments,
+        (unsigned)stats.dropped);
+    printf(
+        "       %u sent, %u queued for ARP, %u lost, %u ARP requests\n",
+        (unsigned)stats.tx_frames,
+        (unsigned)stats.tx_queued,
+        (unsigned)stats.tx_dropped,
+        (unsigned)stats.arp_requests);
+    printf(
+        "ip discards: %u truncated, %u bad version, %u bad header, %u bad "
+        "checksum, %u TTL expired\n",
+        (unsigned)stats.ip_discards.truncated,
+        (unsigned)stats.ip_discards.bad_version,
+        (unsigned)stats.ip_discards.bad_header,
+        (unsigned)stats.ip_discards.bad_checksum,
+        (unsigned)stats.ip_discards.ttl_expired);
+    if (host_link.capture != NULL)
+    {
+        printf(
+            "capture: %u frames\n",
+            (unsigned)pcap_writer_frames(host_link.capture));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    struct host_options options = {
+        .ip_addr     = {10, 0, 0, 2},
+        .mac_addr    = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01},
+        .loops       = 1,
+        .flood_count = 100000,
+        .flood_size  = 64,
+    };
+    if (!parse_options(argc, argv, &options))
+    {
+        fprintf(
+            stderr,
+            "usage: %s (-t tap | -r capture.pcap) [-a ip] [-m mac] "
+            "[-w out.pcap]\n"
+            "       [-l loops] [-d seconds] [-f ip:port] [-n count] "
+            "[-s size]\n",
+            argv[0]);
+        return 1;
+    }
+
+    struct uip stack = {
+        .ip_addr = {options.ip_addr[0], options.ip_addr[1],
+                    options.ip_addr[2], options.ip_addr[3]},
+        .mac_addr = {options.mac_addr[0], options.mac_addr[1],
+                     options.mac_addr[2], options.mac_addr[3],
+                     options.mac_addr[4], options.mac_addr[5]},
+        .send          = host_send,
+        .send_context  = &host_link,
+        .udp_table     = &udp_table,
+        .arp_cache     = &arp_cache,
+        .tx_queue      = tx_queue,
+        .tx_queue_size = sizeof(tx_queue),
+        .ip_reasm      = &reasm,
+        .tcp_table     = &tcp_table,
+    };
+    struct udp_socket echo = {
+        .port    = ECHO_PORT,
+        .handler = udp_echo,
+        .context = &stack,
+    };
+    struct udp_socket discard = {
+        .port    = DISCARD_PORT,
+        .handler = udp_discard,
+    };
+    struct tcp_listener tcp_echo_listener = {
+        .port    = ECHO_PORT,
+        .handler = tcp_echo,
+        .context = &stack,
+    };
+    struct uip_udp_flow flow = {
+        .src_port = 5000,
+        .to       = {.ip_addr = {options.flood_ip[0], options.flood_ip[1],
+                                 options.flood_ip[2], options.flood_ip[3]},
+                     .port    = options.flood_port},
+    };
+    struct flood flood = {.flow = options.flood ? &flow : NULL};
+
+    if (udp_table_init(&udp_table) != 0
+        || udp_table_bind(&udp_table, &echo) != 0
+        || udp_table_bind(&udp_table, &discard) != 0
+        || arp_cache_init(&arp_cache) != 0 || ip_reasm_init(&reasm) != 0
+        || tcp_table_init(&tcp_table) != 0
+        || tcp_table_listen(&tcp_table, &tcp_echo_listener) != 0
+        || packet_pool_init(&block_pool) != 0 || pbuf_pool_init(&pool) != 0
+        || uip_init(&stack) != 0 || uip_udp_flow_init(&stack, &flow) != 0)
+    {
+        fprintf(stderr, "stack setup failed\n");
+        return 1;
+    }
+
+    FILE* capture_file = NULL;
+    if (options.capture_path != NULL)
+    {
+        capture_file = fopen(options.capture_path, "wb");
+        if (capture_file == NULL)
+        {
+            perror(options.capture_path);
+            return 1;
+        }
+    }
+    struct pcap_writer capture = {
+        .write    = file_write,
+        .context  = capture_file,
+        .snap_len = MAX_ETH_PKT_SIZE,
+    };
+    if (capture_file != NULL)
+    {
+        if (pcap_writer_init(&capture) != 0)
+        {
+            fprintf(stderr, "%s: cannot write\n", options.capture_path);
+            fclose(capture_file);
+            return 1;
+        }
+        host_link.capture = &capture;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    double time   = 0;
+    int    result = (options.tap_name != NULL)
+                        ? run_tap(&stack, &options, &flood, &time)
+                        : run_replay(&stack, &options, &time);
+    if (result == 0)
+    {
+        report(&stack, &flood, time);
+    }
+    if (capture_file != NULL)
+    {
+        fclose(capture_file);
+    }
+    return result;
+}
@@ -0,0 +1,155 @@
+#ifndef ARP_CACHE_H
+#define ARP_CACHE_H
+
+/* ========================================================================== */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ========================================================================== */
+
+enum arp_entry_state
+{
+    ARP_ENTRY_FREE,
+    ARP_ENTRY_PENDING,
+    ARP_ENTRY_RESOLVED,
+};
+
+enum arp_cache_event
+{
+    ARP_CACHE_SEND_REQUEST,
+    ARP_CACHE_UNREACHABLE,
+};
+
+/**
+ * @brief Called by arp_cache_age() when an ARP request must be (re)sent for
+ * ip_addr, or when ip_addr did not answer max_requests requests and its entry
+ * was freed.
+ */
+typedef void (*arp_cache_event_t)(
+    void* context, enum arp_cache_event event, const uint8_t* ip_addr);
+
+/**
+ * struct arp_entry - One IPv4 to MAC mapping, storage for struct arp_cache
+ * @confirmed: Tick of the last ARP or IP frame received from the peer
+ * @requested: Tick of the last ARP request sent for the peer
+ * @used: Tick of the last successful lookup, to find the least recently used
+ * @requests: ARP requests sent since the last confirmation
+ * @in_use: Looked up since the last confirmation, so worth refreshing
+ */
+struct arp_entry
+{
+    uint8_t              ip_addr[4];
+    uint8_t              mac_addr[6];
+    enum arp_entry_state state;
+    uint8_t              requests;
+    bool                 in_use;
+    uint32_t             confirmed;
+    uint32_t             requested;
+    uint32_t             used;
+};
+
+/**
+ * struct arp_cache - Fixed-size ARP table with aging
+ * @entries: Array of @capacity entries, owned by the cache once initialized
+ * @capacity: Number of entries
+ * @max_age: Ticks a resolved entry stays valid without being confirmed
+ * @retry_interval: Ticks between two ARP requests for the same address
+ * @max_requests: ARP requests sent before an address is given up
+ *
+ * Time is an opaque tick counter, e.g. milliseconds, given to arp_cache_age();
+ * it may wrap around. A resolved entry older than @max_age is refreshed if it
+ * was looked up since its last confirmation: lookups keep returning the known
+ * MAC while the refresh requests go out, so a steady flow never waits for ARP.
+ * An entry nobody looked up expires silently. When the table is full, the
+ * least recently used resolved entry is replaced; pending entries are kept
+ * until they resolve or are given up, so new addresses are refused while
+ * every entry is pending.
+ *
+ * Configure public fields before calling arp_cache_init().
+ */
+struct arp_cache
+{
+    /* public: user-configurable fields - set before init (const after init) */
+    struct arp_entry* const entries;
+    const uint8_t           capacity;
+    const uint32_t          max_age;
+    const uint32_t          retry_interval;
+    const uint8_t           max_requests;
+
+    /* private: internal state - do not access directly */
+    uint32_t now;
+    bool     was_initialized;
+};
+
+/* ========================================================================== */
+
+/**
+ * @brief Initialize an empty cache.
+ * @param self Pointer to the cache with public fields configured.
+ * @return 0 on success, -EFAULT if self or entries is NULL, -EINVAL if
+ * capacity, retry_interval or max_requests is 0.
+ */
+int8_t arp_cache_init(struct arp_cache* self);
+
+/**
+ * @brief Get the MAC address of a peer.
+ * @param self Pointer to the cache.
+ * @param ip_addr IPv4 address of the peer.
+ * @param mac_addr Set to the MAC address of the peer when resolved.
+ * @return 0 if resolved, -EFAULT if an argument is NULL, -EPERM if not
+ * initialized, -EINPROGRESS if a request is outstanding, -ENOENT if the
+ * address is unknown.
+ */
+int8_t arp_cache_lookup(
+    struct arp_cache* self, const uint8_t* ip_addr, uint8_t* mac_addr);
+
+/**
+ * @brief Record a mapping seen in a received frame: refresh the entry of the
+ * peer, or create one.
+ * @param self Pointer to the cache.
+ * @param ip_addr IPv4 address of the peer.
+ * @param mac_addr MAC address of the peer.
+ * @param insert Create the entry when the address is unknown, replacing the
+ * least recently used resolved one if the table is full.
+ * @return 0 on success, -EFAULT if an argument is NULL, -EPERM if not
+ * initialized, -ENOENT if the address is unknown and insert is false, -ENOSPC
+ * if it must be inserted but every entry is pending.
+ */
+int8_t arp_cache_update(
+    struct arp_cache* self,
+    const uint8_t*    ip_addr,
+    const uint8_t*    mac_addr,
+    bool              insert);
+
+/**
+ * @brief Start resolving an unknown address. The caller sends the first ARP
+ * request; arp_cache_age() asks for the next ones.
+ * @param self Pointer to the cache.
+ * @param ip_addr IPv4 address to resolve.
+ * @return 0 if a request must be sent now, -EFAULT if an argument is NULL,
+ * -EPERM if not initialized, -EALREADY if the address is known or pending,
+ * -ENOSPC if every entry is pending.
+ */
+int8_t arp_cache_resolve(struct arp_cache* self, const uint8_t* ip_addr);
+
+/**
+ * @brief Advance the clock: retry pending requests, refresh entries in use
+ * before they expire, and free the others. Call periodically, e.g. every
+ * retry_interval / 2 ticks.
+ * @param self Pointer to the cache.
+ * @param now Current tick.
+ * @param on_event Called for each request to send and each address given up.
+ * @param context First argument of on_event.
+ * @return 0 on success, -EFAULT if self or on_event is NULL, -EPERM if not
+ * initialized.
+ */
+int8_t arp_cache_age(
+    struct arp_cache* self,
+    uint32_t          now,
+    arp_cache_event_t on_event,
+    void*             context);
+
+/* ========================================================================== */
+
+#endif /* ARP_CACHE_H */
@@ -56,8 +56,9 @@ int8_t icmp_process_frame(
     struct icmp_rx_metadata* mdata);
 
 /**
- * @brief Build an ICMP frame from the provided metadata. Copies the payload,
- * computes and writes the Internet checksum.
+ * @brief Build an ICMP frame from the provided metadata: writes the header in
+ * front of the payload, which must already be at tx_frame + ICMP_HEADER_SIZE,
+ * and the Internet checksum.
  * @param self Pointer to the icmp object instance.
  * @param mdata Pointer to the tx metadata struct containing type, code, id,
  * seq_num, payload pointer and payload size.
@@ -10,6 +10,10 @@
 
 static const uint8_t IP_HEADER_SIZE = 20;
 
+/* Largest IPv4 packet on Ethernet, and the payload of a full fragment */
+static const uint16_t IP_MTU               = 1500;
+static const uint16_t IP_FRAG_PAYLOAD_SIZE = 1480;
+
 /* ========================================================================== */
 
 enum ip_pld_prot_type
@@ -27,11 +31,31 @@ enum ip_version
     IP_VER_UNKNOWN,
 };
 
+/**
+ * struct ip_discards - Packets refused by ip_process_frame(), per reason
+ * @truncated: Shorter than 20 bytes, than its header or than its total length
+ * @bad_version: Not IPv4
+ * @bad_header: Header length (IHL) below 5 words, or total length below the
+ * header length
+ * @bad_checksum: Header checksum mismatch
+ * @ttl_expired: Time to live of 0
+ */
+struct ip_discards
+{
+    uint32_t truncated;
+    uint32_t bad_version;
+    uint32_t bad_header;
+    uint32_t bad_checksum;
+    uint32_t ttl_expired;
+};
+
 struct ip
 {
-    uint8_t ip_addr[4];
+    uint8_t            ip_addr[4];
+    struct ip_discards discards;
 };
 
+/* A fragment has more_fragments set or a non-zero frag_offset, in bytes */
 struct ip_rx_metadata
 {
     enum ip_version       version;
@@ -40,8 +64,12 @@ struct ip_rx_metadata
     uint8_t               src_ip[4];
     const uint8_t*        payload;
     uint16_t              payload_size;
+    uint16_t              id;
+    uint16_t              frag_offset;
+    bool                  more_fragments;
 };
 
+/* frag_offset is in bytes and must be a multiple of 8 */
 struct ip_tx_metadata
 {
     enum ip_version       version;
@@ -50,21 +78,42 @@ struct ip_tx_metadata
     uint8_t               src_ip[4];
     const uint8_t*        payload;
     uint16_t              payload_size;
+    uint16_t              id;
+    uint16_t              frag_offset;
+    bool                  more_fragments;
+};
+
+/**
+ * struct ip_header_template - IPv4 header of a flow, see ip_template_init()
+ * @header: Header with the fields every packet of the flow shares, total
+ * length, ID and checksum left at 0
+ * @partial_sum: One's complement sum of @header, folded to 16 bits
+ */
+struct ip_header_template
+{
+    uint8_t  header[20];
+    uint16_t partial_sum;
 };
 
 /* ========================================================================== */
 
 /**
- * @brief Process an IPv4 frame.
+ * @brief Process an IPv4 frame. The header is validated in one pass before
+ * any field is used: version, header length, total length against the
+ * received size, header checksum and TTL. On success the payload lies within
+ * rx_frame; bytes past the total length (Ethernet padding) are ignored.
+ * Refused packets are counted in self->discards.
  * @param self Pointer to the ip object instance.
  * @param rx_frame Pointer to the IPv4 frame (without Ethernet header).
- * @param rx_frame_size Size of the IPv4 frame. Must be >= 20 bytes.
+ * @param rx_frame_size Size of the IPv4 frame.
  * @param mdata Pointer to the rx metadata struct, where payload info will be
  * stored.
- * @return int8_t Returns 0 in case of success, -ERRNO otherwise.
+ * @return int8_t Returns 0 in case of success, -EFAULT if a pointer is NULL,
+ * -ENOTSUP if the packet is not IPv4 (only mdata->version is set), -EINVAL if
+ * the header is malformed, truncated, has a wrong checksum or a TTL of 0.
  */
 int8_t ip_process_frame(
-    const struct ip*       self,
+    struct ip*             self,
     const uint8_t*         rx_frame,
     uint16_t               rx_frame_size,
     struct ip_rx_metadata* mdata);
@@ -80,9 +129,12 @@ int8_t ip_process_frame(
 bool ip_is_pkt_for_me(const struct ip* self, const struct ip_rx_metadata* mdata);
 
 /**
- * @brief Build an IPv4 frame from the provided metadata. Writes the IP header,
- * copies the payload, and computes the header checksum. The source IP address
- * is taken from the ip object instance.
+ * @brief Build an IPv4 frame from the provided metadata: writes the IP header
+ * and its checksum in front of the payload, which must already be at
+ * tx_frame + IP_HEADER_SIZE (see pbuf_push()). To send a datagram larger than
+ * IP_MTU, build one frame per IP_FRAG_PAYLOAD_SIZE slice of its payload, all
+ * with the same id, each with the offset of its slice and more_fragments set
+ * but on the last one.
  * @param self Pointer to the ip object instance.
  * @param mdata Pointer to the tx metadata struct containing version, protocol,
  * destination IP, payload pointer and payload size.
@@ -90,7 +142,8 @@ bool ip_is_pkt_for_me(const struct ip* self, const struct ip_rx_metadata* mdata)
  * written.
  * @param tx_frame_size Output parameter. Set to IP header size + payload_size
  * on success.
- * @return int8_t Returns 0 in case of success, -ERRNO otherwise.
+ * @return int8_t Returns 0 in case of success, -EINVAL for an unknown
+ * version or protocol, or a frag_offset off the 8-byte grid.
  */
 int8_t ip_build_frame(
     const struct ip*       self,
@@ -98,6 +151,45 @@ int8_t ip_build_frame(
     uint8_t*               tx_frame,
     uint16_t*              tx_frame_size);
 
+/**
+ * @brief Prepare the header of a flow of unfragmented packets sharing
+ * version, protocol and addresses, e.g. a stream of UDP telemetry: the shared
+ * fields are written and summed once, so that ip_template_build() only has
+ * total length and ID left to fill in.
+ * @param self Pointer to the ip object instance.
+ * @param mdata Pointer to the tx metadata struct: version, protocol, source
+ * and destination IP are used.
+ * @param tmpl Pointer to the template to fill in.
+ * @return int8_t Returns 0 in case of success, -EFAULT if a pointer is NULL,
+ * -EINVAL for an unknown version or protocol.
+ */
+int8_t ip_template_init(
+    const struct ip*             self,
+    const struct ip_tx_metadata* mdata,
+    struct ip_header_template*   tmpl);
+
+/**
+ * @brief Build an IPv4 frame from a flow template: same result as
+ * ip_build_frame() for an unfragmented packet, but the header is copied and
+ * its checksum is the template sum plus total length and ID.
+ * @param tmpl Pointer to the template, see ip_template_init().
+ * @param payload_size Size of the payload, already at
+ * tx_frame + IP_HEADER_SIZE.
+ * @param id Identification of the packet.
+ * @param tx_frame Pointer to the output buffer where the IP frame will be
+ * written.
+ * @param tx_frame_size Output parameter. Set to IP header size + payload_size
+ * on success.
+ * @return int8_t Returns 0 in case of success, -EINVAL if the packet would be
+ * larger than IP_MTU.
+ */
+int8_t ip_template_build(
+    const struct ip_header_template* tmpl,
+    uint16_t                         payload_size,
+    uint16_t                         id,
+    uint8_t*                         tx_frame,
+    uint16_t*                        tx_frame_size);
+
 /* ========================================================================== */
 
 #endif /* IP_H */
@@ -0,0 +1,129 @@
+#ifndef IP_REASM_H
+#define IP_REASM_H
+
+/* ========================================================================== */
+
+#include "ip.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ========================================================================== */
+
+/**
+ * struct ip_reasm_slot - One datagram being reassembled, storage for struct
+ * ip_reasm
+ * @data: Payload buffer of the datagram, set by ip_reasm_init()
+ * @started: Tick of the first fragment received
+ * @total_size: Payload size, known once the last fragment arrived, else 0
+ * @holes: Offset in @data of the first hole descriptor, 0xFFFF once every
+ * byte up to @total_size arrived
+ */
+struct ip_reasm_slot
+{
+    uint8_t*              data;
+    uint8_t               src_ip[4];
+    uint8_t               dest_ip[4];
+    uint16_t              id;
+    enum ip_pld_prot_type pld_prot_type;
+    bool                  in_use;
+    uint32_t              started;
+    uint16_t              total_size;
+    uint16_t              holes;
+};
+
+/**
+ * struct ip_reasm_stats - Counters of struct ip_reasm
+ * @fragments: Fragments given to ip_reasm_add()
+ * @reassembled: Datagrams completed
+ * @timed_out: Datagrams given up because a fragment never came
+ * @dropped: Fragments refused: malformed, inconsistent with the previous
+ * ones, too large for a slot, or no slot free
+ */
+struct ip_reasm_stats
+{
+    uint32_t fragments;
+    uint32_t reassembled;
+    uint32_t timed_out;
+    uint32_t dropped;
+};
+
+/**
+ * struct ip_reasm - IPv4 reassembly with bounded buffers
+ * @slots: Array of @slot_count slots, owned by the reassembly once
+ * initialized
+ * @storage: @slot_count x @slot_size bytes backing the slots
+ * @slot_count: Datagrams reassembled at the same time
+ * @slot_size: Largest datagram payload accepted, a multiple of 8
+ * @timeout: Ticks a datagram may take to complete, e.g. 15 s (RFC 1122
+ * recommends 60 s at most)
+ *
+ * Fragments of a datagram are copied into their slot at their offset. The
+ * missing ranges are tracked with the hole descriptor list of RFC 815: each
+ * hole stores its own descriptor in its first bytes, so a slot needs no
+ * memory beyond its payload buffer, and each fragment costs one pass over
+ * the holes. Time is an opaque tick counter given to ip_reasm_age(); it may
+ * wrap around.
+ *
+ * Configure public fields before calling ip_reasm_init().
+ */
+struct ip_reasm
+{
+    /* public: user-configurable fields - set before init (const after init) */
+    struct ip_reasm_slot* const slots;
+    uint8_t* const              storage;
+    const uint8_t               slot_count;
+    const uint16_t              slot_size;
+    const uint32_t              timeout;
+
+    /* private: internal state - do not access directly */
+    uint32_t              now;
+    struct ip_reasm_stats stats;
+    bool                  was_initialized;
+};
+
+/* ========================================================================== */
+
+/**
+ * @brief Free all slots and clear the counters.
+ * @param self Pointer to the reassembly with public fields configured.
+ * @return 0 on success, -EFAULT if self, slots or storage is NULL, -EINVAL if
+ * slot_count is 0 or slot_size is not a non-zero multiple of 8.
+ */
+int8_t ip_reasm_init(struct ip_reasm* self);
+
+/**
+ * @brief Add one fragment to the datagram it belongs to.
+ * @param self Pointer to the reassembly.
+ * @param mdata Metadata of the fragment, from ip_process_frame(). When the
+ * datagram completes, payload and payload_size are changed to the whole
+ * datagram, which stays valid until the next call.
+ * @return 0 when the datagram is complete, -EINPROGRESS while fragments are
+ * missing, -EFAULT if self or mdata is NULL, -EPERM if not initialized,
+ * -EINVAL if the fragment is malformed or contradicts the previous ones (the
+ * datagram is given up), -EMSGSIZE if the datagram exceeds slot_size (given
+ * up), -ENOMEM if no slot is free.
+ */
+int8_t ip_reasm_add(struct ip_reasm* self, struct ip_rx_metadata* mdata);
+
+/**
+ * @brief Give up the datagrams that did not complete within timeout.
+ * @param self Pointer to the reassembly.
+ * @param now Current tick, in the unit of timeout.
+ * @return 0 on success, -EFAULT if self is NULL, -EPERM if not initialized.
+ */
+int8_t ip_reasm_age(struct ip_reasm* self, uint32_t now);
+
+/**
+ * @brief Get the counters.
+ * @param self Pointer to the reassembly.
+ * @param stats Pointer to store the counters.
+ * @return 0 on success, -EFAULT if self or stats is NULL, -EPERM if not
+ * initialized.
+ */
+int8_t ip_reasm_get_stats(
+    const struct ip_reasm* self, struct ip_reasm_stats* stats);
+
+/* ========================================================================== */
+
+#endif /* IP_REASM_H */
@@ -0,0 +1,156 @@
+#ifndef PBUF_H
+#define PBUF_H
+
+/* ========================================================================== */
+
+#include "../../packet-pool/inc/packet_pool.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ========================================================================== */
+
+/**
+ * struct pbuf - Packet buffer with room reserved in front of its data
+ * @buffer: Storage of @capacity bytes
+ * @capacity: Size of @buffer in bytes
+ *
+ * The data is a window [offset, offset + length) into @buffer. On transmit,
+ * the application reserves the headroom of every header below it, writes its
+ * payload once with pbuf_put(), then each layer prepends its header in place
+ * with pbuf_push(). On receive, pbuf_pull() strips a header the same way.
+ * Nothing is ever copied between layers.
+ *
+ * Configure public fields before calling pbuf_reset(), or take a pbuf from a
+ * struct pbuf_pool, which sets them. They are not const so that a pool can.
+ */
+struct pbuf
+{
+    /* public: user-configurable fields - set before reset (fixed after) */
+    uint8_t* buffer;
+    uint16_t capacity;
+
+    /* private: internal state - do not access directly */
+    uint16_t offset;
+    uint16_t length;
+};
+
+/**
+ * struct pbuf_pool - Packet buffers drawn from a shared packet pool
+ * @pbufs: Array of one descriptor per block of @blocks
+ * @blocks: Packet pool backing the buffers, e.g. the one the Ethernet driver
+ * receives into. Its blocks must be large enough for a whole frame.
+ *
+ * Each pbuf is paired with one block of @blocks: allocation and release take
+ * constant time, and the usage counters of @blocks cover the buffers of both
+ * the driver and the stack.
+ *
+ * Configure public fields, and initialize @blocks, before calling
+ * pbuf_pool_init().
+ */
+struct pbuf_pool
+{
+    /* public: user-configurable fields - set before init (const after init) */
+    struct pbuf* const        pbufs;
+    struct packet_pool* const blocks;
+
+    /* private: internal state - do not access directly */
+    bool was_initialized;
+};
+
+/* ========================================================================== */
+
+/**
+ * @brief Empty a packet buffer and reserve headroom in front of its data.
+ * @param self Pointer to the packet buffer.
+ * @param headroom Bytes left free for the headers to prepend, e.g.
+ * UDP_PAYLOAD_OFST for a UDP payload.
+ * @return 0 on success, -EFAULT if self or buffer is NULL, -EINVAL if
+ * headroom exceeds capacity.
+ */
+int8_t pbuf_reset(struct pbuf* self, uint16_t headroom);
+
+/**
+ * @brief Get the start of the data.
+ * @param self Pointer to the packet buffer.
+ * @return Pointer to the first data byte, NULL if self is NULL.
+ */
+uint8_t* pbuf_data(const struct pbuf* self);
+
+/**
+ * @brief Get the size of the data.
+ * @param self Pointer to the packet buffer.
+ * @return Data size in bytes, 0 if self is NULL.
+ */
+uint16_t pbuf_length(const struct pbuf* self);
+
+/**
+ * @brief Append bytes at the end of the data.
+ * @param self Pointer to the packet buffer.
+ * @param size Number of bytes to append.
+ * @param tail Set to the appended area, to be written by the caller.
+ * @return 0 on success, -EFAULT if self or tail is NULL, -ENOSPC if the
+ * tailroom is too small.
+ */
+int8_t pbuf_put(struct pbuf* self, uint16_t size, uint8_t** tail);
+
+/**
+ * @brief Prepend a header in front of the data.
+ * @param self Pointer to the packet buffer.
+ * @param size Size of the header.
+ * @param header Set to the new start of the data, where the header goes.
+ * @return 0 on success, -EFAULT if self or header is NULL, -ENOSPC if the
+ * headroom is too small.
+ */
+int8_t pbuf_push(struct pbuf* self, uint16_t size, uint8_t** header);
+
+/**
+ * @brief Strip a header from the front of the data.
+ * @param self Pointer to the packet buffer.
+ * @param size Size of the header.
+ * @return 0 on success, -EFAULT if self is NULL, -EINVAL if the data is
+ * shorter than size.
+ */
+int8_t pbuf_pull(struct pbuf* self, uint16_t size);
+
+/* ========================================================================== */
+
+/**
+ * @brief Prepare the pool to hand out buffers.
+ * @param self Pointer to the pool with public fields configured.
+ * @return 0 on success, -EFAULT if self, pbufs or blocks is NULL.
+ */
+int8_t pbuf_pool_init(struct pbuf_pool* self);
+
+/**
+ * @brief Take a buffer from the pool, reset with the given headroom.
+ * @param self Pointer to the pool.
+ * @param headroom Bytes reserved in front of the data, see pbuf_reset().
+ * @param pbuf Set to the buffer.
+ * @return 0 on success, -EFAULT if self or pbuf is NULL, -EPERM if not
+ * initialized, -EINVAL if headroom exceeds the block size, -ENOMEM if all
+ * blocks are in use.
+ */
+int8_t pbuf_pool_alloc(
+    struct pbuf_pool* self, uint16_t headroom, struct pbuf** pbuf);
+
+/**
+ * @brief Give a buffer back to its pool.
+ * @param self Pointer to the pool.
+ * @param pbuf Buffer taken from this pool.
+ * @return 0 on success, -EFAULT if self or pbuf is NULL, -EPERM if not
+ * initialized, -EINVAL if pbuf does not belong to the pool.
+ */
+int8_t pbuf_pool_free(struct pbuf_pool* self, struct pbuf* pbuf);
+
+/**
+ * @brief Get the number of buffers available.
+ * @param self Pointer to the pool.
+ * @return Free blocks of the shared packet pool, 0 if self is NULL or not
+ * initialized.
+ */
+uint8_t pbuf_pool_available(const struct pbuf_pool* self);
+
+/* ========================================================================== */
+
+#endif /* PBUF_H */
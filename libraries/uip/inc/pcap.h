@@ -0,0 +1,145 @@
+#ifndef PCAP_H
+#define PCAP_H
+
+/* ========================================================================== */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ========================================================================== */
+
+/* File header and record header of the classic pcap format */
+static const uint8_t PCAP_FILE_HEADER_SIZE   = 24;
+static const uint8_t PCAP_RECORD_HEADER_SIZE = 16;
+
+/* ========================================================================== */
+
+/**
+ * @brief Append size bytes to the capture, e.g. fwrite() to a file or a
+ * wrapper around a UART transmit.
+ * @return 0 on success, negative errno on error.
+ */
+typedef int8_t (*pcap_write_t)(
+    void* context, const uint8_t* data, uint16_t size);
+
+/**
+ * struct pcap_writer - Capture sink writing Ethernet frames in pcap format
+ * @write: Function appending bytes to the capture
+ * @context: First argument of @write
+ * @snap_len: Frames longer than this are cut to @snap_len bytes, their
+ * original size is still recorded
+ *
+ * The file header is written by pcap_writer_init(), then each frame is one
+ * record header followed by its bytes. Timestamps come from the caller, so
+ * the writer needs no clock.
+ *
+ * Configure public fields before calling pcap_writer_init().
+ */
+struct pcap_writer
+{
+    /* public: user-configurable fields - set before init (const after init) */
+    const pcap_write_t write;
+    void* const        context;
+    const uint16_t     snap_len;
+
+    /* private: internal state - do not access directly */
+    uint32_t frames;
+    bool     was_initialized;
+};
+
+/**
+ * struct pcap_record - One frame read back from a capture
+ * @ts_sec: Timestamp, seconds
+ * @ts_usec: Timestamp, microseconds (converted from nanosecond captures)
+ * @frame: Frame bytes, pointing into the capture
+ * @size: Number of bytes captured
+ * @orig_size: Size of the frame on the wire, larger than @size if it was cut
+ */
+struct pcap_record
+{
+    uint32_t       ts_sec;
+    uint32_t       ts_usec;
+    const uint8_t* frame;
+    uint16_t       size;
+    uint32_t       orig_size;
+};
+
+/**
+ * struct pcap_reader - Walks the records of a pcap capture held in memory
+ * @data: The whole capture, file header included
+ * @size: Size of @data in bytes
+ *
+ * Captures of either byte order, with microsecond or nanosecond timestamps,
+ * are accepted, as long as their link type is Ethernet. Records are not
+ * copied: each one points into @data.
+ *
+ * Configure public fields before calling pcap_reader_init().
+ */
+struct pcap_reader
+{
+    /* public: user-configurable fields - set before init (const after init) */
+    const uint8_t* const data;
+    const uint32_t       size;
+
+    /* private: internal state - do not access directly */
+    uint32_t pos;
+    bool     swapped;
+    bool     nanoseconds;
+    bool     was_initialized;
+};
+
+/* ========================================================================== */
+
+/**
+ * @brief Initialize a capture sink and write the file header.
+ * @param self Pointer to the writer with public fields configured.
+ * @return 0 on success, -EFAULT if self or write is NULL, -EINVAL if snap_len
+ * is 0, or the error returned by write.
+ */
+int8_t pcap_writer_init(struct pcap_writer* self);
+
+/**
+ * @brief Append one frame to the capture.
+ * @param self Pointer to the writer.
+ * @param ts_sec Timestamp of the frame, seconds.
+ * @param ts_usec Timestamp of the frame, microseconds.
+ * @param frame Ethernet frame, without FCS.
+ * @param size Size of the frame in bytes.
+ * @return 0 on success, -EFAULT if self or frame is NULL, -EPERM if not
+ * initialized, or the error returned by write.
+ */
+int8_t pcap_writer_frame(
+    struct pcap_writer* self,
+    uint32_t            ts_sec,
+    uint32_t            ts_usec,
+    const uint8_t*      frame,
+    uint16_t            size);
+
+/**
+ * @brief Get the number of frames written so far.
+ * @param self Pointer to the writer.
+ * @return Number of frames, 0 if self is NULL.
+ */
+uint32_t pcap_writer_frames(const struct pcap_writer* self);
+
+/**
+ * @brief Check the file header of a capture and rewind to its first record.
+ * @param self Pointer to the reader with public fields configured.
+ * @return 0 on success, -EFAULT if self or data is NULL, -EINVAL if data is
+ * not a pcap capture, -ENOTSUP if its link type is not Ethernet.
+ */
+int8_t pcap_reader_init(struct pcap_reader* self);
+
+/**
+ * @brief Read the next record of the capture.
+ * @param self Pointer to the reader.
+ * @param record Set to the record, valid as long as data is.
+ * @return 0 on success, -EFAULT if an argument is NULL, -EPERM if not
+ * initialized, -ENOENT past the last record, -EINVAL if the record is cut
+ * short by the end of the capture or larger than 65535 bytes.
+ */
+int8_t pcap_reader_next(struct pcap_reader* self, struct pcap_record* record);
+
+/* ========================================================================== */
+
+#endif /* PCAP_H */
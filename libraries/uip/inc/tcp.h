@@ -0,0 +1,111 @@
+#ifndef TCP_H
+#define TCP_H
+
+/* ========================================================================== */
+
+#include "ip.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ========================================================================== */
+
+static const uint8_t TCP_HEADER_SIZE = 20; /* Without options */
+
+/* Largest segment payload on Ethernet, and the default of RFC 1122 */
+static const uint16_t TCP_MSS_MAX     = 1460;
+static const uint16_t TCP_MSS_DEFAULT = 536;
+
+static const uint8_t TCP_FLAG_FIN = 0x01;
+static const uint8_t TCP_FLAG_SYN = 0x02;
+static const uint8_t TCP_FLAG_RST = 0x04;
+static const uint8_t TCP_FLAG_PSH = 0x08;
+static const uint8_t TCP_FLAG_ACK = 0x10;
+
+/* ========================================================================== */
+
+struct tcp
+{
+    uint16_t lost_frames;
+};
+
+/* mss is the value of the MSS option, 0 if absent */
+struct tcp_rx_metadata
+{
+    struct ip_rx_metadata* ip_mdata;
+    uint16_t               src_port_num;
+    uint16_t               dest_port_num;
+    uint32_t               seq_num;
+    uint32_t               ack_num;
+    uint8_t                flags;
+    uint16_t               window;
+    uint16_t               mss;
+    const uint8_t*         payload;
+    uint16_t               payload_size;
+};
+
+/* A non-zero mss adds the MSS option, which is only valid with SYN */
+struct tcp_tx_metadata
+{
+    struct ip_tx_metadata* ip_mdata;
+    uint16_t               src_port_num;
+    uint16_t               dest_port_num;
+    uint32_t               seq_num;
+    uint32_t               ack_num;
+    uint8_t                flags;
+    uint16_t               window;
+    uint16_t               mss;
+    uint16_t               payload_size;
+};
+
+/* ========================================================================== */
+
+/**
+ * @brief Process a TCP segment. Verifies the checksum over the pseudo-header
+ * and the segment, and extracts header fields, the MSS option and the payload
+ * pointer.
+ * @param self Pointer to the tcp object instance.
+ * @param rx_frame Pointer to the TCP segment (without Ethernet and IP
+ * headers).
+ * @param rx_frame_size Size of the segment in bytes (IP payload size).
+ * @param mdata Pointer to the rx metadata struct, where segment info will be
+ * stored. Its ip_mdata member must already point to the IP rx metadata for
+ * this frame.
+ * @return int8_t Returns 0 in case of success, -EFAULT if a pointer is NULL,
+ * -EINVAL if the segment is truncated or its checksum is wrong.
+ */
+int8_t tcp_process_frame(
+    struct tcp*             self,
+    const uint8_t*          rx_frame,
+    uint16_t                rx_frame_size,
+    struct tcp_rx_metadata* mdata);
+
+/**
+ * @brief Build a TCP segment from the provided metadata: writes the header
+ * (and the MSS option if mss is set) in front of the payload, which must
+ * already be at tx_frame + tcp_header_size(mdata), and the checksum over the
+ * pseudo-header and the segment.
+ * @param self Pointer to the tcp object instance.
+ * @param mdata Pointer to the tx metadata struct. Its ip_mdata member must
+ * already point to the IP tx metadata for this frame.
+ * @param tx_frame Pointer to the output buffer where the segment will be
+ * written.
+ * @param tx_frame_size Output parameter. Set to the header size + payload_size
+ * on success.
+ * @return int8_t Returns 0 in case of success, -EFAULT if a pointer is NULL.
+ */
+int8_t tcp_build_frame(
+    struct tcp*             self,
+    struct tcp_tx_metadata* mdata,
+    uint8_t*                tx_frame,
+    uint16_t*               tx_frame_size);
+
+/**
+ * @brief Size of the header tcp_build_frame() writes for mdata, options
+ * included.
+ */
+uint8_t tcp_header_size(const struct tcp_tx_metadata* mdata);
+
+/* ========================================================================== */
+
+#endif /* TCP_H */
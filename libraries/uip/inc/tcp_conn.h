@@ -0,0 +1,456 @@
+#ifndef TCP_CONN_H
+#define TCP_CONN_H
+
+/* ========================================================================== */
+
+#include "eth.h"
+#include "tcp.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ========================================================================== */
+
+/* Headroom in front of each segment built in tx_frame */
+static const uint8_t TCP_CONN_HEADROOM = ETH_HEADER_SIZE + IP_HEADER_SIZE;
+
+/* ========================================================================== */
+
+enum tcp_state
+{
+    TCP_CLOSED,
+    TCP_SYN_SENT,
+    TCP_SYN_RECEIVED,
+    TCP_ESTABLISHED,
+    TCP_FIN_WAIT_1,
+    TCP_FIN_WAIT_2,
+    TCP_CLOSING,
+    TCP_TIME_WAIT,
+    TCP_CLOSE_WAIT,
+    TCP_LAST_ACK,
+};
+
+/**
+ * enum tcp_event - What a connection reports to its handler
+ * @TCP_EVENT_CONNECTED: Handshake done, data can flow
+ * @TCP_EVENT_RECEIVED: New data in the receive window
+ * @TCP_EVENT_SENT: Data acknowledged, room freed in the send window
+ * @TCP_EVENT_PEER_CLOSED: The peer sent everything (FIN). The data still in
+ * the receive window can be read, and data can still be sent.
+ * @TCP_EVENT_CLOSED: Closed on both sides. Last event, the connection must
+ * not be used any more.
+ * @TCP_EVENT_ABORTED: Reset by the peer, or the peer stopped answering. Last
+ * event, the connection must not be used any more.
+ */
+enum tcp_event
+{
+    TCP_EVENT_CONNECTED,
+    TCP_EVENT_RECEIVED,
+    TCP_EVENT_SENT,
+    TCP_EVENT_PEER_CLOSED,
+    TCP_EVENT_CLOSED,
+    TCP_EVENT_ABORTED,
+};
+
+struct tcp_conn;
+
+/**
+ * @brief Report an event of a connection. Called from uip_input() and
+ * uip_poll(); may call the uip_tcp_*() functions on the connection.
+ */
+typedef void (*tcp_handler_t)(
+    void* context, struct tcp_conn* conn, enum tcp_event event);
+
+/**
+ * @brief Send one segment: write the IPv4 and Ethernet headers in front of it
+ * and transmit the frame, e.g. through uip_output().
+ * @param ip_mdata Addresses and protocol of the segment. Its payload is the
+ * segment, at frame + TCP_CONN_HEADROOM.
+ * @param frame Start of the frame, the tx_frame of the table.
+ * @return 0 if sent or queued, negative errno if the segment is lost (it is
+ * sent again on retransmission).
+ */
+typedef int8_t (*tcp_output_t)(
+    void* context, struct ip_tx_metadata* ip_mdata, uint8_t* frame);
+
+/**
+ * @brief Return 32 random bits, e.g. from a hardware RNG. Called by
+ * tcp_table_init().
+ */
+typedef uint32_t (*tcp_random_t)(void);
+
+struct tcp_endpoint
+{
+    uint8_t  ip_addr[4];
+    uint16_t port;
+};
+
+/**
+ * struct tcp_listener - Local TCP port accepting connections, registered
+ * with tcp_table_listen()
+ * @port: Local port
+ * @handler: Called for the events of every connection accepted on @port
+ * @context: First argument of @handler
+ */
+struct tcp_listener
+{
+    /* public: user-configurable fields - set before listen (const after) */
+    const uint16_t      port;
+    const tcp_handler_t handler;
+    void* const         context;
+};
+
+/**
+ * struct tcp_conn - One connection, storage for struct tcp_table
+ * @rx_buffer: Ring holding the received data until the application consumes
+ * it. Its free space is the window advertised to the peer.
+ * @rx_size: Size of @rx_buffer, 65535 bytes at most (no window scaling)
+ * @tx_buffer: Ring holding the data to send until the peer acknowledges it
+ * @tx_size: Size of @tx_buffer
+ *
+ * Both buffers are windows the application works in directly: it writes the
+ * data to send in place (tcp_conn_tx_window(), then uip_tcp_send()) and reads
+ * the data received in place (tcp_conn_rx_window(), then uip_tcp_consume()).
+ * The payload is copied only between the buffers and the frames.
+ *
+ * Configure public fields before calling tcp_table_init().
+ */
+struct tcp_conn
+{
+    /* public: user-configurable fields - set before init (const after init) */
+    uint8_t* const rx_buffer;
+    const uint16_t rx_size;
+    uint8_t* const tx_buffer;
+    const uint16_t tx_size;
+
+    /* private: internal state - do not access directly */
+    enum tcp_state state;
+    tcp_handler_t  handler;
+    void*          context;
+    uint8_t        local_ip[4];
+    uint8_t        remote_ip[4];
+    uint16_t       local_port;
+    uint16_t       remote_port;
+    uint8_t        generation; /* Counts the connections the slot held */
+
+    /* Send: [snd_una, snd_nxt) in flight, snd_max highest ever sent */
+    uint32_t iss;
+    uint32_t snd_una;
+    uint32_t snd_nxt;
+    uint32_t snd_max;
+    uint16_t snd_wnd;
+    uint32_t snd_wl1; /* Sequence and ACK of the last window update */
+    uint32_t snd_wl2;
+    uint16_t snd_mss;
+    uint16_t tx_head; /* First byte not acknowledged */
+    uint16_t tx_used;
+    uint8_t  dup_acks;
+
+    /* Receive */
+    uint32_t rcv_nxt;
+    uint16_t rx_head; /* First byte not consumed */
+    uint16_t rx_used;
+    uint32_t rcv_adv;     /* Right edge of the window last advertised */
+    uint8_t  ack_pending; /* Segments received since the last ACK */
+    uint32_t ack_since;
+
+    /* Retransmission, RFC 6298: srtt x 8 and rttvar x 4, in ticks */
+    int32_t  srtt;
+    int32_t  rttvar;
+    uint32_t rto;
+    bool     rtt_timing;
+    uint32_t rtt_seq;
+    uint32_t rtt_since;
+    bool     rto_armed;
+    uint32_t rto_since; /* Also the start of TIME-WAIT */
+    uint8_t  retries;
+};
+
+/**
+ * struct tcp_stats - Counters of struct tcp_table
+ * @segments_received: Segments given to tcp_table_input()
+ * @segments_sent: Segments handed to the output function
+ * @retransmits: Segments sent again after a timeout or three duplicate ACKs
+ * @resets_sent: Resets sent, for segments to closed ports included
+ * @dropped: Segments not accepted: no connection, out of order, no
+ * connection free for a new peer, or outside the window
+ */
+struct tcp_stats
+{
+    uint32_t segments_received;
+    uint32_t segments_sent;
+    uint32_t retransmits;
+    uint32_t resets_sent;
+    uint32_t dropped;
+};
+
+/**
+ * struct tcp_table - Fixed table of TCP connections
+ * @conns: Array of @conn_count connections, owned by the table once
+ * initialized
+ * @conn_count: Connections open at the same time, TIME-WAIT included
+ * @listeners: Array of @listener_count pointers, owned by the table once
+ * initialized
+ * @listener_count: Ports listening at the same time
+ * @tx_frame: Buffer each segment is built in before the output function. Its
+ * size bounds the segments sent: e.g. MAX_ETH_PKT_SIZE for full segments.
+ * @tx_frame_size: Size of @tx_frame in bytes
+ * @ack_delay: Ticks an ACK may wait for data to ride on, e.g. 200 ms (RFC
+ * 1122 allows 500 ms at most)
+ * @rto_initial: Retransmission timeout before the first RTT sample, e.g. 1 s
+ * @rto_min: Lower bound of the retransmission timeout, e.g. 200 ms
+ * @rto_max: Upper bound of the retransmission timeout, e.g. 60 s
+ * @max_retries: Retransmissions of a segment before the connection is aborted
+ * @time_wait: Ticks a connection stays in TIME-WAIT, 2 x MSL, e.g. 4 s on a
+ * LAN
+ * @get_random: Source of the secret the initial sequence numbers are keyed
+ * with (RFC 6528), drawn at init. Optional: without it they follow the clock
+ * alone, and a host that cannot see the traffic may guess them.
+ *
+ * A connection advertises the free space of its rx_buffer as its window, and
+ * sends as much of its tx_buffer as the window of the peer allows, in
+ * segments of the negotiated MSS. Received data is acknowledged every second
+ * segment, or after @ack_delay, unless an answer carries the ACK first.
+ * Segments are retransmitted after three duplicate ACKs, or when the
+ * timeout, derived from the measured round-trip time, expires. Segments
+ * arriving out of order are dropped and answered with a duplicate ACK, those
+ * outside the receive window with an ACK.
+ *
+ * Time is an opaque tick counter given to tcp_table_poll(); it may wrap
+ * around. Configure public fields before calling tcp_table_init().
+ */
+struct tcp_table
+{
+    /* public: user-configurable fields - set before init (const after init) */
+    struct tcp_conn* const      conns;
+    const uint8_t               conn_count;
+    struct tcp_listener** const listeners;
+    const uint8_t               listener_count;
+    uint8_t* const              tx_frame;
+    const uint16_t              tx_frame_size;
+    const uint32_t              ack_delay;
+    const uint32_t              rto_initial;
+    const uint32_t              rto_min;
+    const uint32_t              rto_max;
+    const uint8_t               max_retries;
+    const uint32_t              time_wait;
+    const tcp_random_t          get_random;
+
+    /* private: internal state - do not access directly */
+    struct tcp       tcp;
+    uint32_t         now;
+    uint32_t         next_iss;
+    uint32_t         iss_secret;
+    uint16_t         next_port;
+    struct tcp_stats stats;
+    bool             was_initialized;
+};
+
+/* ========================================================================== */
+
+/**
+ * @brief Initialize the table: all connections closed, no port listening.
+ * @param self Pointer to the table with public fields configured.
+ * @return 0 on success, -EFAULT if self, conns, listeners, tx_frame or a
+ * connection buffer is NULL, -EINVAL if a count or buffer size is 0, if
+ * tx_frame cannot hold a header and one byte of data, or if rto_min is 0 or
+ * above rto_max.
+ */
+int8_t tcp_table_init(struct tcp_table* self);
+
+/**
+ * @brief Accept connections on a port.
+ * @param self Pointer to the table.
+ * @param listener Listener with public fields configured. Must stay valid
+ * (static) while listening.
+ * @return 0 on success, -EFAULT if self or listener is NULL, -EPERM if not
+ * initialized, -EINVAL if listener has no handler, -EADDRINUSE if the port is
+ * listening, -ENOSPC if listener_count ports are listening.
+ */
+int8_t tcp_table_listen(struct tcp_table* self, struct tcp_listener* listener);
+
+/**
+ * @brief Stop accepting connections on a port. Connections already accepted
+ * stay open.
+ * @param self Pointer to the table.
+ * @param listener Listening listener.
+ * @return 0 on success, -EFAULT if self or listener is NULL, -EPERM if not
+ * initialized, -ENOENT if the listener is not listening.
+ */
+int8_t
+tcp_table_unlisten(struct tcp_table* self, struct tcp_listener* listener);
+
+/**
+ * @brief Process a received segment for this node: run the state machine of
+ * its connection, accept a new connection on a listening port, or answer
+ * with a reset. Called by uip_input().
+ * @param self Pointer to the table.
+ * @param mdata Metadata of the segment, from tcp_process_frame().
+ * @param output Function sending the segments of the answer.
+ * @param context First argument of output.
+ * @return 0 if the segment was accepted, -EFAULT if self, mdata or output is
+ * NULL, -EPERM if not initialized, -ENOENT if no connection or listener
+ * matches (a reset is sent), -ENOSPC if no connection is free for a new
+ * peer, -EINVAL if the segment is not acceptable for its connection.
+ */
+int8_t tcp_table_input(
+    struct tcp_table*             self,
+    const struct tcp_rx_metadata* mdata,
+    tcp_output_t                  output,
+    void*                         context);
+
+/**
+ * @brief Advance the timers: delayed ACKs, retransmissions and TIME-WAIT.
+ * Call periodically, at least twice per ack_delay and rto_min.
+ * @param self Pointer to the table.
+ * @param now Current tick.
+ * @param output Function sending the segments.
+ * @param context First argument of output.
+ * @return 0 on success, -EFAULT if self or output is NULL, -EPERM if not
+ * initialized.
+ */
+int8_t tcp_table_poll(
+    struct tcp_table* self, uint32_t now, tcp_output_t output, void* context);
+
+/**
+ * @brief Open a connection: take a free connection and send a SYN from an
+ * ephemeral port.
+ * @param self Pointer to the table.
+ * @param local_ip Address of this node.
+ * @param to Address and port of the peer.
+ * @param handler Called for the events of the connection.
+ * @param handler_context First argument of handler.
+ * @param output Function sending the segments.
+ * @param context First argument of output.
+ * @param conn Set to the connection, valid until TCP_EVENT_CLOSED or
+ * TCP_EVENT_ABORTED.
+ * @return 0 if the SYN is sent (TCP_EVENT_CONNECTED follows), -EFAULT if a
+ * pointer is NULL, -EPERM if not initialized, -ENOSPC if no connection is
+ * free.
+ */
+int8_t tcp_table_connect(
+    struct tcp_table*          self,
+    const uint8_t*             local_ip,
+    const struct tcp_endpoint* to,
+    tcp_handler_t              handler,
+    void*                      handler_context,
+    tcp_output_t               output,
+    void*                      context,
+    struct tcp_conn**          conn);
+
+/**
+ * @brief Send the size bytes the application wrote at the start of the send
+ * window (tcp_conn_tx_window()). They go out as soon as the window of the
+ * peer allows.
+ * @param self Pointer to the table.
+ * @param conn Connection.
+ * @param size Bytes written, at most the size of the send window.
+ * @param output Function sending the segments.
+ * @param context First argument of output.
+ * @return 0 on success, -EFAULT if self, conn or output is NULL, -EPERM if not
+ * initialized, -ENOTCONN if the connection cannot send (not established, or
+ * closed by the application), -EINVAL if size exceeds the send window.
+ */
+int8_t tcp_table_send(
+    struct tcp_table* self,
+    struct tcp_conn*  conn,
+    uint16_t          size,
+    tcp_output_t      output,
+    void*             context);
+
+/**
+ * @brief Release the size first bytes of the receive window
+ * (tcp_conn_rx_window()). The peer is told once the window grew enough.
+ * @param self Pointer to the table.
+ * @param conn Connection.
+ * @param size Bytes read, at most the size of the receive window.
+ * @param output Function sending the window update.
+ * @param context First argument of output.
+ * @return 0 on success, -EFAULT if self, conn or output is NULL, -EPERM if not
+ * initialized, -ENOTCONN if the connection is closed, -EINVAL if size exceeds
+ * the data received.
+ */
+int8_t tcp_table_consume(
+    struct tcp_table* self,
+    struct tcp_conn*  conn,
+    uint16_t          size,
+    tcp_output_t      output,
+    void*             context);
+
+/**
+ * @brief Close the sending side: a FIN follows the data still to send. Data
+ * keeps being received until the peer closes too (TCP_EVENT_CLOSED). Before
+ * the handshake completes, the connection is reset and freed at once, and no
+ * event follows.
+ * @param self Pointer to the table.
+ * @param conn Connection.
+ * @param output Function sending the FIN.
+ * @param context First argument of output.
+ * @return 0 on success, -EFAULT if self, conn or output is NULL, -EPERM if not
+ * initialized, -ENOTCONN if the sending side is already closed.
+ */
+int8_t tcp_table_close(
+    struct tcp_table* self,
+    struct tcp_conn*  conn,
+    tcp_output_t      output,
+    void*             context);
+
+/**
+ * @brief Reset a connection and free it at once. No event follows.
+ * @param self Pointer to the table.
+ * @param conn Connection.
+ * @param output Function sending the reset.
+ * @param context First argument of output.
+ * @return 0 on success, -EFAULT if self, conn or output is NULL, -EPERM if not
+ * initialized, -ENOTCONN if the connection is closed.
+ */
+int8_t tcp_table_abort(
+    struct tcp_table* self,
+    struct tcp_conn*  conn,
+    tcp_output_t      output,
+    void*             context);
+
+/**
+ * @brief Get the counters.
+ * @param self Pointer to the table.
+ * @param stats Pointer to store the counters.
+ * @return 0 on success, -EFAULT if self or stats is NULL, -EPERM if not
+ * initialized.
+ */
+int8_t
+tcp_table_get_stats(const struct tcp_table* self, struct tcp_stats* stats);
+
+/* ========================================================================== */
+
+/**
+ * @brief Get the free space of the send buffer the application may write
+ * into, up to its end (the rest follows once that part is sent).
+ * @param self Pointer to the connection.
+ * @param data Set to the start of the free space.
+ * @param size Set to its size, 0 if the buffer is full.
+ * @return 0 on success, -EFAULT if a pointer is NULL.
+ */
+int8_t
+tcp_conn_tx_window(struct tcp_conn* self, uint8_t** data, uint16_t* size);
+
+/**
+ * @brief Get the data received and not consumed yet, up to the end of the
+ * receive buffer (the rest follows once that part is consumed).
+ * @param self Pointer to the connection.
+ * @param data Set to the start of the data.
+ * @param size Set to its size, 0 if there is no data.
+ * @return 0 on success, -EFAULT if a pointer is NULL.
+ */
+int8_t tcp_conn_rx_window(
+    const struct tcp_conn* self, const uint8_t** data, uint16_t* size);
+
+/**
+ * @brief Get the state of a connection.
+ * @param self Pointer to the connection.
+ * @return The state, TCP_CLOSED if self is NULL.
+ */
+enum tcp_state tcp_conn_get_state(const struct tcp_conn* self);
+
+/* ========================================================================== */
+
+#endif /* TCP_CONN_H */
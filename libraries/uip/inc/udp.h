@@ -41,11 +41,12 @@ struct udp_tx_metadata
 
 /**
  * @brief Process a UDP frame. Verifies the checksum over the pseudo-header
- * and the UDP frame, and extracts header fields and payload pointer.
+ * and the UDP frame (unless the sender left it zero), and extracts header
+ * fields and payload pointer.
  * @param self Pointer to the udp object instance.
  * @param rx_frame Pointer to the UDP frame (without Ethernet and IP headers).
- * @param rx_frame_size Size of the UDP frame in bytes. Must be >=
- * UDP_HEADER_SIZE.
+ * @param rx_frame_size Size of the UDP frame in bytes (IP payload size). Must
+ * be >= the UDP length field, which must be >= UDP_HEADER_SIZE.
  * @param mdata Pointer to the rx metadata struct, where payload info will be
  * stored. Its ip_mdata member must already point to the IP rx metadata for
  * this frame.
@@ -58,8 +59,9 @@ int8_t udp_process_frame(
     struct udp_rx_metadata* mdata);
 
 /**
- * @brief Build a UDP frame from the provided metadata. Copies the payload,
- * computes and writes the checksum over the pseudo-header and the UDP frame.
+ * @brief Build a UDP frame from the provided metadata: writes the header in
+ * front of the payload, which must already be at tx_frame + UDP_HEADER_SIZE
+ * (see pbuf_push()), and the checksum over the pseudo-header and the frame.
  * @param self Pointer to the udp object instance.
  * @param mdata Pointer to the tx metadata struct containing source/destination
  * ports, payload pointer and payload size. Its ip_mdata member must already
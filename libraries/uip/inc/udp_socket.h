@@ -0,0 +1,167 @@
+#ifndef UDP_SOCKET_H
+#define UDP_SOCKET_H
+
+/* ========================================================================== */
+
+#include "../../ring-buffer/inc/ring_buffer.h"
+#include "udp.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ========================================================================== */
+
+/* Each datagram queued in rx_queue: [LEN (2)][SRC IP (4)][SRC PORT (2)] */
+#define UDP_SOCKET_RECORD_HEADER_SIZE 8
+
+/* ========================================================================== */
+
+/**
+ * @brief Receive one UDP datagram. mdata, its ip_mdata and the payload point
+ * into the received frame and are only valid during the call.
+ */
+typedef void (*udp_socket_handler_t)(
+    void* context, const struct udp_rx_metadata* mdata);
+
+struct udp_endpoint
+{
+    uint8_t  ip_addr[4];
+    uint16_t port;
+};
+
+/**
+ * struct udp_socket - Local UDP port, bound with udp_table_bind()
+ * @port: Local (destination) port
+ * @handler: Optional, called for each datagram from uip_input()
+ * @context: First argument of @handler
+ * @rx_queue: Optional ring buffer (overwrite disabled) holding the datagrams
+ * until udp_socket_receive(), used when @handler is NULL
+ *
+ * With @handler, a datagram is processed while its frame is still in the
+ * receive buffer, without any copy. With @rx_queue, it is copied once so the
+ * application can read it later, e.g. when uip_input() runs in an interrupt.
+ * A datagram that does not fit in @rx_queue is dropped and counted.
+ *
+ * Configure public fields before calling udp_table_bind().
+ */
+struct udp_socket
+{
+    /* public: user-configurable fields - set before bind (const after bind) */
+    const uint16_t             port;
+    const udp_socket_handler_t handler;
+    void* const                context;
+    struct ring_buffer* const  rx_queue;
+
+    /* private: internal state - do not access directly */
+    uint32_t received;
+    uint32_t dropped;
+};
+
+/**
+ * struct udp_table - Port to socket table, open addressing with linear probing
+ * @slots: Array of @capacity pointers, owned by the table once initialized
+ * @capacity: Number of slots, a power of two. At most 3/4 of the slots are
+ * used, so lookups stay short: @capacity >= 4/3 x the number of sockets.
+ *
+ * Lookup hashes the port and probes from there, so its cost does not depend
+ * on how many ports are bound.
+ *
+ * Configure public fields before calling udp_table_init().
+ */
+struct udp_table
+{
+    /* public: user-configurable fields - set before init (const after init) */
+    struct udp_socket** const slots;
+    const uint16_t            capacity;
+
+    /* private: internal state - do not access directly */
+    uint16_t count;
+    uint8_t  shift;
+    bool     was_initialized;
+};
+
+/* ========================================================================== */
+
+/**
+ * @brief Initialize an empty table.
+ * @param self Pointer to the table with public fields configured.
+ * @return 0 on success, -EFAULT if self or slots is NULL, -EINVAL if capacity
+ * is not a power of two or is below 2.
+ */
+int8_t udp_table_init(struct udp_table* self);
+
+/**
+ * @brief Bind a socket to its port. Resets the socket counters.
+ * @param self Pointer to the table.
+ * @param socket Socket with public fields configured. Must stay valid (static)
+ * while bound.
+ * @return 0 on success, -EFAULT if self or socket is NULL, -EPERM if not
+ * initialized, -EINVAL if the socket has neither handler nor rx_queue,
+ * -EADDRINUSE if the port is bound, -ENOSPC if the table is 3/4 full.
+ */
+int8_t udp_table_bind(struct udp_table* self, struct udp_socket* socket);
+
+/**
+ * @brief Unbind a socket.
+ * @param self Pointer to the table.
+ * @param socket Bound socket.
+ * @return 0 on success, -EFAULT if self or socket is NULL, -EPERM if not
+ * initialized, -ENOENT if the socket is not bound.
+ */
+int8_t udp_table_unbind(struct udp_table* self, struct udp_socket* socket);
+
+/**
+ * @brief Find the socket bound to a port.
+ * @param self Pointer to the table.
+ * @param port Local port.
+ * @return The socket, or NULL if none is bound or the table is not
+ * initialized.
+ */
+struct udp_socket*
+udp_table_lookup(const struct udp_table* self, uint16_t port);
+
+/* ========================================================================== */
+
+/**
+ * @brief Hand a received datagram to a socket: call its handler, or queue it
+ * in its rx_queue. Called by uip_input().
+ * @param self Pointer to the socket.
+ * @param mdata Metadata of the received datagram.
+ * @return 0 on success, -EFAULT if self or mdata is NULL, -ENOSPC if the
+ * queue is full (the datagram is dropped and counted).
+ */
+int8_t udp_socket_deliver(
+    struct udp_socket* self, const struct udp_rx_metadata* mdata);
+
+/**
+ * @brief Read the oldest datagram queued in the socket rx_queue.
+ * @param self Pointer to the socket.
+ * @param buffer Destination of the payload.
+ * @param size Size of buffer.
+ * @param received Set to the number of bytes copied.
+ * @param from Optional, set to the sender address and port.
+ * @return 0 on success, -EFAULT if self, buffer or received is NULL, -ENOTSUP
+ * if the socket has no rx_queue, -ENODATA if no datagram is queued,
+ * -EMSGSIZE if the datagram was larger than size (the rest is discarded).
+ */
+int8_t udp_socket_receive(
+    struct udp_socket*   self,
+    uint8_t*             buffer,
+    uint16_t             size,
+    uint16_t*            received,
+    struct udp_endpoint* from);
+
+/**
+ * @brief Get the datagram counters of a socket.
+ * @param self Pointer to the socket.
+ * @param received Optional, set to the number of datagrams delivered.
+ * @param dropped Optional, set to the number of datagrams dropped because the
+ * rx_queue was full.
+ * @return 0 on success, -EFAULT if self is NULL.
+ */
+int8_t udp_socket_get_stats(
+    const struct udp_socket* self, uint32_t* received, uint32_t* dropped);
+
+/* ========================================================================== */
+
+#endif /* UDP_SOCKET_H */
@@ -1,15 +1,318 @@
 #ifndef UIP_H
 #define UIP_H
 
+/* ========================================================================== */
+
+#include "arp.h"
+#include "arp_cache.h"
 #include "eth.h"
 #include "icmp.h"
 #include "ip.h"
+#include "ip_reasm.h"
+#include "pbuf.h"
+#include "tcp_conn.h"
 #include "udp.h"
+#include "udp_socket.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ========================================================================== */
 
 static const uint8_t IP_FRAME_OFST     = ETH_HEADER_SIZE;
 static const uint8_t UDP_FRAME_OFST    = ETH_HEADER_SIZE + IP_HEADER_SIZE;
 static const uint8_t ICMP_FRAME_OFST   = ETH_HEADER_SIZE + IP_HEADER_SIZE;
+static const uint8_t TCP_FRAME_OFST    = ETH_HEADER_SIZE + IP_HEADER_SIZE;
 static const uint8_t UDP_PAYLOAD_OFST  = UDP_FRAME_OFST + UDP_HEADER_SIZE;
 static const uint8_t ICMP_PAYLOAD_OFST = ICMP_FRAME_OFST + ICMP_HEADER_SIZE;
 
+/* ========================================================================== */
+
+/**
+ * @brief Transmit one Ethernet frame (without FCS), e.g. a wrapper around
+ * enc28j60_transmit_packet().
+ * @return 0 on success, negative errno on error.
+ */
+typedef int8_t (*uip_send_t)(void* context, uint8_t* frame, uint16_t size);
+
+/**
+ * struct uip_stats - Frame counters of uip_input()
+ * @rx_frames: Frames given to uip_input()
+ * @arp_replies: ARP requests answered
+ * @icmp_echo_replies: ICMP echo requests answered
+ * @udp_delivered: UDP datagrams handed to a socket
+ * @tcp_segments: TCP segments accepted by tcp_table
+ * @dropped: Frames not handled: malformed, not for this node, unsupported
+ * protocol, no socket bound to the port, socket queue full, fragment refused
+ * by ip_reasm, TCP segment refused by tcp_table, or transmit error
+ * @tx_frames: Frames sent by uip_output(), directly or after ARP resolution
+ * @tx_queued: Frames uip_output() held in tx_queue until ARP resolution
+ * @tx_dropped: Frames of uip_output() lost: tx_queue full, destination not
+ * answering ARP, or transmit error
+ * @arp_requests: ARP requests sent, gratuitous ones included
+ * @ip_discards: IPv4 packets refused by header validation, per reason (also
+ * counted in @dropped)
+ */
+struct uip_stats
+{
+    uint32_t           rx_frames;
+    uint32_t           arp_replies;
+    uint32_t           icmp_echo_replies;
+    uint32_t           udp_delivered;
+    uint32_t           tcp_segments;
+    uint32_t           dropped;
+    uint32_t           tx_frames;
+    uint32_t           tx_queued;
+    uint32_t           tx_dropped;
+    uint32_t           arp_requests;
+    struct ip_discards ip_discards;
+};
+
+/**
+ * struct uip - Stack core, dispatching received frames through the layers
+ * @ip_addr: IPv4 address of this node
+ * @mac_addr: MAC address of this node
+ * @send: Transmit function used for ARP and ICMP echo replies
+ * @send_context: First argument of @send
+ * @udp_table: Sockets receiving UDP datagrams, see udp_table_bind(). NULL
+ * drops all UDP traffic.
+ * @arp_cache: Initialized ARP cache used by uip_output(). NULL disables
+ * uip_output().
+ * @tx_queue: Optional buffer holding the frames of uip_output() that wait for
+ * ARP resolution, e.g. 2 x (2 + 1514) bytes for two full frames
+ * @tx_queue_size: Size of @tx_queue in bytes
+ * @ip_reasm: Initialized reassembly for fragmented IPv4 datagrams. NULL drops
+ * all fragments.
+ * @tcp_table: Initialized TCP connections, see tcp_table_listen() and
+ * uip_tcp_connect(). Its segments go out through uip_output(), so @arp_cache
+ * is required. NULL drops all TCP traffic.
+ *
+ * uip_input() walks one received frame through Ethernet, then ARP or IPv4,
+ * then ICMP, UDP or TCP, in a single pass. Each layer only gets a pointer
+ * into the frame: nothing is copied. ARP requests and ICMP echo requests for
+ * this node are answered by rewriting the received frame in place and sending
+ * it back. UDP datagrams go to the socket bound to their destination port,
+ * and TCP segments to the state machine of their connection. The sender of
+ * every ARP or IP packet for this node is recorded in @arp_cache, so
+ * answering it needs no ARP exchange.
+ *
+ * Configure public fields before calling uip_init().
+ */
+struct uip
+{
+    /* public: user-configurable fields - set before init (const after init) */
+    const uint8_t           ip_addr[4];
+    const uint8_t           mac_addr[6];
+    const uip_send_t        send;
+    void* const             send_context;
+    struct udp_table* const udp_table;
+    struct arp_cache* const arp_cache;
+    uint8_t* const          tx_queue;
+    const uint16_t          tx_queue_size;
+    struct ip_reasm* const  ip_reasm;
+    struct tcp_table* const tcp_table;
+
+    /* private: internal state - do not access directly */
+    struct eth       eth;
+    struct arp       arp;
+    struct ip        ip;
+    struct icmp      icmp;
+    struct udp       udp;
+    struct tcp       tcp;
+    uint16_t         tx_queue_used;
+    uint16_t         ip_id;
+    struct uip_stats stats;
+    bool             was_initialized;
+};
+
+/**
+ * struct uip_udp_flow - Stream of UDP datagrams from one local port to one
+ * endpoint, e.g. telemetry, sent with uip_udp_flow_send()
+ * @src_port: Local port
+ * @to: Destination address and port
+ *
+ * The IPv4 header is prepared once by uip_udp_flow_init(): each datagram
+ * then only gets its total length, ID and checksum patched in.
+ *
+ * Configure public fields before calling uip_udp_flow_init().
+ */
+struct uip_udp_flow
+{
+    /* public: user-configurable fields - set before init (const after init) */
+    const uint16_t            src_port;
+    const struct udp_endpoint to;
+
+    /* private: internal state - do not access directly */
+    struct ip_header_template ip_template;
+    bool                      was_initialized;
+};
+
+/* ========================================================================== */
+
+/**
+ * @brief Initialize the stack core and its layers.
+ * @param self Pointer to the uip instance with public fields configured.
+ * @return 0 on success, -EFAULT if self or send is NULL.
+ */
+int8_t uip_init(struct uip* self);
+
+/**
+ * @brief Process one received Ethernet frame: answer ARP and ICMP echo
+ * requests for this node, deliver UDP datagrams to their socket and TCP
+ * segments to tcp_table.
+ * @param self Pointer to the uip instance.
+ * @param frame Received frame, as read from the MAC (at least 64 bytes, FCS
+ * included). The buffer is modified when a reply is sent from it.
+ * @param size Size of the frame in bytes.
+ * @return 0 if the frame was handled, -EFAULT if self or frame is NULL, -EPERM
+ * if not initialized, -EINVAL if malformed, -ENOENT if not addressed to this
+ * node or no socket is bound to the port, -ENOSPC if the socket queue is
+ * full, -ENOTSUP for other protocols or for a fragment without ip_reasm, the
+ * errors of ip_reasm_add() for a fragment it refuses, the errors of
+ * tcp_table_input() for a TCP segment, or the error returned by send. A
+ * fragment held for reassembly is handled. Frames not handled are
+ * counted as dropped.
+ */
+int8_t uip_input(struct uip* self, uint8_t* frame, uint16_t size);
+
+/**
+ * @brief Send an IPv4 packet to its destination on the local link, resolving
+ * its MAC address through the ARP cache.
+ * @param self Pointer to the uip instance.
+ * @param frame Ethernet frame: ETH_HEADER_SIZE bytes of headroom, filled in
+ * here, followed by the IPv4 packet. Its destination address picks the MAC.
+ * @param size Size of the frame in bytes, without FCS.
+ * @return 0 if sent, -EINPROGRESS if queued until the destination answers
+ * ARP, -EFAULT if self or frame is NULL, -EPERM if not initialized, -ENOTSUP
+ * without arp_cache, -EINVAL if size is out of range, -ENOSPC if the frame
+ * had to wait and tx_queue is full, or every ARP cache entry is already
+ * pending (it is dropped), or the error returned by send.
+ */
+int8_t uip_output(struct uip* self, uint8_t* frame, uint16_t size);
+
+/**
+ * @brief Send a UDP datagram without copying it: the UDP, IPv4 and Ethernet
+ * headers are prepended in place in front of the payload, then the frame goes
+ * through uip_output(). A datagram larger than IP_MTU is sent as fragments of
+ * IP_FRAG_PAYLOAD_SIZE bytes, each with its headers written over the end of
+ * the previous slice, which is restored after the send.
+ * @param self Pointer to the uip instance.
+ * @param packet Packet buffer holding the payload, with at least
+ * UDP_PAYLOAD_OFST bytes of headroom, e.g. from pbuf_pool_alloc(). It holds
+ * the whole frame on return (only the UDP datagram when fragmented) and can
+ * be freed or reset right away.
+ * @param src_port Local port.
+ * @param to Destination address and port.
+ * @return 0 if sent, -EINPROGRESS if queued until ARP resolution, -EFAULT if
+ * an argument is NULL, -EPERM if not initialized, -ENOSPC if the headroom is
+ * too small, or the errors of uip_output().
+ */
+int8_t uip_udp_send(
+    struct uip*                self,
+    struct pbuf*               packet,
+    uint16_t                   src_port,
+    const struct udp_endpoint* to);
+
+/**
+ * @brief Prepare a UDP flow for uip_udp_flow_send().
+ * @param self Pointer to the initialized uip instance sending the flow.
+ * @param flow Pointer to the flow with public fields configured.
+ * @return 0 on success, -EFAULT if an argument is NULL, -EPERM if self is not
+ * initialized.
+ */
+int8_t uip_udp_flow_init(struct uip* self, struct uip_udp_flow* flow);
+
+/**
+ * @brief Send a UDP datagram of a flow, as uip_udp_send() does, but with the
+ * IPv4 header taken from the flow. Datagrams larger than IP_MTU are
+ * fragmented as by uip_udp_send().
+ * @param self Pointer to the uip instance.
+ * @param flow Pointer to the initialized flow.
+ * @param packet Packet buffer holding the payload, see uip_udp_send().
+ * @return 0 if sent, -EINPROGRESS if queued until ARP resolution, -EFAULT if
+ * an argument is NULL, -EPERM if self or flow is not initialized, -ENOSPC if
+ * the headroom is too small, or the errors of uip_output().
+ */
+int8_t uip_udp_flow_send(
+    struct uip* self, struct uip_udp_flow* flow, struct pbuf* packet);
+
+/**
+ * @brief Open a TCP connection to a peer, see tcp_table_connect().
+ * @param self Pointer to the uip instance.
+ * @param to Address and port of the peer.
+ * @param handler Called for the events of the connection.
+ * @param context First argument of handler.
+ * @param conn Set to the connection.
+ * @return 0 if the SYN is sent, -EFAULT if an argument is NULL, -EPERM if not
+ * initialized, -ENOTSUP without tcp_table, or the errors of
+ * tcp_table_connect().
+ */
+int8_t uip_tcp_connect(
+    struct uip*                self,
+    const struct tcp_endpoint* to,
+    tcp_handler_t              handler,
+    void*                      context,
+    struct tcp_conn**          conn);
+
+/**
+ * @brief Send the size bytes written at the start of the send window of a
+ * connection, see tcp_table_send().
+ * @return 0 on success, -EFAULT if self is NULL, -EPERM if not initialized,
+ * -ENOTSUP without tcp_table, or the errors of tcp_table_send().
+ */
+int8_t uip_tcp_send(struct uip* self, struct tcp_conn* conn, uint16_t size);
+
+/**
+ * @brief Release the size first bytes of the receive window of a connection,
+ * see tcp_table_consume().
+ * @return 0 on success, -EFAULT if self is NULL, -EPERM if not initialized,
+ * -ENOTSUP without tcp_table, or the errors of tcp_table_consume().
+ */
+int8_t uip_tcp_consume(struct uip* self, struct tcp_conn* conn, uint16_t size);
+
+/**
+ * @brief Close the sending side of a connection, see tcp_table_close().
+ * @return 0 on success, -EFAULT if self is NULL, -EPERM if not initialized,
+ * -ENOTSUP without tcp_table, or the errors of tcp_table_close().
+ */
+int8_t uip_tcp_close(struct uip* self, struct tcp_conn* conn);
+
+/**
+ * @brief Reset a connection, see tcp_table_abort().
+ * @return 0 on success, -EFAULT if self is NULL, -EPERM if not initialized,
+ * -ENOTSUP without tcp_table, or the errors of tcp_table_abort().
+ */
+int8_t uip_tcp_abort(struct uip* self, struct tcp_conn* conn);
+
+/**
+ * @brief Advance the stack timers: ARP retries, refreshes and expiry, the
+ * reassembly timeout and the TCP timers. Call periodically, at least twice
+ * per arp_cache retry_interval and tcp_table ack_delay.
+ * @param self Pointer to the uip instance.
+ * @param now Current tick, in the unit of the arp_cache, ip_reasm and
+ * tcp_table settings.
+ * @return 0 on success, -EFAULT if self is NULL, -EPERM if not initialized.
+ */
+int8_t uip_poll(struct uip* self, uint32_t now);
+
+/**
+ * @brief Broadcast a gratuitous ARP for the own address, so that peers update
+ * their caches, e.g. once the link is up after boot.
+ * @param self Pointer to the uip instance.
+ * @return 0 on success, -EFAULT if self is NULL, -EPERM if not initialized,
+ * or the error returned by send.
+ */
+int8_t uip_announce(struct uip* self);
+
+/**
+ * @brief Get the frame counters.
+ * @param self Pointer to the uip instance.
+ * @param stats Pointer to store the counters.
+ * @return 0 on success, -EFAULT if self or stats is NULL, -EPERM if not
+ * initialized.
+ */
+int8_t uip_get_stats(const struct uip* self, struct uip_stats* stats);
+
+/* ========================================================================== */
+
 #endif /* UIP_H */
@@ -0,0 +1,249 @@
+#include "../inc/arp_cache.h"
+
+/* ========================================================================== */
+
+#include "../../inc/errno.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/* ========================================================================== */
+
+/* PRIVATE */
+
+/* ========================================================================== */
+
+/**
+ * @brief Ticks elapsed from since to now, correct across a counter wrap.
+ */
+static uint32_t _elapsed(uint32_t now, uint32_t since)
+{
+    return now - since;
+}
+
+static struct arp_entry* _find(struct arp_cache* self, const uint8_t* ip_addr)
+{
+    for (uint8_t i = 0; i < self->capacity; i++)
+    {
+        struct arp_entry* entry = &self->entries[i];
+        if (entry->state != ARP_ENTRY_FREE
+            && !memcmp(entry->ip_addr, ip_addr, 4))
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Take a free entry, or the least recently used resolved one. Pending
+ * entries are never replaced: frames are waiting on them.
+ * @return The entry, NULL if every entry is pending.
+ */
+static struct arp_entry* _take(struct arp_cache* self, const uint8_t* ip_addr)
+{
+    struct arp_entry* victim = NULL;
+    for (uint8_t i = 0; i < self->capacity; i++)
+    {
+        struct arp_entry* entry = &self->entries[i];
+        if (entry->state == ARP_ENTRY_FREE)
+        {
+            victim = entry;
+            break;
+        }
+        if (victim == NULL
+            || (victim->state == ARP_ENTRY_PENDING
+                && entry->state == ARP_ENTRY_RESOLVED)
+            || (victim->state == entry->state
+                && _elapsed(self->now, entry->used)
+                       > _elapsed(self->now, victim->used)))
+        {
+            victim = entry;
+        }
+    }
+    if (victim->state == ARP_ENTRY_PENDING)
+    {
+        return NULL;
+    }
+    memset(victim, 0, sizeof(*victim));
+    memcpy(victim->ip_addr, ip_addr, 4);
+    victim->used = self->now;
+    return victim;
+}
+
+/* ========================================================================== */
+
+/* PUBLIC */
+
+/* ========================================================================== */
+
+int8_t arp_cache_init(struct arp_cache* self)
+{
+    if (self == NULL || self->entries == NULL)
+    {
+        return -EFAULT;
+    }
+    if (self->capacity == 0 || self->retry_interval == 0
+        || self->max_requests == 0)
+    {
+        return -EINVAL;
+    }
+
+    memset(self->entries, 0, self->capacity * sizeof(self->entries[0]));
+    self->now             = 0;
+    self->was_initialized = true;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t arp_cache_lookup(
+    struct arp_cache* self, const uint8_t* ip_addr, uint8_t* mac_addr)
+{
+    if (self == NULL || ip_addr == NULL || mac_addr == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+
+    struct arp_entry* entry = _find(self, ip_addr);
+    if (entry == NULL)
+    {
+        return -ENOENT;
+    }
+    if (entry->state == ARP_ENTRY_PENDING)
+    {
+        return -EINPROGRESS;
+    }
+    memcpy(mac_addr, entry->mac_addr, 6);
+    entry->used   = self->now;
+    entry->in_use = true;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t arp_cache_update(
+    struct arp_cache* self,
+    const uint8_t*    ip_addr,
+    const uint8_t*    mac_addr,
+    bool              insert)
+{
+    if (self == NULL || ip_addr == NULL || mac_addr == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+
+    struct arp_entry* entry = _find(self, ip_addr);
+    if (entry == NULL)
+    {
+        if (!insert)
+        {
+            return -ENOENT;
+        }
+        entry = _take(self, ip_addr);
+        if (entry == NULL)
+        {
+            return -ENOSPC;
+        }
+    }
+    memcpy(entry->mac_addr, mac_addr, 6);
+    entry->state     = ARP_ENTRY_RESOLVED;
+    entry->requests  = 0;
+    entry->in_use    = false;
+    entry->confirmed = self->now;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t arp_cache_resolve(struct arp_cache* self, const uint8_t* ip_addr)
+{
+    if (self == NULL || ip_addr == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    if (_find(self, ip_addr) != NULL)
+    {
+        return -EALREADY;
+    }
+
+    struct arp_entry* entry = _take(self, ip_addr);
+    if (entry == NULL)
+    {
+        return -ENOSPC;
+    }
+    entry->state     = ARP_ENTRY_PENDING;
+    entry->requests  = 1;
+    entry->requested = self->now;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t arp_cache_age(
+    struct arp_cache* self,
+    uint32_t          now,
+    arp_cache_event_t on_event,
+    void*             context)
+{
+    if (self == NULL || on_event == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    self->now = now;
+
+    for (uint8_t i = 0; i < self->capacity; i++)
+    {
+        struct arp_entry* entry = &self->entries[i];
+        if (entry->state == ARP_ENTRY_FREE)
+        {
+            continue;
+        }
+        if (entry->state == ARP_ENTRY_RESOLVED)
+        {
+            if (_elapsed(now, entry->confirmed) < self->max_age)
+            {
+                continue;
+            }
+            // Nobody needs it: let it go rather than keep asking
+            if (!entry->in_use)
+            {
+                entry->state = ARP_ENTRY_FREE;
+                continue;
+            }
+        }
+        if (entry->requests > 0
+            && _elapsed(now, entry->requested) < self->retry_interval)
+        {
+            continue;
+        }
+        if (entry->requests >= self->max_requests)
+        {
+            entry->state = ARP_ENTRY_FREE;
+            on_event(context, ARP_CACHE_UNREACHABLE, entry->ip_addr);
+            continue;
+        }
+        entry->requests += 1;
+        entry->requested = now;
+        on_event(context, ARP_CACHE_SEND_REQUEST, entry->ip_addr);
+    }
+    return 0;
+}
+
+/* ========================================================================== */
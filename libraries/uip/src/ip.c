@@ -29,6 +29,10 @@ static const uint8_t IP_MIN_HEADER_SIZE = 20; /* IHL = 5, no options */
 static const uint8_t IP_VERSION_MASK = 0xF0;
 static const uint8_t IP_IHL_MASK     = 0x0F;
 
+/* Within the 16-bit flags + fragment offset field, offset in 8-byte units */
+static const uint16_t IP_FLAG_MF        = 0x2000;
+static const uint16_t IP_FRAG_OFST_MASK = 0x1FFF;
+
 /* Used as switch/case labels below: must stay object-like macros, a const
  * variable is not a compile-time constant expression in C. */
 #define IP_VER_4_VAL         (uint8_t)4
@@ -42,8 +46,36 @@ static const uint8_t IP_IHL_NO_OPTS_VAL = 5;
 
 /* ========================================================================== */
 
+/**
+ * @brief One's complement sum of the header words, folded to 16 bits: 0xFFFF
+ * when the checksum is right. The 20 bytes every header has are summed
+ * unrolled, the options, if any, in a loop.
+ */
+static uint16_t sum_header(const uint8_t* header, uint8_t header_size)
+{
+    uint32_t acc = ((uint32_t)header[0] << 8 | header[1])
+                   + ((uint32_t)header[2] << 8 | header[3])
+                   + ((uint32_t)header[4] << 8 | header[5])
+                   + ((uint32_t)header[6] << 8 | header[7])
+                   + ((uint32_t)header[8] << 8 | header[9])
+                   + ((uint32_t)header[10] << 8 | header[11])
+                   + ((uint32_t)header[12] << 8 | header[13])
+                   + ((uint32_t)header[14] << 8 | header[15])
+                   + ((uint32_t)header[16] << 8 | header[17])
+                   + ((uint32_t)header[18] << 8 | header[19]);
+    for (uint8_t i = IP_MIN_HEADER_SIZE; i < header_size; i += 2)
+    {
+        acc += (uint32_t)header[i] << 8 | header[i + 1];
+    }
+    acc = (acc & 0xFFFF) + (acc >> 16);
+    acc = (acc & 0xFFFF) + (acc >> 16);
+    return (uint16_t)acc;
+}
+
+/* ========================================================================== */
+
 int8_t ip_process_frame(
-    const struct ip*       self,
+    struct ip*             self,
     const uint8_t*         rx_frame,
     uint16_t               rx_frame_size,
     struct ip_rx_metadata* mdata)
@@ -55,6 +87,7 @@ int8_t ip_process_frame(
 
     if (rx_frame_size < IP_MIN_HEADER_SIZE)
     {
+        self->discards.truncated += 1;
         return -EINVAL;
     }
 
@@ -70,15 +103,44 @@ int8_t ip_process_frame(
         case IP_VER_6_VAL:
         {
             mdata->version = IP_VER_6;
-            break;
+            self->discards.bad_version += 1;
+            return -ENOTSUP;
         }
         default:
         {
             mdata->version = IP_VER_UNKNOWN;
-            break;
+            self->discards.bad_version += 1;
+            return -ENOTSUP;
         }
     }
 
+    // Every length is checked before it is used: the payload must lie within
+    // the received bytes
+    uint8_t header_size
+        = (uint8_t)(4 * (rx_frame[IP_VERSION_IHL_FRAME_OFST] & IP_IHL_MASK));
+    uint16_t tot_len = ((uint16_t)rx_frame[IP_TOTAL_LEN_FRAME_OFST] << 8)
+                       | (uint16_t)rx_frame[IP_TOTAL_LEN_FRAME_OFST + 1];
+    if (header_size < IP_MIN_HEADER_SIZE || tot_len < header_size)
+    {
+        self->discards.bad_header += 1;
+        return -EINVAL;
+    }
+    if (tot_len > rx_frame_size)
+    {
+        self->discards.truncated += 1;
+        return -EINVAL;
+    }
+    if (sum_header(rx_frame, header_size) != 0xFFFF)
+    {
+        self->discards.bad_checksum += 1;
+        return -EINVAL;
+    }
+    if (rx_frame[IP_TTL_FRAME_OFST] == 0)
+    {
+        self->discards.ttl_expired += 1;
+        return -EINVAL;
+    }
+
     uint8_t prot = rx_frame[IP_PROT_FRAME_OFST];
     switch (prot)
     {
@@ -104,12 +166,16 @@ int8_t ip_process_frame(
         }
     }
 
-    uint8_t ihl    = rx_frame[IP_VERSION_IHL_FRAME_OFST] & IP_IHL_MASK;
-    mdata->payload = rx_frame + ihl * 4;
+    mdata->payload      = rx_frame + header_size;
+    mdata->payload_size = tot_len - header_size;
 
-    uint16_t tot_len = ((uint16_t)rx_frame[IP_TOTAL_LEN_FRAME_OFST] << 8)
-                       | (uint16_t)rx_frame[IP_TOTAL_LEN_FRAME_OFST + 1];
-    mdata->payload_size = tot_len - 4 * ihl;
+    mdata->id = (uint16_t)((rx_frame[IP_ID_FRAME_OFST] << 8)
+                           | rx_frame[IP_ID_FRAME_OFST + 1]);
+    uint16_t flags_frag
+        = (uint16_t)((rx_frame[IP_FLAGS_FRAG_FRAME_OFST] << 8)
+                     | rx_frame[IP_FLAGS_FRAG_FRAME_OFST + 1]);
+    mdata->more_fragments = (flags_frag & IP_FLAG_MF) != 0;
+    mdata->frag_offset    = (uint16_t)((flags_frag & IP_FRAG_OFST_MASK) * 8);
 
     memcpy(mdata->src_ip, rx_frame + IP_SRC_IP_FRAME_OFST, 4);
     memcpy(mdata->dest_ip, rx_frame + IP_DEST_IP_FRAME_OFST, 4);
@@ -164,10 +230,20 @@ int8_t ip_build_frame(
     tx_frame[IP_TOTAL_LEN_FRAME_OFST + 1] = (uint8_t)(tot_len);
     *tx_frame_size                        = tot_len;
 
-    tx_frame[IP_ID_FRAME_OFST]             = 0;
-    tx_frame[IP_ID_FRAME_OFST + 1]         = 0;
-    tx_frame[IP_FLAGS_FRAG_FRAME_OFST]     = 0;
-    tx_frame[IP_FLAGS_FRAG_FRAME_OFST + 1] = 0;
+    if (mdata->frag_offset % 8 != 0)
+    {
+        return -EINVAL;
+    }
+    uint16_t flags_frag = (uint16_t)(mdata->frag_offset / 8);
+    if (mdata->more_fragments)
+    {
+        flags_frag |= IP_FLAG_MF;
+    }
+
+    tx_frame[IP_ID_FRAME_OFST]             = (uint8_t)(mdata->id >> 8);
+    tx_frame[IP_ID_FRAME_OFST + 1]         = (uint8_t)(mdata->id);
+    tx_frame[IP_FLAGS_FRAG_FRAME_OFST]     = (uint8_t)(flags_frag >> 8);
+    tx_frame[IP_FLAGS_FRAG_FRAME_OFST + 1] = (uint8_t)(flags_frag);
     tx_frame[IP_TTL_FRAME_OFST]            = 64;
 
     switch (mdata->pld_prot_type)
@@ -207,3 +283,68 @@ int8_t ip_build_frame(
 
     return 0;
 }
+
+/* ========================================================================== */
+
+int8_t ip_template_init(
+    const struct ip*             self,
+    const struct ip_tx_metadata* mdata,
+    struct ip_header_template*   tmpl)
+{
+    if (self == NULL || mdata == NULL || tmpl == NULL)
+    {
+        return -EFAULT;
+    }
+
+    // Build the header of an empty, unfragmented packet, then clear what
+    // changes from packet to packet
+    struct ip_tx_metadata shared = {
+        .version       = mdata->version,
+        .pld_prot_type = mdata->pld_prot_type,
+    };
+    memcpy(shared.src_ip, mdata->src_ip, 4);
+    memcpy(shared.dest_ip, mdata->dest_ip, 4);
+    uint16_t size   = 0;
+    int8_t   status = ip_build_frame(self, &shared, tmpl->header, &size);
+    if (status != 0)
+    {
+        return status;
+    }
+    memset(tmpl->header + IP_TOTAL_LEN_FRAME_OFST, 0, 4);
+    memset(tmpl->header + IP_CHECKSUM_FRAME_OFST, 0, 2);
+    tmpl->partial_sum = sum_header(tmpl->header, IP_MIN_HEADER_SIZE);
+
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t ip_template_build(
+    const struct ip_header_template* tmpl,
+    uint16_t                         payload_size,
+    uint16_t                         id,
+    uint8_t*                         tx_frame,
+    uint16_t*                        tx_frame_size)
+{
+    if (payload_size > IP_MTU - IP_MIN_HEADER_SIZE)
+    {
+        return -EINVAL;
+    }
+
+    uint16_t tot_len = IP_MIN_HEADER_SIZE + payload_size;
+    memcpy(tx_frame, tmpl->header, IP_MIN_HEADER_SIZE);
+    tx_frame[IP_TOTAL_LEN_FRAME_OFST]     = (uint8_t)(tot_len >> 8);
+    tx_frame[IP_TOTAL_LEN_FRAME_OFST + 1] = (uint8_t)(tot_len);
+    tx_frame[IP_ID_FRAME_OFST]            = (uint8_t)(id >> 8);
+    tx_frame[IP_ID_FRAME_OFST + 1]        = (uint8_t)(id);
+    *tx_frame_size                        = tot_len;
+
+    // The fields left at 0 in the template add to its sum
+    uint32_t acc = (uint32_t)tmpl->partial_sum + tot_len + id;
+    acc          = (acc & 0xFFFF) + (acc >> 16);
+    acc          = (acc & 0xFFFF) + (acc >> 16);
+    tx_frame[IP_CHECKSUM_FRAME_OFST]     = (uint8_t)(~acc >> 8);
+    tx_frame[IP_CHECKSUM_FRAME_OFST + 1] = (uint8_t)(~acc);
+
+    return 0;
+}
@@ -0,0 +1,278 @@
+#include "../inc/ip_reasm.h"
+
+/* ========================================================================== */
+
+#include "../../inc/errno.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/* ========================================================================== */
+
+/* PRIVATE */
+
+/* ========================================================================== */
+
+/* Each hole starts with its descriptor: [END (2)][NEXT (2)], END exclusive */
+static const uint16_t NO_HOLE     = 0xFFFF;
+static const uint16_t END_UNKNOWN = 0xFFFF; /* Until the last fragment */
+static const uint16_t HOLE_ALIGN  = 8;      /* Fragment offset unit */
+
+static uint32_t _elapsed(uint32_t now, uint32_t since)
+{
+    return now - since;
+}
+
+static void _read_hole(
+    const struct ip_reasm_slot* slot,
+    uint16_t                    hole,
+    uint16_t*                   end,
+    uint16_t*                   next)
+{
+    memcpy(end, slot->data + hole, 2);
+    memcpy(next, slot->data + hole + 2, 2);
+}
+
+static void _write_hole(
+    struct ip_reasm_slot* slot, uint16_t hole, uint16_t end, uint16_t next)
+{
+    memcpy(slot->data + hole, &end, 2);
+    memcpy(slot->data + hole + 2, &next, 2);
+}
+
+/**
+ * @brief Point prev (or the list head if prev is NO_HOLE) at hole.
+ */
+static void _link(struct ip_reasm_slot* slot, uint16_t prev, uint16_t hole)
+{
+    if (prev == NO_HOLE)
+    {
+        slot->holes = hole;
+    }
+    else
+    {
+        memcpy(slot->data + prev + 2, &hole, 2);
+    }
+}
+
+static struct ip_reasm_slot* _find(
+    struct ip_reasm* self, const struct ip_rx_metadata* mdata)
+{
+    for (uint8_t i = 0; i < self->slot_count; i++)
+    {
+        struct ip_reasm_slot* slot = &self->slots[i];
+        if (slot->in_use && slot->id == mdata->id
+            && slot->pld_prot_type == mdata->pld_prot_type
+            && !memcmp(slot->src_ip, mdata->src_ip, 4)
+            && !memcmp(slot->dest_ip, mdata->dest_ip, 4))
+        {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+static struct ip_reasm_slot* _take(
+    struct ip_reasm* self, const struct ip_rx_metadata* mdata)
+{
+    for (uint8_t i = 0; i < self->slot_count; i++)
+    {
+        struct ip_reasm_slot* slot = &self->slots[i];
+        if (!slot->in_use)
+        {
+            memcpy(slot->src_ip, mdata->src_ip, 4);
+            memcpy(slot->dest_ip, mdata->dest_ip, 4);
+            slot->id            = mdata->id;
+            slot->pld_prot_type = mdata->pld_prot_type;
+            slot->in_use        = true;
+            slot->started       = self->now;
+            slot->total_size    = 0;
+            slot->holes         = 0;
+            _write_hole(slot, 0, END_UNKNOWN, NO_HOLE);
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+static int8_t _give_up(
+    struct ip_reasm* self, struct ip_reasm_slot* slot, int8_t status)
+{
+    if (slot != NULL)
+    {
+        slot->in_use = false;
+    }
+    self->stats.dropped += 1;
+    return status;
+}
+
+/* ========================================================================== */
+
+/* PUBLIC */
+
+/* ========================================================================== */
+
+int8_t ip_reasm_init(struct ip_reasm* self)
+{
+    if (self == NULL || self->slots == NULL || self->storage == NULL)
+    {
+        return -EFAULT;
+    }
+    if (self->slot_count == 0 || self->slot_size == 0
+        || self->slot_size % HOLE_ALIGN != 0)
+    {
+        return -EINVAL;
+    }
+
+    for (uint8_t i = 0; i < self->slot_count; i++)
+    {
+        self->slots[i].data   = self->storage + (size_t)i * self->slot_size;
+        self->slots[i].in_use = false;
+    }
+    self->now             = 0;
+    self->stats           = (struct ip_reasm_stats){0};
+    self->was_initialized = true;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t ip_reasm_add(struct ip_reasm* self, struct ip_rx_metadata* mdata)
+{
+    if (self == NULL || mdata == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    if (!mdata->more_fragments && mdata->frag_offset == 0)
+    {
+        return 0; /* Not a fragment */
+    }
+    self->stats.fragments += 1;
+
+    uint32_t first = mdata->frag_offset;
+    uint32_t end   = first + mdata->payload_size;
+    bool     more  = mdata->more_fragments;
+    // Only the last fragment may end off the 8-byte grid, so every hole is
+    // large enough for its descriptor
+    if (mdata->payload_size == 0 || (more && mdata->payload_size % HOLE_ALIGN))
+    {
+        return _give_up(self, _find(self, mdata), -EINVAL);
+    }
+
+    struct ip_reasm_slot* slot = _find(self, mdata);
+    // More data follows a fragment ending at slot_size: too large
+    if (end > self->slot_size || (more && end == self->slot_size))
+    {
+        return _give_up(self, slot, -EMSGSIZE);
+    }
+    if (slot == NULL)
+    {
+        slot = _take(self, mdata);
+        if (slot == NULL)
+        {
+            return _give_up(self, NULL, -ENOMEM);
+        }
+    }
+    if (slot->total_size != 0
+        && (end > slot->total_size || (!more && end != slot->total_size)))
+    {
+        return _give_up(self, slot, -EINVAL);
+    }
+    if (!more)
+    {
+        slot->total_size = (uint16_t)end;
+    }
+
+    // RFC 815: every hole the fragment overlaps is replaced by what is left
+    // of it on either side. The new descriptors lie outside the fragment, so
+    // its data is copied once the list is updated.
+    uint16_t prev = NO_HOLE;
+    uint16_t hole = slot->holes;
+    while (hole != NO_HOLE)
+    {
+        uint16_t hole_end = 0;
+        uint16_t next     = NO_HOLE;
+        _read_hole(slot, hole, &hole_end, &next);
+        if (first >= hole_end || end <= hole)
+        {
+            prev = hole;
+            hole = next;
+            continue;
+        }
+
+        _link(slot, prev, next);
+        if (first > hole)
+        {
+            _write_hole(slot, hole, (uint16_t)first, next);
+            _link(slot, prev, hole);
+            prev = hole;
+        }
+        if (end < hole_end && more)
+        {
+            _write_hole(slot, (uint16_t)end, hole_end, next);
+            _link(slot, prev, (uint16_t)end);
+            prev = (uint16_t)end;
+        }
+        hole = next;
+    }
+    memcpy(slot->data + first, mdata->payload, mdata->payload_size);
+
+    if (slot->total_size == 0 || slot->holes != NO_HOLE)
+    {
+        return -EINPROGRESS;
+    }
+    slot->in_use        = false;
+    mdata->payload      = slot->data;
+    mdata->payload_size = slot->total_size;
+    self->stats.reassembled += 1;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t ip_reasm_age(struct ip_reasm* self, uint32_t now)
+{
+    if (self == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    self->now = now;
+
+    for (uint8_t i = 0; i < self->slot_count; i++)
+    {
+        struct ip_reasm_slot* slot = &self->slots[i];
+        if (slot->in_use && _elapsed(now, slot->started) >= self->timeout)
+        {
+            slot->in_use = false;
+            self->stats.timed_out += 1;
+        }
+    }
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t ip_reasm_get_stats(
+    const struct ip_reasm* self, struct ip_reasm_stats* stats)
+{
+    if (self == NULL || stats == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    *stats = self->stats;
+    return 0;
+}
+
+/* ========================================================================== */
@@ -0,0 +1,169 @@
+#include "../inc/pbuf.h"
+
+/* ========================================================================== */
+
+#include "../../inc/errno.h"
+
+#include <stddef.h>
+
+/* ========================================================================== */
+
+int8_t pbuf_reset(struct pbuf* self, uint16_t headroom)
+{
+    if (self == NULL || self->buffer == NULL)
+    {
+        return -EFAULT;
+    }
+    if (headroom > self->capacity)
+    {
+        return -EINVAL;
+    }
+    self->offset = headroom;
+    self->length = 0;
+    return 0;
+}
+
+/* ========================================================================== */
+
+uint8_t* pbuf_data(const struct pbuf* self)
+{
+    return (self == NULL) ? NULL : self->buffer + self->offset;
+}
+
+/* ========================================================================== */
+
+uint16_t pbuf_length(const struct pbuf* self)
+{
+    return (self == NULL) ? 0 : self->length;
+}
+
+/* ========================================================================== */
+
+int8_t pbuf_put(struct pbuf* self, uint16_t size, uint8_t** tail)
+{
+    if (self == NULL || tail == NULL)
+    {
+        return -EFAULT;
+    }
+    if (size > self->capacity - self->offset - self->length)
+    {
+        return -ENOSPC;
+    }
+    *tail = self->buffer + self->offset + self->length;
+    self->length += size;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t pbuf_push(struct pbuf* self, uint16_t size, uint8_t** header)
+{
+    if (self == NULL || header == NULL)
+    {
+        return -EFAULT;
+    }
+    if (size > self->offset)
+    {
+        return -ENOSPC;
+    }
+    self->offset -= size;
+    self->length += size;
+    *header = self->buffer + self->offset;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t pbuf_pull(struct pbuf* self, uint16_t size)
+{
+    if (self == NULL)
+    {
+        return -EFAULT;
+    }
+    if (size > self->length)
+    {
+        return -EINVAL;
+    }
+    self->offset += size;
+    self->length -= size;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t pbuf_pool_init(struct pbuf_pool* self)
+{
+    if (self == NULL || self->pbufs == NULL || self->blocks == NULL)
+    {
+        return -EFAULT;
+    }
+    self->was_initialized = true;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t pbuf_pool_alloc(
+    struct pbuf_pool* self, uint16_t headroom, struct pbuf** pbuf)
+{
+    if (self == NULL || pbuf == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    if (headroom > self->blocks->block_size)
+    {
+        return -EINVAL;
+    }
+
+    struct packet_block* block  = NULL;
+    int8_t               status = packet_pool_alloc(self->blocks, &block);
+    if (status != 0)
+    {
+        return status;
+    }
+
+    // The descriptor of a block is at the same index as the block
+    *pbuf             = &self->pbufs[block - self->blocks->blocks];
+    (*pbuf)->buffer   = block->data;
+    (*pbuf)->capacity = self->blocks->block_size;
+    return pbuf_reset(*pbuf, headroom);
+}
+
+/* ========================================================================== */
+
+int8_t pbuf_pool_free(struct pbuf_pool* self, struct pbuf* pbuf)
+{
+    if (self == NULL || pbuf == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    if (pbuf < self->pbufs || pbuf >= self->pbufs + self->blocks->block_count)
+    {
+        return -EINVAL;
+    }
+
+    struct packet_block* block = &self->blocks->blocks[pbuf - self->pbufs];
+    block->next                = NULL;
+    return packet_pool_free(self->blocks, block);
+}
+
+/* ========================================================================== */
+
+uint8_t pbuf_pool_available(const struct pbuf_pool* self)
+{
+    if (self == NULL || !self->was_initialized)
+    {
+        return 0;
+    }
+    return packet_pool_available(self->blocks);
+}
+
+/* ========================================================================== */
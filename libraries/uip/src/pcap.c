@@ -0,0 +1,223 @@
+#include "../inc/pcap.h"
+
+/* ========================================================================== */
+
+#include "../../inc/errno.h"
+
+#include <stddef.h>
+
+/* ========================================================================== */
+
+/* PRIVATE */
+
+/* ========================================================================== */
+
+/* Magic numbers as read little-endian: the byte order of the writer and the
+ * timestamp resolution follow from which one matches */
+static const uint32_t PCAP_MAGIC_USEC         = 0xA1B2C3D4;
+static const uint32_t PCAP_MAGIC_USEC_SWAPPED = 0xD4C3B2A1;
+static const uint32_t PCAP_MAGIC_NSEC         = 0xA1B23C4D;
+static const uint32_t PCAP_MAGIC_NSEC_SWAPPED = 0x4D3CB2A1;
+
+static const uint16_t PCAP_VERSION_MAJOR  = 2;
+static const uint16_t PCAP_VERSION_MINOR  = 4;
+static const uint32_t PCAP_LINKTYPE_ETH   = 1;
+static const uint8_t  PCAP_LINKTYPE_OFST  = 20;
+static const uint8_t  PCAP_SNAP_LEN_OFST  = 16;
+static const uint32_t PCAP_MAX_FRAME_SIZE = 0xFFFF;
+
+/* Captures are written little-endian, whatever the host */
+static void _put_u16(uint8_t* dest, uint16_t value)
+{
+    dest[0] = (uint8_t)(value);
+    dest[1] = (uint8_t)(value >> 8);
+}
+
+static void _put_u32(uint8_t* dest, uint32_t value)
+{
+    dest[0] = (uint8_t)(value);
+    dest[1] = (uint8_t)(value >> 8);
+    dest[2] = (uint8_t)(value >> 16);
+    dest[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t _get_u32(const struct pcap_reader* self, uint32_t ofst)
+{
+    const uint8_t* src   = self->data + ofst;
+    uint32_t       value = (uint32_t)src[0] | (uint32_t)src[1] << 8
+                     | (uint32_t)src[2] << 16 | (uint32_t)src[3] << 24;
+    if (self->swapped)
+    {
+        value = (value >> 24) | ((value >> 8) & 0xFF00)
+                | ((value << 8) & 0xFF0000) | (value << 24);
+    }
+    return value;
+}
+
+/* ========================================================================== */
+
+/* PUBLIC */
+
+/* ========================================================================== */
+
+int8_t pcap_writer_init(struct pcap_writer* self)
+{
+    if (self == NULL || self->write == NULL)
+    {
+        return -EFAULT;
+    }
+    if (self->snap_len == 0)
+    {
+        return -EINVAL;
+    }
+
+    uint8_t header[PCAP_FILE_HEADER_SIZE];
+    _put_u32(header, PCAP_MAGIC_USEC);
+    _put_u16(header + 4, PCAP_VERSION_MAJOR);
+    _put_u16(header + 6, PCAP_VERSION_MINOR);
+    _put_u32(header + 8, 0);  /* Time zone: UTC */
+    _put_u32(header + 12, 0); /* Timestamp accuracy */
+    _put_u32(header + PCAP_SNAP_LEN_OFST, self->snap_len);
+    _put_u32(header + PCAP_LINKTYPE_OFST, PCAP_LINKTYPE_ETH);
+
+    int8_t status = self->write(self->context, header, sizeof(header));
+    if (status != 0)
+    {
+        return status;
+    }
+
+    self->frames          = 0;
+    self->was_initialized = true;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t pcap_writer_frame(
+    struct pcap_writer* self,
+    uint32_t            ts_sec,
+    uint32_t            ts_usec,
+    const uint8_t*      frame,
+    uint16_t            size)
+{
+    if (self == NULL || frame == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+
+    uint16_t captured = (size > self->snap_len) ? self->snap_len : size;
+    uint8_t  header[PCAP_RECORD_HEADER_SIZE];
+    _put_u32(header, ts_sec);
+    _put_u32(header + 4, ts_usec);
+    _put_u32(header + 8, captured);
+    _put_u32(header + 12, size);
+
+    int8_t status = self->write(self->context, header, sizeof(header));
+    if (status == 0)
+    {
+        status = self->write(self->context, frame, captured);
+    }
+    if (status != 0)
+    {
+        return status;
+    }
+
+    self->frames += 1;
+    return 0;
+}
+
+/* ========================================================================== */
+
+uint32_t pcap_writer_frames(const struct pcap_writer* self)
+{
+    return (self == NULL) ? 0 : self->frames;
+}
+
+/* ========================================================================== */
+
+int8_t pcap_reader_init(struct pcap_reader* self)
+{
+    if (self == NULL || self->data == NULL)
+    {
+        return -EFAULT;
+    }
+    if (self->size < PCAP_FILE_HEADER_SIZE)
+    {
+        return -EINVAL;
+    }
+
+    self->swapped  = false;
+    uint32_t magic = _get_u32(self, 0);
+    if (magic == PCAP_MAGIC_USEC || magic == PCAP_MAGIC_USEC_SWAPPED)
+    {
+        self->nanoseconds = false;
+    }
+    else if (magic == PCAP_MAGIC_NSEC || magic == PCAP_MAGIC_NSEC_SWAPPED)
+    {
+        self->nanoseconds = true;
+    }
+    else
+    {
+        return -EINVAL;
+    }
+    self->swapped = (magic == PCAP_MAGIC_USEC_SWAPPED)
+                    || (magic == PCAP_MAGIC_NSEC_SWAPPED);
+
+    if (_get_u32(self, PCAP_LINKTYPE_OFST) != PCAP_LINKTYPE_ETH)
+    {
+        return -ENOTSUP;
+    }
+
+    self->pos             = PCAP_FILE_HEADER_SIZE;
+    self->was_initialized = true;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t pcap_reader_next(struct pcap_reader* self, struct pcap_record* record)
+{
+    if (self == NULL || record == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    if (self->pos == self->size)
+    {
+        return -ENOENT;
+    }
+
+    uint32_t left = self->size - self->pos;
+    if (left < PCAP_RECORD_HEADER_SIZE)
+    {
+        return -EINVAL;
+    }
+    uint32_t captured = _get_u32(self, self->pos + 8);
+    if (captured > PCAP_MAX_FRAME_SIZE
+        || captured > left - PCAP_RECORD_HEADER_SIZE)
+    {
+        return -EINVAL;
+    }
+
+    record->ts_sec    = _get_u32(self, self->pos);
+    record->ts_usec   = _get_u32(self, self->pos + 4);
+    record->orig_size = _get_u32(self, self->pos + 12);
+    record->frame     = self->data + self->pos + PCAP_RECORD_HEADER_SIZE;
+    record->size      = (uint16_t)captured;
+    if (self->nanoseconds)
+    {
+        record->ts_usec /= 1000;
+    }
+
+    self->pos += PCAP_RECORD_HEADER_SIZE + captured;
+    return 0;
+}
+
+/* ========================================================================== */
@@ -0,0 +1,208 @@
+#include "../inc/tcp.h"
+
+/* ========================================================================== */
+
+#include "../../inc/errno.h"
+#include "../inc/utils.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/* ========================================================================== */
+
+/* Mirrors ip.c's macro of the same name, see udp.c */
+#define IP_PLD_PROT_TCP_VAL (uint8_t)6
+
+static const uint8_t TCP_SRC_PORT_FRAME_OFST  = 0;  /* 2 bytes */
+static const uint8_t TCP_DEST_PORT_FRAME_OFST = 2;  /* 2 bytes */
+static const uint8_t TCP_SEQ_FRAME_OFST       = 4;  /* 4 bytes */
+static const uint8_t TCP_ACK_FRAME_OFST       = 8;  /* 4 bytes */
+static const uint8_t TCP_DATA_OFST_FRAME_OFST = 12; /* High nibble, words */
+static const uint8_t TCP_FLAGS_FRAME_OFST     = 13;
+static const uint8_t TCP_WINDOW_FRAME_OFST    = 14; /* 2 bytes */
+static const uint8_t TCP_CHECKSUM_FRAME_OFST  = 16; /* 2 bytes */
+static const uint8_t TCP_URGENT_FRAME_OFST    = 18; /* 2 bytes */
+static const uint8_t TCP_OPTIONS_FRAME_OFST   = 20;
+
+static const uint8_t TCP_OPT_END      = 0;
+static const uint8_t TCP_OPT_NOP      = 1;
+static const uint8_t TCP_OPT_MSS      = 2;
+static const uint8_t TCP_OPT_MSS_SIZE = 4;
+
+/* ========================================================================== */
+
+static uint16_t compute_tcp_checksum(
+    const uint8_t* src_ip,
+    const uint8_t* dest_ip,
+    const uint8_t* frame,
+    uint16_t       frame_size)
+{
+    uint8_t tcp_pseudo_header[4] = {
+        0,
+        IP_PLD_PROT_TCP_VAL,
+        (uint8_t)(frame_size >> 8),
+        (uint8_t)(frame_size),
+    };
+    struct slice frame_slice[]
+        = {{.base = src_ip, .len = 4},
+           {.base = dest_ip, .len = 4},
+           {.base = tcp_pseudo_header, .len = sizeof(tcp_pseudo_header)},
+           {.base = frame, .len = frame_size}};
+    return compute_inet_checksum(frame_slice, 4);
+}
+
+static uint32_t read_u32(const uint8_t* data)
+{
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16)
+           | ((uint32_t)data[2] << 8) | (uint32_t)data[3];
+}
+
+static void write_u32(uint8_t* data, uint32_t value)
+{
+    data[0] = (uint8_t)(value >> 24);
+    data[1] = (uint8_t)(value >> 16);
+    data[2] = (uint8_t)(value >> 8);
+    data[3] = (uint8_t)(value);
+}
+
+/**
+ * @brief Find the MSS option. Malformed options end the walk.
+ */
+static uint16_t find_mss_option(const uint8_t* options, uint8_t size)
+{
+    uint8_t offset = 0;
+    while (offset < size && options[offset] != TCP_OPT_END)
+    {
+        if (options[offset] == TCP_OPT_NOP)
+        {
+            offset += 1;
+            continue;
+        }
+        if (size - offset < 2 || options[offset + 1] < 2
+            || options[offset + 1] > size - offset)
+        {
+            break;
+        }
+        if (options[offset] == TCP_OPT_MSS
+            && options[offset + 1] == TCP_OPT_MSS_SIZE)
+        {
+            return (uint16_t)((options[offset + 2] << 8) | options[offset + 3]);
+        }
+        offset += options[offset + 1];
+    }
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t tcp_process_frame(
+    struct tcp*             self,
+    const uint8_t*          rx_frame,
+    uint16_t                rx_frame_size,
+    struct tcp_rx_metadata* mdata)
+{
+    if (self == NULL || rx_frame == NULL || mdata == NULL)
+    {
+        return -EFAULT;
+    }
+
+    if (rx_frame_size < TCP_HEADER_SIZE)
+    {
+        self->lost_frames += 1;
+        return -EINVAL;
+    }
+
+    uint8_t header_size
+        = (uint8_t)(4 * (rx_frame[TCP_DATA_OFST_FRAME_OFST] >> 4));
+    if (header_size < TCP_HEADER_SIZE || header_size > rx_frame_size)
+    {
+        self->lost_frames += 1;
+        return -EINVAL;
+    }
+
+    if (compute_tcp_checksum(
+            mdata->ip_mdata->src_ip,
+            mdata->ip_mdata->dest_ip,
+            rx_frame,
+            rx_frame_size)
+        != 0)
+    {
+        self->lost_frames += 1;
+        return -EINVAL;
+    }
+
+    mdata->src_port_num = (uint16_t)((rx_frame[TCP_SRC_PORT_FRAME_OFST]) << 8)
+                          | (rx_frame[TCP_SRC_PORT_FRAME_OFST + 1]);
+    mdata->dest_port_num = (uint16_t)((rx_frame[TCP_DEST_PORT_FRAME_OFST]) << 8)
+                           | (rx_frame[TCP_DEST_PORT_FRAME_OFST + 1]);
+    mdata->seq_num = read_u32(rx_frame + TCP_SEQ_FRAME_OFST);
+    mdata->ack_num = read_u32(rx_frame + TCP_ACK_FRAME_OFST);
+    mdata->flags   = rx_frame[TCP_FLAGS_FRAME_OFST];
+    mdata->window  = (uint16_t)((rx_frame[TCP_WINDOW_FRAME_OFST]) << 8)
+                    | (rx_frame[TCP_WINDOW_FRAME_OFST + 1]);
+    mdata->mss = find_mss_option(
+        rx_frame + TCP_OPTIONS_FRAME_OFST,
+        (uint8_t)(header_size - TCP_HEADER_SIZE));
+    mdata->payload      = rx_frame + header_size;
+    mdata->payload_size = rx_frame_size - header_size;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t tcp_build_frame(
+    struct tcp*             self,
+    struct tcp_tx_metadata* mdata,
+    uint8_t*                tx_frame,
+    uint16_t*               tx_frame_size)
+{
+    if (self == NULL || mdata == NULL || tx_frame == NULL
+        || tx_frame_size == NULL)
+    {
+        return -EFAULT;
+    }
+
+    uint8_t  header_size = tcp_header_size(mdata);
+    uint16_t tcp_len     = header_size + mdata->payload_size;
+
+    tx_frame[TCP_SRC_PORT_FRAME_OFST]     = (uint8_t)(mdata->src_port_num >> 8);
+    tx_frame[TCP_SRC_PORT_FRAME_OFST + 1] = (uint8_t)(mdata->src_port_num);
+    tx_frame[TCP_DEST_PORT_FRAME_OFST] = (uint8_t)(mdata->dest_port_num >> 8);
+    tx_frame[TCP_DEST_PORT_FRAME_OFST + 1] = (uint8_t)(mdata->dest_port_num);
+    write_u32(tx_frame + TCP_SEQ_FRAME_OFST, mdata->seq_num);
+    write_u32(tx_frame + TCP_ACK_FRAME_OFST, mdata->ack_num);
+    tx_frame[TCP_DATA_OFST_FRAME_OFST]    = (uint8_t)((header_size / 4) << 4);
+    tx_frame[TCP_FLAGS_FRAME_OFST]        = mdata->flags;
+    tx_frame[TCP_WINDOW_FRAME_OFST]       = (uint8_t)(mdata->window >> 8);
+    tx_frame[TCP_WINDOW_FRAME_OFST + 1]   = (uint8_t)(mdata->window);
+    tx_frame[TCP_CHECKSUM_FRAME_OFST]     = 0;
+    tx_frame[TCP_CHECKSUM_FRAME_OFST + 1] = 0;
+    tx_frame[TCP_URGENT_FRAME_OFST]       = 0;
+    tx_frame[TCP_URGENT_FRAME_OFST + 1]   = 0;
+    if (mdata->mss != 0)
+    {
+        uint8_t* option = tx_frame + TCP_OPTIONS_FRAME_OFST;
+        option[0]       = TCP_OPT_MSS;
+        option[1]       = TCP_OPT_MSS_SIZE;
+        option[2]       = (uint8_t)(mdata->mss >> 8);
+        option[3]       = (uint8_t)(mdata->mss);
+    }
+
+    uint16_t checksum = compute_tcp_checksum(
+        mdata->ip_mdata->src_ip, mdata->ip_mdata->dest_ip, tx_frame, tcp_len);
+    tx_frame[TCP_CHECKSUM_FRAME_OFST]     = (uint8_t)(checksum >> 8);
+    tx_frame[TCP_CHECKSUM_FRAME_OFST + 1] = (uint8_t)(checksum);
+
+    *tx_frame_size = tcp_len;
+    return 0;
+}
+
+/* ========================================================================== */
+
+uint8_t tcp_header_size(const struct tcp_tx_metadata* mdata)
+{
+    return (mdata->mss != 0) ? TCP_HEADER_SIZE + TCP_OPT_MSS_SIZE
+                             : TCP_HEADER_SIZE;
+}
+
+/* ========================================================================== */
@@ -0,0 +1,1474 @@
+#include "../inc/tcp_conn.h"
+
+/* ========================================================================== */
+
+#include "../../inc/errno.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/* ========================================================================== */
+
+/* PRIVATE */
+
+/* ========================================================================== */
+
+static const uint16_t EPHEMERAL_PORT_FIRST = 49152; /* RFC 6335 */
+static const uint32_t ISS_INCREMENT        = 64000;
+static const uint8_t  DUP_ACK_THRESHOLD    = 3; /* RFC 5681 */
+
+/* Each handler event of one segment is a bit, reported in this order */
+static const uint8_t EVENT_BIT_CONNECTED   = 1 << TCP_EVENT_CONNECTED;
+static const uint8_t EVENT_BIT_RECEIVED    = 1 << TCP_EVENT_RECEIVED;
+static const uint8_t EVENT_BIT_SENT        = 1 << TCP_EVENT_SENT;
+static const uint8_t EVENT_BIT_PEER_CLOSED = 1 << TCP_EVENT_PEER_CLOSED;
+static const uint8_t EVENT_BIT_CLOSED      = 1 << TCP_EVENT_CLOSED;
+
+static bool _seq_lt(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+static bool _seq_le(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) <= 0;
+}
+
+static uint32_t _elapsed(uint32_t now, uint32_t since)
+{
+    return now - since;
+}
+
+static uint16_t _min(uint32_t a, uint32_t b)
+{
+    return (uint16_t)((a < b) ? a : b);
+}
+
+static uint16_t _ring_index(uint16_t head, uint32_t offset, uint16_t size)
+{
+    return (uint16_t)((head + offset) % size);
+}
+
+static uint16_t _rx_free(const struct tcp_conn* conn)
+{
+    return conn->rx_size - conn->rx_used;
+}
+
+/**
+ * @brief Whether a segment falls in the receive window (RFC 793): its first
+ * or its last sequence number, or its start for an empty one. With the window
+ * closed, only the next sequence number is accepted, for the ACK of a window
+ * probe.
+ */
+static bool
+_acceptable(const struct tcp_conn* conn, const struct tcp_rx_metadata* mdata)
+{
+    uint32_t window = _rx_free(conn);
+    uint32_t length = mdata->payload_size
+                      + ((mdata->flags & TCP_FLAG_FIN) ? 1 : 0);
+    uint32_t first  = mdata->seq_num - conn->rcv_nxt;
+    if (window == 0)
+    {
+        return first == 0;
+    }
+    if (length == 0)
+    {
+        return first < window;
+    }
+    return first < window || first + length - 1 < window;
+}
+
+/**
+ * @brief Whether the application closed the sending side: a FIN follows the
+ * data of tx_buffer.
+ */
+static bool _fin_queued(const struct tcp_conn* conn)
+{
+    return conn->state == TCP_FIN_WAIT_1 || conn->state == TCP_CLOSING
+           || conn->state == TCP_LAST_ACK;
+}
+
+/**
+ * @brief Bytes of tx_buffer sent at least once since snd_una. The FIN, if
+ * sent, is the sequence number after them.
+ */
+static uint16_t _tx_sent(const struct tcp_conn* conn)
+{
+    return _min(conn->snd_nxt - conn->snd_una, conn->tx_used);
+}
+
+static uint16_t _local_mss(const struct tcp_table* self)
+{
+    return _min(
+        self->tx_frame_size - TCP_CONN_HEADROOM - TCP_HEADER_SIZE,
+        TCP_MSS_MAX);
+}
+
+/**
+ * @brief Segment size towards the peer: its MSS option, or the default of RFC
+ * 1122, within what tx_frame holds.
+ */
+static uint16_t
+_peer_mss(const struct tcp_table* self, const struct tcp_rx_metadata* mdata)
+{
+    return _min(
+        (mdata->mss != 0) ? mdata->mss : TCP_MSS_DEFAULT, _local_mss(self));
+}
+
+static void _arm_rto(struct tcp_table* self, struct tcp_conn* conn)
+{
+    conn->rto_armed = true;
+    conn->rto_since = self->now;
+}
+
+static void _start_rtt(struct tcp_table* self, struct tcp_conn* conn)
+{
+    conn->rtt_timing = true;
+    conn->rtt_seq    = conn->snd_nxt;
+    conn->rtt_since  = self->now;
+}
+
+/**
+ * @brief Update the smoothed RTT and the retransmission timeout with one
+ * sample (RFC 6298, in the fixed point of Jacobson's algorithm).
+ */
+static void _rtt_sample(struct tcp_table* self, struct tcp_conn* conn)
+{
+    int32_t rtt = (int32_t)_elapsed(self->now, conn->rtt_since);
+    conn->rtt_timing = false;
+    if (conn->srtt == 0)
+    {
+        conn->srtt   = rtt << 3;
+        conn->rttvar = rtt << 1;
+    }
+    else
+    {
+        int32_t err = rtt - (conn->srtt >> 3);
+        conn->srtt += err;
+        if (err < 0)
+        {
+            err = -err;
+        }
+        conn->rttvar += err - (conn->rttvar >> 2);
+    }
+
+    uint32_t rto = (uint32_t)((conn->srtt >> 3) + conn->rttvar);
+    if (rto < self->rto_min)
+    {
+        rto = self->rto_min;
+    }
+    conn->rto = (rto > self->rto_max) ? self->rto_max : rto;
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Build a segment in tx_frame, its payload already in place, and hand
+ * it to output.
+ */
+static int8_t _emit(
+    struct tcp_table*       self,
+    struct tcp_tx_metadata* mdata,
+    tcp_output_t            output,
+    void*                   context)
+{
+    uint8_t* segment = self->tx_frame + TCP_CONN_HEADROOM;
+    uint16_t size    = 0;
+    int8_t   status  = tcp_build_frame(&self->tcp, mdata, segment, &size);
+    if (status != 0)
+    {
+        return status;
+    }
+    mdata->ip_mdata->payload      = segment;
+    mdata->ip_mdata->payload_size = size;
+    self->stats.segments_sent += 1;
+    return output(context, mdata->ip_mdata, self->tx_frame);
+}
+
+/**
+ * @brief Send a segment of a connection carrying the size bytes of tx_buffer
+ * that start at seq. A SYN carries the MSS option, an ACK advertises the
+ * free space of rx_buffer.
+ */
+static int8_t _send(
+    struct tcp_table* self,
+    struct tcp_conn*  conn,
+    uint32_t          seq,
+    uint8_t           flags,
+    uint16_t          size,
+    tcp_output_t      output,
+    void*             context)
+{
+    struct ip_tx_metadata ip_mdata = {
+        .version       = IP_VER_4,
+        .pld_prot_type = IP_PLD_TCP,
+    };
+    memcpy(ip_mdata.src_ip, conn->local_ip, 4);
+    memcpy(ip_mdata.dest_ip, conn->remote_ip, 4);
+    struct tcp_tx_metadata mdata = {
+        .ip_mdata      = &ip_mdata,
+        .src_port_num  = conn->local_port,
+        .dest_port_num = conn->remote_port,
+        .seq_num       = seq,
+        .ack_num       = (flags & TCP_FLAG_ACK) ? conn->rcv_nxt : 0,
+        .flags         = flags,
+        .window        = _rx_free(conn),
+        .mss           = (flags & TCP_FLAG_SYN) ? _local_mss(self) : 0,
+        .payload_size  = size,
+    };
+
+    // The data may wrap around the end of tx_buffer
+    if (size > 0)
+    {
+        uint8_t* payload = self->tx_frame + TCP_CONN_HEADROOM
+                           + tcp_header_size(&mdata);
+        uint16_t start
+            = _ring_index(conn->tx_head, seq - conn->snd_una, conn->tx_size);
+        uint16_t first = _min(size, conn->tx_size - start);
+        memcpy(payload, conn->tx_buffer + start, first);
+        memcpy(payload + first, conn->tx_buffer, size - first);
+    }
+    if (flags & TCP_FLAG_ACK)
+    {
+        conn->ack_pending = 0;
+        conn->rcv_adv     = conn->rcv_nxt + mdata.window;
+    }
+    return _emit(self, &mdata, output, context);
+}
+
+/**
+ * @brief Answer a segment no connection accepts with a reset (RFC 793).
+ */
+static void _send_reset(
+    struct tcp_table*             self,
+    const struct tcp_rx_metadata* rx_mdata,
+    tcp_output_t                  output,
+    void*                         context)
+{
+    if (rx_mdata->flags & TCP_FLAG_RST)
+    {
+        return;
+    }
+
+    struct ip_tx_metadata ip_mdata = {
+        .version       = IP_VER_4,
+        .pld_prot_type = IP_PLD_TCP,
+    };
+    memcpy(ip_mdata.src_ip, rx_mdata->ip_mdata->dest_ip, 4);
+    memcpy(ip_mdata.dest_ip, rx_mdata->ip_mdata->src_ip, 4);
+    struct tcp_tx_metadata mdata = {
+        .ip_mdata      = &ip_mdata,
+        .src_port_num  = rx_mdata->dest_port_num,
+        .dest_port_num = rx_mdata->src_port_num,
+    };
+    if (rx_mdata->flags & TCP_FLAG_ACK)
+    {
+        mdata.seq_num = rx_mdata->ack_num;
+        mdata.flags   = TCP_FLAG_RST;
+    }
+    else
+    {
+        // SYN and FIN take a sequence number each
+        mdata.ack_num = rx_mdata->seq_num + rx_mdata->payload_size
+                        + ((rx_mdata->flags & TCP_FLAG_SYN) ? 1 : 0)
+                        + ((rx_mdata->flags & TCP_FLAG_FIN) ? 1 : 0);
+        mdata.flags = TCP_FLAG_RST | TCP_FLAG_ACK;
+    }
+    self->stats.resets_sent += 1;
+    _emit(self, &mdata, output, context);
+}
+
+/**
+ * @brief Free a connection and give the handler its last event.
+ */
+static void _release(struct tcp_conn* conn, enum tcp_event event)
+{
+    conn->state = TCP_CLOSED;
+    conn->handler(conn->context, conn, event);
+}
+
+/**
+ * @brief Reset a connection and free it.
+ */
+static void _reset(
+    struct tcp_table* self,
+    struct tcp_conn*  conn,
+    tcp_output_t      output,
+    void*             context)
+{
+    self->stats.resets_sent += 1;
+    _send(
+        self,
+        conn,
+        conn->snd_nxt,
+        TCP_FLAG_RST | TCP_FLAG_ACK,
+        0,
+        output,
+        context);
+    conn->state = TCP_CLOSED;
+}
+
+/**
+ * @brief Send the data of tx_buffer the window of the peer allows, then the
+ * FIN once all data went out. With probe, only one segment is sent, and a
+ * zero window gets one byte anyway.
+ */
+static void _send_pending(
+    struct tcp_table* self,
+    struct tcp_conn*  conn,
+    bool              probe,
+    tcp_output_t      output,
+    void*             context)
+{
+    if (conn->state != TCP_ESTABLISHED && conn->state != TCP_CLOSE_WAIT
+        && !_fin_queued(conn))
+    {
+        return;
+    }
+
+    uint16_t unsent = 0;
+    while (true)
+    {
+        uint16_t sent     = _tx_sent(conn);
+        uint32_t inflight = conn->snd_nxt - conn->snd_una;
+        uint16_t usable
+            = (conn->snd_wnd > inflight) ? (uint16_t)(conn->snd_wnd - inflight)
+                                         : 0;
+        unsent = conn->tx_used - sent;
+        if (probe && usable == 0 && inflight == 0)
+        {
+            usable = 1;
+        }
+
+        uint16_t size = _min(_min(unsent, usable), conn->snd_mss);
+        bool     fin  = _fin_queued(conn) && size == unsent
+                   && inflight <= conn->tx_used;
+        if (size == 0 && !fin)
+        {
+            break;
+        }
+
+        uint8_t flags = TCP_FLAG_ACK;
+        flags |= (size > 0 && size == unsent) ? TCP_FLAG_PSH : 0;
+        flags |= fin ? TCP_FLAG_FIN : 0;
+        // Time one segment of new data at a time, never a retransmission
+        if (conn->snd_nxt == conn->snd_max && !conn->rtt_timing)
+        {
+            conn->rtt_timing = true;
+            conn->rtt_seq    = conn->snd_nxt + size + (fin ? 1 : 0);
+            conn->rtt_since  = self->now;
+        }
+        _send(self, conn, conn->snd_nxt, flags, size, output, context);
+        conn->snd_nxt += size + (fin ? 1 : 0);
+        if (_seq_lt(conn->snd_max, conn->snd_nxt))
+        {
+            conn->snd_max = conn->snd_nxt;
+        }
+        if (!conn->rto_armed)
+        {
+            _arm_rto(self, conn);
+        }
+        if (probe || fin)
+        {
+            return;
+        }
+    }
+
+    // A zero window with data waiting: the timer sends the probes
+    if (unsent > 0 && !conn->rto_armed)
+    {
+        _arm_rto(self, conn);
+    }
+}
+
+/**
+ * @brief Send again the first segment not acknowledged.
+ */
+static void _retransmit(
+    struct tcp_table* self,
+    struct tcp_conn*  conn,
+    tcp_output_t      output,
+    void*             context)
+{
+    self->stats.retransmits += 1;
+    conn->rtt_timing = false; /* Karn's algorithm */
+    switch (conn->state)
+    {
+        case TCP_SYN_SENT:
+        {
+            _send(self, conn, conn->iss, TCP_FLAG_SYN, 0, output, context);
+            break;
+        }
+        case TCP_SYN_RECEIVED:
+        {
+            _send(
+                self,
+                conn,
+                conn->iss,
+                TCP_FLAG_SYN | TCP_FLAG_ACK,
+                0,
+                output,
+                context);
+            break;
+        }
+        default:
+        {
+            // Go back N: the segments after it follow as the ACKs come in,
+            // a receiver that dropped them out of order needs them again
+            conn->snd_nxt = conn->snd_una;
+            _send_pending(self, conn, true, output, context);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Timeout: back off and retransmit, or give the connection up.
+ */
+static void _on_rto(
+    struct tcp_table* self,
+    struct tcp_conn*  conn,
+    tcp_output_t      output,
+    void*             context)
+{
+    if (conn->retries >= self->max_retries)
+    {
+        _reset(self, conn, output, context);
+        conn->handler(conn->context, conn, TCP_EVENT_ABORTED);
+        return;
+    }
+    conn->retries += 1;
+    conn->rto = (conn->rto > self->rto_max / 2) ? self->rto_max : conn->rto * 2;
+    _retransmit(self, conn, output, context);
+    _arm_rto(self, conn);
+}
+
+/* ========================================================================== */
+
+static struct tcp_conn*
+_find(struct tcp_table* self, const struct tcp_rx_metadata* mdata)
+{
+    for (uint8_t i = 0; i < self->conn_count; i++)
+    {
+        struct tcp_conn* conn = &self->conns[i];
+        if (conn->state != TCP_CLOSED
+            && conn->local_port == mdata->dest_port_num
+            && conn->remote_port == mdata->src_port_num
+            && !memcmp(conn->remote_ip, mdata->ip_mdata->src_ip, 4)
+            && !memcmp(conn->local_ip, mdata->ip_mdata->dest_ip, 4))
+        {
+            return conn;
+        }
+    }
+    return NULL;
+}
+
+static struct tcp_listener*
+_find_listener(const struct tcp_table* self, uint16_t port)
+{
+    for (uint8_t i = 0; i < self->listener_count; i++)
+    {
+        if (self->listeners[i] != NULL && self->listeners[i]->port == port)
+        {
+            return self->listeners[i];
+        }
+    }
+    return NULL;
+}
+
+static uint32_t _mix(uint32_t hash)
+{
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6B;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+/**
+ * @brief Keyed hash of the addresses and ports of a connection, the F() of RFC
+ * 6528. The finalizer of MurmurHash3 rather than MD5: not cryptographic, but
+ * out of reach of a host that cannot see the traffic, at a few cycles.
+ */
+static uint32_t
+_iss_offset(const struct tcp_table* self, const struct tcp_conn* conn)
+{
+    uint32_t local  = 0;
+    uint32_t remote = 0;
+    memcpy(&local, conn->local_ip, 4);
+    memcpy(&remote, conn->remote_ip, 4);
+    uint32_t ports = (uint32_t)conn->local_port << 16 | conn->remote_port;
+
+    uint32_t hash = _mix(self->iss_secret ^ local);
+    hash          = _mix(hash ^ remote);
+    return _mix(hash ^ ports);
+}
+
+/**
+ * @brief Take a free connection and reset its state for a new peer.
+ */
+static struct tcp_conn* _open(
+    struct tcp_table* self,
+    const uint8_t*    local_ip,
+    const uint8_t*    remote_ip,
+    uint16_t          local_port,
+    uint16_t          remote_port)
+{
+    struct tcp_conn* conn = NULL;
+    for (uint8_t i = 0; i < self->conn_count && conn == NULL; i++)
+    {
+        if (self->conns[i].state == TCP_CLOSED)
+        {
+            conn = &self->conns[i];
+        }
+    }
+    if (conn == NULL)
+    {
+        return NULL;
+    }
+
+    memcpy(conn->local_ip, local_ip, 4);
+    memcpy(conn->remote_ip, remote_ip, 4);
+    conn->local_port  = local_port;
+    conn->remote_port = remote_port;
+    conn->generation += 1;
+
+    // RFC 793: the ISS follows a clock, so old duplicates of a previous
+    // connection with the same ports fall outside the new window. Each pair
+    // of endpoints starts from its own secret offset (RFC 6528).
+    conn->iss = self->next_iss + self->now * 250 + _iss_offset(self, conn);
+    self->next_iss += ISS_INCREMENT;
+    conn->snd_una     = conn->iss;
+    conn->snd_nxt     = conn->iss;
+    conn->snd_max     = conn->iss;
+    conn->snd_wnd     = 0;
+    conn->snd_mss     = TCP_MSS_DEFAULT;
+    conn->tx_head     = 0;
+    conn->tx_used     = 0;
+    conn->dup_acks    = 0;
+    conn->rcv_nxt     = 0;
+    conn->rx_head     = 0;
+    conn->rx_used     = 0;
+    conn->rcv_adv     = 0;
+    conn->ack_pending = 0;
+    conn->srtt        = 0;
+    conn->rttvar      = 0;
+    conn->rto         = self->rto_initial;
+    conn->rtt_timing  = false;
+    conn->rto_armed   = false;
+    conn->retries     = 0;
+    return conn;
+}
+
+/**
+ * @brief Deliver the events of one segment, then send what it made possible:
+ * data the window now allows, and the ACK if no segment carried it. The
+ * events stop once the handler aborts the connection, or reuses its slot.
+ */
+static void _finish(
+    struct tcp_table* self,
+    struct tcp_conn*  conn,
+    uint8_t           events,
+    bool              ack_now,
+    tcp_output_t      output,
+    void*             context)
+{
+    bool    open       = conn->state != TCP_CLOSED;
+    uint8_t generation = conn->generation;
+    for (uint8_t event = TCP_EVENT_CONNECTED; event <= TCP_EVENT_CLOSED;
+         event++)
+    {
+        if (events & (1 << event))
+        {
+            conn->handler(conn->context, conn, (enum tcp_event)event);
+            if (conn->generation != generation
+                || (open && conn->state == TCP_CLOSED))
+            {
+                return;
+            }
+        }
+    }
+    if (conn->state == TCP_CLOSED || conn->state == TCP_SYN_SENT)
+    {
+        return;
+    }
+
+    _send_pending(self, conn, false, output, context);
+    // Every second segment is acknowledged at once (RFC 1122)
+    if (conn->ack_pending > 0 && (ack_now || conn->ack_pending >= 2))
+    {
+        _send(self, conn, conn->snd_nxt, TCP_FLAG_ACK, 0, output, context);
+    }
+}
+
+/**
+ * @brief A SYN for a listening port: answer with SYN-ACK.
+ */
+static int8_t _input_listen(
+    struct tcp_table*             self,
+    const struct tcp_rx_metadata* mdata,
+    tcp_output_t                  output,
+    void*                         context)
+{
+    struct tcp_listener* listener
+        = _find_listener(self, mdata->dest_port_num);
+    uint8_t handshake
+        = mdata->flags & (TCP_FLAG_SYN | TCP_FLAG_ACK | TCP_FLAG_RST);
+    if (listener == NULL || handshake != TCP_FLAG_SYN)
+    {
+        _send_reset(self, mdata, output, context);
+        self->stats.dropped += 1;
+        return -ENOENT;
+    }
+
+    struct tcp_conn* conn = _open(
+        self,
+        mdata->ip_mdata->dest_ip,
+        mdata->ip_mdata->src_ip,
+        mdata->dest_port_num,
+        mdata->src_port_num);
+    if (conn == NULL)
+    {
+        // No reset: the peer retries its SYN, maybe once a connection is free
+        self->stats.dropped += 1;
+        return -ENOSPC;
+    }
+    conn->state   = TCP_SYN_RECEIVED;
+    conn->handler = listener->handler;
+    conn->context = listener->context;
+    conn->rcv_nxt = mdata->seq_num + 1;
+    conn->snd_wnd = mdata->window;
+    conn->snd_wl1 = mdata->seq_num;
+    conn->snd_wl2 = conn->iss;
+    conn->snd_mss = _peer_mss(self, mdata);
+
+    _start_rtt(self, conn);
+    conn->rtt_seq += 1;
+    _send(
+        self,
+        conn,
+        conn->iss,
+        TCP_FLAG_SYN | TCP_FLAG_ACK,
+        0,
+        output,
+        context);
+    conn->snd_nxt = conn->iss + 1;
+    conn->snd_max = conn->snd_nxt;
+    _arm_rto(self, conn);
+    return 0;
+}
+
+/**
+ * @brief The answer to the SYN of an active open.
+ */
+static int8_t _input_syn_sent(
+    struct tcp_table*             self,
+    struct tcp_conn*              conn,
+    const struct tcp_rx_metadata* mdata,
+    tcp_output_t                  output,
+    void*                         context)
+{
+    bool has_ack = (mdata->flags & TCP_FLAG_ACK) != 0;
+    if (has_ack && mdata->ack_num != conn->iss + 1)
+    {
+        _send_reset(self, mdata, output, context);
+        self->stats.dropped += 1;
+        return -EINVAL;
+    }
+    if (mdata->flags & TCP_FLAG_RST)
+    {
+        if (!has_ack)
+        {
+            self->stats.dropped += 1;
+            return -EINVAL;
+        }
+        _release(conn, TCP_EVENT_ABORTED); /* Connection refused */
+        return 0;
+    }
+    // A SYN without ACK would be a simultaneous open: not supported
+    if (!(mdata->flags & TCP_FLAG_SYN) || !has_ack)
+    {
+        self->stats.dropped += 1;
+        return -EINVAL;
+    }
+
+    conn->state     = TCP_ESTABLISHED;
+    conn->rcv_nxt   = mdata->seq_num + 1;
+    conn->snd_una   = mdata->ack_num;
+    conn->snd_wnd   = mdata->window;
+    conn->snd_wl1   = mdata->seq_num;
+    conn->snd_wl2   = mdata->ack_num;
+    conn->snd_mss   = _peer_mss(self, mdata);
+    conn->retries   = 0;
+    conn->rto_armed = false;
+    if (conn->rtt_timing)
+    {
+        _rtt_sample(self, conn);
+    }
+    // The first data of the application can carry the ACK
+    conn->ack_pending = 1;
+    _finish(self, conn, EVENT_BIT_CONNECTED, true, output, context);
+    return 0;
+}
+
+/**
+ * @brief Process the acknowledgment of a segment: free the data it covers,
+ * measure the RTT, follow the FIN. Returns false if the segment must be
+ * dropped.
+ */
+static bool _input_ack(
+    struct tcp_table*             self,
+    struct tcp_conn*              conn,
+    const struct tcp_rx_metadata* mdata,
+    uint8_t*                      events,
+    tcp_output_t                  output,
+    void*                         context)
+{
+    uint32_t ack = mdata->ack_num;
+    if (_seq_lt(conn->snd_max, ack))
+    {
+        // Acknowledges what was never sent
+        _send(self, conn, conn->snd_nxt, TCP_FLAG_ACK, 0, output, context);
+        return false;
+    }
+    if (_seq_lt(ack, conn->snd_una))
+    {
+        return true; /* Old duplicate */
+    }
+
+    // Only a segment as recent as the last window update moves the window: an
+    // older one delayed behind it would bring back a stale window (RFC 793)
+    uint16_t window = conn->snd_wnd;
+    if (_seq_lt(conn->snd_wl1, mdata->seq_num)
+        || (conn->snd_wl1 == mdata->seq_num && _seq_le(conn->snd_wl2, ack)))
+    {
+        conn->snd_wnd = mdata->window;
+        conn->snd_wl1 = mdata->seq_num;
+        conn->snd_wl2 = ack;
+    }
+    conn->retries = 0;
+    if (ack == conn->snd_una)
+    {
+        // Three duplicate ACKs: the segment after ack was lost (RFC 5681)
+        if (mdata->payload_size == 0 && window == mdata->window
+            && conn->snd_una != conn->snd_max
+            && ++conn->dup_acks == DUP_ACK_THRESHOLD)
+        {
+            _retransmit(self, conn, output, context);
+        }
+        return true;
+    }
+
+    uint32_t acked     = ack - conn->snd_una;
+    uint16_t data      = _min(acked, conn->tx_used);
+    bool     fin_acked = _fin_queued(conn) && acked > conn->tx_used;
+    conn->tx_head      = _ring_index(conn->tx_head, data, conn->tx_size);
+    conn->tx_used -= data;
+    conn->snd_una  = ack;
+    conn->dup_acks = 0;
+    if (_seq_lt(conn->snd_nxt, ack))
+    {
+        conn->snd_nxt = ack;
+    }
+    if (conn->rtt_timing && _seq_le(conn->rtt_seq, ack))
+    {
+        _rtt_sample(self, conn);
+    }
+    // Restart the timer for the rest, stop it when all is acknowledged
+    conn->rto_armed = false;
+    if (conn->snd_una != conn->snd_max)
+    {
+        _arm_rto(self, conn);
+    }
+    if (data > 0)
+    {
+        *events |= EVENT_BIT_SENT;
+    }
+
+    if (fin_acked)
+    {
+        switch (conn->state)
+        {
+            case TCP_FIN_WAIT_1:
+            {
+                conn->state = TCP_FIN_WAIT_2;
+                break;
+            }
+            case TCP_CLOSING:
+            {
+                conn->state     = TCP_TIME_WAIT;
+                conn->rto_since = self->now;
+                *events |= EVENT_BIT_CLOSED;
+                break;
+            }
+            default: /* TCP_LAST_ACK */
+            {
+                conn->state = TCP_CLOSED;
+                *events |= EVENT_BIT_CLOSED;
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Take the data of a segment if it is the next expected, then its FIN.
+ */
+static void _input_data(
+    struct tcp_table*             self,
+    struct tcp_conn*              conn,
+    const struct tcp_rx_metadata* mdata,
+    uint8_t*                      events,
+    bool*                         ack_now)
+{
+    const uint8_t* payload = mdata->payload;
+    uint16_t       size    = mdata->payload_size;
+    uint32_t       seq     = mdata->seq_num;
+    bool           fin     = (mdata->flags & TCP_FLAG_FIN) != 0;
+
+    // Skip what was received already
+    if (_seq_lt(seq, conn->rcv_nxt))
+    {
+        uint32_t old = conn->rcv_nxt - seq;
+        if (old > size)
+        {
+            // A duplicate: the peer missed the ACK
+            conn->ack_pending += 1;
+            *ack_now = true;
+            return;
+        }
+        payload += old;
+        size -= (uint16_t)old;
+        seq = conn->rcv_nxt;
+    }
+    if (seq != conn->rcv_nxt)
+    {
+        // Out of order: a duplicate ACK
+        conn->ack_pending += 1;
+        *ack_now = true;
+        self->stats.dropped += 1;
+        return;
+    }
+
+    if (size > 0)
+    {
+        uint16_t take = _min(size, _rx_free(conn));
+        uint16_t tail
+            = _ring_index(conn->rx_head, conn->rx_used, conn->rx_size);
+        uint16_t first = _min(take, conn->rx_size - tail);
+        memcpy(conn->rx_buffer + tail, payload, first);
+        memcpy(conn->rx_buffer, payload + first, take - first);
+        conn->rx_used += take;
+        conn->rcv_nxt += take;
+        if (conn->ack_pending++ == 0)
+        {
+            conn->ack_since = self->now;
+        }
+        if (take > 0)
+        {
+            *events |= EVENT_BIT_RECEIVED;
+        }
+        if (take < size)
+        {
+            *ack_now = true; /* The window is full */
+            return;
+        }
+    }
+    if (!fin)
+    {
+        return;
+    }
+
+    conn->rcv_nxt += 1;
+    conn->ack_pending += 1;
+    *ack_now = true;
+    switch (conn->state)
+    {
+        case TCP_ESTABLISHED:
+        {
+            conn->state = TCP_CLOSE_WAIT;
+            *events |= EVENT_BIT_PEER_CLOSED;
+            break;
+        }
+        case TCP_FIN_WAIT_1:
+        {
+            conn->state = TCP_CLOSING;
+            *events |= EVENT_BIT_PEER_CLOSED;
+            break;
+        }
+        default: /* TCP_FIN_WAIT_2 */
+        {
+            conn->state     = TCP_TIME_WAIT;
+            conn->rto_armed = false;
+            conn->rto_since = self->now;
+            *events |= EVENT_BIT_PEER_CLOSED | EVENT_BIT_CLOSED;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief A segment for a connection past its SYN (RFC 793, "otherwise").
+ */
+static int8_t _input_synchronized(
+    struct tcp_table*             self,
+    struct tcp_conn*              conn,
+    const struct tcp_rx_metadata* mdata,
+    tcp_output_t                  output,
+    void*                         context)
+{
+    if (mdata->flags & TCP_FLAG_RST)
+    {
+        // Only a reset inside the window is believed
+        uint32_t window = _rx_free(conn) ? _rx_free(conn) : 1;
+        if (_seq_lt(mdata->seq_num, conn->rcv_nxt)
+            || !_seq_lt(mdata->seq_num, conn->rcv_nxt + window))
+        {
+            self->stats.dropped += 1;
+            return -EINVAL;
+        }
+        // A reset must not cut TIME-WAIT short: old duplicates of this
+        // connection could reach the next one (RFC 1337)
+        if (conn->state == TCP_TIME_WAIT)
+        {
+            self->stats.dropped += 1;
+            return -EINVAL;
+        }
+        if (conn->state == TCP_SYN_RECEIVED)
+        {
+            conn->state = TCP_CLOSED; /* Never reported as connected */
+        }
+        else
+        {
+            _release(conn, TCP_EVENT_ABORTED);
+        }
+        return 0;
+    }
+
+    if (mdata->flags & TCP_FLAG_SYN)
+    {
+        // Our SYN-ACK was lost and the peer sent its SYN again
+        if (conn->state == TCP_SYN_RECEIVED
+            && mdata->seq_num + 1 == conn->rcv_nxt)
+        {
+            _retransmit(self, conn, output, context);
+            return 0;
+        }
+        _send(self, conn, conn->snd_nxt, TCP_FLAG_ACK, 0, output, context);
+        self->stats.dropped += 1;
+        return -EINVAL;
+    }
+    if (!_acceptable(conn, mdata))
+    {
+        // A duplicate, or from beyond the window: the ACK tells the peer
+        // where we are. The FIN again in TIME-WAIT means our ACK was lost,
+        // TIME-WAIT starts over.
+        if (conn->state == TCP_TIME_WAIT && (mdata->flags & TCP_FLAG_FIN))
+        {
+            conn->rto_since = self->now;
+        }
+        _send(self, conn, conn->snd_nxt, TCP_FLAG_ACK, 0, output, context);
+        self->stats.dropped += 1;
+        return -EINVAL;
+    }
+    if (!(mdata->flags & TCP_FLAG_ACK))
+    {
+        self->stats.dropped += 1;
+        return -EINVAL;
+    }
+
+    uint8_t events  = 0;
+    bool    ack_now = false;
+    if (conn->state == TCP_SYN_RECEIVED)
+    {
+        if (mdata->ack_num != conn->iss + 1)
+        {
+            _send_reset(self, mdata, output, context);
+            self->stats.dropped += 1;
+            return -EINVAL;
+        }
+        conn->state = TCP_ESTABLISHED;
+        events |= EVENT_BIT_CONNECTED;
+    }
+    if (conn->state == TCP_TIME_WAIT)
+    {
+        // The FIN again: our ACK was lost, TIME-WAIT starts over
+        if (mdata->flags & TCP_FLAG_FIN)
+        {
+            conn->rto_since = self->now;
+            _send(self, conn, conn->snd_nxt, TCP_FLAG_ACK, 0, output, context);
+        }
+        return 0;
+    }
+    if (!_input_ack(self, conn, mdata, &events, output, context))
+    {
+        self->stats.dropped += 1;
+        return -EINVAL;
+    }
+
+    if (mdata->payload_size > 0 || (mdata->flags & TCP_FLAG_FIN))
+    {
+        if (conn->state == TCP_ESTABLISHED || conn->state == TCP_FIN_WAIT_1
+            || conn->state == TCP_FIN_WAIT_2)
+        {
+            _input_data(self, conn, mdata, &events, &ack_now);
+        }
+        else if (conn->state == TCP_CLOSE_WAIT || conn->state == TCP_CLOSING
+                 || conn->state == TCP_LAST_ACK)
+        {
+            // Nothing is accepted past the FIN of the peer: a segment sent
+            // again means it missed our ACK
+            conn->ack_pending += 1;
+            ack_now = true;
+        }
+    }
+    _finish(self, conn, events, ack_now, output, context);
+    return 0;
+}
+
+/* ========================================================================== */
+
+/* PUBLIC */
+
+/* ========================================================================== */
+
+int8_t tcp_table_init(struct tcp_table* self)
+{
+    if (self == NULL || self->conns == NULL || self->listeners == NULL
+        || self->tx_frame == NULL)
+    {
+        return -EFAULT;
+    }
+    if (self->conn_count == 0 || self->listener_count == 0
+        || self->tx_frame_size <= TCP_CONN_HEADROOM + TCP_HEADER_SIZE + 4
+        || self->rto_min == 0 || self->rto_min > self->rto_max)
+    {
+        return -EINVAL;
+    }
+    for (uint8_t i = 0; i < self->conn_count; i++)
+    {
+        const struct tcp_conn* conn = &self->conns[i];
+        if (conn->rx_buffer == NULL || conn->tx_buffer == NULL)
+        {
+            return -EFAULT;
+        }
+        if (conn->rx_size == 0 || conn->tx_size == 0)
+        {
+            return -EINVAL;
+        }
+    }
+
+    for (uint8_t i = 0; i < self->conn_count; i++)
+    {
+        self->conns[i].state = TCP_CLOSED;
+    }
+    for (uint8_t i = 0; i < self->listener_count; i++)
+    {
+        self->listeners[i] = NULL;
+    }
+    self->tcp.lost_frames = 0;
+    self->now             = 0;
+    self->next_iss        = 0;
+    self->iss_secret      = (self->get_random != NULL) ? self->get_random() : 0;
+    self->next_port       = EPHEMERAL_PORT_FIRST;
+    self->stats           = (struct tcp_stats){0};
+    self->was_initialized = true;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t tcp_table_listen(struct tcp_table* self, struct tcp_listener* listener)
+{
+    if (self == NULL || listener == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    if (listener->handler == NULL)
+    {
+        return -EINVAL;
+    }
+    if (_find_listener(self, listener->port) != NULL)
+    {
+        return -EADDRINUSE;
+    }
+
+    for (uint8_t i = 0; i < self->listener_count; i++)
+    {
+        if (self->listeners[i] == NULL)
+        {
+            self->listeners[i] = listener;
+            return 0;
+        }
+    }
+    return -ENOSPC;
+}
+
+/* ========================================================================== */
+
+int8_t
+tcp_table_unlisten(struct tcp_table* self, struct tcp_listener* listener)
+{
+    if (self == NULL || listener == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+
+    for (uint8_t i = 0; i < self->listener_count; i++)
+    {
+        if (self->listeners[i] == listener)
+        {
+            self->listeners[i] = NULL;
+            return 0;
+        }
+    }
+    return -ENOENT;
+}
+
+/* ========================================================================== */
+
+int8_t tcp_table_input(
+    struct tcp_table*             self,
+    const struct tcp_rx_metadata* mdata,
+    tcp_output_t                  output,
+    void*                         context)
+{
+    if (self == NULL || mdata == NULL || output == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    self->stats.segments_received += 1;
+
+    struct tcp_conn* conn = _find(self, mdata);
+    if (conn == NULL)
+    {
+        return _input_listen(self, mdata, output, context);
+    }
+    if (conn->state == TCP_SYN_SENT)
+    {
+        return _input_syn_sent(self, conn, mdata, output, context);
+    }
+    return _input_synchronized(self, conn, mdata, output, context);
+}
+
+/* ========================================================================== */
+
+int8_t tcp_table_poll(
+    struct tcp_table* self, uint32_t now, tcp_output_t output, void* context)
+{
+    if (self == NULL || output == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    self->now = now;
+
+    for (uint8_t i = 0; i < self->conn_count; i++)
+    {
+        struct tcp_conn* conn = &self->conns[i];
+        if (conn->state == TCP_TIME_WAIT)
+        {
+            if (_elapsed(now, conn->rto_since) >= self->time_wait)
+            {
+                conn->state = TCP_CLOSED;
+            }
+            continue;
+        }
+        if (conn->state == TCP_CLOSED)
+        {
+            continue;
+        }
+
+        if (conn->ack_pending > 0
+            && _elapsed(now, conn->ack_since) >= self->ack_delay)
+        {
+            _send(self, conn, conn->snd_nxt, TCP_FLAG_ACK, 0, output, context);
+        }
+        if (conn->rto_armed && _elapsed(now, conn->rto_since) >= conn->rto)
+        {
+            _on_rto(self, conn, output, context);
+        }
+    }
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t tcp_table_connect(
+    struct tcp_table*          self,
+    const uint8_t*             local_ip,
+    const struct tcp_endpoint* to,
+    tcp_handler_t              handler,
+    void*                      handler_context,
+    tcp_output_t               output,
+    void*                      context,
+    struct tcp_conn**          conn)
+{
+    if (self == NULL || local_ip == NULL || to == NULL || handler == NULL
+        || output == NULL || conn == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+
+    // Next ephemeral port, skipping the ones in use
+    uint16_t port = 0;
+    for (uint8_t tries = 0; tries <= self->conn_count && port == 0; tries++)
+    {
+        port = self->next_port;
+        self->next_port
+            = (port == UINT16_MAX) ? EPHEMERAL_PORT_FIRST : port + 1;
+        for (uint8_t i = 0; i < self->conn_count; i++)
+        {
+            if (self->conns[i].state != TCP_CLOSED
+                && self->conns[i].local_port == port)
+            {
+                port = 0;
+                break;
+            }
+        }
+    }
+
+    struct tcp_conn* opened
+        = _open(self, local_ip, to->ip_addr, port, to->port);
+    if (opened == NULL)
+    {
+        return -ENOSPC;
+    }
+    opened->state   = TCP_SYN_SENT;
+    opened->handler = handler;
+    opened->context = handler_context;
+
+    _start_rtt(self, opened);
+    opened->rtt_seq += 1;
+    _send(self, opened, opened->iss, TCP_FLAG_SYN, 0, output, context);
+    opened->snd_nxt = opened->iss + 1;
+    opened->snd_max = opened->snd_nxt;
+    _arm_rto(self, opened);
+    *conn = opened;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t tcp_table_send(
+    struct tcp_table* self,
+    struct tcp_conn*  conn,
+    uint16_t          size,
+    tcp_output_t      output,
+    void*             context)
+{
+    if (self == NULL || conn == NULL || output == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    if (conn->state != TCP_ESTABLISHED && conn->state != TCP_CLOSE_WAIT)
+    {
+        return -ENOTCONN;
+    }
+    if (size > conn->tx_size - conn->tx_used)
+    {
+        return -EINVAL;
+    }
+
+    conn->tx_used += size;
+    _send_pending(self, conn, false, output, context);
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t tcp_table_consume(
+    struct tcp_table* self,
+    struct tcp_conn*  conn,
+    uint16_t          size,
+    tcp_output_t      output,
+    void*             context)
+{
+    if (self == NULL || conn == NULL || output == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    if (conn->state == TCP_CLOSED)
+    {
+        return -ENOTCONN;
+    }
+    if (size > conn->rx_used)
+    {
+        return -EINVAL;
+    }
+
+    conn->rx_head = _ring_index(conn->rx_head, size, conn->rx_size);
+    conn->rx_used -= size;
+
+    // Tell the peer once the window grew by a segment or half the buffer, not
+    // byte by byte (receiver side of the silly window avoidance, RFC 1122)
+    uint16_t threshold = _min(conn->snd_mss, conn->rx_size / 2);
+    uint32_t growth    = conn->rcv_nxt + _rx_free(conn) - conn->rcv_adv;
+    if (conn->state != TCP_SYN_SENT && conn->state != TCP_SYN_RECEIVED
+        && conn->state != TCP_TIME_WAIT && (int32_t)growth >= threshold)
+    {
+        _send(self, conn, conn->snd_nxt, TCP_FLAG_ACK, 0, output, context);
+    }
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t tcp_table_close(
+    struct tcp_table* self,
+    struct tcp_conn*  conn,
+    tcp_output_t      output,
+    void*             context)
+{
+    if (self == NULL || conn == NULL || output == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+
+    switch (conn->state)
+    {
+        case TCP_SYN_SENT:
+        case TCP_SYN_RECEIVED:
+        {
+            // Nothing was exchanged yet: no need for a graceful close
+            _reset(self, conn, output, context);
+            return 0;
+        }
+        case TCP_ESTABLISHED:
+        {
+            conn->state = TCP_FIN_WAIT_1;
+            break;
+        }
+        case TCP_CLOSE_WAIT:
+        {
+            conn->state = TCP_LAST_ACK;
+            break;
+        }
+        default:
+        {
+            return -ENOTCONN;
+        }
+    }
+    _send_pending(self, conn, false, output, context);
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t tcp_table_abort(
+    struct tcp_table* self,
+    struct tcp_conn*  conn,
+    tcp_output_t      output,
+    void*             context)
+{
+    if (self == NULL || conn == NULL || output == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    if (conn->state == TCP_CLOSED)
+    {
+        return -ENOTCONN;
+    }
+
+    if (conn->state == TCP_TIME_WAIT)
+    {
+        conn->state = TCP_CLOSED;
+        return 0;
+    }
+    _reset(self, conn, output, context);
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t
+tcp_table_get_stats(const struct tcp_table* self, struct tcp_stats* stats)
+{
+    if (self == NULL || stats == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    *stats = self->stats;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t
+tcp_conn_tx_window(struct tcp_conn* self, uint8_t** data, uint16_t* size)
+{
+    if (self == NULL || data == NULL || size == NULL)
+    {
+        return -EFAULT;
+    }
+
+    uint16_t tail = _ring_index(self->tx_head, self->tx_used, self->tx_size);
+    *data         = self->tx_buffer + tail;
+    *size         = _min(self->tx_size - self->tx_used, self->tx_size - tail);
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t tcp_conn_rx_window(
+    const struct tcp_conn* self, const uint8_t** data, uint16_t* size)
+{
+    if (self == NULL || data == NULL || size == NULL)
+    {
+        return -EFAULT;
+    }
+
+    *data = self->rx_buffer + self->rx_head;
+    *size = _min(self->rx_used, self->rx_size - self->rx_head);
+    return 0;
+}
+
+/* ========================================================================== */
+
+enum tcp_state tcp_conn_get_state(const struct tcp_conn* self)
+{
+    return (self == NULL) ? TCP_CLOSED : self->state;
+}
+
+/* ========================================================================== */
@@ -58,12 +58,30 @@ int8_t udp_process_frame(
         return -EFAULT;
     }
 
-    if (compute_udp_checksum(
-            mdata->ip_mdata->src_ip,
-            mdata->ip_mdata->dest_ip,
-            rx_frame,
-            rx_frame_size)
-        != 0)
+    if (rx_frame_size < UDP_HEADER_SIZE)
+    {
+        self->lost_frames += 1;
+        return -EINVAL;
+    }
+
+    uint16_t udp_len = (uint16_t)(rx_frame[UDP_LENGTH_FRAME_OFST] << 8)
+                       | rx_frame[UDP_LENGTH_FRAME_OFST + 1];
+    if (udp_len < UDP_HEADER_SIZE || udp_len > rx_frame_size)
+    {
+        self->lost_frames += 1;
+        return -EINVAL;
+    }
+
+    /* A zero checksum means the sender did not compute one (RFC 768) */
+    bool has_checksum = rx_frame[UDP_CHECKSUM_FRAME_OFST] != 0
+                        || rx_frame[UDP_CHECKSUM_FRAME_OFST + 1] != 0;
+    if (has_checksum
+        && compute_udp_checksum(
+               mdata->ip_mdata->src_ip,
+               mdata->ip_mdata->dest_ip,
+               rx_frame,
+               udp_len)
+               != 0)
     {
         self->lost_frames += 1;
         return -EINVAL;
@@ -74,7 +92,7 @@ int8_t udp_process_frame(
     mdata->dest_port_num = (uint16_t)((rx_frame[UDP_DEST_PORT_FRAME_OFST]) << 8)
                            | (rx_frame[UDP_DEST_PORT_FRAME_OFST + 1]);
     mdata->payload      = rx_frame + UDP_PAYLOAD_FRAME_OFST;
-    mdata->payload_size = rx_frame[UDP_LENGTH_FRAME_OFST] - UDP_HEADER_SIZE;
+    mdata->payload_size = udp_len - UDP_HEADER_SIZE;
     return 0;
 }
 
@@ -0,0 +1,286 @@
+#include "../inc/udp_socket.h"
+
+/* ========================================================================== */
+
+#include "../../inc/errno.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/* ========================================================================== */
+
+/* PRIVATE */
+
+/* ========================================================================== */
+
+/* 2^16 / golden ratio: Fibonacci hashing spreads consecutive ports */
+static const uint16_t PORT_HASH_MULTIPLIER = 40503u;
+
+static uint16_t _slot_of(const struct udp_table* self, uint16_t port)
+{
+    // In 32 bits: promoted to int, the product overflows from port 53021 on
+    return (uint16_t)((uint32_t)port * PORT_HASH_MULTIPLIER) >> self->shift;
+}
+
+/**
+ * @brief Find the slot holding a port, or the empty slot ending its probe
+ * sequence.
+ */
+static uint16_t _probe(const struct udp_table* self, uint16_t port)
+{
+    uint16_t mask = self->capacity - 1;
+    uint16_t slot = _slot_of(self, port);
+    while (self->slots[slot] != NULL && self->slots[slot]->port != port)
+    {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/**
+ * @brief Drop bytes from the front of the queue.
+ */
+static void _discard(struct ring_buffer* queue, size_t size)
+{
+    uint8_t discard;
+    for (size_t i = 0; i < size; i++)
+    {
+        ring_buffer_pop(queue, &discard, 1);
+    }
+}
+
+/* ========================================================================== */
+
+/* PUBLIC */
+
+/* ========================================================================== */
+
+int8_t udp_table_init(struct udp_table* self)
+{
+    if (self == NULL || self->slots == NULL)
+    {
+        return -EFAULT;
+    }
+    if (self->capacity < 2 || (self->capacity & (self->capacity - 1)) != 0)
+    {
+        return -EINVAL;
+    }
+
+    uint8_t bits = 0;
+    while ((1u << bits) < self->capacity)
+    {
+        bits += 1;
+    }
+    memset(self->slots, 0, self->capacity * sizeof(self->slots[0]));
+    self->shift           = (uint8_t)(16 - bits);
+    self->count           = 0;
+    self->was_initialized = true;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t udp_table_bind(struct udp_table* self, struct udp_socket* socket)
+{
+    if (self == NULL || socket == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    if (socket->handler == NULL && socket->rx_queue == NULL)
+    {
+        return -EINVAL;
+    }
+
+    uint16_t slot = _probe(self, socket->port);
+    if (self->slots[slot] != NULL)
+    {
+        return -EADDRINUSE;
+    }
+    if ((uint32_t)(self->count + 1) * 4 > (uint32_t)self->capacity * 3)
+    {
+        return -ENOSPC;
+    }
+
+    socket->received  = 0;
+    socket->dropped   = 0;
+    self->slots[slot] = socket;
+    self->count += 1;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t udp_table_unbind(struct udp_table* self, struct udp_socket* socket)
+{
+    if (self == NULL || socket == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+
+    uint16_t hole = _probe(self, socket->port);
+    if (self->slots[hole] != socket)
+    {
+        return -ENOENT;
+    }
+
+    // Backward shift: move up the entries whose probe sequence crosses the
+    // hole, so lookups never need tombstones
+    uint16_t mask = self->capacity - 1;
+    uint16_t next = hole;
+    while (true)
+    {
+        next = (next + 1) & mask;
+        if (self->slots[next] == NULL)
+        {
+            break;
+        }
+        uint16_t home = _slot_of(self, self->slots[next]->port);
+        bool     stays_after_hole
+            = (hole <= next) ? (hole < home && home <= next)
+                             : (hole < home || home <= next);
+        if (!stays_after_hole)
+        {
+            self->slots[hole] = self->slots[next];
+            hole              = next;
+        }
+    }
+    self->slots[hole] = NULL;
+    self->count -= 1;
+    return 0;
+}
+
+/* ========================================================================== */
+
+struct udp_socket* udp_table_lookup(const struct udp_table* self, uint16_t port)
+{
+    if (self == NULL || !self->was_initialized)
+    {
+        return NULL;
+    }
+    return self->slots[_probe(self, port)];
+}
+
+/* ========================================================================== */
+
+int8_t udp_socket_deliver(
+    struct udp_socket* self, const struct udp_rx_metadata* mdata)
+{
+    if (self == NULL || mdata == NULL)
+    {
+        return -EFAULT;
+    }
+
+    if (self->handler != NULL)
+    {
+        self->handler(self->context, mdata);
+        self->received += 1;
+        return 0;
+    }
+
+    size_t available = 0;
+    ring_buffer_available(self->rx_queue, &available);
+    // The ring buffer keeps one byte free to tell full from empty
+    if (available < 1u + UDP_SOCKET_RECORD_HEADER_SIZE + mdata->payload_size)
+    {
+        self->dropped += 1;
+        return -ENOSPC;
+    }
+
+    uint8_t header[UDP_SOCKET_RECORD_HEADER_SIZE] = {
+        (uint8_t)(mdata->payload_size >> 8),
+        (uint8_t)(mdata->payload_size),
+        mdata->ip_mdata->src_ip[0],
+        mdata->ip_mdata->src_ip[1],
+        mdata->ip_mdata->src_ip[2],
+        mdata->ip_mdata->src_ip[3],
+        (uint8_t)(mdata->src_port_num >> 8),
+        (uint8_t)(mdata->src_port_num),
+    };
+    ring_buffer_push(self->rx_queue, header, sizeof(header));
+    if (mdata->payload_size > 0)
+    {
+        ring_buffer_push(self->rx_queue, mdata->payload, mdata->payload_size);
+    }
+    self->received += 1;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t udp_socket_receive(
+    struct udp_socket*   self,
+    uint8_t*             buffer,
+    uint16_t             size,
+    uint16_t*            received,
+    struct udp_endpoint* from)
+{
+    if (self == NULL || buffer == NULL || received == NULL)
+    {
+        return -EFAULT;
+    }
+    if (self->rx_queue == NULL)
+    {
+        return -ENOTSUP;
+    }
+
+    // Only take a record once the producer has pushed all of it
+    uint8_t header[UDP_SOCKET_RECORD_HEADER_SIZE];
+    size_t  count = 0;
+    ring_buffer_count(self->rx_queue, &count);
+    if (count < sizeof(header)
+        || ring_buffer_peek(self->rx_queue, header, sizeof(header)) != 0)
+    {
+        return -ENODATA;
+    }
+    uint16_t length = (uint16_t)((header[0] << 8) | header[1]);
+    if (count < sizeof(header) + length)
+    {
+        return -ENODATA;
+    }
+
+    ring_buffer_pop(self->rx_queue, header, sizeof(header));
+    uint16_t copied = (length > size) ? size : length;
+    if (copied > 0)
+    {
+        ring_buffer_pop(self->rx_queue, buffer, copied);
+    }
+    _discard(self->rx_queue, length - copied);
+
+    if (from != NULL)
+    {
+        memcpy(from->ip_addr, &header[2], 4);
+        from->port = (uint16_t)((header[6] << 8) | header[7]);
+    }
+    *received = copied;
+    return (copied < length) ? -EMSGSIZE : 0;
+}
+
+/* ========================================================================== */
+
+int8_t udp_socket_get_stats(
+    const struct udp_socket* self, uint32_t* received, uint32_t* dropped)
+{
+    if (self == NULL)
+    {
+        return -EFAULT;
+    }
+    if (received != NULL)
+    {
+        *received = self->received;
+    }
+    if (dropped != NULL)
+    {
+        *dropped = self->dropped;
+    }
+    return 0;
+}
+
+/* ========================================================================== */
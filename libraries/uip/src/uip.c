@@ -0,0 +1,983 @@
+#include "../inc/uip.h"
+
+/* ========================================================================== */
+
+#include "../../inc/errno.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/* ========================================================================== */
+
+/* PRIVATE */
+
+/* ========================================================================== */
+
+static const uint8_t ICMP_ECHO_REPLY_TYPE   = 0;
+static const uint8_t ICMP_ECHO_REQUEST_TYPE = 8;
+
+static const uint8_t IP_BROADCAST_ADDR[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+static const uint8_t IP_ANY_ADDR[4]       = {0x00, 0x00, 0x00, 0x00};
+
+static const uint8_t ETH_BROADCAST_ADDR[6]
+    = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+/* Within the IP header */
+static const uint8_t IP_DEST_ADDR_FRAME_OFST = 16;
+
+/* Each frame waiting in tx_queue: [LEN (2)][FRAME (LEN)] */
+static const uint8_t TX_RECORD_HEADER_SIZE = 2;
+
+static const uint8_t ETH_FCS_SIZE = 4;
+
+/**
+ * @brief Count a frame that was not handled and pass its status on.
+ */
+static int8_t _drop(struct uip* self, int8_t status)
+{
+    self->stats.dropped += 1;
+    return status;
+}
+
+/**
+ * @brief Turn the received frame around: the Ethernet header is rewritten to
+ * go back to the sender, then the frame is sent.
+ */
+static int8_t _reply(
+    struct uip*                   self,
+    const struct eth_rx_metadata* eth_mdata,
+    enum eth_payload_type         payload_type,
+    uint8_t*                      frame,
+    uint16_t                      payload_size)
+{
+    struct eth_tx_metadata tx_mdata = {
+        .payload_type = payload_type,
+        .payload      = frame + ETH_HEADER_SIZE,
+        .payload_size = payload_size,
+    };
+    memcpy(tx_mdata.dest_mac_addr, eth_mdata->src_mac_addr, 6);
+
+    uint16_t size   = 0;
+    int8_t   status = eth_build_frame(&self->eth, &tx_mdata, frame, &size);
+    if (status == 0)
+    {
+        status = self->send(self->send_context, frame, size);
+    }
+    return status;
+}
+
+/**
+ * @brief Fill in the Ethernet header of an outgoing IPv4 frame and send it.
+ */
+static int8_t _send_to(
+    struct uip* self, const uint8_t* mac_addr, uint8_t* frame, uint16_t size)
+{
+    struct eth_tx_metadata tx_mdata = {
+        .payload_type = ETH_PLD_IPV4,
+        .payload      = frame + ETH_HEADER_SIZE,
+        .payload_size = size - ETH_HEADER_SIZE,
+    };
+    memcpy(tx_mdata.dest_mac_addr, mac_addr, 6);
+
+    int8_t status = eth_build_frame(&self->eth, &tx_mdata, frame, &size);
+    if (status == 0)
+    {
+        status = self->send(self->send_context, frame, size);
+    }
+    if (status == 0)
+    {
+        self->stats.tx_frames += 1;
+    }
+    else
+    {
+        self->stats.tx_dropped += 1;
+    }
+    return status;
+}
+
+/**
+ * @brief Broadcast an ARP request for ip_addr. Asking for the own address
+ * makes it a gratuitous ARP.
+ */
+static int8_t _send_arp_request(struct uip* self, const uint8_t* ip_addr)
+{
+    uint8_t                frame[64];
+    uint8_t                arp_size  = 0;
+    struct arp_tx_metadata arp_mdata = {.op_type = ARP_REQUEST};
+    memcpy(arp_mdata.dest_ip_addr, ip_addr, 4);
+    int8_t status = arp_build_frame(
+        &self->arp, &arp_mdata, frame + ETH_HEADER_SIZE, &arp_size);
+    if (status != 0)
+    {
+        return status;
+    }
+
+    struct eth_tx_metadata eth_mdata = {
+        .payload_type = ETH_PLD_ARP,
+        .payload      = frame + ETH_HEADER_SIZE,
+        .payload_size = arp_size,
+    };
+    memcpy(eth_mdata.dest_mac_addr, ETH_BROADCAST_ADDR, 6);
+    uint16_t size = 0;
+    status        = eth_build_frame(&self->eth, &eth_mdata, frame, &size);
+    if (status == 0)
+    {
+        status = self->send(self->send_context, frame, size);
+    }
+    if (status == 0)
+    {
+        self->stats.arp_requests += 1;
+    }
+    return status;
+}
+
+/**
+ * @brief Keep an outgoing frame in tx_queue until its destination resolves.
+ */
+static int8_t _enqueue(struct uip* self, const uint8_t* frame, uint16_t size)
+{
+    if (self->tx_queue == NULL
+        || self->tx_queue_size - self->tx_queue_used
+               < TX_RECORD_HEADER_SIZE + size)
+    {
+        return -ENOSPC;
+    }
+
+    uint8_t* record = self->tx_queue + self->tx_queue_used;
+    record[0]       = (uint8_t)(size >> 8);
+    record[1]       = (uint8_t)(size);
+    memcpy(record + TX_RECORD_HEADER_SIZE, frame, size);
+    self->tx_queue_used += TX_RECORD_HEADER_SIZE + size;
+    self->stats.tx_queued += 1;
+    return 0;
+}
+
+/**
+ * @brief Take the frames queued for ip_addr out of tx_queue: send them to
+ * mac_addr, or drop them if mac_addr is NULL. Other frames keep their order.
+ */
+static void _release_queued(
+    struct uip* self, const uint8_t* ip_addr, const uint8_t* mac_addr)
+{
+    uint16_t offset = 0;
+    while (offset < self->tx_queue_used)
+    {
+        uint8_t* record      = self->tx_queue + offset;
+        uint8_t* frame       = record + TX_RECORD_HEADER_SIZE;
+        uint16_t size        = (uint16_t)((record[0] << 8) | record[1]);
+        uint16_t record_size = TX_RECORD_HEADER_SIZE + size;
+        if (memcmp(frame + IP_FRAME_OFST + IP_DEST_ADDR_FRAME_OFST, ip_addr, 4))
+        {
+            offset += record_size;
+            continue;
+        }
+
+        if (mac_addr != NULL)
+        {
+            _send_to(self, mac_addr, frame, size);
+        }
+        else
+        {
+            self->stats.tx_dropped += 1;
+        }
+        memmove(
+            record,
+            record + record_size,
+            self->tx_queue_used - offset - record_size);
+        self->tx_queue_used -= record_size;
+    }
+}
+
+/**
+ * @brief Record the sender of a received frame in the ARP cache, then send
+ * the frames that were waiting for it.
+ */
+static void _learn(
+    struct uip*    self,
+    const uint8_t* ip_addr,
+    const uint8_t* mac_addr,
+    bool           insert)
+{
+    if (self->arp_cache == NULL || !memcmp(ip_addr, IP_ANY_ADDR, 4)
+        || !memcmp(ip_addr, self->ip_addr, 4) || (mac_addr[0] & 0x01) != 0)
+    {
+        return;
+    }
+    if (arp_cache_update(self->arp_cache, ip_addr, mac_addr, insert) == 0)
+    {
+        _release_queued(self, ip_addr, mac_addr);
+    }
+}
+
+/**
+ * @brief Act on the ARP cache aging: retry requests, drop the frames queued
+ * for an address that never answered.
+ */
+static void _on_arp_event(
+    void* context, enum arp_cache_event event, const uint8_t* ip_addr)
+{
+    struct uip* self = context;
+    if (event == ARP_CACHE_SEND_REQUEST)
+    {
+        _send_arp_request(self, ip_addr);
+    }
+    else
+    {
+        _release_queued(self, ip_addr, NULL);
+    }
+}
+
+/**
+ * @brief Learn the sender of an ARP packet and answer it if it is a request
+ * for this node, in place.
+ */
+static int8_t _input_arp(
+    struct uip*                   self,
+    const struct eth_rx_metadata* eth_mdata,
+    uint8_t*                      frame)
+{
+    struct arp_rx_metadata rx_mdata;
+    uint8_t                size = (eth_mdata->payload_size > UINT8_MAX)
+                                      ? UINT8_MAX
+                                      : (uint8_t)eth_mdata->payload_size;
+    int8_t                 status
+        = arp_process_frame(&self->arp, eth_mdata->payload, size, &rx_mdata);
+    if (status != 0)
+    {
+        return status;
+    }
+    // RFC 826: always learn a sender talking to this node, otherwise only
+    // refresh a peer already known
+    bool for_me = !memcmp(rx_mdata.dest_ip_addr, self->ip_addr, 4);
+    if (rx_mdata.op_type == ARP_REQUEST || rx_mdata.op_type == ARP_REPLY)
+    {
+        _learn(self, rx_mdata.src_ip_addr, rx_mdata.src_mac_addr, for_me);
+    }
+    if (!arp_is_request_for_me(&self->arp, &rx_mdata))
+    {
+        return (for_me && rx_mdata.op_type == ARP_REPLY) ? 0 : -ENOENT;
+    }
+
+    struct arp_tx_metadata tx_mdata = {.op_type = ARP_REPLY};
+    memcpy(tx_mdata.dest_ip_addr, rx_mdata.src_ip_addr, 4);
+    memcpy(tx_mdata.dest_mac_addr, rx_mdata.src_mac_addr, 6);
+    status = arp_build_frame(
+        &self->arp, &tx_mdata, frame + ETH_HEADER_SIZE, &size);
+    if (status == 0)
+    {
+        status = _reply(self, eth_mdata, ETH_PLD_ARP, frame, size);
+    }
+    if (status == 0)
+    {
+        self->stats.arp_replies += 1;
+    }
+    return status;
+}
+
+/**
+ * @brief Answer an ICMP echo request, in place: the payload stays where it
+ * is and the ICMP, IP and Ethernet headers are rewritten around it.
+ */
+static int8_t _input_icmp(
+    struct uip*                   self,
+    const struct eth_rx_metadata* eth_mdata,
+    const struct ip_rx_metadata*  ip_mdata,
+    uint8_t*                      frame)
+{
+    struct icmp_rx_metadata rx_mdata;
+    int8_t                  status = icmp_process_frame(
+        &self->icmp, ip_mdata->payload, ip_mdata->payload_size, &rx_mdata);
+    if (status != 0)
+    {
+        return status;
+    }
+    if (rx_mdata.type != ICMP_ECHO_REQUEST_TYPE)
+    {
+        return -ENOTSUP;
+    }
+    // The reply header has no options: the payload must follow a bare header
+    if (ip_mdata->payload != frame + ETH_HEADER_SIZE + IP_HEADER_SIZE)
+    {
+        return -ENOTSUP;
+    }
+
+    uint8_t*                ip_frame   = frame + ETH_HEADER_SIZE;
+    uint16_t                size       = 0;
+    struct icmp_tx_metadata icmp_mdata = {
+        .type         = ICMP_ECHO_REPLY_TYPE,
+        .code         = 0,
+        .id           = rx_mdata.id,
+        .seq_num      = rx_mdata.seq_num,
+        .payload      = rx_mdata.payload,
+        .payload_size = rx_mdata.payload_size,
+    };
+    status = icmp_build_frame(
+        &self->icmp, &icmp_mdata, ip_frame + IP_HEADER_SIZE, &size);
+    if (status != 0)
+    {
+        return status;
+    }
+
+    struct ip_tx_metadata ip_tx_mdata = {
+        .version       = IP_VER_4,
+        .pld_prot_type = IP_PLD_ICMP,
+        .payload       = ip_frame + IP_HEADER_SIZE,
+        .payload_size  = size,
+    };
+    memcpy(ip_tx_mdata.dest_ip, ip_mdata->src_ip, 4);
+    memcpy(ip_tx_mdata.src_ip, self->ip_addr, 4);
+    status = ip_build_frame(&self->ip, &ip_tx_mdata, ip_frame, &size);
+    if (status == 0)
+    {
+        status = _reply(self, eth_mdata, ETH_PLD_IPV4, frame, size);
+    }
+    if (status == 0)
+    {
+        self->stats.icmp_echo_replies += 1;
+    }
+    return status;
+}
+
+/**
+ * @brief Deliver a UDP datagram to the socket bound to its destination port.
+ */
+static int8_t _input_udp(struct uip* self, struct ip_rx_metadata* ip_mdata)
+{
+    struct udp_rx_metadata rx_mdata = {.ip_mdata = ip_mdata};
+    int8_t                 status   = udp_process_frame(
+        &self->udp, ip_mdata->payload, ip_mdata->payload_size, &rx_mdata);
+    if (status != 0)
+    {
+        return status;
+    }
+
+    struct udp_socket* socket
+        = udp_table_lookup(self->udp_table, rx_mdata.dest_port_num);
+    if (socket == NULL)
+    {
+        return -ENOENT;
+    }
+    status = udp_socket_deliver(socket, &rx_mdata);
+    if (status == 0)
+    {
+        self->stats.udp_delivered += 1;
+    }
+    return status;
+}
+
+/**
+ * @brief Send a segment built by tcp_table: the IPv4 header goes in front of
+ * it, then the frame goes through uip_output().
+ */
+static int8_t
+_output_tcp(void* context, struct ip_tx_metadata* ip_mdata, uint8_t* frame)
+{
+    struct uip* self = context;
+    uint16_t    size = 0;
+    ip_mdata->id     = self->ip_id++;
+    int8_t status    = ip_build_frame(
+        &self->ip, ip_mdata, frame + ETH_HEADER_SIZE, &size);
+    if (status == 0)
+    {
+        status = uip_output(self, frame, ETH_HEADER_SIZE + size);
+    }
+    // A segment waiting for ARP is as good as sent
+    return (status == -EINPROGRESS) ? 0 : status;
+}
+
+/**
+ * @brief Hand a TCP segment to the state machine of its connection.
+ */
+static int8_t _input_tcp(struct uip* self, struct ip_rx_metadata* ip_mdata)
+{
+    if (self->tcp_table == NULL)
+    {
+        return -ENOTSUP;
+    }
+    struct tcp_rx_metadata rx_mdata = {.ip_mdata = ip_mdata};
+    int8_t                 status   = tcp_process_frame(
+        &self->tcp, ip_mdata->payload, ip_mdata->payload_size, &rx_mdata);
+    if (status != 0)
+    {
+        return status;
+    }
+    status = tcp_table_input(self->tcp_table, &rx_mdata, _output_tcp, self);
+    if (status == 0)
+    {
+        self->stats.tcp_segments += 1;
+    }
+    return status;
+}
+
+/**
+ * @brief Check an IPv4 packet against the frame holding it, then hand its
+ * payload to ICMP, UDP or TCP.
+ */
+static int8_t _input_ip(
+    struct uip*                   self,
+    const struct eth_rx_metadata* eth_mdata,
+    uint8_t*                      frame)
+{
+    struct ip_rx_metadata ip_mdata;
+    int8_t                status = ip_process_frame(
+        &self->ip, eth_mdata->payload, eth_mdata->payload_size, &ip_mdata);
+    // A malformed header never gets here: the payload lies within the frame
+    if (status != 0)
+    {
+        return status;
+    }
+
+    bool is_broadcast = !memcmp(ip_mdata.dest_ip, IP_BROADCAST_ADDR, 4);
+    if (!is_broadcast && !ip_is_pkt_for_me(&self->ip, &ip_mdata))
+    {
+        return -ENOENT;
+    }
+
+    // Whoever sends to this node will likely get an answer: learn its MAC
+    // now so the answer does not wait for ARP
+    if (!is_broadcast)
+    {
+        _learn(self, ip_mdata.src_ip, eth_mdata->src_mac_addr, true);
+    }
+
+    // A fragment is held until its datagram is whole, then the datagram goes
+    // on from the reassembly buffer
+    if (ip_mdata.more_fragments || ip_mdata.frag_offset != 0)
+    {
+        if (self->ip_reasm == NULL)
+        {
+            return -ENOTSUP;
+        }
+        status = ip_reasm_add(self->ip_reasm, &ip_mdata);
+        if (status != 0)
+        {
+            return (status == -EINPROGRESS) ? 0 : status;
+        }
+    }
+
+    switch (ip_mdata.pld_prot_type)
+    {
+        case IP_PLD_ICMP:
+        {
+            // Echo requests sent to the broadcast address are not answered
+            if (is_broadcast)
+            {
+                return -ENOENT;
+            }
+            return _input_icmp(self, eth_mdata, &ip_mdata, frame);
+        }
+        case IP_PLD_UDP:
+        {
+            return _input_udp(self, &ip_mdata);
+        }
+        case IP_PLD_TCP:
+        {
+            // TCP is unicast only
+            if (is_broadcast)
+            {
+                return -ENOENT;
+            }
+            return _input_tcp(self, &ip_mdata);
+        }
+        default:
+        {
+            return -ENOTSUP;
+        }
+    }
+}
+
+/**
+ * @brief Send a UDP datagram larger than IP_MTU as IPv4 fragments. Each
+ * fragment gets its Ethernet and IP headers written over the tail of the
+ * previous slice of the payload, which is saved and restored around the send.
+ */
+static int8_t _output_fragments(
+    struct uip* self, struct ip_tx_metadata* ip_mdata, uint8_t* frame)
+{
+    const uint8_t* payload = ip_mdata->payload;
+    uint16_t       total   = ip_mdata->payload_size;
+    uint16_t       offset  = 0;
+    bool           queued  = false;
+    int8_t         status  = 0;
+    uint8_t        saved[ETH_HEADER_SIZE + IP_HEADER_SIZE];
+
+    ip_mdata->id = self->ip_id++;
+    while (offset < total && (status == 0 || status == -EINPROGRESS))
+    {
+        uint16_t slice = total - offset;
+        if (slice > IP_FRAG_PAYLOAD_SIZE)
+        {
+            slice = IP_FRAG_PAYLOAD_SIZE;
+        }
+        // The headers go right in front of the slice
+        uint8_t* header = frame + offset;
+        memcpy(saved, header, sizeof(saved));
+
+        uint16_t size            = 0;
+        ip_mdata->payload        = payload + offset;
+        ip_mdata->payload_size   = slice;
+        ip_mdata->frag_offset    = offset;
+        ip_mdata->more_fragments = offset + slice < total;
+        status                   = ip_build_frame(
+            &self->ip, ip_mdata, header + ETH_HEADER_SIZE, &size);
+        if (status == 0)
+        {
+            status = uip_output(self, header, ETH_HEADER_SIZE + size);
+        }
+        queued |= (status == -EINPROGRESS);
+
+        memcpy(header, saved, sizeof(saved));
+        offset += slice;
+    }
+    return (status == 0 && queued) ? -EINPROGRESS : status;
+}
+
+/**
+ * @brief Prepend the UDP, IPv4 and Ethernet headers to the payload of packet
+ * and send it. The IPv4 header comes from ip_template when given, except for
+ * fragments.
+ */
+static int8_t _output_udp(
+    struct uip*                      self,
+    struct pbuf*                     packet,
+    uint16_t                         src_port,
+    const struct udp_endpoint*       to,
+    const struct ip_header_template* ip_template)
+{
+    struct ip_tx_metadata ip_mdata = {
+        .version       = IP_VER_4,
+        .pld_prot_type = IP_PLD_UDP,
+    };
+    memcpy(ip_mdata.src_ip, self->ip_addr, 4);
+    memcpy(ip_mdata.dest_ip, to->ip_addr, 4);
+    struct udp_tx_metadata udp_mdata = {
+        .ip_mdata      = &ip_mdata,
+        .src_port_num  = src_port,
+        .dest_port_num = to->port,
+        .payload       = pbuf_data(packet),
+        .payload_size  = pbuf_length(packet),
+    };
+
+    // Each layer writes its header right in front of the one above
+    uint8_t* header = NULL;
+    uint16_t size   = 0;
+    int8_t   status = pbuf_push(packet, UDP_HEADER_SIZE, &header);
+    if (status == 0)
+    {
+        status = udp_build_frame(&self->udp, &udp_mdata, header, &size);
+    }
+    if (status != 0)
+    {
+        return status;
+    }
+    ip_mdata.payload      = header;
+    ip_mdata.payload_size = size;
+    status                = pbuf_push(packet, IP_HEADER_SIZE, &header);
+    if (status == 0)
+    {
+        status = pbuf_push(packet, ETH_HEADER_SIZE, &header);
+    }
+    if (status != 0)
+    {
+        return status;
+    }
+    if (ip_mdata.payload_size > IP_MTU - IP_HEADER_SIZE)
+    {
+        return _output_fragments(self, &ip_mdata, header);
+    }
+
+    uint16_t id = self->ip_id++;
+    if (ip_template != NULL)
+    {
+        status = ip_template_build(
+            ip_template, size, id, header + ETH_HEADER_SIZE, &size);
+    }
+    else
+    {
+        ip_mdata.id = id;
+        status      = ip_build_frame(
+            &self->ip, &ip_mdata, header + ETH_HEADER_SIZE, &size);
+    }
+    if (status != 0)
+    {
+        return status;
+    }
+    return uip_output(self, header, pbuf_length(packet));
+}
+
+/* ========================================================================== */
+
+/* PUBLIC */
+
+/* ========================================================================== */
+
+int8_t uip_init(struct uip* self)
+{
+    if (self == NULL || self->send == NULL)
+    {
+        return -EFAULT;
+    }
+
+    memset(&self->eth, 0, sizeof(self->eth));
+    memset(&self->arp, 0, sizeof(self->arp));
+    memset(&self->ip, 0, sizeof(self->ip));
+    memcpy(self->eth.ip_addr, self->ip_addr, 4);
+    memcpy(self->eth.mac_addr, self->mac_addr, 6);
+    memcpy(self->arp.ip_addr, self->ip_addr, 4);
+    memcpy(self->arp.mac_addr, self->mac_addr, 6);
+    memcpy(self->ip.ip_addr, self->ip_addr, 4);
+    self->icmp.lost_frames = 0;
+    self->udp.lost_frames  = 0;
+    self->tcp.lost_frames  = 0;
+
+    self->tx_queue_used   = 0;
+    self->ip_id           = 0;
+    self->stats           = (struct uip_stats){0};
+    self->was_initialized = true;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t uip_input(struct uip* self, uint8_t* frame, uint16_t size)
+{
+    if (self == NULL || frame == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    self->stats.rx_frames += 1;
+
+    struct eth_rx_metadata eth_mdata;
+    int8_t status = eth_process_frame(&self->eth, frame, size, &eth_mdata);
+    if (status != 0)
+    {
+        return _drop(self, status);
+    }
+    if (eth_mdata.mac_type == ETH_MAC_UNKNOWN)
+    {
+        return _drop(self, -ENOENT);
+    }
+
+    switch (eth_mdata.payload_type)
+    {
+        case ETH_PLD_ARP:
+        {
+            status = _input_arp(self, &eth_mdata, frame);
+            break;
+        }
+        case ETH_PLD_IPV4:
+        {
+            status = _input_ip(self, &eth_mdata, frame);
+            break;
+        }
+        default:
+        {
+            status = -ENOTSUP;
+            break;
+        }
+    }
+    return (status == 0) ? 0 : _drop(self, status);
+}
+
+/* ========================================================================== */
+
+int8_t uip_output(struct uip* self, uint8_t* frame, uint16_t size)
+{
+    if (self == NULL || frame == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    if (self->arp_cache == NULL)
+    {
+        return -ENOTSUP;
+    }
+    if (size < ETH_HEADER_SIZE + IP_HEADER_SIZE
+        || size > MAX_ETH_PKT_SIZE - ETH_FCS_SIZE)
+    {
+        return -EINVAL;
+    }
+
+    const uint8_t* dest_ip = frame + IP_FRAME_OFST + IP_DEST_ADDR_FRAME_OFST;
+    uint8_t        dest_mac[6];
+    int8_t         status = 0;
+    if (!memcmp(dest_ip, IP_BROADCAST_ADDR, 4))
+    {
+        memcpy(dest_mac, ETH_BROADCAST_ADDR, 6);
+    }
+    else
+    {
+        status = arp_cache_lookup(self->arp_cache, dest_ip, dest_mac);
+    }
+    if (status == 0)
+    {
+        return _send_to(self, dest_mac, frame, size);
+    }
+
+    // Unknown address: no frame is held without an entry to release it
+    if (status == -ENOENT)
+    {
+        status = arp_cache_resolve(self->arp_cache, dest_ip);
+        if (status == -ENOSPC)
+        {
+            self->stats.tx_dropped += 1;
+            return status;
+        }
+    }
+
+    // Not resolved yet: hold the frame until the ARP reply comes
+    int8_t queued = _enqueue(self, frame, size);
+    if (status == 0)
+    {
+        _send_arp_request(self, dest_ip);
+    }
+    if (queued != 0)
+    {
+        self->stats.tx_dropped += 1;
+        return queued;
+    }
+    return -EINPROGRESS;
+}
+
+/* ========================================================================== */
+
+int8_t uip_udp_send(
+    struct uip*                self,
+    struct pbuf*               packet,
+    uint16_t                   src_port,
+    const struct udp_endpoint* to)
+{
+    if (self == NULL || packet == NULL || to == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+
+    return _output_udp(self, packet, src_port, to, NULL);
+}
+
+/* ========================================================================== */
+
+int8_t uip_udp_flow_init(struct uip* self, struct uip_udp_flow* flow)
+{
+    if (self == NULL || flow == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+
+    struct ip_tx_metadata ip_mdata = {
+        .version       = IP_VER_4,
+        .pld_prot_type = IP_PLD_UDP,
+    };
+    memcpy(ip_mdata.src_ip, self->ip_addr, 4);
+    memcpy(ip_mdata.dest_ip, flow->to.ip_addr, 4);
+    int8_t status = ip_template_init(&self->ip, &ip_mdata, &flow->ip_template);
+    if (status != 0)
+    {
+        return status;
+    }
+
+    flow->was_initialized = true;
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t uip_udp_flow_send(
+    struct uip* self, struct uip_udp_flow* flow, struct pbuf* packet)
+{
+    if (self == NULL || flow == NULL || packet == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized || !flow->was_initialized)
+    {
+        return -EPERM;
+    }
+
+    return _output_udp(
+        self, packet, flow->src_port, &flow->to, &flow->ip_template);
+}
+
+/* ========================================================================== */
+
+int8_t uip_tcp_connect(
+    struct uip*                self,
+    const struct tcp_endpoint* to,
+    tcp_handler_t              handler,
+    void*                      context,
+    struct tcp_conn**          conn)
+{
+    if (self == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    if (self->tcp_table == NULL)
+    {
+        return -ENOTSUP;
+    }
+    return tcp_table_connect(
+        self->tcp_table,
+        self->ip_addr,
+        to,
+        handler,
+        context,
+        _output_tcp,
+        self,
+        conn);
+}
+
+/* ========================================================================== */
+
+int8_t uip_tcp_send(struct uip* self, struct tcp_conn* conn, uint16_t size)
+{
+    if (self == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    if (self->tcp_table == NULL)
+    {
+        return -ENOTSUP;
+    }
+    return tcp_table_send(self->tcp_table, conn, size, _output_tcp, self);
+}
+
+/* ========================================================================== */
+
+int8_t uip_tcp_consume(struct uip* self, struct tcp_conn* conn, uint16_t size)
+{
+    if (self == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    if (self->tcp_table == NULL)
+    {
+        return -ENOTSUP;
+    }
+    return tcp_table_consume(self->tcp_table, conn, size, _output_tcp, self);
+}
+
+/* ========================================================================== */
+
+int8_t uip_tcp_close(struct uip* self, struct tcp_conn* conn)
+{
+    if (self == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    if (self->tcp_table == NULL)
+    {
+        return -ENOTSUP;
+    }
+    return tcp_table_close(self->tcp_table, conn, _output_tcp, self);
+}
+
+/* ========================================================================== */
+
+int8_t uip_tcp_abort(struct uip* self, struct tcp_conn* conn)
+{
+    if (self == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    if (self->tcp_table == NULL)
+    {
+        return -ENOTSUP;
+    }
+    return tcp_table_abort(self->tcp_table, conn, _output_tcp, self);
+}
+
+/* ========================================================================== */
+
+int8_t uip_poll(struct uip* self, uint32_t now)
+{
+    if (self == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    if (self->arp_cache != NULL)
+    {
+        arp_cache_age(self->arp_cache, now, _on_arp_event, self);
+    }
+    if (self->ip_reasm != NULL)
+    {
+        ip_reasm_age(self->ip_reasm, now);
+    }
+    if (self->tcp_table != NULL)
+    {
+        tcp_table_poll(self->tcp_table, now, _output_tcp, self);
+    }
+    return 0;
+}
+
+/* ========================================================================== */
+
+int8_t uip_announce(struct uip* self)
+{
+    if (self == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    return _send_arp_request(self, self->ip_addr);
+}
+
+/* ========================================================================== */
+
+int8_t uip_get_stats(const struct uip* self, struct uip_stats* stats)
+{
+    if (self == NULL || stats == NULL)
+    {
+        return -EFAULT;
+    }
+    if (!self->was_initialized)
+    {
+        return -EPERM;
+    }
+    *stats             = self->stats;
+    stats->ip_discards = self->ip.discards;
+    return 0;
+}
+
+/* ========================================================================== */
@@ -0,0 +1,167 @@
+#include "unity.h"
+
+/* ========================================================================== */
+
+#include "../../inc/errno.h"
+#include "../inc/arp_cache.h"
+
+#include <string.h>
+
+TEST_SOURCE_FILE("../src/arp_cache.c")
+
+/* ========================================================================== */
+
+static const uint8_t IP_A[4]  = {192, 168, 1, 20};
+static const uint8_t IP_B[4]  = {192, 168, 1, 21};
+static const uint8_t IP_C[4]  = {192, 168, 1, 22};
+static const uint8_t MAC_A[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x20};
+static const uint8_t MAC_B[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x21};
+static const uint8_t MAC_C[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x22};
+
+static struct arp_entry entries[2];
+static struct arp_cache cache = {
+    .entries        = entries,
+    .capacity       = 2,
+    .max_age        = 1000,
+    .retry_interval = 100,
+    .max_requests   = 3,
+};
+
+static enum arp_cache_event events[8];
+static uint8_t              event_ips[8][4];
+static int                  event_count;
+
+static void record_event(
+    void* context, enum arp_cache_event event, const uint8_t* ip_addr)
+{
+    (void)context;
+    if (event_count < 8)
+    {
+        events[event_count] = event;
+        memcpy(event_ips[event_count], ip_addr, 4);
+    }
+    event_count += 1;
+}
+
+/* ========================================================================== */
+
+void setUp(void)
+{
+    event_count = 0;
+    TEST_ASSERT_EQUAL(0, arp_cache_init(&cache));
+}
+
+void tearDown(void)
+{
+}
+
+/* ========================================================================== */
+
+void test_address_resolves_once_the_peer_answers(void)
+{
+    uint8_t mac[6];
+    TEST_ASSERT_EQUAL(-ENOENT, arp_cache_lookup(&cache, IP_A, mac));
+    TEST_ASSERT_EQUAL(0, arp_cache_resolve(&cache, IP_A));
+    TEST_ASSERT_EQUAL(-EALREADY, arp_cache_resolve(&cache, IP_A));
+    TEST_ASSERT_EQUAL(-EINPROGRESS, arp_cache_lookup(&cache, IP_A, mac));
+
+    // Only a peer already known is refreshed without insert
+    TEST_ASSERT_EQUAL(-ENOENT, arp_cache_update(&cache, IP_B, MAC_B, false));
+    TEST_ASSERT_EQUAL(0, arp_cache_update(&cache, IP_A, MAC_A, false));
+    TEST_ASSERT_EQUAL(0, arp_cache_lookup(&cache, IP_A, mac));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(MAC_A, mac, 6);
+}
+
+void test_pending_request_is_retried_then_given_up(void)
+{
+    TEST_ASSERT_EQUAL(0, arp_cache_resolve(&cache, IP_A));
+    TEST_ASSERT_EQUAL(0, arp_cache_age(&cache, 99, record_event, NULL));
+    TEST_ASSERT_EQUAL(0, event_count);
+
+    TEST_ASSERT_EQUAL(0, arp_cache_age(&cache, 100, record_event, NULL));
+    TEST_ASSERT_EQUAL(0, arp_cache_age(&cache, 200, record_event, NULL));
+    TEST_ASSERT_EQUAL(0, arp_cache_age(&cache, 300, record_event, NULL));
+    TEST_ASSERT_EQUAL(3, event_count);
+    TEST_ASSERT_EQUAL(ARP_CACHE_SEND_REQUEST, events[0]);
+    TEST_ASSERT_EQUAL(ARP_CACHE_SEND_REQUEST, events[1]);
+    TEST_ASSERT_EQUAL(ARP_CACHE_UNREACHABLE, events[2]);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(IP_A, event_ips[2], 4);
+
+    uint8_t mac[6];
+    TEST_ASSERT_EQUAL(-ENOENT, arp_cache_lookup(&cache, IP_A, mac));
+}
+
+void test_entry_in_use_is_refreshed_and_stays_valid(void)
+{
+    uint8_t mac[6];
+    TEST_ASSERT_EQUAL(0, arp_cache_update(&cache, IP_A, MAC_A, true));
+    TEST_ASSERT_EQUAL(0, arp_cache_update(&cache, IP_B, MAC_B, true));
+    TEST_ASSERT_EQUAL(0, arp_cache_age(&cache, 500, record_event, NULL));
+    TEST_ASSERT_EQUAL(0, arp_cache_lookup(&cache, IP_A, mac));
+
+    // A was used since it was confirmed, B was not
+    TEST_ASSERT_EQUAL(0, arp_cache_age(&cache, 1000, record_event, NULL));
+    TEST_ASSERT_EQUAL(1, event_count);
+    TEST_ASSERT_EQUAL(ARP_CACHE_SEND_REQUEST, events[0]);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(IP_A, event_ips[0], 4);
+    TEST_ASSERT_EQUAL(0, arp_cache_lookup(&cache, IP_A, mac));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(MAC_A, mac, 6);
+    TEST_ASSERT_EQUAL(-ENOENT, arp_cache_lookup(&cache, IP_B, mac));
+
+    // The reply confirms it again: no more requests
+    TEST_ASSERT_EQUAL(0, arp_cache_update(&cache, IP_A, MAC_A, false));
+    TEST_ASSERT_EQUAL(0, arp_cache_age(&cache, 1100, record_event, NULL));
+    TEST_ASSERT_EQUAL(1, event_count);
+}
+
+void test_least_recently_used_entry_is_replaced(void)
+{
+    uint8_t mac[6];
+    TEST_ASSERT_EQUAL(0, arp_cache_update(&cache, IP_A, MAC_A, true));
+    TEST_ASSERT_EQUAL(0, arp_cache_update(&cache, IP_B, MAC_B, true));
+    TEST_ASSERT_EQUAL(0, arp_cache_age(&cache, 10, record_event, NULL));
+    TEST_ASSERT_EQUAL(0, arp_cache_lookup(&cache, IP_A, mac));
+
+    TEST_ASSERT_EQUAL(0, arp_cache_update(&cache, IP_C, MAC_C, true));
+    TEST_ASSERT_EQUAL(0, arp_cache_lookup(&cache, IP_A, mac));
+    TEST_ASSERT_EQUAL(-ENOENT, arp_cache_lookup(&cache, IP_B, mac));
+    TEST_ASSERT_EQUAL(0, arp_cache_lookup(&cache, IP_C, mac));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(MAC_C, mac, 6);
+
+    // A pending request is kept over a resolved entry
+    TEST_ASSERT_EQUAL(0, arp_cache_resolve(&cache, IP_B));
+    TEST_ASSERT_EQUAL(0, arp_cache_update(&cache, IP_A, MAC_A, true));
+    TEST_ASSERT_EQUAL(-EINPROGRESS, arp_cache_lookup(&cache, IP_B, mac));
+}
+
+void test_pending_entries_are_never_replaced(void)
+{
+    uint8_t mac[6];
+    TEST_ASSERT_EQUAL(0, arp_cache_resolve(&cache, IP_A));
+    TEST_ASSERT_EQUAL(0, arp_cache_resolve(&cache, IP_B));
+    TEST_ASSERT_EQUAL(-ENOSPC, arp_cache_resolve(&cache, IP_C));
+    TEST_ASSERT_EQUAL(-ENOSPC, arp_cache_update(&cache, IP_C, MAC_C, true));
+    TEST_ASSERT_EQUAL(-EINPROGRESS, arp_cache_lookup(&cache, IP_A, mac));
+    TEST_ASSERT_EQUAL(-EINPROGRESS, arp_cache_lookup(&cache, IP_B, mac));
+
+    // Once one resolves, it can be replaced
+    TEST_ASSERT_EQUAL(0, arp_cache_update(&cache, IP_A, MAC_A, false));
+    TEST_ASSERT_EQUAL(0, arp_cache_resolve(&cache, IP_C));
+    TEST_ASSERT_EQUAL(-ENOENT, arp_cache_lookup(&cache, IP_A, mac));
+}
+
+void test_aging_survives_a_tick_wrap(void)
+{
+    uint8_t mac[6];
+    TEST_ASSERT_EQUAL(
+        0, arp_cache_age(&cache, UINT32_MAX - 100, record_event, NULL));
+    TEST_ASSERT_EQUAL(0, arp_cache_update(&cache, IP_A, MAC_A, true));
+    TEST_ASSERT_EQUAL(0, arp_cache_age(&cache, 500, record_event, NULL));
+    TEST_ASSERT_EQUAL(0, arp_cache_lookup(&cache, IP_A, mac));
+    TEST_ASSERT_EQUAL(0, arp_cache_age(&cache, 898, record_event, NULL));
+    TEST_ASSERT_EQUAL(0, event_count);
+    TEST_ASSERT_EQUAL(0, arp_cache_age(&cache, 899, record_event, NULL));
+    TEST_ASSERT_EQUAL(1, event_count);
+}
+
+/* ========================================================================== */
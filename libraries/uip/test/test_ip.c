@@ -0,0 +1,239 @@
+#include "unity.h"
+
+/* ========================================================================== */
+
+#include "../../inc/errno.h"
+#include "../inc/ip.h"
+
+#include <string.h>
+
+TEST_SOURCE_FILE("../src/ip.c")
+TEST_SOURCE_FILE("../src/utils.c")
+
+/* ========================================================================== */
+
+static const uint8_t NODE_IP[4] = {192, 168, 1, 10};
+static const uint8_t PEER_IP[4] = {192, 168, 1, 20};
+
+static struct ip ip;
+
+/* Room for the longest header (60 bytes) and some payload */
+static uint8_t packet[128];
+
+/**
+ * @brief Build a valid IPv4 packet with payload_size bytes of payload.
+ */
+static uint16_t build_packet(uint16_t payload_size)
+{
+    struct ip             peer  = {.ip_addr = {0}};
+    struct ip_tx_metadata mdata = {
+        .version       = IP_VER_4,
+        .pld_prot_type = IP_PLD_UDP,
+        .payload_size  = payload_size,
+        .id            = 0x1234,
+    };
+    uint16_t size = 0;
+    memcpy(mdata.src_ip, PEER_IP, 4);
+    memcpy(mdata.dest_ip, NODE_IP, 4);
+    for (uint16_t i = 0; i < payload_size; i++)
+    {
+        packet[IP_HEADER_SIZE + i] = (uint8_t)i;
+    }
+    TEST_ASSERT_EQUAL(0, ip_build_frame(&peer, &mdata, packet, &size));
+    return size;
+}
+
+/**
+ * @brief Write the header checksum of the header_size first bytes of packet.
+ */
+static void set_checksum(uint8_t header_size)
+{
+    uint32_t acc = 0;
+    packet[10]   = 0;
+    packet[11]   = 0;
+    for (uint8_t i = 0; i < header_size; i += 2)
+    {
+        acc += (uint32_t)(packet[i] << 8 | packet[i + 1]);
+    }
+    while (acc >> 16)
+    {
+        acc = (acc & 0xFFFF) + (acc >> 16);
+    }
+    packet[10] = (uint8_t)(~acc >> 8);
+    packet[11] = (uint8_t)(~acc);
+}
+
+/* ========================================================================== */
+
+void setUp(void)
+{
+    memset(&ip, 0, sizeof(ip));
+    memcpy(ip.ip_addr, NODE_IP, 4);
+    memset(packet, 0, sizeof(packet));
+}
+
+void tearDown(void)
+{
+}
+
+/* ========================================================================== */
+
+void test_valid_packet_is_parsed(void)
+{
+    // Ethernet padding after the packet is not payload
+    uint16_t              size = build_packet(10);
+    struct ip_rx_metadata mdata;
+    TEST_ASSERT_EQUAL(0, ip_process_frame(&ip, packet, size + 16, &mdata));
+    TEST_ASSERT_EQUAL(IP_VER_4, mdata.version);
+    TEST_ASSERT_EQUAL(IP_PLD_UDP, mdata.pld_prot_type);
+    TEST_ASSERT_EQUAL_PTR(packet + IP_HEADER_SIZE, mdata.payload);
+    TEST_ASSERT_EQUAL(10, mdata.payload_size);
+    TEST_ASSERT_EQUAL_HEX16(0x1234, mdata.id);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(PEER_IP, mdata.src_ip, 4);
+    TEST_ASSERT_TRUE(ip_is_pkt_for_me(&ip, &mdata));
+
+    // Options are part of the header and of the checksum
+    memmove(packet + 28, packet + IP_HEADER_SIZE, 10);
+    memset(packet + IP_HEADER_SIZE, 0x01, 8); /* NOP options */
+    packet[0] = 0x47;
+    packet[3] = 38;
+    set_checksum(28);
+    TEST_ASSERT_EQUAL(0, ip_process_frame(&ip, packet, 38, &mdata));
+    TEST_ASSERT_EQUAL_PTR(packet + 28, mdata.payload);
+    TEST_ASSERT_EQUAL(10, mdata.payload_size);
+}
+
+void test_malformed_headers_are_counted_by_reason(void)
+{
+    struct ip_rx_metadata mdata;
+    uint16_t              size = build_packet(10);
+
+    TEST_ASSERT_EQUAL(-EINVAL, ip_process_frame(&ip, packet, 19, &mdata));
+
+    // Total length beyond the bytes received
+    TEST_ASSERT_EQUAL(
+        -EINVAL, ip_process_frame(&ip, packet, size - 1, &mdata));
+
+    // IHL below 5, or total length below the header
+    packet[0] = 0x44;
+    set_checksum(20);
+    TEST_ASSERT_EQUAL(-EINVAL, ip_process_frame(&ip, packet, size, &mdata));
+    build_packet(10);
+    packet[3] = 19;
+    set_checksum(20);
+    TEST_ASSERT_EQUAL(-EINVAL, ip_process_frame(&ip, packet, size, &mdata));
+
+    // Header longer than the bytes received
+    build_packet(10);
+    packet[0] = 0x4F;
+    packet[3] = 60;
+    set_checksum(20);
+    TEST_ASSERT_EQUAL(-EINVAL, ip_process_frame(&ip, packet, size, &mdata));
+
+    build_packet(10);
+    packet[15] ^= 0x01;
+    TEST_ASSERT_EQUAL(-EINVAL, ip_process_frame(&ip, packet, size, &mdata));
+
+    build_packet(10);
+    packet[8] = 0;
+    set_checksum(20);
+    TEST_ASSERT_EQUAL(-EINVAL, ip_process_frame(&ip, packet, size, &mdata));
+
+    build_packet(10);
+    packet[0] = 0x65;
+    TEST_ASSERT_EQUAL(-ENOTSUP, ip_process_frame(&ip, packet, size, &mdata));
+    TEST_ASSERT_EQUAL(IP_VER_6, mdata.version);
+
+    TEST_ASSERT_EQUAL(3, ip.discards.truncated);
+    TEST_ASSERT_EQUAL(2, ip.discards.bad_header);
+    TEST_ASSERT_EQUAL(1, ip.discards.bad_checksum);
+    TEST_ASSERT_EQUAL(1, ip.discards.ttl_expired);
+    TEST_ASSERT_EQUAL(1, ip.discards.bad_version);
+}
+
+void test_random_headers_never_point_outside_the_packet(void)
+{
+    // Mutate a valid packet at random: whatever is accepted must describe a
+    // payload inside the received bytes, and every refusal is counted once
+    uint32_t seed     = 1;
+    uint32_t accepted = 0;
+    for (uint32_t round = 0; round < 20000; round++)
+    {
+        uint16_t size = build_packet(40);
+        for (uint8_t flips = 0; flips < 1 + round % 4; flips++)
+        {
+            seed = seed * 1103515245u + 12345u;
+            packet[(seed >> 16) % 24] ^= (uint8_t)(1u << ((seed >> 8) % 8));
+        }
+        // Fix the checksum half of the time, so the checks behind it run
+        if (round % 2 == 0)
+        {
+            uint8_t ihl = (uint8_t)(4 * (packet[0] & 0x0F));
+            set_checksum((ihl >= 20 && ihl <= size) ? ihl : 20);
+        }
+        uint16_t received = (uint16_t)(size - (seed >> 4) % 8);
+
+        struct ip_rx_metadata mdata;
+        int8_t status = ip_process_frame(&ip, packet, received, &mdata);
+        if (status == 0)
+        {
+            accepted += 1;
+            TEST_ASSERT_TRUE(mdata.payload >= packet + IP_HEADER_SIZE);
+            TEST_ASSERT_TRUE(
+                mdata.payload + mdata.payload_size <= packet + received);
+        }
+        else
+        {
+            TEST_ASSERT_TRUE(status == -EINVAL || status == -ENOTSUP);
+        }
+    }
+
+    uint32_t refused = ip.discards.truncated + ip.discards.bad_version
+                       + ip.discards.bad_header + ip.discards.bad_checksum
+                       + ip.discards.ttl_expired;
+    TEST_ASSERT_EQUAL(20000, accepted + refused);
+    TEST_ASSERT_GREATER_THAN(0, accepted);
+    TEST_ASSERT_GREATER_THAN(0, ip.discards.bad_checksum);
+    TEST_ASSERT_GREATER_THAN(0, ip.discards.bad_header);
+}
+
+void test_template_builds_the_same_header_as_ip_build_frame(void)
+{
+    struct ip_tx_metadata mdata = {
+        .version       = IP_VER_4,
+        .pld_prot_type = IP_PLD_UDP,
+    };
+    memcpy(mdata.src_ip, NODE_IP, 4);
+    memcpy(mdata.dest_ip, PEER_IP, 4);
+    struct ip_header_template tmpl;
+    TEST_ASSERT_EQUAL(0, ip_template_init(&ip, &mdata, &tmpl));
+
+    // Every carry case of the checksum: sizes and IDs across their range
+    uint8_t  expected[IP_HEADER_SIZE];
+    uint16_t expected_size = 0;
+    uint16_t size          = 0;
+    for (uint32_t round = 0; round < 5000; round++)
+    {
+        mdata.payload_size = (uint16_t)(round * 7 % 1481);
+        mdata.id           = (uint16_t)(round * 40503u);
+        TEST_ASSERT_EQUAL(
+            0, ip_build_frame(&ip, &mdata, expected, &expected_size));
+        TEST_ASSERT_EQUAL(
+            0,
+            ip_template_build(
+                &tmpl, mdata.payload_size, mdata.id, packet, &size));
+        TEST_ASSERT_EQUAL(expected_size, size);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, packet, IP_HEADER_SIZE);
+    }
+
+    // No fragmentation from a template
+    TEST_ASSERT_EQUAL(
+        -EINVAL, ip_template_build(&tmpl, 1481, 0, packet, &size));
+
+    mdata.pld_prot_type = IP_PLD_UNKNOWN;
+    TEST_ASSERT_EQUAL(-EINVAL, ip_template_init(&ip, &mdata, &tmpl));
+    TEST_ASSERT_EQUAL(-EFAULT, ip_template_init(&ip, NULL, &tmpl));
+    TEST_ASSERT_EQUAL(-EFAULT, ip_template_init(NULL, &mdata, &tmpl));
+}
+
+/* ========================================================================== */
@@ -0,0 +1,168 @@
+#include "unity.h"
+
+/* ========================================================================== */
+
+#include "../../inc/errno.h"
+#include "../inc/ip_reasm.h"
+
+#include <string.h>
+
+TEST_SOURCE_FILE("../src/ip_reasm.c")
+
+/* ========================================================================== */
+
+static const uint8_t SRC_IP[4]  = {192, 168, 1, 20};
+static const uint8_t DEST_IP[4] = {192, 168, 1, 10};
+
+static struct ip_reasm_slot slots[2];
+static uint8_t              storage[2 * 64];
+static struct ip_reasm      reasm = {
+    .slots      = slots,
+    .storage    = storage,
+    .slot_count = 2,
+    .slot_size  = 64,
+    .timeout    = 1000,
+};
+
+static uint8_t datagram[64];
+
+/**
+ * @brief Metadata of the fragment [offset, offset + size) of datagram.
+ */
+static struct ip_rx_metadata fragment(
+    uint16_t id, uint16_t offset, uint16_t size, bool more)
+{
+    struct ip_rx_metadata mdata = {
+        .version        = IP_VER_4,
+        .pld_prot_type  = IP_PLD_UDP,
+        .payload        = datagram + offset,
+        .payload_size   = size,
+        .id             = id,
+        .frag_offset    = offset,
+        .more_fragments = more,
+    };
+    memcpy(mdata.src_ip, SRC_IP, 4);
+    memcpy(mdata.dest_ip, DEST_IP, 4);
+    return mdata;
+}
+
+/* ========================================================================== */
+
+void setUp(void)
+{
+    for (uint8_t i = 0; i < sizeof(datagram); i++)
+    {
+        datagram[i] = (uint8_t)(i * 3 + 1);
+    }
+    TEST_ASSERT_EQUAL(0, ip_reasm_init(&reasm));
+}
+
+void tearDown(void)
+{
+}
+
+/* ========================================================================== */
+
+void test_fragments_in_any_order_make_the_datagram(void)
+{
+    struct ip_rx_metadata middle = fragment(7, 16, 16, true);
+    struct ip_rx_metadata last   = fragment(7, 32, 5, false);
+    struct ip_rx_metadata first  = fragment(7, 0, 16, true);
+    TEST_ASSERT_EQUAL(-EINPROGRESS, ip_reasm_add(&reasm, &middle));
+    TEST_ASSERT_EQUAL(-EINPROGRESS, ip_reasm_add(&reasm, &last));
+    // A duplicate changes nothing
+    TEST_ASSERT_EQUAL(-EINPROGRESS, ip_reasm_add(&reasm, &middle));
+
+    TEST_ASSERT_EQUAL(0, ip_reasm_add(&reasm, &first));
+    TEST_ASSERT_EQUAL(37, first.payload_size);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(datagram, first.payload, 37);
+
+    struct ip_reasm_stats stats;
+    TEST_ASSERT_EQUAL(0, ip_reasm_get_stats(&reasm, &stats));
+    TEST_ASSERT_EQUAL(4, stats.fragments);
+    TEST_ASSERT_EQUAL(1, stats.reassembled);
+    TEST_ASSERT_EQUAL(0, stats.dropped);
+}
+
+void test_datagrams_are_told_apart_by_id(void)
+{
+    struct ip_rx_metadata a_first = fragment(1, 0, 8, true);
+    struct ip_rx_metadata b_first = fragment(2, 0, 24, true);
+    struct ip_rx_metadata a_last  = fragment(1, 8, 8, false);
+    struct ip_rx_metadata b_last  = fragment(2, 24, 40, false);
+    TEST_ASSERT_EQUAL(-EINPROGRESS, ip_reasm_add(&reasm, &a_first));
+    TEST_ASSERT_EQUAL(-EINPROGRESS, ip_reasm_add(&reasm, &b_first));
+
+    // Both slots are taken
+    struct ip_rx_metadata c_first = fragment(3, 0, 8, true);
+    TEST_ASSERT_EQUAL(-ENOMEM, ip_reasm_add(&reasm, &c_first));
+
+    TEST_ASSERT_EQUAL(0, ip_reasm_add(&reasm, &b_last));
+    TEST_ASSERT_EQUAL(64, b_last.payload_size);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(datagram, b_last.payload, 64);
+    TEST_ASSERT_EQUAL(0, ip_reasm_add(&reasm, &a_last));
+    TEST_ASSERT_EQUAL(16, a_last.payload_size);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(datagram, a_last.payload, 16);
+}
+
+void test_bad_fragments_give_the_datagram_up(void)
+{
+    // Off the 8-byte grid while more fragments follow
+    struct ip_rx_metadata odd = fragment(1, 0, 12, true);
+    TEST_ASSERT_EQUAL(-EINVAL, ip_reasm_add(&reasm, &odd));
+
+    // Larger than a slot, or exactly a slot with more to come
+    struct ip_rx_metadata big = fragment(2, 56, 16, false);
+    TEST_ASSERT_EQUAL(-EMSGSIZE, ip_reasm_add(&reasm, &big));
+    struct ip_rx_metadata full = fragment(3, 0, 64, true);
+    TEST_ASSERT_EQUAL(-EMSGSIZE, ip_reasm_add(&reasm, &full));
+
+    // Two different ends
+    struct ip_rx_metadata last  = fragment(4, 16, 8, false);
+    struct ip_rx_metadata other = fragment(4, 24, 8, true);
+    TEST_ASSERT_EQUAL(-EINPROGRESS, ip_reasm_add(&reasm, &last));
+    TEST_ASSERT_EQUAL(-EINVAL, ip_reasm_add(&reasm, &other));
+
+    // The slot was freed: the datagram starts over
+    struct ip_rx_metadata first = fragment(4, 0, 16, true);
+    TEST_ASSERT_EQUAL(-EINPROGRESS, ip_reasm_add(&reasm, &first));
+    last = fragment(4, 16, 8, false);
+    TEST_ASSERT_EQUAL(0, ip_reasm_add(&reasm, &last));
+
+    struct ip_reasm_stats stats;
+    TEST_ASSERT_EQUAL(0, ip_reasm_get_stats(&reasm, &stats));
+    TEST_ASSERT_EQUAL(4, stats.dropped);
+    TEST_ASSERT_EQUAL(1, stats.reassembled);
+}
+
+void test_incomplete_datagram_times_out(void)
+{
+    TEST_ASSERT_EQUAL(0, ip_reasm_age(&reasm, UINT32_MAX - 10));
+    struct ip_rx_metadata first = fragment(9, 0, 8, true);
+    TEST_ASSERT_EQUAL(-EINPROGRESS, ip_reasm_add(&reasm, &first));
+    TEST_ASSERT_EQUAL(0, ip_reasm_age(&reasm, 988));
+
+    struct ip_reasm_stats stats;
+    TEST_ASSERT_EQUAL(0, ip_reasm_get_stats(&reasm, &stats));
+    TEST_ASSERT_EQUAL(0, stats.timed_out);
+    TEST_ASSERT_EQUAL(0, ip_reasm_age(&reasm, 989));
+    TEST_ASSERT_EQUAL(0, ip_reasm_get_stats(&reasm, &stats));
+    TEST_ASSERT_EQUAL(1, stats.timed_out);
+
+    // The last fragment alone does not complete it any more
+    struct ip_rx_metadata last = fragment(9, 8, 8, false);
+    TEST_ASSERT_EQUAL(-EINPROGRESS, ip_reasm_add(&reasm, &last));
+}
+
+void test_whole_datagram_is_passed_through(void)
+{
+    struct ip_rx_metadata whole = fragment(5, 0, 20, false);
+    TEST_ASSERT_EQUAL(0, ip_reasm_add(&reasm, &whole));
+    TEST_ASSERT_EQUAL_PTR(datagram, whole.payload);
+
+    struct ip_reasm_stats stats;
+    TEST_ASSERT_EQUAL(0, ip_reasm_get_stats(&reasm, &stats));
+    TEST_ASSERT_EQUAL(0, stats.fragments);
+}
+
+/* ========================================================================== */
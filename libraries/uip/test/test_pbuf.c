@@ -0,0 +1,116 @@
+#include "unity.h"
+
+/* ========================================================================== */
+
+#include "../../inc/errno.h"
+#include "../inc/pbuf.h"
+
+#include <string.h>
+
+TEST_SOURCE_FILE("../src/pbuf.c")
+TEST_SOURCE_FILE("../../packet-pool/src/packet_pool.c")
+
+/* ========================================================================== */
+
+static struct packet_block blocks[3];
+static uint8_t             storage[3 * 64];
+static struct packet_pool  shared = {
+    .blocks      = blocks,
+    .storage     = storage,
+    .block_count = 3,
+    .block_size  = 64,
+};
+static struct pbuf      pbufs[3];
+static struct pbuf_pool pool = {.pbufs = pbufs, .blocks = &shared};
+
+/* ========================================================================== */
+
+void setUp(void)
+{
+    TEST_ASSERT_EQUAL(0, packet_pool_init(&shared));
+    TEST_ASSERT_EQUAL(0, pbuf_pool_init(&pool));
+}
+
+void tearDown(void)
+{
+}
+
+/* ========================================================================== */
+
+void test_headers_are_prepended_in_front_of_the_payload(void)
+{
+    uint8_t     buffer[32];
+    struct pbuf packet = {.buffer = buffer, .capacity = sizeof(buffer)};
+    TEST_ASSERT_EQUAL(-EINVAL, pbuf_reset(&packet, 33));
+    TEST_ASSERT_EQUAL(0, pbuf_reset(&packet, 12));
+    TEST_ASSERT_EQUAL_PTR(buffer + 12, pbuf_data(&packet));
+    TEST_ASSERT_EQUAL(0, pbuf_length(&packet));
+
+    uint8_t* area = NULL;
+    TEST_ASSERT_EQUAL(0, pbuf_put(&packet, 20, &area));
+    TEST_ASSERT_EQUAL_PTR(buffer + 12, area);
+    TEST_ASSERT_EQUAL(-ENOSPC, pbuf_put(&packet, 1, &area));
+
+    TEST_ASSERT_EQUAL(0, pbuf_push(&packet, 8, &area));
+    TEST_ASSERT_EQUAL_PTR(buffer + 4, area);
+    TEST_ASSERT_EQUAL(-ENOSPC, pbuf_push(&packet, 5, &area));
+    TEST_ASSERT_EQUAL(0, pbuf_push(&packet, 4, &area));
+    TEST_ASSERT_EQUAL_PTR(buffer, pbuf_data(&packet));
+    TEST_ASSERT_EQUAL(32, pbuf_length(&packet));
+
+    // Receive side: strip the headers again
+    TEST_ASSERT_EQUAL(0, pbuf_pull(&packet, 12));
+    TEST_ASSERT_EQUAL_PTR(buffer + 12, pbuf_data(&packet));
+    TEST_ASSERT_EQUAL(20, pbuf_length(&packet));
+    TEST_ASSERT_EQUAL(-EINVAL, pbuf_pull(&packet, 21));
+}
+
+void test_pool_hands_out_each_buffer_once(void)
+{
+    struct pbuf* taken[3];
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        TEST_ASSERT_EQUAL(0, pbuf_pool_alloc(&pool, 42, &taken[i]));
+        TEST_ASSERT_EQUAL(42, pbuf_data(taken[i]) - taken[i]->buffer);
+        TEST_ASSERT_EQUAL(0, pbuf_length(taken[i]));
+    }
+    TEST_ASSERT_EQUAL(0, pbuf_pool_available(&pool));
+    TEST_ASSERT_TRUE(taken[0]->buffer != taken[1]->buffer);
+    TEST_ASSERT_TRUE(taken[1]->buffer != taken[2]->buffer);
+
+    struct pbuf* extra = NULL;
+    TEST_ASSERT_EQUAL(-ENOMEM, pbuf_pool_alloc(&pool, 42, &extra));
+    TEST_ASSERT_EQUAL(0, pbuf_pool_free(&pool, taken[1]));
+    TEST_ASSERT_EQUAL(0, pbuf_pool_alloc(&pool, 0, &extra));
+    TEST_ASSERT_EQUAL_PTR(taken[1], extra);
+}
+
+void test_pool_shares_its_blocks_with_the_driver(void)
+{
+    // The driver holds a received frame while the stack sends one
+    struct packet_block* received = NULL;
+    struct pbuf*         packet   = NULL;
+    TEST_ASSERT_EQUAL(0, packet_pool_alloc(&shared, &received));
+    TEST_ASSERT_EQUAL(0, pbuf_pool_alloc(&pool, 42, &packet));
+    TEST_ASSERT_TRUE(packet->buffer != received->data);
+    TEST_ASSERT_EQUAL(1, pbuf_pool_available(&pool));
+
+    struct packet_pool_stats stats;
+    TEST_ASSERT_EQUAL(0, pbuf_pool_free(&pool, packet));
+    TEST_ASSERT_EQUAL(0, packet_pool_free(&shared, received));
+    TEST_ASSERT_EQUAL(0, packet_pool_get_stats(&shared, &stats));
+    TEST_ASSERT_EQUAL(0, stats.in_use);
+    TEST_ASSERT_EQUAL(2, stats.high_water);
+}
+
+void test_pool_rejects_foreign_buffers(void)
+{
+    uint8_t      buffer[16];
+    struct pbuf  foreign = {.buffer = buffer, .capacity = sizeof(buffer)};
+    struct pbuf* taken   = NULL;
+    TEST_ASSERT_EQUAL(-EINVAL, pbuf_pool_free(&pool, &foreign));
+    TEST_ASSERT_EQUAL(-EINVAL, pbuf_pool_alloc(&pool, 65, &taken));
+    TEST_ASSERT_EQUAL(3, pbuf_pool_available(&pool));
+}
+
+/* ========================================================================== */
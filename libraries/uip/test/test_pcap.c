@@ -0,0 +1,139 @@
+#include "unity.h"
+
+/* ========================================================================== */
+
+#include "../../inc/errno.h"
+#include "../inc/pcap.h"
+
+#include <string.h>
+
+TEST_SOURCE_FILE("../src/pcap.c")
+
+/* ========================================================================== */
+
+static uint8_t  capture[256];
+static uint16_t capture_size;
+
+static int8_t memory_write(void* context, const uint8_t* data, uint16_t size)
+{
+    (void)context;
+    if (size > sizeof(capture) - capture_size)
+    {
+        return -ENOSPC;
+    }
+    memcpy(capture + capture_size, data, size);
+    capture_size += size;
+    return 0;
+}
+
+/* ========================================================================== */
+
+void setUp(void)
+{
+    memset(capture, 0, sizeof(capture));
+    capture_size = 0;
+}
+
+void tearDown(void)
+{
+}
+
+/* ========================================================================== */
+
+void test_written_frames_are_read_back(void)
+{
+    struct pcap_writer writer = {.write = memory_write, .snap_len = 32};
+    TEST_ASSERT_EQUAL(-EPERM, pcap_writer_frame(&writer, 0, 0, capture, 1));
+    TEST_ASSERT_EQUAL(0, pcap_writer_init(&writer));
+    TEST_ASSERT_EQUAL(PCAP_FILE_HEADER_SIZE, capture_size);
+    // Magic number and Ethernet link type, little-endian
+    TEST_ASSERT_EQUAL_HEX8(0xD4, capture[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xA1, capture[3]);
+    TEST_ASSERT_EQUAL_HEX8(1, capture[20]);
+
+    // The second frame is longer than snap_len: cut, size on the wire kept
+    uint8_t frames[2][60];
+    for (uint8_t i = 0; i < 60; i++)
+    {
+        frames[0][i] = i;
+        frames[1][i] = (uint8_t)(0xFF - i);
+    }
+    TEST_ASSERT_EQUAL(0, pcap_writer_frame(&writer, 10, 500, frames[0], 14));
+    TEST_ASSERT_EQUAL(0, pcap_writer_frame(&writer, 11, 0, frames[1], 60));
+    TEST_ASSERT_EQUAL(2, pcap_writer_frames(&writer));
+
+    struct pcap_reader reader = {.data = capture, .size = capture_size};
+    struct pcap_record record;
+    TEST_ASSERT_EQUAL(0, pcap_reader_init(&reader));
+    TEST_ASSERT_EQUAL(0, pcap_reader_next(&reader, &record));
+    TEST_ASSERT_EQUAL(10, record.ts_sec);
+    TEST_ASSERT_EQUAL(500, record.ts_usec);
+    TEST_ASSERT_EQUAL(14, record.size);
+    TEST_ASSERT_EQUAL(14, record.orig_size);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(frames[0], record.frame, 14);
+    TEST_ASSERT_EQUAL(0, pcap_reader_next(&reader, &record));
+    TEST_ASSERT_EQUAL(32, record.size);
+    TEST_ASSERT_EQUAL(60, record.orig_size);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(frames[1], record.frame, 32);
+    TEST_ASSERT_EQUAL(-ENOENT, pcap_reader_next(&reader, &record));
+
+    // A sink that runs out of room reports it
+    capture_size = sizeof(capture) - 20;
+    TEST_ASSERT_EQUAL(
+        -ENOSPC, pcap_writer_frame(&writer, 12, 0, frames[0], 14));
+    TEST_ASSERT_EQUAL(2, pcap_writer_frames(&writer));
+}
+
+void test_big_endian_nanosecond_captures_are_read(void)
+{
+    static const uint8_t big_endian[] = {
+        0xA1, 0xB2, 0x3C, 0x4D, 0x00, 0x02, 0x00, 0x04, /* Magic, version */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* Zone, accuracy */
+        0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x01, /* Snap, Ethernet */
+        0x00, 0x00, 0x00, 0x07, 0x00, 0x0F, 0x42, 0x40, /* 7 s, 1000000 ns */
+        0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x02, /* 2 bytes */
+        0xAB, 0xCD,
+    };
+    struct pcap_reader reader = {
+        .data = big_endian,
+        .size = sizeof(big_endian),
+    };
+    struct pcap_record record;
+    TEST_ASSERT_EQUAL(0, pcap_reader_init(&reader));
+    TEST_ASSERT_EQUAL(0, pcap_reader_next(&reader, &record));
+    TEST_ASSERT_EQUAL(7, record.ts_sec);
+    TEST_ASSERT_EQUAL(1000, record.ts_usec);
+    TEST_ASSERT_EQUAL(2, record.size);
+    TEST_ASSERT_EQUAL_HEX8(0xCD, record.frame[1]);
+    TEST_ASSERT_EQUAL(-ENOENT, pcap_reader_next(&reader, &record));
+}
+
+void test_malformed_captures_are_refused(void)
+{
+    struct pcap_writer writer = {.write = memory_write, .snap_len = 64};
+    TEST_ASSERT_EQUAL(0, pcap_writer_init(&writer));
+    uint8_t frame[20] = {0};
+    TEST_ASSERT_EQUAL(0, pcap_writer_frame(&writer, 0, 0, frame, 20));
+    struct pcap_record record;
+
+    // Record cut short by the end of the capture
+    struct pcap_reader cut = {.data = capture, .size = capture_size - 1};
+    TEST_ASSERT_EQUAL(0, pcap_reader_init(&cut));
+    TEST_ASSERT_EQUAL(-EINVAL, pcap_reader_next(&cut, &record));
+
+    // Too short for the file header
+    struct pcap_reader empty = {.data = capture, .size = 10};
+    TEST_ASSERT_EQUAL(-EINVAL, pcap_reader_init(&empty));
+
+    struct pcap_reader reader = {.data = capture, .size = capture_size};
+    capture[20] = 105; /* IEEE 802.11 */
+    TEST_ASSERT_EQUAL(-ENOTSUP, pcap_reader_init(&reader));
+    capture[0] = 0x00;
+    TEST_ASSERT_EQUAL(-EINVAL, pcap_reader_init(&reader));
+    TEST_ASSERT_EQUAL(-EPERM, pcap_reader_next(&reader, &record));
+
+    struct pcap_writer no_snap = {.write = memory_write};
+    TEST_ASSERT_EQUAL(-EINVAL, pcap_writer_init(&no_snap));
+}
+
+/* ========================================================================== */
@@ -0,0 +1,663 @@
+#include "unity.h"
+
+/* ========================================================================== */
+
+#include "../../inc/errno.h"
+#include "../inc/uip.h"
+
+#include <string.h>
+
+TEST_SOURCE_FILE("../src/arp.c")
+TEST_SOURCE_FILE("../src/arp_cache.c")
+TEST_SOURCE_FILE("../src/eth.c")
+TEST_SOURCE_FILE("../src/icmp.c")
+TEST_SOURCE_FILE("../src/ip.c")
+TEST_SOURCE_FILE("../src/ip_reasm.c")
+TEST_SOURCE_FILE("../src/pbuf.c")
+TEST_SOURCE_FILE("../src/tcp.c")
+TEST_SOURCE_FILE("../src/tcp_conn.c")
+TEST_SOURCE_FILE("../src/udp.c")
+TEST_SOURCE_FILE("../src/udp_socket.c")
+TEST_SOURCE_FILE("../src/utils.c")
+TEST_SOURCE_FILE("../src/uip.c")
+TEST_SOURCE_FILE("../../packet-pool/src/packet_pool.c")
+TEST_SOURCE_FILE("../../ring-buffer/src/ring_buffer.c")
+
+/* ========================================================================== */
+
+/*
+ * Two stacks, NODE (client) and PEER (server), joined by an in-memory link:
+ * every frame sent is queued for the other stack and delivered by run_link().
+ * Time only moves in advance().
+ */
+
+#define LINK_DEPTH 32
+#define BUF_SIZE   8192
+
+#define CONN(buffers)                                                          \
+    {                                                                          \
+        .rx_buffer = (buffers)[0], .rx_size = BUF_SIZE,                        \
+        .tx_buffer = (buffers)[1], .tx_size = BUF_SIZE,                        \
+    }
+
+static const uint8_t PEER_IP[4] = {192, 168, 1, 20};
+
+static const uint16_t SERVER_PORT = 80;
+static const uint32_t ACK_DELAY   = 200;
+static const uint32_t RTO_MIN     = 200;
+static const uint32_t TIME_WAIT   = 4000;
+
+struct link_frame
+{
+    struct uip* to;
+    uint16_t    size;
+    uint8_t     data[MAX_ETH_PKT_SIZE];
+};
+
+static struct link_frame link_frames[LINK_DEPTH];
+static uint8_t           link_head;
+static uint8_t           link_used;
+static int               drop_count; /* Frames the link loses next */
+static uint32_t          now;
+
+static int8_t link_send(void* context, uint8_t* frame, uint16_t size)
+{
+    if (drop_count > 0)
+    {
+        drop_count -= 1;
+        return 0;
+    }
+    TEST_ASSERT_LESS_THAN(LINK_DEPTH, link_used);
+    struct link_frame* slot
+        = &link_frames[(link_head + link_used) % LINK_DEPTH];
+    memset(slot->data, 0, sizeof(slot->data));
+    memcpy(slot->data, frame, size);
+    // The MAC delivers the padding and the FCS with the frame
+    slot->size = ((size < 60) ? 60 : size) + 4;
+    slot->to   = context;
+    link_used += 1;
+    return 0;
+}
+
+static void run_link(void)
+{
+    static uint8_t frame[MAX_ETH_PKT_SIZE];
+    while (link_used > 0)
+    {
+        struct link_frame* slot = &link_frames[link_head];
+        struct uip*        to   = slot->to;
+        uint16_t           size = slot->size;
+        memcpy(frame, slot->data, size);
+        link_head = (link_head + 1) % LINK_DEPTH;
+        link_used -= 1;
+        uip_input(to, frame, size);
+    }
+}
+
+/**
+ * @brief Take the next frame off the link without delivering it.
+ */
+static void take_frame(struct link_frame* frame)
+{
+    TEST_ASSERT_GREATER_THAN(0, link_used);
+    *frame    = link_frames[link_head];
+    link_head = (link_head + 1) % LINK_DEPTH;
+    link_used -= 1;
+}
+
+/**
+ * @brief Bytes of TCP payload in the frames queued on the link for a stack.
+ */
+static uint32_t queued_payload(const struct uip* to)
+{
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < link_used; i++)
+    {
+        const uint8_t* ip
+            = link_frames[(link_head + i) % LINK_DEPTH].data + ETH_HEADER_SIZE;
+        if (link_frames[(link_head + i) % LINK_DEPTH].to == to)
+        {
+            uint16_t ip_size  = (uint16_t)(ip[2] << 8 | ip[3]);
+            uint8_t  ihl      = (ip[0] & 0x0F) * 4;
+            uint8_t  tcp_size = (ip[ihl + 12] >> 4) * 4;
+            total += ip_size - ihl - tcp_size;
+        }
+    }
+    return total;
+}
+
+/* ========================================================================== */
+
+struct app
+{
+    struct uip*      stack;
+    struct tcp_conn* conn;
+    int              events[TCP_EVENT_ABORTED + 1];
+    uint8_t          received[BUF_SIZE];
+    uint16_t         received_size;
+    bool             hold;     /* Leave the data received in the window */
+    uint16_t         greeting; /* Bytes sent once connected */
+    bool             refuse;   /* Abort once connected */
+};
+
+static struct app client;
+static struct app server;
+
+static void send_pattern(struct app* app, uint16_t size);
+
+/**
+ * @brief Count the events and read everything received right away.
+ */
+static void
+tcp_handler(void* context, struct tcp_conn* conn, enum tcp_event event)
+{
+    struct app* app = context;
+    app->conn       = conn;
+    app->events[event] += 1;
+    if (event == TCP_EVENT_CONNECTED && app->refuse)
+    {
+        TEST_ASSERT_EQUAL(0, uip_tcp_abort(app->stack, conn));
+        return;
+    }
+    if (event == TCP_EVENT_CONNECTED && app->greeting > 0)
+    {
+        send_pattern(app, app->greeting);
+        return;
+    }
+    if (event != TCP_EVENT_RECEIVED || app->hold)
+    {
+        return;
+    }
+
+    const uint8_t* data = NULL;
+    uint16_t       size = 0;
+    while (tcp_conn_rx_window(conn, &data, &size) == 0 && size > 0)
+    {
+        memcpy(app->received + app->received_size, data, size);
+        app->received_size += size;
+        TEST_ASSERT_EQUAL(0, uip_tcp_consume(app->stack, conn, size));
+    }
+}
+
+static struct tcp_listener listener = {
+    .port    = 80,
+    .handler = tcp_handler,
+    .context = &server,
+};
+
+/* ========================================================================== */
+
+static uint32_t random_value;
+
+static uint32_t get_random(void)
+{
+    return random_value;
+}
+
+static uint8_t         node_buffers[2][2][BUF_SIZE];
+static struct tcp_conn node_conns[2] = {
+    CONN(node_buffers[0]),
+    CONN(node_buffers[1]),
+};
+static struct tcp_listener* node_listeners[1];
+static uint8_t              node_tx_frame[MAX_ETH_PKT_SIZE];
+static struct tcp_table     node_table = {
+    .conns          = node_conns,
+    .conn_count     = 2,
+    .listeners      = node_listeners,
+    .listener_count = 1,
+    .tx_frame       = node_tx_frame,
+    .tx_frame_size  = sizeof(node_tx_frame),
+    .ack_delay      = 200,
+    .rto_initial    = 1000,
+    .rto_min        = 200,
+    .rto_max        = 60000,
+    .max_retries    = 4,
+    .time_wait      = 4000,
+    .get_random     = get_random,
+};
+
+static uint8_t         peer_buffers[2][2][BUF_SIZE];
+static struct tcp_conn peer_conns[2] = {
+    CONN(peer_buffers[0]),
+    CONN(peer_buffers[1]),
+};
+static struct tcp_listener* peer_listeners[1];
+static uint8_t              peer_tx_frame[MAX_ETH_PKT_SIZE];
+static struct tcp_table     peer_table = {
+    .conns          = peer_conns,
+    .conn_count     = 2,
+    .listeners      = peer_listeners,
+    .listener_count = 1,
+    .tx_frame       = peer_tx_frame,
+    .tx_frame_size  = sizeof(peer_tx_frame),
+    .ack_delay      = 200,
+    .rto_initial    = 1000,
+    .rto_min        = 200,
+    .rto_max        = 60000,
+    .max_retries    = 4,
+    .time_wait      = 4000,
+};
+
+static struct arp_entry node_arp_entries[2];
+static struct arp_entry peer_arp_entries[2];
+static struct arp_cache node_arp_cache = {
+    .entries        = node_arp_entries,
+    .capacity       = 2,
+    .max_age        = 100000,
+    .retry_interval = 100,
+    .max_requests   = 3,
+};
+static struct arp_cache peer_arp_cache = {
+    .entries        = peer_arp_entries,
+    .capacity       = 2,
+    .max_age        = 100000,
+    .retry_interval = 100,
+    .max_requests   = 3,
+};
+static uint8_t node_tx_queue[2 * (2 + 1514)];
+static uint8_t peer_tx_queue[2 * (2 + 1514)];
+
+static struct uip peer;
+static struct uip node = {
+    .ip_addr       = {192, 168, 1, 10},
+    .mac_addr      = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01},
+    .send          = link_send,
+    .send_context  = &peer,
+    .arp_cache     = &node_arp_cache,
+    .tx_queue      = node_tx_queue,
+    .tx_queue_size = sizeof(node_tx_queue),
+    .tcp_table     = &node_table,
+};
+static struct uip peer = {
+    .ip_addr       = {192, 168, 1, 20},
+    .mac_addr      = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02},
+    .send          = link_send,
+    .send_context  = &node,
+    .arp_cache     = &peer_arp_cache,
+    .tx_queue      = peer_tx_queue,
+    .tx_queue_size = sizeof(peer_tx_queue),
+    .tcp_table     = &peer_table,
+};
+
+/* ========================================================================== */
+
+/**
+ * @brief Move time forward in steps of 10 ticks, running the timers of both
+ * stacks and the link at each step.
+ */
+static void advance(uint32_t ticks)
+{
+    for (uint32_t step = 0; step < ticks; step += 10)
+    {
+        now += 10;
+        TEST_ASSERT_EQUAL(0, uip_poll(&node, now));
+        TEST_ASSERT_EQUAL(0, uip_poll(&peer, now));
+        run_link();
+    }
+}
+
+static void connect_to_server(void)
+{
+    struct tcp_endpoint to   = {.port = SERVER_PORT};
+    struct tcp_conn*    conn = NULL;
+    memcpy(to.ip_addr, PEER_IP, 4);
+    TEST_ASSERT_EQUAL(
+        0, uip_tcp_connect(&node, &to, tcp_handler, &client, &conn));
+    run_link();
+    TEST_ASSERT_EQUAL(1, client.events[TCP_EVENT_CONNECTED]);
+    TEST_ASSERT_EQUAL(1, server.events[TCP_EVENT_CONNECTED]);
+    TEST_ASSERT_EQUAL_PTR(conn, client.conn);
+    TEST_ASSERT_EQUAL(TCP_ESTABLISHED, tcp_conn_get_state(client.conn));
+    TEST_ASSERT_EQUAL(TCP_ESTABLISHED, tcp_conn_get_state(server.conn));
+}
+
+/**
+ * @brief Write size bytes of a counting pattern into the send window of app,
+ * then send them.
+ */
+static void send_pattern(struct app* app, uint16_t size)
+{
+    uint8_t* data   = NULL;
+    uint16_t window = 0;
+    TEST_ASSERT_EQUAL(0, tcp_conn_tx_window(app->conn, &data, &window));
+    TEST_ASSERT_GREATER_OR_EQUAL(size, window);
+    for (uint16_t i = 0; i < size; i++)
+    {
+        data[i] = (uint8_t)(i * 7 + 3);
+    }
+    TEST_ASSERT_EQUAL(0, uip_tcp_send(app->stack, app->conn, size));
+}
+
+static void assert_pattern(const struct app* app, uint16_t size)
+{
+    TEST_ASSERT_EQUAL(size, app->received_size);
+    for (uint16_t i = 0; i < size; i++)
+    {
+        TEST_ASSERT_EQUAL_HEX8((uint8_t)(i * 7 + 3), app->received[i]);
+    }
+}
+
+/* ========================================================================== */
+
+void setUp(void)
+{
+    link_head    = 0;
+    link_used    = 0;
+    drop_count   = 0;
+    now          = 0;
+    random_value = 0x2545F491;
+    memset(&client, 0, sizeof(client));
+    memset(&server, 0, sizeof(server));
+    client.stack = &node;
+    server.stack = &peer;
+
+    TEST_ASSERT_EQUAL(0, arp_cache_init(&node_arp_cache));
+    TEST_ASSERT_EQUAL(0, arp_cache_init(&peer_arp_cache));
+    TEST_ASSERT_EQUAL(0, tcp_table_init(&node_table));
+    TEST_ASSERT_EQUAL(0, tcp_table_init(&peer_table));
+    TEST_ASSERT_EQUAL(0, uip_init(&node));
+    TEST_ASSERT_EQUAL(0, uip_init(&peer));
+    TEST_ASSERT_EQUAL(0, tcp_table_listen(&peer_table, &listener));
+}
+
+void tearDown(void)
+{
+}
+
+/* ========================================================================== */
+
+void test_data_flows_both_ways_after_the_handshake(void)
+{
+    // The SYN waits for ARP, then the handshake completes
+    connect_to_server();
+
+    // Larger than one segment: sent as two, acknowledged at once
+    send_pattern(&client, 2000);
+    run_link();
+    assert_pattern(&server, 2000);
+    TEST_ASSERT_EQUAL(1, client.events[TCP_EVENT_SENT]);
+
+    send_pattern(&server, 500);
+    run_link();
+    assert_pattern(&client, 500);
+
+    struct uip_stats stats;
+    TEST_ASSERT_EQUAL(0, uip_get_stats(&peer, &stats));
+    TEST_ASSERT_EQUAL(4, stats.tcp_segments); /* ACK, 2 x data, ACK */
+    TEST_ASSERT_EQUAL(0, stats.dropped);
+}
+
+void test_single_segment_is_acknowledged_after_the_ack_delay(void)
+{
+    connect_to_server();
+
+    send_pattern(&client, 100);
+    run_link();
+    assert_pattern(&server, 100);
+    TEST_ASSERT_EQUAL(0, client.events[TCP_EVENT_SENT]);
+
+    advance(ACK_DELAY - 10);
+    TEST_ASSERT_EQUAL(0, client.events[TCP_EVENT_SENT]);
+    advance(10);
+    TEST_ASSERT_EQUAL(1, client.events[TCP_EVENT_SENT]);
+
+    // An answer carries the ACK without waiting
+    send_pattern(&client, 100);
+    run_link();
+    send_pattern(&server, 10);
+    run_link();
+    TEST_ASSERT_EQUAL(2, client.events[TCP_EVENT_SENT]);
+}
+
+void test_lost_segment_is_retransmitted_with_backoff(void)
+{
+    // The handshake took no time: the RTO drops from 1000 to RTO_MIN
+    connect_to_server();
+
+    drop_count = 2;
+    send_pattern(&client, 100);
+    advance(RTO_MIN - 10);
+    TEST_ASSERT_EQUAL(0, server.received_size);
+
+    // First retransmission lost too, the next comes after twice the RTO
+    advance(10);
+    advance(2 * RTO_MIN - 10);
+    TEST_ASSERT_EQUAL(0, server.received_size);
+    advance(10);
+    assert_pattern(&server, 100);
+
+    advance(ACK_DELAY);
+    TEST_ASSERT_EQUAL(1, client.events[TCP_EVENT_SENT]);
+    struct tcp_stats stats;
+    TEST_ASSERT_EQUAL(0, tcp_table_get_stats(&node_table, &stats));
+    TEST_ASSERT_EQUAL(2, stats.retransmits);
+}
+
+void test_three_duplicate_acks_trigger_a_fast_retransmit(void)
+{
+    connect_to_server();
+
+    // The first of five segments is lost, the four others are out of order
+    // and each answered with a duplicate ACK. The third one brings the lost
+    // segment back, and the rest follows its ACK, before any timeout.
+    drop_count = 1;
+    send_pattern(&client, 5 * TCP_MSS_MAX);
+    run_link();
+    assert_pattern(&server, 5 * TCP_MSS_MAX);
+
+    struct tcp_stats stats;
+    TEST_ASSERT_EQUAL(0, tcp_table_get_stats(&node_table, &stats));
+    TEST_ASSERT_EQUAL(1, stats.retransmits);
+    TEST_ASSERT_EQUAL(0, tcp_table_get_stats(&peer_table, &stats));
+    TEST_ASSERT_EQUAL(4, stats.dropped);
+}
+
+void test_connection_to_a_closed_port_is_reset(void)
+{
+    struct tcp_endpoint to   = {.port = SERVER_PORT + 1};
+    struct tcp_conn*    conn = NULL;
+    memcpy(to.ip_addr, PEER_IP, 4);
+    TEST_ASSERT_EQUAL(
+        0, uip_tcp_connect(&node, &to, tcp_handler, &client, &conn));
+    run_link();
+
+    TEST_ASSERT_EQUAL(1, client.events[TCP_EVENT_ABORTED]);
+    TEST_ASSERT_EQUAL(0, client.events[TCP_EVENT_CONNECTED]);
+    TEST_ASSERT_EQUAL(TCP_CLOSED, tcp_conn_get_state(conn));
+    struct tcp_stats stats;
+    TEST_ASSERT_EQUAL(0, tcp_table_get_stats(&peer_table, &stats));
+    TEST_ASSERT_EQUAL(1, stats.resets_sent);
+}
+
+void test_no_event_follows_an_abort_from_the_handler(void)
+{
+    // The data of the client carries the last ACK of the handshake: the
+    // segment connects the server and brings it data
+    client.greeting = 100;
+    server.refuse   = true;
+    struct tcp_endpoint to   = {.port = SERVER_PORT};
+    struct tcp_conn*    conn = NULL;
+    memcpy(to.ip_addr, PEER_IP, 4);
+    TEST_ASSERT_EQUAL(
+        0, uip_tcp_connect(&node, &to, tcp_handler, &client, &conn));
+    run_link();
+
+    TEST_ASSERT_EQUAL(1, server.events[TCP_EVENT_CONNECTED]);
+    TEST_ASSERT_EQUAL(0, server.events[TCP_EVENT_RECEIVED]);
+    TEST_ASSERT_EQUAL(TCP_CLOSED, tcp_conn_get_state(server.conn));
+    TEST_ASSERT_EQUAL(1, client.events[TCP_EVENT_ABORTED]);
+}
+
+void test_close_goes_through_time_wait(void)
+{
+    connect_to_server();
+    struct tcp_conn* conn = client.conn;
+
+    // The data still to send goes before the FIN
+    send_pattern(&client, 300);
+    TEST_ASSERT_EQUAL(0, uip_tcp_close(&node, conn));
+    run_link();
+    assert_pattern(&server, 300);
+    TEST_ASSERT_EQUAL(1, server.events[TCP_EVENT_PEER_CLOSED]);
+    TEST_ASSERT_EQUAL(TCP_FIN_WAIT_2, tcp_conn_get_state(conn));
+    TEST_ASSERT_EQUAL(TCP_CLOSE_WAIT, tcp_conn_get_state(server.conn));
+    TEST_ASSERT_EQUAL(-ENOTCONN, uip_tcp_send(&node, conn, 1));
+
+    // The server can still answer, then closes too
+    send_pattern(&server, 50);
+    TEST_ASSERT_EQUAL(0, uip_tcp_close(&peer, server.conn));
+    run_link();
+    assert_pattern(&client, 50);
+    TEST_ASSERT_EQUAL(1, client.events[TCP_EVENT_PEER_CLOSED]);
+    TEST_ASSERT_EQUAL(1, client.events[TCP_EVENT_CLOSED]);
+    TEST_ASSERT_EQUAL(1, server.events[TCP_EVENT_CLOSED]);
+    TEST_ASSERT_EQUAL(TCP_CLOSED, tcp_conn_get_state(server.conn));
+
+    // The client keeps the connection until TIME-WAIT ends
+    TEST_ASSERT_EQUAL(TCP_TIME_WAIT, tcp_conn_get_state(conn));
+    advance(TIME_WAIT - 10);
+    TEST_ASSERT_EQUAL(TCP_TIME_WAIT, tcp_conn_get_state(conn));
+    advance(10);
+    TEST_ASSERT_EQUAL(TCP_CLOSED, tcp_conn_get_state(conn));
+}
+
+void test_reset_does_not_end_time_wait(void)
+{
+    static struct link_frame fin;
+    static struct link_frame ack;
+    connect_to_server();
+    TEST_ASSERT_EQUAL(0, uip_tcp_close(&node, client.conn));
+    run_link();
+    TEST_ASSERT_EQUAL(0, uip_tcp_close(&peer, server.conn));
+    take_frame(&fin);
+    uip_input(&node, fin.data, fin.size);
+    take_frame(&ack);
+    uip_input(&peer, ack.data, ack.size);
+    TEST_ASSERT_EQUAL(TCP_CLOSED, tcp_conn_get_state(server.conn));
+    TEST_ASSERT_EQUAL(TCP_TIME_WAIT, tcp_conn_get_state(client.conn));
+
+    // The last ACK again finds no connection: the server resets it, right in
+    // the window of the client
+    uip_input(&peer, ack.data, ack.size);
+    TEST_ASSERT_EQUAL(1, link_used);
+    run_link();
+    TEST_ASSERT_EQUAL(TCP_TIME_WAIT, tcp_conn_get_state(client.conn));
+    TEST_ASSERT_EQUAL(0, client.events[TCP_EVENT_ABORTED]);
+    advance(TIME_WAIT);
+    TEST_ASSERT_EQUAL(TCP_CLOSED, tcp_conn_get_state(client.conn));
+}
+
+void test_fin_sent_again_in_close_wait_is_acknowledged(void)
+{
+    static struct link_frame fin;
+    connect_to_server();
+
+    TEST_ASSERT_EQUAL(0, uip_tcp_close(&node, client.conn));
+    TEST_ASSERT_EQUAL(1, link_used);
+    fin = link_frames[link_head];
+    run_link();
+    TEST_ASSERT_EQUAL(TCP_CLOSE_WAIT, tcp_conn_get_state(server.conn));
+
+    // The client missed the ACK and sends its FIN again: the server answers
+    // right away, without taking the FIN a second time
+    uip_input(&peer, fin.data, fin.size);
+    TEST_ASSERT_EQUAL(1, link_used);
+    TEST_ASSERT_EQUAL_PTR(&node, link_frames[link_head].to);
+    run_link();
+    TEST_ASSERT_EQUAL(1, server.events[TCP_EVENT_PEER_CLOSED]);
+    TEST_ASSERT_EQUAL(TCP_CLOSE_WAIT, tcp_conn_get_state(server.conn));
+    TEST_ASSERT_EQUAL(TCP_FIN_WAIT_2, tcp_conn_get_state(client.conn));
+}
+
+void test_duplicate_segment_is_dropped_and_acknowledged(void)
+{
+    static struct link_frame data;
+    connect_to_server();
+
+    send_pattern(&client, 100);
+    take_frame(&data);
+    uip_input(&peer, data.data, data.size);
+    assert_pattern(&server, 100);
+
+    // Its ACK was lost and the segment comes again: the server answers at
+    // once and leaves the data already received alone
+    uip_input(&peer, data.data, data.size);
+    TEST_ASSERT_EQUAL(1, link_used);
+    TEST_ASSERT_EQUAL_PTR(&node, link_frames[link_head].to);
+    run_link();
+    TEST_ASSERT_EQUAL(1, client.events[TCP_EVENT_SENT]);
+    assert_pattern(&server, 100);
+    TEST_ASSERT_EQUAL(1, server.events[TCP_EVENT_RECEIVED]);
+    struct tcp_stats stats;
+    TEST_ASSERT_EQUAL(0, tcp_table_get_stats(&peer_table, &stats));
+    TEST_ASSERT_EQUAL(1, stats.dropped);
+}
+
+void test_delayed_segment_does_not_shrink_the_window_back(void)
+{
+    static struct link_frame late;
+    connect_to_server();
+
+    // The client holds 2000 bytes: its next segment advertises less room
+    client.hold = true;
+    send_pattern(&server, 2000);
+    run_link();
+    send_pattern(&client, 100);
+    take_frame(&late);
+
+    // The client reads them: the window update overtakes the segment
+    TEST_ASSERT_EQUAL(0, uip_tcp_consume(&node, client.conn, 2000));
+    TEST_ASSERT_EQUAL(1, link_used);
+    run_link();
+    uip_input(&peer, late.data, late.size);
+    assert_pattern(&server, 100);
+
+    // The whole window is still open to the server
+    send_pattern(&server, BUF_SIZE - 2000);
+    send_pattern(&server, 2000);
+    TEST_ASSERT_EQUAL(BUF_SIZE, queued_payload(&node));
+}
+
+void test_initial_sequence_number_is_keyed_with_the_secret(void)
+{
+    static struct link_frame syn;
+    static const uint32_t    secrets[3] = {0x2545F491, 0x9E3779B9, 0x2545F491};
+    uint32_t                 iss[3];
+    connect_to_server(); /* Resolves the peer: the SYNs go out at once */
+
+    // Same clock, ports and addresses each time, only the secret changes
+    struct tcp_endpoint to = {.port = SERVER_PORT};
+    memcpy(to.ip_addr, PEER_IP, 4);
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        struct tcp_conn* conn = NULL;
+        random_value          = secrets[i];
+        TEST_ASSERT_EQUAL(0, tcp_table_init(&node_table));
+        TEST_ASSERT_EQUAL(
+            0, uip_tcp_connect(&node, &to, tcp_handler, &client, &conn));
+        take_frame(&syn);
+        const uint8_t* seq = syn.data + TCP_CONN_HEADROOM + 4;
+        iss[i] = (uint32_t)seq[0] << 24 | (uint32_t)seq[1] << 16
+                 | (uint32_t)seq[2] << 8 | seq[3];
+    }
+    TEST_ASSERT_TRUE(iss[0] != iss[1]);
+    TEST_ASSERT_EQUAL_HEX32(iss[0], iss[2]);
+}
+
+void test_tcp_calls_without_a_table_are_refused(void)
+{
+    struct uip bare = {
+        .ip_addr = {192, 168, 1, 30},
+        .send    = link_send,
+    };
+    struct tcp_endpoint to   = {.port = SERVER_PORT};
+    struct tcp_conn*    conn = NULL;
+    TEST_ASSERT_EQUAL(0, uip_init(&bare));
+    TEST_ASSERT_EQUAL(
+        -ENOTSUP, uip_tcp_connect(&bare, &to, tcp_handler, &client, &conn));
+    TEST_ASSERT_EQUAL(-ENOTSUP, uip_tcp_send(&bare, conn, 0));
+    TEST_ASSERT_EQUAL(-ENOTSUP, uip_tcp_close(&bare, conn));
+}
+
+/* ========================================================================== */
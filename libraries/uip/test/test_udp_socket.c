@@ -0,0 +1,229 @@
+#include "unity.h"
+
+/* ========================================================================== */
+
+#include "../../inc/errno.h"
+#include "../inc/udp_socket.h"
+
+#include <string.h>
+
+TEST_SOURCE_FILE("../src/udp_socket.c")
+TEST_SOURCE_FILE("../../ring-buffer/src/ring_buffer.c")
+
+/* ========================================================================== */
+
+static const uint8_t PEER_IP[4] = {192, 168, 1, 20};
+
+static struct udp_socket* slots[8];
+static struct udp_table   table = {.slots = slots, .capacity = 8};
+
+static int handled_count;
+
+static void count_datagram(void* context, const struct udp_rx_metadata* mdata)
+{
+    (void)mdata;
+    *(int*)context += 1;
+}
+
+static struct ip_rx_metadata  datagram_ip_mdata;
+static struct udp_rx_metadata datagram_mdata;
+
+static const struct udp_rx_metadata*
+make_datagram(uint16_t src_port, const uint8_t* payload, uint16_t size)
+{
+    memset(&datagram_ip_mdata, 0, sizeof(datagram_ip_mdata));
+    memcpy(datagram_ip_mdata.src_ip, PEER_IP, 4);
+    datagram_mdata.ip_mdata     = &datagram_ip_mdata;
+    datagram_mdata.src_port_num = src_port;
+    datagram_mdata.payload      = payload;
+    datagram_mdata.payload_size = size;
+    return &datagram_mdata;
+}
+
+/* ========================================================================== */
+
+void setUp(void)
+{
+    handled_count = 0;
+    TEST_ASSERT_EQUAL(0, udp_table_init(&table));
+}
+
+void tearDown(void)
+{
+}
+
+/* ========================================================================== */
+
+void test_table_capacity_must_be_a_power_of_two(void)
+{
+    struct udp_socket* few_slots[6];
+    struct udp_table   bad = {.slots = few_slots, .capacity = 6};
+    TEST_ASSERT_EQUAL(-EINVAL, udp_table_init(&bad));
+    struct udp_table no_slots = {.slots = NULL, .capacity = 8};
+    TEST_ASSERT_EQUAL(-EFAULT, udp_table_init(&no_slots));
+}
+
+void test_bind_rejects_duplicate_ports_and_a_full_table(void)
+{
+    static struct udp_socket sockets[7] = {
+        {.port = 1000, .handler = count_datagram},
+        {.port = 1001, .handler = count_datagram},
+        {.port = 1002, .handler = count_datagram},
+        {.port = 1003, .handler = count_datagram},
+        {.port = 1004, .handler = count_datagram},
+        {.port = 1005, .handler = count_datagram},
+        {.port = 1006, .handler = count_datagram},
+    };
+    for (uint16_t i = 0; i < 6; i++)
+    {
+        TEST_ASSERT_EQUAL(0, udp_table_bind(&table, &sockets[i]));
+    }
+    // At most 3/4 of the slots are used
+    TEST_ASSERT_EQUAL(-ENOSPC, udp_table_bind(&table, &sockets[6]));
+
+    struct udp_socket same_port = {.port = 1000, .handler = count_datagram};
+    TEST_ASSERT_EQUAL(-EADDRINUSE, udp_table_bind(&table, &same_port));
+    struct udp_socket no_sink = {.port = 2000};
+    TEST_ASSERT_EQUAL(-EINVAL, udp_table_bind(&table, &no_sink));
+
+    for (uint16_t i = 0; i < 6; i++)
+    {
+        TEST_ASSERT_EQUAL_PTR(
+            &sockets[i], udp_table_lookup(&table, (uint16_t)(1000 + i)));
+    }
+    TEST_ASSERT_NULL(udp_table_lookup(&table, 1006));
+}
+
+void test_unbind_keeps_colliding_ports_reachable(void)
+{
+    // Ports 8, 16 and 21 hash to the last slot, so their probe sequence wraps
+    // around; port 5 hashes to the first slot and lands after them
+    static struct udp_socket sockets[4] = {
+        {.port = 8, .handler = count_datagram},
+        {.port = 16, .handler = count_datagram},
+        {.port = 21, .handler = count_datagram},
+        {.port = 5, .handler = count_datagram},
+    };
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        TEST_ASSERT_EQUAL(0, udp_table_bind(&table, &sockets[i]));
+    }
+
+    TEST_ASSERT_EQUAL(0, udp_table_unbind(&table, &sockets[0]));
+    TEST_ASSERT_EQUAL(-ENOENT, udp_table_unbind(&table, &sockets[0]));
+    TEST_ASSERT_NULL(udp_table_lookup(&table, 8));
+    for (uint8_t i = 1; i < 4; i++)
+    {
+        TEST_ASSERT_EQUAL_PTR(
+            &sockets[i], udp_table_lookup(&table, sockets[i].port));
+    }
+
+    TEST_ASSERT_EQUAL(0, udp_table_unbind(&table, &sockets[2]));
+    TEST_ASSERT_EQUAL_PTR(&sockets[1], udp_table_lookup(&table, 16));
+    TEST_ASSERT_EQUAL_PTR(&sockets[3], udp_table_lookup(&table, 5));
+    TEST_ASSERT_NULL(udp_table_lookup(&table, 21));
+}
+
+void test_ephemeral_ports_are_bound_and_found(void)
+{
+    // port * multiplier exceeds INT_MAX from port 53021 on
+    static struct udp_socket sockets[4] = {
+        {.port = 49152, .handler = count_datagram},
+        {.port = 53021, .handler = count_datagram},
+        {.port = 61000, .handler = count_datagram},
+        {.port = 65535, .handler = count_datagram},
+    };
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        TEST_ASSERT_EQUAL(0, udp_table_bind(&table, &sockets[i]));
+    }
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        TEST_ASSERT_EQUAL_PTR(
+            &sockets[i], udp_table_lookup(&table, sockets[i].port));
+    }
+    TEST_ASSERT_EQUAL(0, udp_table_unbind(&table, &sockets[3]));
+    TEST_ASSERT_NULL(udp_table_lookup(&table, 65535));
+    TEST_ASSERT_EQUAL_PTR(&sockets[2], udp_table_lookup(&table, 61000));
+}
+
+void test_handler_socket_gets_each_datagram(void)
+{
+    struct udp_socket socket = {
+        .port    = 7,
+        .handler = count_datagram,
+        .context = &handled_count,
+    };
+    TEST_ASSERT_EQUAL(0, udp_table_bind(&table, &socket));
+    uint8_t payload[4] = {1, 2, 3, 4};
+    TEST_ASSERT_EQUAL(
+        0, udp_socket_deliver(&socket, make_datagram(5000, payload, 4)));
+    TEST_ASSERT_EQUAL(1, handled_count);
+
+    uint8_t  buffer[4];
+    uint16_t size = 0;
+    TEST_ASSERT_EQUAL(
+        -ENOTSUP, udp_socket_receive(&socket, buffer, 4, &size, NULL));
+}
+
+void test_queued_datagrams_are_received_in_order(void)
+{
+    uint8_t            queue_buffer[64];
+    struct ring_buffer queue = {
+        .buffer    = queue_buffer,
+        .size      = sizeof(queue_buffer),
+        .overwrite = false,
+    };
+    TEST_ASSERT_EQUAL(0, ring_buffer_init(&queue));
+    struct udp_socket socket = {.port = 7, .rx_queue = &queue};
+    TEST_ASSERT_EQUAL(0, udp_table_bind(&table, &socket));
+
+    uint8_t  buffer[32];
+    uint16_t size = 0;
+    TEST_ASSERT_EQUAL(
+        -ENODATA,
+        udp_socket_receive(&socket, buffer, sizeof(buffer), &size, NULL));
+
+    const uint8_t first[3]   = {0xA1, 0xA2, 0xA3};
+    const uint8_t second[20] = {0xB1};
+    TEST_ASSERT_EQUAL(
+        0, udp_socket_deliver(&socket, make_datagram(5000, first, 3)));
+    TEST_ASSERT_EQUAL(
+        0, udp_socket_deliver(&socket, make_datagram(5001, second, 20)));
+    TEST_ASSERT_EQUAL(
+        0, udp_socket_deliver(&socket, make_datagram(5002, NULL, 0)));
+    // 3 x 8 header bytes and 23 payload bytes leave room for 16 more
+    TEST_ASSERT_EQUAL(
+        -ENOSPC, udp_socket_deliver(&socket, make_datagram(5003, second, 9)));
+
+    struct udp_endpoint from;
+    TEST_ASSERT_EQUAL(
+        0, udp_socket_receive(&socket, buffer, sizeof(buffer), &size, &from));
+    TEST_ASSERT_EQUAL(3, size);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(first, buffer, 3);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(PEER_IP, from.ip_addr, 4);
+    TEST_ASSERT_EQUAL(5000, from.port);
+
+    // A datagram larger than the buffer is truncated, the rest discarded
+    TEST_ASSERT_EQUAL(
+        -EMSGSIZE, udp_socket_receive(&socket, buffer, 8, &size, &from));
+    TEST_ASSERT_EQUAL(8, size);
+    TEST_ASSERT_EQUAL_HEX8(0xB1, buffer[0]);
+    TEST_ASSERT_EQUAL(5001, from.port);
+
+    TEST_ASSERT_EQUAL(
+        0, udp_socket_receive(&socket, buffer, sizeof(buffer), &size, &from));
+    TEST_ASSERT_EQUAL(0, size);
+    TEST_ASSERT_EQUAL(5002, from.port);
+    TEST_ASSERT_EQUAL(
+        -ENODATA,
+        udp_socket_receive(&socket, buffer, sizeof(buffer), &size, NULL));
+
+    uint32_t received = 0;
+    uint32_t dropped  = 0;
+    TEST_ASSERT_EQUAL(0, udp_socket_get_stats(&socket, &received, &dropped));
+    TEST_ASSERT_EQUAL(3, received);
+    TEST_ASSERT_EQUAL(1, dropped);
+}
+
+/* ========================================================================== */
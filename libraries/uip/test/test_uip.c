@@ -0,0 +1,738 @@
+#include "unity.h"
+
+/* ========================================================================== */
+
+#include "../../inc/errno.h"
+#include "../inc/uip.h"
+#include "../inc/utils.h"
+
+#include <string.h>
+
+TEST_SOURCE_FILE("../src/arp.c")
+TEST_SOURCE_FILE("../src/arp_cache.c")
+TEST_SOURCE_FILE("../src/eth.c")
+TEST_SOURCE_FILE("../src/icmp.c")
+TEST_SOURCE_FILE("../src/ip.c")
+TEST_SOURCE_FILE("../src/ip_reasm.c")
+TEST_SOURCE_FILE("../src/pbuf.c")
+TEST_SOURCE_FILE("../src/tcp.c")
+TEST_SOURCE_FILE("../src/tcp_conn.c")
+TEST_SOURCE_FILE("../src/udp.c")
+TEST_SOURCE_FILE("../src/udp_socket.c")
+TEST_SOURCE_FILE("../src/utils.c")
+TEST_SOURCE_FILE("../src/uip.c")
+TEST_SOURCE_FILE("../../packet-pool/src/packet_pool.c")
+TEST_SOURCE_FILE("../../ring-buffer/src/ring_buffer.c")
+
+/* ========================================================================== */
+
+static const uint8_t NODE_IP[4]  = {192, 168, 1, 10};
+static const uint8_t NODE_MAC[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+static const uint8_t PEER_IP[4]  = {192, 168, 1, 20};
+static const uint8_t PEER_MAC[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02};
+
+static const uint8_t ETH_BROADCAST_MAC[6]
+    = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+static uint8_t        sent_frame[MAX_ETH_PKT_SIZE];
+static const uint8_t* sent_from;
+static uint16_t       sent_size;
+static int            sent_count;
+
+/* The first frames sent, e.g. the fragments of one datagram */
+static uint8_t  first_frames[2][MAX_ETH_PKT_SIZE];
+static uint16_t first_sizes[2];
+
+static int8_t fake_send(void* context, uint8_t* frame, uint16_t size)
+{
+    (void)context;
+    memcpy(sent_frame, frame, size);
+    if (sent_count < 2)
+    {
+        memcpy(first_frames[sent_count], frame, size);
+        first_sizes[sent_count] = size;
+    }
+    sent_from = frame;
+    sent_size = size;
+    sent_count += 1;
+    return 0;
+}
+
+static struct udp_socket* slots[8];
+static struct udp_table   table = {.slots = slots, .capacity = 8};
+
+static struct arp_entry arp_entries[4];
+static struct arp_cache arp_cache = {
+    .entries        = arp_entries,
+    .capacity       = 4,
+    .max_age        = 1000,
+    .retry_interval = 100,
+    .max_requests   = 3,
+};
+static uint8_t tx_queue[256];
+
+static struct ip_reasm_slot reasm_slots[1];
+static uint8_t              reasm_storage[2048];
+static struct ip_reasm      reasm = {
+    .slots      = reasm_slots,
+    .storage    = reasm_storage,
+    .slot_count = 1,
+    .slot_size  = sizeof(reasm_storage),
+    .timeout    = 1000,
+};
+
+static struct uip stack = {
+    .ip_addr       = {192, 168, 1, 10},
+    .mac_addr      = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01},
+    .send          = fake_send,
+    .udp_table     = &table,
+    .arp_cache     = &arp_cache,
+    .tx_queue      = tx_queue,
+    .tx_queue_size = sizeof(tx_queue),
+    .ip_reasm      = &reasm,
+};
+
+static uint8_t  received_payload[2048];
+static uint16_t received_size;
+static uint16_t received_src_port;
+static int      received_count;
+
+static void udp_handler(void* context, const struct udp_rx_metadata* mdata)
+{
+    *(int*)context += 1;
+    memcpy(received_payload, mdata->payload, mdata->payload_size);
+    received_size     = mdata->payload_size;
+    received_src_port = mdata->src_port_num;
+}
+
+static struct udp_socket handler_socket = {
+    .port    = 1234,
+    .handler = udp_handler,
+    .context = &received_count,
+};
+
+/* ========================================================================== */
+
+static uint16_t finish_eth_frame(
+    uint8_t*              frame,
+    enum eth_payload_type type,
+    const uint8_t*        dest_mac,
+    uint16_t              payload_size)
+{
+    struct eth             peer = {.calc_crc = false};
+    struct eth_tx_metadata mdata
+        = {.payload_type = type, .payload_size = payload_size};
+    uint16_t size = 0;
+    memcpy(peer.mac_addr, PEER_MAC, 6);
+    memcpy(mdata.dest_mac_addr, dest_mac, 6);
+    TEST_ASSERT_EQUAL(0, eth_build_frame(&peer, &mdata, frame, &size));
+    // Room for the padding and FCS the MAC delivers with the frame
+    return (size < 60) ? 64 : size + 4;
+}
+
+static uint16_t build_ip_frame(
+    uint8_t*              frame,
+    enum ip_pld_prot_type prot,
+    const uint8_t*        dest_ip,
+    uint16_t              payload_size)
+{
+    struct ip             peer  = {.ip_addr = {0}};
+    struct ip_tx_metadata mdata = {
+        .version       = IP_VER_4,
+        .pld_prot_type = prot,
+        .payload_size  = payload_size,
+    };
+    uint16_t size = 0;
+    memcpy(mdata.src_ip, PEER_IP, 4);
+    memcpy(mdata.dest_ip, dest_ip, 4);
+    TEST_ASSERT_EQUAL(
+        0, ip_build_frame(&peer, &mdata, frame + IP_FRAME_OFST, &size));
+    return finish_eth_frame(frame, ETH_PLD_IPV4, NODE_MAC, size);
+}
+
+static uint16_t build_udp_frame(
+    uint8_t*       frame,
+    const uint8_t* dest_ip,
+    uint16_t       dest_port,
+    const uint8_t* payload,
+    uint16_t       payload_size)
+{
+    struct udp            peer     = {0};
+    struct ip_tx_metadata ip_mdata = {0};
+    memcpy(ip_mdata.src_ip, PEER_IP, 4);
+    memcpy(ip_mdata.dest_ip, dest_ip, 4);
+    struct udp_tx_metadata mdata = {
+        .ip_mdata      = &ip_mdata,
+        .src_port_num  = 5000,
+        .dest_port_num = dest_port,
+        .payload_size  = payload_size,
+    };
+    uint16_t size = 0;
+    memcpy(frame + UDP_PAYLOAD_OFST, payload, payload_size);
+    TEST_ASSERT_EQUAL(
+        0, udp_build_frame(&peer, &mdata, frame + UDP_FRAME_OFST, &size));
+    return build_ip_frame(frame, IP_PLD_UDP, dest_ip, size);
+}
+
+/**
+ * @brief Build the IPv4 fragment of a UDP datagram from the peer holding
+ * [offset, offset + size) of the datagram.
+ */
+static uint16_t build_fragment(
+    uint8_t*       frame,
+    const uint8_t* datagram,
+    uint16_t       offset,
+    uint16_t       size,
+    bool           more)
+{
+    struct ip             peer  = {.ip_addr = {0}};
+    struct ip_tx_metadata mdata = {
+        .version        = IP_VER_4,
+        .pld_prot_type  = IP_PLD_UDP,
+        .payload_size   = size,
+        .id             = 0x4242,
+        .frag_offset    = offset,
+        .more_fragments = more,
+    };
+    uint16_t ip_size = 0;
+    memcpy(mdata.src_ip, PEER_IP, 4);
+    memcpy(mdata.dest_ip, NODE_IP, 4);
+    memcpy(frame + UDP_FRAME_OFST, datagram + offset, size);
+    TEST_ASSERT_EQUAL(
+        0, ip_build_frame(&peer, &mdata, frame + IP_FRAME_OFST, &ip_size));
+    return finish_eth_frame(frame, ETH_PLD_IPV4, NODE_MAC, ip_size);
+}
+
+/**
+ * @brief Build an IPv4 packet from this node behind ETH_HEADER_SIZE bytes of
+ * headroom, as given to uip_output().
+ */
+static uint16_t build_output_frame(
+    uint8_t* frame, const uint8_t* dest_ip, uint16_t payload_size)
+{
+    struct ip             node  = {.ip_addr = {0}};
+    struct ip_tx_metadata mdata = {
+        .version       = IP_VER_4,
+        .pld_prot_type = IP_PLD_UDP,
+        .payload_size  = payload_size,
+    };
+    uint16_t size = 0;
+    memcpy(mdata.src_ip, NODE_IP, 4);
+    memcpy(mdata.dest_ip, dest_ip, 4);
+    TEST_ASSERT_EQUAL(
+        0, ip_build_frame(&node, &mdata, frame + IP_FRAME_OFST, &size));
+    return ETH_HEADER_SIZE + size;
+}
+
+static uint16_t build_arp_frame(
+    uint8_t* frame, enum arp_op_type op_type, const uint8_t* dest_mac)
+{
+    struct arp             peer;
+    struct arp_tx_metadata mdata = {.op_type = op_type};
+    uint8_t                size  = 0;
+    memcpy(peer.ip_addr, PEER_IP, 4);
+    memcpy(peer.mac_addr, PEER_MAC, 6);
+    memcpy(mdata.dest_ip_addr, NODE_IP, 4);
+    if (op_type == ARP_REPLY)
+    {
+        memcpy(mdata.dest_mac_addr, NODE_MAC, 6);
+    }
+    TEST_ASSERT_EQUAL(
+        0, arp_build_frame(&peer, &mdata, frame + ETH_HEADER_SIZE, &size));
+    return finish_eth_frame(frame, ETH_PLD_ARP, dest_mac, size);
+}
+
+static bool checksum_is_valid(const uint8_t* data, uint16_t size)
+{
+    struct slice data_slice = {.base = data, .len = size};
+    return compute_inet_checksum(&data_slice, 1) == 0;
+}
+
+/* ========================================================================== */
+
+void setUp(void)
+{
+    memset(sent_frame, 0, sizeof(sent_frame));
+    sent_size      = 0;
+    sent_count     = 0;
+    received_count = 0;
+    TEST_ASSERT_EQUAL(0, udp_table_init(&table));
+    TEST_ASSERT_EQUAL(0, arp_cache_init(&arp_cache));
+    TEST_ASSERT_EQUAL(0, ip_reasm_init(&reasm));
+    TEST_ASSERT_EQUAL(0, uip_init(&stack));
+}
+
+void tearDown(void)
+{
+}
+
+/* ========================================================================== */
+
+void test_arp_request_is_answered(void)
+{
+    uint8_t  frame[64] = {0};
+    uint16_t frame_size
+        = build_arp_frame(frame, ARP_REQUEST, ETH_BROADCAST_MAC);
+
+    TEST_ASSERT_EQUAL(0, uip_input(&stack, frame, frame_size));
+    TEST_ASSERT_EQUAL(1, sent_count);
+    TEST_ASSERT_EQUAL(ETH_HEADER_SIZE + ARP_PACKET_SIZE, sent_size);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(PEER_MAC, sent_frame, 6);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(NODE_MAC, &sent_frame[6], 6);
+    const uint8_t* arp = &sent_frame[ETH_HEADER_SIZE];
+    TEST_ASSERT_EQUAL_HEX8(0x02, arp[7]); // Reply
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(NODE_MAC, &arp[8], 6);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(NODE_IP, &arp[14], 4);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(PEER_MAC, &arp[18], 6);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(PEER_IP, &arp[24], 4);
+
+    // A request for another address is ignored
+    memcpy(frame, sent_frame, sizeof(frame));
+    TEST_ASSERT_EQUAL(-ENOENT, uip_input(&stack, frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL(1, sent_count);
+}
+
+void test_icmp_echo_request_is_answered_in_place(void)
+{
+    uint8_t                 frame[128] = {0};
+    uint8_t*                icmp       = frame + ICMP_FRAME_OFST;
+    struct icmp             peer       = {0};
+    struct icmp_tx_metadata mdata      = {
+        .type = 8, .code = 0, .id = 0x1234, .seq_num = 7, .payload_size = 32};
+    uint16_t size = 0;
+    for (uint8_t i = 0; i < 32; i++)
+    {
+        icmp[ICMP_HEADER_SIZE + i] = i;
+    }
+    TEST_ASSERT_EQUAL(0, icmp_build_frame(&peer, &mdata, icmp, &size));
+    uint16_t frame_size = build_ip_frame(frame, IP_PLD_ICMP, NODE_IP, size);
+
+    TEST_ASSERT_EQUAL(0, uip_input(&stack, frame, frame_size));
+    TEST_ASSERT_EQUAL(1, sent_count);
+    TEST_ASSERT_EQUAL(ICMP_PAYLOAD_OFST + 32, sent_size);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(PEER_MAC, sent_frame, 6);
+    const uint8_t* ip = &sent_frame[IP_FRAME_OFST];
+    TEST_ASSERT_TRUE(checksum_is_valid(ip, IP_HEADER_SIZE));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(NODE_IP, &ip[12], 4);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(PEER_IP, &ip[16], 4);
+    TEST_ASSERT_TRUE(checksum_is_valid(&sent_frame[ICMP_FRAME_OFST], size));
+    TEST_ASSERT_EQUAL_HEX8(0, sent_frame[ICMP_FRAME_OFST]); // Echo reply
+    TEST_ASSERT_EQUAL_HEX8(0x12, sent_frame[ICMP_FRAME_OFST + 4]);
+    TEST_ASSERT_EQUAL_HEX8(7, sent_frame[ICMP_FRAME_OFST + 7]);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(
+        &icmp[ICMP_HEADER_SIZE], &sent_frame[ICMP_PAYLOAD_OFST], 32);
+
+    struct uip_stats stats;
+    TEST_ASSERT_EQUAL(0, uip_get_stats(&stack, &stats));
+    TEST_ASSERT_EQUAL(1, stats.icmp_echo_replies);
+    TEST_ASSERT_EQUAL(0, stats.dropped);
+}
+
+void test_udp_datagram_is_delivered_to_its_socket(void)
+{
+    TEST_ASSERT_EQUAL(0, udp_table_bind(&table, &handler_socket));
+
+    // Longer than 255 bytes: the UDP length field has a high byte
+    uint8_t frame[400] = {0};
+    uint8_t payload[300];
+    for (uint16_t i = 0; i < sizeof(payload); i++)
+    {
+        payload[i] = (uint8_t)(i * 7);
+    }
+    uint16_t frame_size
+        = build_udp_frame(frame, NODE_IP, 1234, payload, sizeof(payload));
+    TEST_ASSERT_EQUAL(0, uip_input(&stack, frame, frame_size));
+    TEST_ASSERT_EQUAL(1, received_count);
+    TEST_ASSERT_EQUAL(sizeof(payload), received_size);
+    TEST_ASSERT_EQUAL(5000, received_src_port);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(payload, received_payload, sizeof(payload));
+    TEST_ASSERT_EQUAL(0, sent_count);
+
+    // A zero checksum means none was computed
+    frame_size = build_udp_frame(frame, NODE_IP, 1234, payload, 10);
+    frame[UDP_FRAME_OFST + 6] = 0;
+    frame[UDP_FRAME_OFST + 7] = 0;
+    TEST_ASSERT_EQUAL(0, uip_input(&stack, frame, frame_size));
+    TEST_ASSERT_EQUAL(2, received_count);
+
+    // A corrupted datagram is not delivered
+    frame_size = build_udp_frame(frame, NODE_IP, 1234, payload, 10);
+    frame[UDP_PAYLOAD_OFST] ^= 0x01;
+    TEST_ASSERT_EQUAL(-EINVAL, uip_input(&stack, frame, frame_size));
+    TEST_ASSERT_EQUAL(2, received_count);
+
+    // No socket is bound to that port
+    frame_size = build_udp_frame(frame, NODE_IP, 1235, payload, 10);
+    TEST_ASSERT_EQUAL(-ENOENT, uip_input(&stack, frame, frame_size));
+
+    struct uip_stats stats;
+    TEST_ASSERT_EQUAL(0, uip_get_stats(&stack, &stats));
+    TEST_ASSERT_EQUAL(4, stats.rx_frames);
+    TEST_ASSERT_EQUAL(2, stats.udp_delivered);
+    TEST_ASSERT_EQUAL(2, stats.dropped);
+}
+
+void test_udp_datagram_is_dropped_when_its_socket_queue_is_full(void)
+{
+    uint8_t            queue_buffer[32];
+    struct ring_buffer queue = {
+        .buffer    = queue_buffer,
+        .size      = sizeof(queue_buffer),
+        .overwrite = false,
+    };
+    TEST_ASSERT_EQUAL(0, ring_buffer_init(&queue));
+    struct udp_socket socket = {.port = 1234, .rx_queue = &queue};
+    TEST_ASSERT_EQUAL(0, udp_table_bind(&table, &socket));
+
+    uint8_t  frame[128]  = {0};
+    uint8_t  payload[16]  = {1, 2, 3};
+    uint16_t frame_size
+        = build_udp_frame(frame, NODE_IP, 1234, payload, sizeof(payload));
+    TEST_ASSERT_EQUAL(0, uip_input(&stack, frame, frame_size));
+    frame_size
+        = build_udp_frame(frame, NODE_IP, 1234, payload, sizeof(payload));
+    TEST_ASSERT_EQUAL(-ENOSPC, uip_input(&stack, frame, frame_size));
+
+    uint8_t             buffer[32];
+    uint16_t            size = 0;
+    struct udp_endpoint from;
+    TEST_ASSERT_EQUAL(
+        0, udp_socket_receive(&socket, buffer, sizeof(buffer), &size, &from));
+    TEST_ASSERT_EQUAL(sizeof(payload), size);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(payload, buffer, sizeof(payload));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(PEER_IP, from.ip_addr, 4);
+    TEST_ASSERT_EQUAL(5000, from.port);
+
+    struct uip_stats stats;
+    TEST_ASSERT_EQUAL(0, uip_get_stats(&stack, &stats));
+    TEST_ASSERT_EQUAL(1, stats.udp_delivered);
+    TEST_ASSERT_EQUAL(1, stats.dropped);
+}
+
+void test_frames_for_other_nodes_are_dropped(void)
+{
+    TEST_ASSERT_EQUAL(0, udp_table_bind(&table, &handler_socket));
+    uint8_t              frame[128]  = {0};
+    static const uint8_t other_ip[4] = {192, 168, 1, 11};
+    uint16_t frame_size = build_udp_frame(frame, other_ip, 1234, frame, 0);
+    TEST_ASSERT_EQUAL(-ENOENT, uip_input(&stack, frame, frame_size));
+
+    frame_size = build_udp_frame(frame, NODE_IP, 1234, frame, 0);
+    frame[0] ^= 0x02; // Other unicast MAC
+    TEST_ASSERT_EQUAL(-ENOENT, uip_input(&stack, frame, frame_size));
+
+    // IP total length beyond the received frame
+    frame_size = build_udp_frame(frame, NODE_IP, 1234, frame, 0);
+    frame[IP_FRAME_OFST + 2] = 0x05;
+    TEST_ASSERT_EQUAL(-EINVAL, uip_input(&stack, frame, frame_size));
+
+    TEST_ASSERT_EQUAL(-EINVAL, uip_input(&stack, frame, 20));
+    TEST_ASSERT_EQUAL(0, received_count);
+    TEST_ASSERT_EQUAL(0, sent_count);
+}
+
+void test_output_waits_for_arp_then_sends(void)
+{
+    uint8_t  frame[128] = {0};
+    uint16_t frame_size = build_output_frame(frame, PEER_IP, 8);
+    TEST_ASSERT_EQUAL(-EINPROGRESS, uip_output(&stack, frame, frame_size));
+    TEST_ASSERT_EQUAL(1, sent_count);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(ETH_BROADCAST_MAC, sent_frame, 6);
+    TEST_ASSERT_EQUAL_HEX8(0x06, sent_frame[13]); // ARP
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(
+        PEER_IP, &sent_frame[ETH_HEADER_SIZE + 24], 4);
+
+    // The request is outstanding: no second one
+    TEST_ASSERT_EQUAL(-EINPROGRESS, uip_output(&stack, frame, frame_size));
+    TEST_ASSERT_EQUAL(1, sent_count);
+
+    // The reply releases both frames
+    uint8_t  reply[64]  = {0};
+    uint16_t reply_size = build_arp_frame(reply, ARP_REPLY, NODE_MAC);
+    TEST_ASSERT_EQUAL(0, uip_input(&stack, reply, reply_size));
+    TEST_ASSERT_EQUAL(3, sent_count);
+    TEST_ASSERT_EQUAL(frame_size, sent_size);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(PEER_MAC, sent_frame, 6);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(NODE_MAC, &sent_frame[6], 6);
+    TEST_ASSERT_EQUAL_HEX8(0x00, sent_frame[13]); // IPv4
+
+    // Resolved: sent right away
+    TEST_ASSERT_EQUAL(0, uip_output(&stack, frame, frame_size));
+    TEST_ASSERT_EQUAL(4, sent_count);
+
+    struct uip_stats stats;
+    TEST_ASSERT_EQUAL(0, uip_get_stats(&stack, &stats));
+    TEST_ASSERT_EQUAL(3, stats.tx_frames);
+    TEST_ASSERT_EQUAL(2, stats.tx_queued);
+    TEST_ASSERT_EQUAL(0, stats.tx_dropped);
+    TEST_ASSERT_EQUAL(1, stats.arp_requests);
+}
+
+void test_output_to_a_sender_needs_no_arp(void)
+{
+    TEST_ASSERT_EQUAL(0, udp_table_bind(&table, &handler_socket));
+    uint8_t  frame[128] = {0};
+    uint16_t frame_size = build_udp_frame(frame, NODE_IP, 1234, frame, 4);
+    TEST_ASSERT_EQUAL(0, uip_input(&stack, frame, frame_size));
+
+    frame_size = build_output_frame(frame, PEER_IP, 8);
+    TEST_ASSERT_EQUAL(0, uip_output(&stack, frame, frame_size));
+    TEST_ASSERT_EQUAL(1, sent_count);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(PEER_MAC, sent_frame, 6);
+}
+
+void test_frames_for_an_unanswered_address_are_dropped(void)
+{
+    uint8_t  frame[128] = {0};
+    uint16_t frame_size = build_output_frame(frame, PEER_IP, 8);
+    TEST_ASSERT_EQUAL(-EINPROGRESS, uip_output(&stack, frame, frame_size));
+    for (uint32_t now = 50; now <= 300; now += 50)
+    {
+        TEST_ASSERT_EQUAL(0, uip_poll(&stack, now));
+    }
+
+    struct uip_stats stats;
+    TEST_ASSERT_EQUAL(0, uip_get_stats(&stack, &stats));
+    TEST_ASSERT_EQUAL(3, stats.arp_requests);
+    TEST_ASSERT_EQUAL(1, stats.tx_dropped);
+    TEST_ASSERT_EQUAL(0, stats.tx_frames);
+
+    // A late reply finds nothing queued
+    uint8_t  reply[64]  = {0};
+    uint16_t reply_size = build_arp_frame(reply, ARP_REPLY, NODE_MAC);
+    TEST_ASSERT_EQUAL(0, uip_input(&stack, reply, reply_size));
+    TEST_ASSERT_EQUAL(3, sent_count);
+}
+
+void test_output_is_dropped_when_every_arp_entry_is_pending(void)
+{
+    // Every entry waits for a reply: the fifth address gets none, and its
+    // frame is not queued where no reply or timeout would ever release it
+    uint8_t  frame[128] = {0};
+    uint8_t  dest_ip[4] = {192, 168, 1, 30};
+    uint16_t frame_size = 0;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        dest_ip[3] = (uint8_t)(30 + i);
+        frame_size = build_output_frame(frame, dest_ip, 8);
+        TEST_ASSERT_EQUAL(-EINPROGRESS, uip_output(&stack, frame, frame_size));
+    }
+    dest_ip[3] = 34;
+    frame_size = build_output_frame(frame, dest_ip, 8);
+    TEST_ASSERT_EQUAL(-ENOSPC, uip_output(&stack, frame, frame_size));
+    TEST_ASSERT_EQUAL(4, sent_count);
+
+    struct uip_stats stats;
+    TEST_ASSERT_EQUAL(0, uip_get_stats(&stack, &stats));
+    TEST_ASSERT_EQUAL(4, stats.tx_queued);
+    TEST_ASSERT_EQUAL(1, stats.tx_dropped);
+
+    // The queued frames are dropped once their addresses are given up
+    for (uint32_t now = 50; now <= 300; now += 50)
+    {
+        TEST_ASSERT_EQUAL(0, uip_poll(&stack, now));
+    }
+    TEST_ASSERT_EQUAL(0, uip_get_stats(&stack, &stats));
+    TEST_ASSERT_EQUAL(5, stats.tx_dropped);
+    TEST_ASSERT_EQUAL(0, stats.tx_frames);
+
+    // The table is free again
+    TEST_ASSERT_EQUAL(-EINPROGRESS, uip_output(&stack, frame, frame_size));
+}
+
+void test_output_is_dropped_when_the_queue_is_full(void)
+{
+    uint8_t  frame[200] = {0};
+    uint16_t frame_size = build_output_frame(frame, PEER_IP, 150);
+    TEST_ASSERT_EQUAL(-EINPROGRESS, uip_output(&stack, frame, frame_size));
+    TEST_ASSERT_EQUAL(-ENOSPC, uip_output(&stack, frame, frame_size));
+
+    struct uip_stats stats;
+    TEST_ASSERT_EQUAL(0, uip_get_stats(&stack, &stats));
+    TEST_ASSERT_EQUAL(1, stats.tx_queued);
+    TEST_ASSERT_EQUAL(1, stats.tx_dropped);
+}
+
+void test_gratuitous_arp_announces_own_address(void)
+{
+    TEST_ASSERT_EQUAL(0, uip_announce(&stack));
+    TEST_ASSERT_EQUAL(1, sent_count);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(ETH_BROADCAST_MAC, sent_frame, 6);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(
+        NODE_MAC, &sent_frame[ETH_HEADER_SIZE + 8], 6);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(
+        NODE_IP, &sent_frame[ETH_HEADER_SIZE + 14], 4);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(
+        NODE_IP, &sent_frame[ETH_HEADER_SIZE + 24], 4);
+}
+
+void test_udp_send_prepends_headers_in_place(void)
+{
+    TEST_ASSERT_EQUAL(0, arp_cache_update(&arp_cache, PEER_IP, PEER_MAC, true));
+    uint8_t     buffer[128];
+    struct pbuf packet = {.buffer = buffer, .capacity = sizeof(buffer)};
+    TEST_ASSERT_EQUAL(0, pbuf_reset(&packet, UDP_PAYLOAD_OFST));
+    uint8_t* payload = NULL;
+    TEST_ASSERT_EQUAL(0, pbuf_put(&packet, 5, &payload));
+    memcpy(payload, "hello", 5);
+
+    struct udp_endpoint to = {.ip_addr = {192, 168, 1, 20}, .port = 6000};
+    TEST_ASSERT_EQUAL(0, uip_udp_send(&stack, &packet, 7000, &to));
+    TEST_ASSERT_EQUAL(1, sent_count);
+    TEST_ASSERT_EQUAL_PTR(buffer, sent_from); // Never copied
+    TEST_ASSERT_EQUAL(UDP_PAYLOAD_OFST + 5, sent_size);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(PEER_MAC, sent_frame, 6);
+    TEST_ASSERT_TRUE(checksum_is_valid(&sent_frame[IP_FRAME_OFST], 20));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(NODE_IP, &sent_frame[IP_FRAME_OFST + 12], 4);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(PEER_IP, &sent_frame[IP_FRAME_OFST + 16], 4);
+    TEST_ASSERT_EQUAL_HEX8(0x1B, sent_frame[UDP_FRAME_OFST]);     // 7000
+    TEST_ASSERT_EQUAL_HEX8(0x70, sent_frame[UDP_FRAME_OFST + 3]); // 6000
+    TEST_ASSERT_EQUAL_MEMORY("hello", &sent_frame[UDP_PAYLOAD_OFST], 5);
+
+    // The peer accepts the UDP checksum
+    struct udp             peer     = {0};
+    struct ip_rx_metadata  ip_mdata = {0};
+    struct udp_rx_metadata mdata    = {.ip_mdata = &ip_mdata};
+    memcpy(ip_mdata.src_ip, NODE_IP, 4);
+    memcpy(ip_mdata.dest_ip, PEER_IP, 4);
+    TEST_ASSERT_EQUAL(
+        0, udp_process_frame(&peer, &sent_frame[UDP_FRAME_OFST], 13, &mdata));
+    TEST_ASSERT_EQUAL(5, mdata.payload_size);
+
+    // Not enough headroom for the headers
+    TEST_ASSERT_EQUAL(0, pbuf_reset(&packet, UDP_PAYLOAD_OFST - 1));
+    TEST_ASSERT_EQUAL(-ENOSPC, uip_udp_send(&stack, &packet, 7000, &to));
+}
+
+void test_udp_flow_sends_the_same_frames_as_udp_send(void)
+{
+    TEST_ASSERT_EQUAL(0, arp_cache_update(&arp_cache, PEER_IP, PEER_MAC, true));
+    uint8_t     buffer[128];
+    struct pbuf packet = {.buffer = buffer, .capacity = sizeof(buffer)};
+
+    struct udp_endpoint to   = {.ip_addr = {192, 168, 1, 20}, .port = 6000};
+    struct uip_udp_flow flow = {.src_port = 7000, .to = to};
+    TEST_ASSERT_EQUAL(-EPERM, uip_udp_flow_send(&stack, &flow, &packet));
+    TEST_ASSERT_EQUAL(0, uip_udp_flow_init(&stack, &flow));
+
+    uint8_t  expected[UDP_PAYLOAD_OFST + 5];
+    uint8_t* payload = NULL;
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        TEST_ASSERT_EQUAL(0, pbuf_reset(&packet, UDP_PAYLOAD_OFST));
+        TEST_ASSERT_EQUAL(0, pbuf_put(&packet, 5, &payload));
+        memcpy(payload, "hello", 5);
+        if (i == 0)
+        {
+            TEST_ASSERT_EQUAL(0, uip_udp_send(&stack, &packet, 7000, &to));
+            memcpy(expected, sent_frame, sizeof(expected));
+        }
+        else
+        {
+            TEST_ASSERT_EQUAL(0, uip_udp_flow_send(&stack, &flow, &packet));
+        }
+    }
+    TEST_ASSERT_EQUAL(2, sent_count);
+    TEST_ASSERT_EQUAL(sizeof(expected), sent_size);
+    TEST_ASSERT_TRUE(checksum_is_valid(&sent_frame[IP_FRAME_OFST], 20));
+
+    // Only the ID, and so the header checksum, differ
+    uint16_t id = (uint16_t)(expected[IP_FRAME_OFST + 4] << 8
+                             | expected[IP_FRAME_OFST + 5]);
+    id += 1;
+    TEST_ASSERT_EQUAL_HEX8(id >> 8, sent_frame[IP_FRAME_OFST + 4]);
+    TEST_ASSERT_EQUAL_HEX8(id & 0xFF, sent_frame[IP_FRAME_OFST + 5]);
+    memcpy(&expected[IP_FRAME_OFST + 4], &sent_frame[IP_FRAME_OFST + 4], 2);
+    memcpy(&expected[IP_FRAME_OFST + 10], &sent_frame[IP_FRAME_OFST + 10], 2);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, sent_frame, sizeof(expected));
+}
+
+void test_fragmented_udp_datagram_is_reassembled(void)
+{
+    TEST_ASSERT_EQUAL(0, udp_table_bind(&table, &handler_socket));
+    uint8_t frame[128] = {0};
+    uint8_t payload[24];
+    for (uint8_t i = 0; i < sizeof(payload); i++)
+    {
+        payload[i] = (uint8_t)(0xA0 + i);
+    }
+    build_udp_frame(frame, NODE_IP, 1234, payload, sizeof(payload));
+    uint8_t datagram[UDP_HEADER_SIZE + sizeof(payload)];
+    memcpy(datagram, &frame[UDP_FRAME_OFST], sizeof(datagram));
+
+    // The last fragment first: held until the datagram is whole
+    uint16_t frame_size = build_fragment(frame, datagram, 16, 16, false);
+    TEST_ASSERT_EQUAL(0, uip_input(&stack, frame, frame_size));
+    TEST_ASSERT_EQUAL(0, received_count);
+    frame_size = build_fragment(frame, datagram, 0, 16, true);
+    TEST_ASSERT_EQUAL(0, uip_input(&stack, frame, frame_size));
+    TEST_ASSERT_EQUAL(1, received_count);
+    TEST_ASSERT_EQUAL(sizeof(payload), received_size);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(payload, received_payload, sizeof(payload));
+
+    // A fragment the reassembly refuses is dropped
+    frame_size = build_fragment(frame, datagram, 0, 12, true);
+    TEST_ASSERT_EQUAL(-EINVAL, uip_input(&stack, frame, frame_size));
+
+    struct uip_stats stats;
+    TEST_ASSERT_EQUAL(0, uip_get_stats(&stack, &stats));
+    TEST_ASSERT_EQUAL(1, stats.udp_delivered);
+    TEST_ASSERT_EQUAL(1, stats.dropped);
+}
+
+void test_large_udp_datagram_is_sent_as_fragments(void)
+{
+    TEST_ASSERT_EQUAL(0, arp_cache_update(&arp_cache, PEER_IP, PEER_MAC, true));
+    static uint8_t buffer[2048];
+    struct pbuf    packet = {.buffer = buffer, .capacity = sizeof(buffer)};
+    TEST_ASSERT_EQUAL(0, pbuf_reset(&packet, UDP_PAYLOAD_OFST));
+    uint8_t* payload = NULL;
+    TEST_ASSERT_EQUAL(0, pbuf_put(&packet, 2000, &payload));
+    for (uint16_t i = 0; i < 2000; i++)
+    {
+        payload[i] = (uint8_t)(i * 7);
+    }
+
+    struct udp_endpoint to = {.ip_addr = {192, 168, 1, 20}, .port = 6000};
+    TEST_ASSERT_EQUAL(0, uip_udp_send(&stack, &packet, 7000, &to));
+    TEST_ASSERT_EQUAL(2, sent_count);
+    TEST_ASSERT_EQUAL(ETH_HEADER_SIZE + IP_MTU, first_sizes[0]);
+    TEST_ASSERT_EQUAL(UDP_FRAME_OFST + 2008 - 1480, first_sizes[1]);
+
+    // The slices under the headers of the next fragment were restored
+    for (uint16_t i = 0; i < 2000; i++)
+    {
+        TEST_ASSERT_EQUAL_HEX8((uint8_t)(i * 7), payload[i]);
+    }
+
+    // The peer reassembles the datagram and accepts its UDP checksum
+    struct ip             peer_ip  = {.ip_addr = {0}};
+    struct ip_rx_metadata ip_mdata = {0};
+    memcpy(peer_ip.ip_addr, PEER_IP, 4);
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        const uint8_t* ip_frame = &first_frames[i][IP_FRAME_OFST];
+        TEST_ASSERT_TRUE(checksum_is_valid(ip_frame, 20));
+        TEST_ASSERT_EQUAL(
+            0,
+            ip_process_frame(
+                &peer_ip,
+                ip_frame,
+                first_sizes[i] - ETH_HEADER_SIZE,
+                &ip_mdata));
+        TEST_ASSERT_EQUAL(i == 0, ip_mdata.more_fragments);
+        TEST_ASSERT_EQUAL(i * 1480, ip_mdata.frag_offset);
+        TEST_ASSERT_EQUAL(
+            (i == 0) ? -EINPROGRESS : 0, ip_reasm_add(&reasm, &ip_mdata));
+    }
+    struct udp             peer  = {0};
+    struct udp_rx_metadata mdata = {.ip_mdata = &ip_mdata};
+    TEST_ASSERT_EQUAL(
+        0,
+        udp_process_frame(
+            &peer, ip_mdata.payload, ip_mdata.payload_size, &mdata));
+    TEST_ASSERT_EQUAL(2000, mdata.payload_size);
+    TEST_ASSERT_EQUAL_MEMORY(payload, mdata.payload, 2000);
+}
+
+/* ========================================================================== */